@@ -51,51 +51,36 @@ AccelSensor::~AccelSensor()
 int AccelSensor::enable(int32_t handle, int en)
 {
     unsigned int flags = en ? 1 : 0;
-    int fd, ret = 0;
-    char buf[50];
 
     D("AccelSensor-%s, flags = %d, mEnabled = %d", __func__, flags, mEnabled);
 
     if (flags == mEnabled)
         return 0;
 
-    if ((fd = SensorBase::openFile(mConfig->activate_path, O_RDWR)) < 0) {
-        E("AccelSensor: Open device file failed, possible path: %s!",
+    if (mActivate.write(flags) < 0) {
+        E("AccelSensor: Write device file failed, possible path: %s!",
                                                 mConfig->activate_path);
         return -1;
     }
+    mEnabled = flags;
 
-    buf[1] = 0;
-    buf[0] = flags ? '1' : '0';
-    ret = write(fd, buf, sizeof(buf));
-    if (ret == sizeof(buf)) {
-        mEnabled = flags;
-        ret = 0;
-    }
-    close(fd);
-
-    return ret;
+    return 0;
 }
 
 int AccelSensor::setDelay(int32_t handle, int64_t ns)
 {
-    int fd, ms;
-    char buf[10] = { 0 };
-
-    if ((fd = SensorBase::openFile(mConfig->poll_path, O_RDWR)) < 0) {
-        E("AccelSensor: Open device file failed, possible path: %s!",
-                                                mConfig->poll_path);
-        return -1;
-    }
+    int ms;
 
     if (ns / 1000 == SENSOR_NOPOLL)
         ms = 0;
     else
         ms = ns / 1000000;
 
-    snprintf(buf, sizeof(buf), "%d", ms);
-    write(fd, buf, sizeof(buf));
-    close(fd);
+    if (mPollDelay.write(ms) < 0) {
+        E("AccelSensor: Write device file failed, possible path: %s!",
+                                                mConfig->poll_path);
+        return -1;
+    }
 
     return 0;
 }
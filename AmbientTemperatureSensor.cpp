@@ -258,22 +258,17 @@ int AmbTempSensor::enable(int32_t handle, int en)
 
 int AmbTempSensor::setDelay(int32_t handle, int64_t delay_ns)
 {
-    int fd, delay_ms;
-    char buf[10] = { 0 };
-
-    if ((fd = open(mConfig->poll_path, O_RDWR)) < 0) {
-        E("AmbTempSensor: Open %s failed!", mConfig->poll_path);
-        return -1;
-    }
+    int delay_ms;
 
     if (delay_ns < mConfig->min_delay)
         delay_ns = mConfig->min_delay;
 
     D("AmbTempSensor-%s, delay_ns= %d", __func__, delay_ns);
     delay_ms = delay_ns / 1000000;
-    snprintf(buf, sizeof(buf), "%d", delay_ms);
-    write(fd, buf, sizeof(buf));
-    close(fd);
+    if (mPollDelay.write(delay_ms) < 0) {
+        E("AmbTempSensor: Write %s failed!", mConfig->poll_path);
+        return -1;
+    }
 
     return 0;
 }
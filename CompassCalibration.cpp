@@ -3,6 +3,10 @@
 #include "CompassSensor.h"
 #include "CompassCalibration.h"
 #include "mat.h"
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <cutils/atomic.h>
 
 using namespace android;
 #define DS_SIZE 48
@@ -20,15 +24,72 @@ typedef struct {
     double bfield;
 } CompassCalData;
 
-typedef mat<double, 3, DS_SIZE> mat_input_t;
+/*
+ * The ellipsoid is fitted by least squares over the accepted points. Rather
+ * than buffering DS_SIZE points and refitting them in one go, the normal
+ * equations are accumulated per accepted point with an exponential forgetting
+ * factor giving an effective window of DS_SIZE points, so a fresh solution is
+ * available after every point at a fixed cost.
+ */
+typedef struct {
+    /* sum of h * h' and of h * w over the window, h being one design row */
+    mat<double, 9, 9> hh;
+    mat<double, 1, 9> hw;
+
+    /* mean square error of the published and of the candidate solutions */
+    double err;
+    double err_new;
+    int err_count;
+    /* points the candidate was scored on since the worker returned it */
+    int err_new_count;
+} CompassCalStats;
+
+#define FORGET_FACTOR (1.0 - 1.0 / DS_SIZE)
 
 #define MIN_DIFF 1.5f
 #define MAX_SQR_ERR 2.0f
+/* points a fresh fit is scored on before it is published or dropped */
+#define SCORE_SIZE (DS_SIZE / 2)
 #define LOOKBACK_COUNT 6
 
-static float select_points[DS_SIZE][3];
+/* ring of the last accepted points, for the acceptance check */
+static float select_points[LOOKBACK_COUNT][3];
+static int select_point_next = 0;
+/* accepted points, saturates at DS_SIZE once the window is full */
 static int select_point_count = 0;
 
+/*
+ * Solving the fit runs on a worker thread. The event path and the worker
+ * pass a single job back and forth; the state says who owns it, and is
+ * only ever changed by the owner with a release store, so neither side
+ * takes a lock.
+ */
+enum {
+    JOB_IDLE,       /* owned by the event path */
+    JOB_SUBMITTED,  /* owned by the worker */
+    JOB_DONE,       /* back to the event path with a result */
+};
+
+typedef struct {
+    volatile int32_t state;
+    int generation;
+    mat<double, 9, 9> hh;
+    mat<double, 1, 9> hw;
+    bool valid;
+    CompassCalData result;
+} CompassCalJob;
+
+static CompassCalStats cal_stats;
+static CompassCalData new_cal_data;
+static int new_cal_valid = 0;
+static int new_point = 0;
+
+static CompassCalJob cal_job;
+static int cal_generation = 0;
+static sem_t cal_job_sem;
+static pthread_once_t cal_worker_once = PTHREAD_ONCE_INIT;
+static bool cal_worker_running = false;
+
 #ifdef DBG_RAW_DATA
 #define MAX_RAW_DATA_COUNT 2000
 static FILE *raw_data = NULL;
@@ -40,6 +101,26 @@ int file_no = 0;
 static CompassCalData cal_data;
 static int g_caled = 0;
 
+/* cal_data compiled for the apply path: result = m * raw + b, m row major */
+typedef struct {
+    float m[9];
+    float b[3];
+} CompassCalTransform;
+
+static CompassCalTransform cal_transform;
+
+static void compile_transform(const CompassCalData &data, CompassCalTransform &t)
+{
+    for (int r = 0; r < 3; ++r) {
+        double b = 0;
+        for (int c = 0; c < 3; ++c) {
+            t.m[r * 3 + c] = (float) data.w_invert[c][r];
+            b -= data.w_invert[c][r] * data.offset[0][c];
+        }
+        t.b[r] = (float) b;
+    }
+}
+
 // Given an real symmetric 3x3 matrix A, compute the eigenvalues
 // ref: http://en.wikipedia.org/wiki/Eigenvalue_algorithm
 static void compute_eigenvalues(const mat<double, 3, 3> &A, double &eig1, double &eig2, double &eig3)
@@ -111,30 +192,28 @@ calc_evector(const mat<double, 3, 3> &A, double eig)
     return evector;
 }
 
-bool ellipsoid_fit(const mat_input_t &M, mat<double, 1, 3> &offset,
-    mat<double, 3, 3> &w_invert, double &bfield)
+/* add one point to the normal equations of the fit */
+static void ellipsoid_accumulate(CompassCalStats &stats, const float data[3])
 {
-    int i, j;
-    mat<double, 9, DS_SIZE> H;
-    mat<double, 1, DS_SIZE> W;
-
-    for (i = 0; i < DS_SIZE; ++i) {
-        W[0][i] = M[0][i] * M[0][i];
-        H[0][i] = M[0][i];
-        H[1][i] = M[1][i];
-        H[2][i] = M[2][i];
-        H[3][i] = -1 * M[0][i] * M[1][i];
-        H[4][i] = -1 * M[0][i] * M[2][i];
-        H[5][i] = -1 * M[1][i] * M[2][i];
-        H[6][i] = -1 * M[1][i] * M[1][i];
-        H[7][i] = -1 * M[2][i] * M[2][i];
-        H[8][i] = 1;
+    double x = data[0], y = data[1], z = data[2];
+    double h[9] = { x, y, z, -x * y, -x * z, -y * z, -y * y, -z * z, 1 };
+    double w = x * x;
+
+    for (int i = 0; i < 9; ++i) {
+        for (int j = 0; j <= i; ++j) {
+            stats.hh[j][i] = FORGET_FACTOR * stats.hh[j][i] + h[i] * h[j];
+            stats.hh[i][j] = stats.hh[j][i];
+        }
+        stats.hw[0][i] = FORGET_FACTOR * stats.hw[0][i] + h[i] * w;
     }
+}
 
-    mat<double, DS_SIZE, 9> H_trans = transpose(H);
-    mat<double, 9, 9> P_temp1 = invert(H_trans * H);
-    mat<double, DS_SIZE, 9> P_temp2 = P_temp1 * H_trans;
-    mat<double, 1, 9> P = P_temp2 * W;
+static bool ellipsoid_fit(const mat<double, 9, 9> &hh, const mat<double, 1, 9> &hw,
+    mat<double, 1, 3> &offset, mat<double, 3, 3> &w_invert, double &bfield)
+{
+    mat<double, 1, 9> P;
+    if (!cholesky_solve(hh, hw, P))
+        return false;
     mat<double, 3, 3> temp1;
     temp1[0][0] = 2;
     temp1[1][0] = P[0][3];
@@ -173,6 +252,10 @@ bool ellipsoid_fit(const mat_input_t &M, mat<double, 1, 3> &offset,
     double eig1, eig2, eig3;
     compute_eigenvalues(A, eig1, eig2, eig3);
 
+    /* not an ellipsoid, the points do not cover enough directions yet */
+    if (!(eig1 > 0 && eig2 > 0 && eig3 > 0))
+        return false;
+
     mat<double, 3, 3> sqrt_evals;
     sqrt_evals[0][0] = sqrt(eig1);
     sqrt_evals[1][0] = 0;
@@ -194,13 +277,82 @@ bool ellipsoid_fit(const mat_input_t &M, mat<double, 1, 3> &offset,
     return true;
 }
 
+static void *calibration_worker(void *)
+{
+    while (true) {
+        if (sem_wait(&cal_job_sem) != 0)
+            continue;
+        if (android_atomic_acquire_load(&cal_job.state) != JOB_SUBMITTED)
+            continue;
+
+        cal_job.valid = ellipsoid_fit(cal_job.hh, cal_job.hw, cal_job.result.offset,
+                                      cal_job.result.w_invert, cal_job.result.bfield);
+        android_atomic_release_store(JOB_DONE, &cal_job.state);
+    }
+    return NULL;
+}
+
+static void start_worker()
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+
+    if (sem_init(&cal_job_sem, 0, 0) != 0) {
+        E("CompassCalibration: sem_init failed: %s", strerror(errno));
+        return;
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, calibration_worker, NULL) != 0)
+        E("CompassCalibration: cannot start calibration worker");
+    else
+        cal_worker_running = true;
+    pthread_attr_destroy(&attr);
+}
+
+/* hand the current window to the worker unless it is still busy */
+static bool submit_job()
+{
+    if (android_atomic_acquire_load(&cal_job.state) != JOB_IDLE)
+        return false;
+
+    cal_job.generation = cal_generation;
+    cal_job.hh = cal_stats.hh;
+    cal_job.hw = cal_stats.hw;
+
+    if (!cal_worker_running) {
+        cal_job.valid = ellipsoid_fit(cal_job.hh, cal_job.hw, cal_job.result.offset,
+                                      cal_job.result.w_invert, cal_job.result.bfield);
+        cal_job.state = JOB_DONE;
+        return true;
+    }
+
+    android_atomic_release_store(JOB_SUBMITTED, &cal_job.state);
+    sem_post(&cal_job_sem);
+    return true;
+}
+
 /* reset calibration algorithm */
 static void reset()
 {
     select_point_count = 0;
-    for (int i = 0; i < DS_SIZE; ++i)
+    select_point_next = 0;
+    for (int i = 0; i < LOOKBACK_COUNT; ++i)
         for (int j=0; j < 3; ++j)
             select_points[i][j] = 0;
+
+    cal_stats.hh = 0;
+    cal_stats.hw = 0;
+    cal_stats.err = 0;
+    cal_stats.err_new = 0;
+    cal_stats.err_count = 0;
+    cal_stats.err_new_count = 0;
+    new_cal_valid = 0;
+    new_point = 0;
+
+    /* a fit still in flight belongs to the old window */
+    ++cal_generation;
 }
 
 void CompassCal_init(FILE *calDataFile)
@@ -226,6 +378,7 @@ void CompassCal_init(FILE *calDataFile)
     raw_data_count = 0;
 #endif
 
+    pthread_once(&cal_worker_once, start_worker);
     reset();
 
     g_caled = 0;
@@ -277,6 +430,7 @@ void CompassCal_init(FILE *calDataFile)
 
         cal_data.bfield = 0;
     }
+    compile_transform(cal_data, cal_transform);
 }
 
 void CompassCal_storeResult(FILE *calDataFile)
@@ -295,6 +449,21 @@ void CompassCal_storeResult(FILE *calDataFile)
     }
 }
 
+// fold the square error of one point into a running mean over the last window points,
+// count being how many of them were seen so far
+static void update_err(double &err, int count, int window, const CompassCalData &data, const float point[3])
+{
+    mat<double, 1, 3> raw, result;
+    raw[0][0] = point[0];
+    raw[0][1] = point[1];
+    raw[0][2] = point[2];
+    result = data.w_invert * (raw - data.offset);
+    double diff = sqrt(result[0][0] * result[0][0] + result[0][1] * result[0][1]
+        + result[0][2] * result[0][2]) - data.bfield;
+    int n = count < window ? count + 1 : window;
+    err += (diff * diff - err) / n;
+}
+
 /* return 0 reject value, return 1 accept value. */
 int CompassCal_collectData(float rawMagX, float rawMagY, float rawMagZ, long currentTimeMSec)
 {
@@ -315,104 +484,112 @@ int CompassCal_collectData(float rawMagX, float rawMagY, float rawMagZ, long cur
 
     // For the current point to be accepted, each x/y/z value must be different enough
     // to the last several collected points
-    if (select_point_count > 0 && select_point_count < DS_SIZE) {
-        int lookback = LOOKBACK_COUNT < select_point_count ? LOOKBACK_COUNT : select_point_count;
-        for (int index = 0; index < lookback; ++index){
-            for (int j = 0; j < 3; ++j) {
-                if (fabsf(data[j] - select_points[select_point_count-1-index][j]) < MIN_DIFF) {
-                    D("CompassCalibration:point reject: [%f,%f,%f], selected_count=%d",
-                       (double)data[0], (double)data[1], (double)data[2], select_point_count);
-                        return 0;
-                }
+    int lookback = LOOKBACK_COUNT < select_point_count ? LOOKBACK_COUNT : select_point_count;
+    for (int index = 0; index < lookback; ++index){
+        for (int j = 0; j < 3; ++j) {
+            int k = (select_point_next + LOOKBACK_COUNT - 1 - index) % LOOKBACK_COUNT;
+            if (fabsf(data[j] - select_points[k][j]) < MIN_DIFF) {
+                D("CompassCalibration:point reject: [%f,%f,%f], selected_count=%d",
+                   (double)data[0], (double)data[1], (double)data[2], select_point_count);
+                    return 0;
             }
         }
     }
 
-    if (select_point_count < DS_SIZE) {
-        memcpy(select_points[select_point_count], data, sizeof(float) * 3);
+    memcpy(select_points[select_point_next], data, sizeof(float) * 3);
+    select_point_next = (select_point_next + 1) % LOOKBACK_COUNT;
+    if (select_point_count < DS_SIZE)
         ++select_point_count;
-        D("CompassCalibration:point collected [%f,%f,%f], selected_count=%d",
-            (double)data[0], (double)data[1], (double)data[2], select_point_count);
+    D("CompassCalibration:point collected [%f,%f,%f], selected_count=%d",
+        (double)data[0], (double)data[1], (double)data[2], select_point_count);
 #ifdef DBG_RAW_DATA
-        if (raw_data_selected) {
-            fprintf(raw_data_selected, "%f %f %f\n", (double)data[0], (double)data[1], (double)data[2]);
-        }
-#endif
+    if (raw_data_selected) {
+        fprintf(raw_data_selected, "%f %f %f\n", (double)data[0], (double)data[1], (double)data[2]);
     }
-   return 1;
-}
-
+#endif
 
-// use second data set to calculate square error
-double calc_square_err(const CompassCalData &data)
-{
-    double err = 0;
-    mat<double, 1, 3> raw, result;
-    for (int i = 0; i < DS_SIZE; ++i) {
-        raw[0][0] = select_points[i][0];
-        raw[0][1] = select_points[i][1];
-        raw[0][2] = select_points[i][2];
-        result = data.w_invert * (raw - data.offset);
-         double diff = sqrt(result[0][0] * result[0][0] + result[0][1] * result[0][1]
-             + result[0][2] * result[0][2]) - data.bfield;
-         err += diff * diff;
+    // score the solutions on the new point before it is part of the fit
+    update_err(cal_stats.err, cal_stats.err_count, DS_SIZE, cal_data, data);
+    if (cal_stats.err_count < DS_SIZE)
+        ++cal_stats.err_count;
+    if (new_cal_valid && cal_stats.err_new_count < SCORE_SIZE) {
+        update_err(cal_stats.err_new, cal_stats.err_new_count, SCORE_SIZE, new_cal_data, data);
+        ++cal_stats.err_new_count;
     }
-    err /= DS_SIZE;
-    return err;
+
+    ellipsoid_accumulate(cal_stats, data);
+    new_point = 1;
+   return 1;
 }
 
 /* check if calibration complete */
 int CompassCal_readyCheck()
 {
-    mat_input_t mat;
+    /* pick up the latest fit from the worker */
+    if (android_atomic_acquire_load(&cal_job.state) == JOB_DONE) {
+        if (cal_job.valid && cal_job.generation == cal_generation) {
+            /* a fresh candidate is scored from scratch on the points that follow */
+            new_cal_data = cal_job.result;
+            cal_stats.err_new = 0;
+            cal_stats.err_new_count = 0;
+            new_cal_valid = 1;
+        }
+        cal_job.state = JOB_IDLE;
+    }
 
     if (select_point_count < DS_SIZE)
         return g_caled;
 
-    // enough points have been collected, do the ellipsoid calibration
-    for (int i = 0; i < DS_SIZE; ++i) {
-        mat[0][i] = select_points[i][0];
-        mat[1][i] = select_points[i][1];
-        mat[2][i] = select_points[i][2];
-    }
-
-    /* check if result is good */
-    CompassCalData new_cal_data;
-    if (ellipsoid_fit(mat, new_cal_data.offset,
-                      new_cal_data.w_invert, new_cal_data.bfield)) {
-        double err_new = calc_square_err(new_cal_data);
-        if (err_new < MAX_SQR_ERR) {
-            double err = calc_square_err(cal_data);
-            if (err_new < err) {
-              // new cal_data is better, so we switch to the new
-              cal_data = new_cal_data;
-              g_caled = 1;
-              D("CompassCalibration: ready check success, caldata: %f %f %f %f %f %f %f %f %f %f %f %f %f, err %f",
-                cal_data.offset[0][0], cal_data.offset[0][1], cal_data.offset[0][2], cal_data.w_invert[0][0],
-                cal_data.w_invert[1][0], cal_data.w_invert[2][0], cal_data.w_invert[0][1],cal_data.w_invert[1][1],
-                cal_data.w_invert[2][1], cal_data.w_invert[0][2], cal_data.w_invert[1][2], cal_data.w_invert[2][2],
-                cal_data.bfield, err_new);
-            }
+    /* once scored, switch to the candidate if it beats the published solution */
+    if (new_cal_valid && cal_stats.err_new_count >= SCORE_SIZE) {
+        new_cal_valid = 0;
+        if (cal_stats.err_count >= DS_SIZE
+            && cal_stats.err_new < MAX_SQR_ERR && cal_stats.err_new < cal_stats.err) {
+            cal_data = new_cal_data;
+            compile_transform(cal_data, cal_transform);
+            cal_stats.err = cal_stats.err_new;
+            g_caled = 1;
+            D("CompassCalibration: ready check success, caldata: %f %f %f %f %f %f %f %f %f %f %f %f %f, err %f",
+              cal_data.offset[0][0], cal_data.offset[0][1], cal_data.offset[0][2], cal_data.w_invert[0][0],
+              cal_data.w_invert[1][0], cal_data.w_invert[2][0], cal_data.w_invert[0][1],cal_data.w_invert[1][1],
+              cal_data.w_invert[2][1], cal_data.w_invert[0][2], cal_data.w_invert[1][2], cal_data.w_invert[2][2],
+              cal_data.bfield, cal_stats.err_new);
         }
     }
 
-    reset();
+    /*
+     * refit once the worker is free and no candidate is being scored, the
+     * window only changes with new points
+     */
+    if (new_point && !new_cal_valid && submit_job())
+        new_point = 0;
+
     return g_caled;
 }
 
 void CompassCal_computeCal(float rawX, float rawY, float rawZ,
                 float *resultX, float *resultY, float *resultZ)
 {
-  if (!g_caled)
-      return;
+    if (!g_caled)
+        return;
 
-    mat<double, 1, 3> raw, result;
-    raw[0][0] = rawX;
-    raw[0][1] = rawY;
-    raw[0][2] = rawZ;
-
-    result = cal_data.w_invert * (raw - cal_data.offset);
-    *resultX = (float) result[0][0];
-    *resultY = (float) result[0][1];
-    *resultZ = (float) result[0][2];
+    float raw[3] = {rawX, rawY, rawZ};
+    CompassCal_computeCalBatch(raw, raw, 1);
+    *resultX = raw[0];
+    *resultY = raw[1];
+    *resultZ = raw[2];
+}
+
+void CompassCal_computeCalBatch(const float *raw, float *result, int count)
+{
+    if (!g_caled)
+        return;
+
+    const CompassCalTransform &t = cal_transform;
+    for (int i = 0; i < count; ++i, raw += 3, result += 3) {
+        const float x = raw[0], y = raw[1], z = raw[2];
+        result[0] = t.m[0] * x + t.m[1] * y + t.m[2] * z + t.b[0];
+        result[1] = t.m[3] * x + t.m[4] * y + t.m[5] * z + t.b[1];
+        result[2] = t.m[6] * x + t.m[7] * y + t.m[8] * z + t.b[2];
+    }
 }
@@ -49,4 +49,12 @@ int CompassCal_readyCheck();
 void CompassCal_computeCal(float rawX, float rawY, float rawZ, float *resultX,
                           float *resultY, float *resultZ);
 
+/* CompassCal_computeCalBatch
+ * Same as CompassCal_computeCal for count samples
+ * stored as consecutive x, y, z triplets.
+ *
+ * raw and result may point to the same buffer.
+ */
+void CompassCal_computeCalBatch(const float *raw, float *result, int count);
+
 #endif /*__COMPASS_CALIBRATION_H__*/
@@ -80,8 +80,7 @@ void CompassSensor::storeCalibrationData()
 int CompassSensor::enable(int32_t handle, int en)
 {
     unsigned int flags = en ? 1 : 0;
-    int fd, ret = 0;
-    char buf[50];
+    int ret = 0;
 
     D("CompassSensor - %s, flags = %d, mEnabled = %d",
          __func__, flags, mEnabled);
@@ -89,7 +88,7 @@ int CompassSensor::enable(int32_t handle, int en)
     if (flags == mEnabled)
         return 0;
 
-    if ((fd = SensorBase::openFile(mConfig->activate_path, O_RDWR)) < 0) {
+    if (mActivate.resolve() < 0) {
         E("CompassSensor: Open device file failed, possible path: %s!",
                                                 mConfig->activate_path);
         return -1;
@@ -124,36 +123,25 @@ int CompassSensor::enable(int32_t handle, int en)
         }
     }
 
-    buf[1] = 0;
-    buf[0] = flags ? '1' : '0';
-    ret = write(fd, buf, sizeof(buf));
-    if (ret > 0) {
+    ret = mActivate.write(flags);
+    if (ret == 0)
         mEnabled = flags;
-        ret = 0;
-    }
-    close(fd);
 
     return ret;
 }
 
 int CompassSensor::setDelay(int32_t handle, int64_t ns)
 {
-    int fd;
     unsigned long delay_ms;
-    char buf[10] = { 0 };
 
     D("%s setDelay ns = %lld\n", __func__, ns);
 
-    if ((fd = SensorBase::openFile(mConfig->poll_path, O_RDWR)) < 0) {
-        E("CompassSensor: Open device file failed, possible path: %s!",
+    delay_ms = ns / 1000 / 1000;
+    if (mPollDelay.write(delay_ms) < 0) {
+        E("CompassSensor: Write device file failed, possible path: %s!",
                                                 mConfig->poll_path);
         return -1;
     }
-
-    delay_ms = ns / 1000 / 1000;
-    snprintf(buf, sizeof(buf), "%ld", delay_ms);
-    write(fd, buf, sizeof(buf));
-    close(fd);
     return 0;
 }
 
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include "ConfigSourceStamp.h"
+
+#define FNV_OFFSET_BASIS        2166136261U
+#define FNV_PRIME               16777619U
+
+static int stamp_fd(int fd, uint32_t size, struct config_source_stamp *stamp)
+{
+    unsigned char buf[4096];
+    uint32_t hash = FNV_OFFSET_BASIS, total = 0;
+    ssize_t n;
+
+    while ((n = read(fd, buf, sizeof(buf))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        for (ssize_t i = 0; i < n; i++)
+            hash = (hash ^ buf[i]) * FNV_PRIME;
+        total += n;
+    }
+
+    /* Rewritten while we read it */
+    if (total != size)
+        return -1;
+
+    stamp->size = size;
+    stamp->hash = hash;
+    return 0;
+}
+
+int config_source_stamp_get(const char *file, struct config_source_stamp *stamp)
+{
+    struct stat st;
+    int fd, ret;
+
+    fd = open(file, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    ret = fstat(fd, &st) < 0 ? -1 : stamp_fd(fd, st.st_size, stamp);
+    close(fd);
+    return ret;
+}
+
+int config_source_stamp_matches(const char *file, const struct config_source_stamp *stamp)
+{
+    struct config_source_stamp current;
+    struct stat st;
+
+    if (stat(file, &st) < 0)
+        return errno == ENOENT;
+
+    /* The cheap check catches almost every edit */
+    if ((uint32_t)st.st_size != stamp->size)
+        return 0;
+
+    if (config_source_stamp_get(file, &current) < 0)
+        return 0;
+
+    return current.hash == stamp->hash;
+}
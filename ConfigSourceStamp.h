@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_CONFIG_SOURCE_STAMP_H
+#define ANDROID_CONFIG_SOURCE_STAMP_H
+
+#include <stdint.h>
+
+/*
+ * Identity of the sensor_hal_config_*.xml a precompiled config blob was
+ * compiled from, recorded in the blob header by both HAL trees
+ * (SensorConfigBlob.h, scalability/PlatformConfigBlob.hpp) so that a blob
+ * left behind by an edited XML is not used.
+ *
+ * Install time stamps are not kept across images, so the file is identified
+ * by its size and a hash of its contents. Checking a blob stats the XML and
+ * only reads it when the size still matches.
+ */
+struct config_source_stamp {
+    uint32_t size;
+    uint32_t hash;              /* FNV-1a of the contents */
+};
+
+/* stamp file, return 0 on success, -1 if it cannot be read */
+int config_source_stamp_get(const char *file, struct config_source_stamp *stamp);
+
+/*
+ * return 1 if file still has stamp or is not installed, as a blob shipped
+ * without its XML has nothing to go stale against, 0 if it changed
+ */
+int config_source_stamp_matches(const char *file, const struct config_source_stamp *stamp);
+
+#endif  // ANDROID_CONFIG_SOURCE_STAMP_H
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <utils/Log.h>
+
+#include "EventLoop.h"
+
+EventLoop::EventLoop()
+    : mEpollFd(-1)
+{
+    mWakeFds[0] = mWakeFds[1] = -1;
+
+    mEpollFd = epoll_create(MAX_EVENTS);
+    if (mEpollFd < 0) {
+        LOGE("%s: epoll_create error: %s", __FUNCTION__, strerror(errno));
+        return;
+    }
+    fcntl(mEpollFd, F_SETFD, FD_CLOEXEC);
+
+    if (pipe(mWakeFds) < 0) {
+        LOGE("%s: error creating wake pipe: %s", __FUNCTION__, strerror(errno));
+        mWakeFds[0] = mWakeFds[1] = -1;
+        return;
+    }
+    fcntl(mWakeFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(mWakeFds[1], F_SETFL, O_NONBLOCK);
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.ptr = this;
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeFds[0], &ev) < 0)
+        LOGE("%s: cannot watch wake pipe: %s", __FUNCTION__, strerror(errno));
+}
+
+EventLoop::~EventLoop()
+{
+    if (mWakeFds[0] >= 0)
+        close(mWakeFds[0]);
+    if (mWakeFds[1] >= 0)
+        close(mWakeFds[1]);
+    if (mEpollFd >= 0)
+        close(mEpollFd);
+}
+
+int EventLoop::add(int fd, void *owner)
+{
+    struct epoll_event ev;
+
+    if (fd < 0)
+        return -EINVAL;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = owner;
+
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &ev) == 0)
+        return 0;
+    if (errno == EEXIST && epoll_ctl(mEpollFd, EPOLL_CTL_MOD, fd, &ev) == 0)
+        return 0;
+
+    LOGE("%s: fd %d: %s", __FUNCTION__, fd, strerror(errno));
+    return -errno;
+}
+
+int EventLoop::remove(int fd)
+{
+    struct epoll_event ev;
+
+    if (fd < 0)
+        return -EINVAL;
+
+    /* kernels before 2.6.9 require a non-NULL event for EPOLL_CTL_DEL */
+    memset(&ev, 0, sizeof(ev));
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, &ev) == 0 || errno == ENOENT)
+        return 0;
+
+    LOGE("%s: fd %d: %s", __FUNCTION__, fd, strerror(errno));
+    return -errno;
+}
+
+int EventLoop::wake()
+{
+    const char msg = 'W';
+    int result = write(mWakeFds[1], &msg, 1);
+
+    /* a full pipe already guarantees a wakeup */
+    if (result < 0 && errno != EAGAIN) {
+        LOGE("%s: error sending wake message: %s", __FUNCTION__, strerror(errno));
+        return -errno;
+    }
+    return 0;
+}
+
+int EventLoop::wait(void **owners, int count, int timeout, bool *woken)
+{
+    int n, num = 0;
+
+    *woken = false;
+
+    if (count > MAX_EVENTS)
+        count = MAX_EVENTS;
+
+    do {
+        n = epoll_wait(mEpollFd, mEvents, count, timeout);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        LOGE("%s: epoll_wait error: %s", __FUNCTION__, strerror(errno));
+        return -errno;
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (mEvents[i].data.ptr == this) {
+            char buf[16];
+
+            /* edge triggered: drain everything written so far */
+            while (read(mWakeFds[0], buf, sizeof(buf)) > 0)
+                ;
+            *woken = true;
+            continue;
+        }
+
+        if (!(mEvents[i].events & EPOLLIN)) {
+            LOGE("%s: error on watched fd: events 0x%x", __FUNCTION__, mEvents[i].events);
+            continue;
+        }
+        owners[num++] = mEvents[i].data.ptr;
+    }
+
+    return num;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_EVENT_LOOP_H
+#define ANDROID_EVENT_LOOP_H
+
+#include <sys/epoll.h>
+
+/*
+ * epoll based multiplexer shared by the legacy (sensors.cpp) and the
+ * scalability (SensorHAL.cpp) poll entry points.
+ *
+ * Only fds of enabled sensors are registered. Each fd carries a pointer to
+ * its owning Sensor/SensorBase in epoll_data, so a wakeup dispatches
+ * straight to the sensors that are ready instead of scanning all of them.
+ * Sensor fds are level triggered because readEvents()/getData() read a
+ * bounded number of events per call; the internal wake pipe is edge
+ * triggered and always drained completely.
+ */
+class EventLoop
+{
+    static const int MAX_EVENTS = 32;
+
+    int mEpollFd;
+    int mWakeFds[2];
+    struct epoll_event mEvents[MAX_EVENTS];
+
+public:
+    EventLoop();
+    ~EventLoop();
+
+    bool isValid() const { return mEpollFd >= 0; }
+
+    /* Start/stop watching fd; safe to call while another thread is in wait() */
+    int add(int fd, void *owner);
+    int remove(int fd);
+
+    /* Make a pending or future wait() return */
+    int wake();
+
+    /*
+     * Wait up to timeout ms (-1 blocks) and store the owners of the ready
+     * fds in owners. Returns the number of owners, 0 on timeout or wake,
+     * or -errno. woken is set when wake() was called.
+     */
+    int wait(void **owners, int count, int timeout, bool *woken);
+};
+
+#endif  // ANDROID_EVENT_LOOP_H
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "FusionSensor.h"
+
+#define FUSION_DEFAULT_DELAY    200000000LL     /* SENSOR_DELAY_NORMAL */
+
+FusionSensor::FusionSensor(const sensor_platform_config_t *config, int type, SensorFusion &fusion)
+    : SensorBase(config),
+      mFusion(fusion),
+      mType(type),
+      mEnabled(0),
+      mDelay(FUSION_DEFAULT_DELAY),
+      mLastTimestamp(0),
+      mHead(0),
+      mCount(0)
+{
+}
+
+FusionSensor::~FusionSensor()
+{
+}
+
+int FusionSensor::enable(int32_t handle, int en)
+{
+    int flags = en ? 1 : 0;
+
+    D("FusionSensor: handle %d en %d", handle, en);
+
+    if (flags == mEnabled)
+        return 0;
+
+    mEnabled = flags;
+    mHead = mCount = 0;
+    mLastTimestamp = 0;
+    return 0;
+}
+
+int FusionSensor::setDelay(int32_t handle, int64_t ns)
+{
+    if (ns < mConfig->min_delay)
+        ns = mConfig->min_delay;
+    mDelay = ns;
+    return 0;
+}
+
+bool FusionSensor::hasPendingEvents() const
+{
+    return mCount > 0;
+}
+
+void FusionSensor::publish(int64_t timestamp)
+{
+    /* The engine runs at the gyroscope rate, report at the requested one */
+    if (!mEnabled || (mLastTimestamp && timestamp - mLastTimestamp < mDelay))
+        return;
+    mLastTimestamp = timestamp;
+
+    if (mCount == FUSION_SENSOR_QUEUE) {
+        mHead = (mHead + 1) % FUSION_SENSOR_QUEUE;
+        mCount--;
+    }
+
+    sensors_event_t &event = mEvents[(mHead + mCount) % FUSION_SENSOR_QUEUE];
+    memset(&event, 0, sizeof(event));
+    event.version = sizeof(sensors_event_t);
+    event.sensor = mConfig->handle;
+    event.type = mType;
+    event.timestamp = timestamp;
+
+    switch (mType) {
+    case SENSOR_TYPE_ORIENTATION:
+        mFusion.getOrientation(event.data);
+        event.orientation.status = SENSOR_STATUS_ACCURACY_HIGH;
+        break;
+    case SENSOR_TYPE_GRAVITY:
+        mFusion.getGravity(event.data);
+        break;
+    case SENSOR_TYPE_LINEAR_ACCELERATION:
+        mFusion.getLinearAcceleration(event.data);
+        break;
+    case SENSOR_TYPE_ROTATION_VECTOR:
+        mFusion.getRotationVector(event.data);
+        break;
+    }
+
+    mCount++;
+}
+
+int FusionSensor::readEvents(sensors_event_t* data, int count)
+{
+    int n = 0;
+
+    if (count < 1)
+        return -EINVAL;
+
+    while (count-- && mCount) {
+        *data++ = mEvents[mHead];
+        mHead = (mHead + 1) % FUSION_SENSOR_QUEUE;
+        mCount--;
+        n++;
+    }
+
+    return n;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_FUSION_SENSOR_H
+#define ANDROID_FUSION_SENSOR_H
+
+#include "SensorBase.h"
+#include "SensorFusion.h"
+
+#define FUSION_SENSOR_QUEUE     16
+
+/*
+ * Virtual sensor (orientation, gravity, linear acceleration, rotation
+ * vector) computed by the shared SensorFusion engine.
+ *
+ * It has no fd: sensors.cpp feeds the raw events to the engine and calls
+ * publish() after each gyroscope update, which queues one event. The queue
+ * is fixed size and keeps the newest events if the framework falls behind.
+ */
+class FusionSensor : public SensorBase {
+    SensorFusion &mFusion;
+    int mType;
+    int mEnabled;
+    int64_t mDelay;
+    int64_t mLastTimestamp;
+    sensors_event_t mEvents[FUSION_SENSOR_QUEUE];
+    int mHead;
+    int mCount;
+
+public:
+    FusionSensor(const sensor_platform_config_t *config, int type, SensorFusion &fusion);
+    virtual ~FusionSensor();
+    virtual int readEvents(sensors_event_t* data, int count);
+    virtual bool hasPendingEvents() const;
+    virtual int enable(int32_t handle, int enabled);
+    virtual int setDelay(int32_t handle, int64_t ns);
+
+    int getType() const { return mType; }
+    bool isEnabled() const { return mEnabled; }
+    int64_t getDelay() const { return mDelay; }
+    void publish(int64_t timestamp);
+};
+
+#endif  // ANDROID_FUSION_SENSOR_H
@@ -50,7 +50,7 @@ GyroSensor::~GyroSensor()
 
 int GyroSensor::enable(int32_t handle, int en)
 {
-    int fd, ret = 0;
+    int ret = 0;
     int flags = en ? 1 : 0;
     char buf[50];
 
@@ -59,7 +59,7 @@ int GyroSensor::enable(int32_t handle, int en)
     if (flags == mEnabled)
         return 0;
 
-    if ((fd = SensorBase::openFile(mConfig->activate_path, O_RDWR)) < 0) {
+    if (mActivate.resolve() < 0) {
         E("GyroSensor: Open device file failed, possible path: %s!",
                                                 mConfig->activate_path);
         return -1;
@@ -82,14 +82,9 @@ int GyroSensor::enable(int32_t handle, int en)
         }
     }
 
-    buf[1] = 0;
-    buf[0] = flags ? '1' : '0';
-    ret = write(fd, buf, sizeof(buf));
-    if (ret > 0) {
+    ret = mActivate.write(flags);
+    if (ret == 0)
         mEnabled = flags;
-        ret = 0;
-    }
-    close(fd);
 
     return ret;
 }
@@ -101,25 +96,18 @@ bool GyroSensor::hasPendingEvents() const
 
 int GyroSensor::setDelay(int32_t handle, int64_t delay_ns)
 {
-    int fd;
     unsigned long delay_ms;
-    char buf[10] = { 0 };
-
-
-    if ((fd = SensorBase::openFile(mConfig->poll_path, O_RDWR)) < 0) {
-        E("GyroSensor: Open device file failed, possible path: %s!",
-                                                mConfig->poll_path);
-        return -1;
-    }
 
     if (delay_ns < mConfig->min_delay)
         delay_ns = mConfig->min_delay;
 
     D("GyroSensor::%s, delay_ns=%lld", __func__, delay_ns);
     delay_ms = delay_ns / 1000000;
-    snprintf(buf, sizeof(buf), "%ld", delay_ms);
-    write(fd, buf, sizeof(buf));
-    close(fd);
+    if (mPollDelay.write(delay_ms) < 0) {
+        E("GyroSensor: Write device file failed, possible path: %s!",
+                                                mConfig->poll_path);
+        return -1;
+    }
 
     return 0;
 }
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/inotify.h>
+#include <linux/input.h>
+#include <utils/Log.h>
+
+#include "InputDeviceIndex.h"
+
+#define INPUT_SYS_DIR   "/sys/class/input"
+#define INPUT_DEV_DIR   "/dev/input"
+
+pthread_mutex_t InputDeviceIndex::sLock = PTHREAD_MUTEX_INITIALIZER;
+InputDeviceIndex::Entry InputDeviceIndex::sEntries[MAX_DEVICES];
+int InputDeviceIndex::sCount;
+bool InputDeviceIndex::sScanned;
+int InputDeviceIndex::sNotifyFd = -1;
+
+void InputDeviceIndex::watch()
+{
+    sNotifyFd = inotify_init();
+    if (sNotifyFd < 0) {
+        LOGW("%s: inotify_init error: %s, rescanning on misses", __FUNCTION__, strerror(errno));
+        return;
+    }
+    fcntl(sNotifyFd, F_SETFL, O_NONBLOCK);
+    fcntl(sNotifyFd, F_SETFD, FD_CLOEXEC);
+
+    if (inotify_add_watch(sNotifyFd, INPUT_DEV_DIR,
+                          IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO) < 0) {
+        LOGW("%s: cannot watch %s: %s", __FUNCTION__, INPUT_DEV_DIR, strerror(errno));
+        close(sNotifyFd);
+        sNotifyFd = -1;
+    }
+}
+
+/* Drain pending inotify events, true if /dev/input changed since last call */
+bool InputDeviceIndex::changed()
+{
+    char buf[512];
+    bool ret = false;
+
+    if (sNotifyFd < 0)
+        return false;
+
+    while (read(sNotifyFd, buf, sizeof(buf)) > 0)
+        ret = true;
+
+    return ret;
+}
+
+void InputDeviceIndex::scan()
+{
+    char path[PATH_MAX];
+    struct dirent *de;
+    DIR *dir;
+    int fd, len;
+
+    sCount = 0;
+    sScanned = true;
+
+    dir = opendir(INPUT_SYS_DIR);
+    if (dir == NULL) {
+        LOGE("%s: opendir %s failed", __FUNCTION__, INPUT_SYS_DIR);
+        return;
+    }
+
+    while ((de = readdir(dir)) && sCount < MAX_DEVICES) {
+        Entry *entry = &sEntries[sCount];
+
+        if (strncmp(de->d_name, "event", 5) ||
+            strlen(de->d_name) >= sizeof(entry->node))
+            continue;
+
+        snprintf(path, sizeof(path), INPUT_SYS_DIR "/%s/device/name", de->d_name);
+        fd = open(path, O_RDONLY);
+        if (fd < 0)
+            continue;
+        len = read(fd, entry->name, sizeof(entry->name) - 1);
+        close(fd);
+        if (len < 1)
+            continue;
+
+        entry->name[len] = '\0';
+        if (entry->name[len - 1] == '\n')
+            entry->name[len - 1] = '\0';
+        strcpy(entry->node, de->d_name);
+        sCount++;
+    }
+    closedir(dir);
+}
+
+const char *InputDeviceIndex::find(const char *name)
+{
+    for (int i = 0; i < sCount; i++) {
+        if (!strcmp(sEntries[i].name, name))
+            return sEntries[i].node;
+    }
+    return NULL;
+}
+
+int InputDeviceIndex::openDevice(const char *name, int flags)
+{
+    char path[PATH_MAX];
+    char devName[NAME_MAX_LEN];
+    int clockId = CLOCK_MONOTONIC;
+    const char *node;
+    int fd = -1;
+
+    if (name == NULL)
+        return -1;
+
+    pthread_mutex_lock(&sLock);
+
+    if (!sScanned) {
+        watch();
+        scan();
+    } else if (changed()) {
+        scan();
+    }
+
+    /* A second pass covers nodes renumbered behind our back */
+    for (int pass = 0; pass < 2 && fd < 0; pass++) {
+        if (pass > 0)
+            scan();
+
+        node = find(name);
+        if (node == NULL) {
+            /* With inotify the index is current, a miss is final */
+            if (sNotifyFd >= 0)
+                break;
+            continue;
+        }
+
+        snprintf(path, sizeof(path), INPUT_DEV_DIR "/%s", node);
+        fd = open(path, flags);
+        if (fd < 0) {
+            LOGE("%s: open %s error: %s", __FUNCTION__, path, strerror(errno));
+            continue;
+        }
+
+        devName[sizeof(devName) - 1] = '\0';
+        if (ioctl(fd, EVIOCGNAME(sizeof(devName) - 1), devName) < 1 ||
+            strcmp(devName, name)) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    pthread_mutex_unlock(&sLock);
+
+    if (fd >= 0)
+        ioctl(fd, EVIOCSCLOCKID, &clockId);
+
+    return fd;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_INPUT_DEVICE_INDEX_H
+#define ANDROID_INPUT_DEVICE_INDEX_H
+
+#include <pthread.h>
+
+/*
+ * Input device name to /dev/input/eventX index shared by the legacy
+ * (SensorBase::openInputDev) and the scalability (InputEventSensor)
+ * sensors.
+ *
+ * Names are read once from /sys/class/input/eventX/device/name, so no
+ * device node is opened or ioctl'd during discovery. The index is refreshed
+ * when inotify reports nodes appearing in or leaving /dev/input, or, without
+ * inotify, when a lookup misses.
+ */
+class InputDeviceIndex
+{
+    static const int MAX_DEVICES = 64;
+    static const int NAME_MAX_LEN = 80;
+    static const int NODE_MAX_LEN = 16;
+
+    struct Entry {
+        char name[NAME_MAX_LEN];
+        char node[NODE_MAX_LEN];
+    };
+
+    static pthread_mutex_t sLock;
+    static Entry sEntries[MAX_DEVICES];
+    static int sCount;
+    static bool sScanned;
+    static int sNotifyFd;
+
+    static void watch();
+    static bool changed();
+    static void scan();
+    static const char *find(const char *name);
+
+public:
+    /*
+     * Open the event node of the input device called name with flags and
+     * switch its event timestamps to CLOCK_MONOTONIC. Returns the fd, or -1
+     * if there is no such device.
+     */
+    static int openDevice(const char *name, int flags);
+};
+
+#endif  // ANDROID_INPUT_DEVICE_INDEX_H
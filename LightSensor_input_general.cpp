@@ -53,28 +53,11 @@ LightSensor::~LightSensor()
 int LightSensor::enable(int32_t handle, int en)
 {
     unsigned int flags = en ? 1 : 0;
-    int fd;
-    char buf[2] = { 0 };
 
     D("LightSensor -%s, flags = %d, mEnabled = %d", __func__, flags, mEnabled);
     if (flags == mEnabled)
         return 0;
-    fd = open(mConfig->activate_path, O_RDWR);
-    if (fd < 0) {
-        E("LightSensor %s - open %s failed, errno=%d", __func__,
-                                                mConfig->activate_path, errno);
-        return -1;
-    }
-
-    if (flags) {
-       buf[0] = '1';
-    } else {
-       buf[0] = '0';
-    }
-    int ret = write(fd, buf, sizeof(buf));
-    close(fd);
-
-    if (ret != sizeof(buf)) {
+    if (mActivate.write(flags) < 0) {
         E("LightSensor %s - write %s failed, errno=%d",
                 __func__, mConfig->activate_path, errno);
         return -1;
@@ -46,22 +46,9 @@ int PressureSensor::enable(int32_t handle, int en)
     int flags = en ? 1 : 0;
 
     if (flags != mEnabled) {
-        int fd;
-        fd = open(mConfig->activate_path, O_RDWR);
-        if (fd >= 0) {
-            char buf[2];
-            buf[1] = 0;
-            if (flags) {
-                buf[0] = '1';
-            } else {
-                buf[0] = '0';
-            }
-            int ret = write(fd, buf, sizeof(buf));
-            close(fd);
-            if (ret == sizeof(buf)) {
-                mEnabled = flags;
-                return 0;
-            }
+        if (mActivate.write(flags) == 0) {
+            mEnabled = flags;
+            return 0;
         }
         return -1;
     }
@@ -71,19 +58,15 @@ int PressureSensor::enable(int32_t handle, int en)
 int PressureSensor::setDelay(int32_t handle, int64_t delay_ns)
 {
 
-    int fd, ms;
-    char buf[10] = { 0 };
+    int ms;
 
     D("PressureSensor: %s delay_ns=%lld", __FUNCTION__, delay_ns);
-    if ((fd = open(mConfig->poll_path, O_RDWR)) < 0) {
-        E("PressureSensor: Open %s failed!", mConfig->poll_path);
-        return -1;
-    }
 
     ms = delay_ns / 1000000;
-    snprintf(buf, sizeof(buf), "%d", ms);
-    write(fd, buf, sizeof(buf));
-    close(fd);
+    if (mPollDelay.write(ms) < 0) {
+        E("PressureSensor: Write %s failed!", mConfig->poll_path);
+        return -1;
+    }
 
     return 0;
 }
@@ -22,7 +22,11 @@ ProximitySensor::ProximitySensor(const sensor_platform_config_t *config)
       mInputReader(32),
       mHasPendingEvent(false),
       inputDataOverrun(0),
-      thresh(APDS_PROX_DEF_THRES)
+      thresh(APDS_PROX_DEF_THRES),
+      mCalibTries(0),
+      mCalibLoaded(false),
+      mCalibDirty(false),
+      mCalibOffset(0)
 {
     if (mConfig->handle != SENSORS_HANDLE_PROXIMITY)
         E("ProximitySensor: Incorrect sensor config");
@@ -32,6 +36,9 @@ ProximitySensor::ProximitySensor(const sensor_platform_config_t *config)
 
     D("ProximitySensor open proximity input dev%s",mConfig->name);
 
+    memset(&mCalib, 0, sizeof(mCalib));
+    mThreshold.setPath(mConfig->config_path);
+
     mPendingEvent.version = sizeof(sensors_event_t);
     mPendingEvent.sensor = SENSORS_HANDLE_PROXIMITY;
     mPendingEvent.type = SENSOR_TYPE_PROXIMITY;
@@ -44,17 +51,42 @@ ProximitySensor::~ProximitySensor()
         enable(0, 0);
 }
 
-int ProximitySensor::calibThresh(int raw_data)
+void ProximitySensor::loadCalib()
 {
-    int ret, fd, maxthresh = APDS990X_MAX_THRESH;
-    off_t offset = 0;
-    struct flock lock;
+    int ret, fd;
     ps_calib_t calib;
 
+    mCalibLoaded = true;
+    mCalibOffset = 0;
+    memset(&mCalib, 0, sizeof(mCalib));
+
+    if ((fd = open(SENSOR_CALIB_FILE, O_RDONLY)) < 0) {
+        LOGI("ProximitySensor: open %s failed, %s",
+                                        SENSOR_CALIB_FILE, strerror(errno));
+        return;
+    }
+
+    memset(&calib, 0, sizeof(calib));
+    while ((ret = pread(fd, &calib, sizeof(calib), mCalibOffset)) > 0) {
+        LOGI("ProximitySensor: pread %d bytes from seonsr config file", ret);
+        if (calib.type == SENSOR_TYPE_PROXIMITY) {
+            mCalib = calib;
+            break;
+        }
+        mCalibOffset += sizeof(calib);
+    }
+    close(fd);
+}
+
+void ProximitySensor::storeCalib()
+{
+    int ret, fd;
+    struct flock lock;
+
     if ((fd = open(SENSOR_CALIB_FILE, O_RDWR | O_CREAT, S_IRWXU)) < 0) {
         E("ProximitySensor: open %s failed, %s",
                                         SENSOR_CALIB_FILE, strerror(errno));
-        return fd;
+        return;
     }
 
     lock.l_type = F_WRLCK;
@@ -64,137 +96,108 @@ int ProximitySensor::calibThresh(int raw_data)
     if (fcntl(fd, F_SETLK, &lock) < 0) {
         LOGI("%d ProximitySensor: File lock failed failed, %s",__LINE__, strerror(errno));
         close(fd);
-        return -1;
-    }
-
-    memset(&calib, 0, sizeof(calib));
-    while ((ret = pread(fd, &calib, sizeof(calib), offset)) > 0) {
-        LOGI("ProximitySensor: pread %d bytes from seonsr config file", ret);
-        if (calib.type == SENSOR_TYPE_PROXIMITY) {
-            LOGI("ProximitySensor: thresh=%d, raw_data=%d", calib.thresh, raw_data);
-            maxthresh = calib.thresh;
-            break;
-        }
-        offset += sizeof(calib);
+        return;
     }
-    if (raw_data < maxthresh && raw_data >= APDS990X_MIN_THRESH) {
-        LOGI("ProximitySensor: raw %d max %d", raw_data, maxthresh);
 
-        maxthresh = raw_data;
-        calib.thresh = maxthresh;
-        calib.type = SENSOR_TYPE_PROXIMITY;
-        if ((ret = pwrite(fd, &calib, sizeof(calib), offset)) > 0)
-            LOGI("ProximitySensor: write %d bytes to sensor config file", ret);
-        else
-            LOGI("ProximitySensor: write data failed, %s", strerror(errno));
-    }
+    if ((ret = pwrite(fd, &mCalib, sizeof(mCalib), mCalibOffset)) > 0) {
+        LOGI("ProximitySensor: write %d bytes to sensor config file", ret);
+        mCalibDirty = false;
+    } else
+        LOGI("ProximitySensor: write data failed, %s", strerror(errno));
 
     lock.l_type = F_UNLCK;
-    if (fcntl(fd, F_SETLK, &lock) < 0) {
+    if (fcntl(fd, F_SETLK, &lock) < 0)
         LOGI("ProximitySensor: File unlock failed, %s", strerror(errno));
-        maxthresh = -1;
-    }
     close(fd);
-
-    return maxthresh;
 }
 
-int ProximitySensor::enable(int32_t, int en)
+int ProximitySensor::calibThresh(int raw_data)
 {
-    int flags = en ? 1 : 0;
-    int fd;
-    char buf[2] = { 0 };
-    int newThresh;
-    int len, raw_data = 0;
+    int maxthresh = APDS990X_MAX_THRESH;
 
-    D("ProximitySensor-%s, flags = %d, mEnabled = %d", __func__, flags, mEnabled);
+    if (!mCalibLoaded)
+        loadCalib();
 
-    if (flags == mEnabled)
-        return 0;
-
-    fd = open(mConfig->activate_path, O_RDWR);
-    if (fd < 0) {
-        E("ProximitySensor%s - open %s failed, errno=%d", __func__,
-                                                mConfig->activate_path, errno);
-        return -1;
+    if (mCalib.type == SENSOR_TYPE_PROXIMITY) {
+        LOGI("ProximitySensor: thresh=%d, raw_data=%d", mCalib.thresh, raw_data);
+        maxthresh = mCalib.thresh;
     }
+    if (raw_data < maxthresh && raw_data >= APDS990X_MIN_THRESH) {
+        LOGI("ProximitySensor: raw %d max %d", raw_data, maxthresh);
 
-    if (flags) {
-       buf[0] = '1';
-    } else {
-       buf[0] = '0';
+        maxthresh = raw_data;
+        mCalib.thresh = maxthresh;
+        mCalib.type = SENSOR_TYPE_PROXIMITY;
+        /* written back by enable(0) */
+        mCalibDirty = true;
     }
 
-    int ret = write(fd, buf, sizeof(buf));
-    close(fd);
-
-    if (ret != sizeof(buf)) {
-        E("ProximitySensor%s - write %s failed, errno=%d",
-                __func__, mConfig->activate_path, errno);
-        return -1;
-    }
-    D("ProximitySensor%s %s",__func__, mConfig->activate_path);
+    return maxthresh;
+}
 
-    mEnabled = flags;
-    if (!flags)
-        return 0;
+/* Called for samples while mCalibTries > 0, the sensor is already running */
+void ProximitySensor::calibrate()
+{
+    int fd, len, newThresh, raw_data = 0;
+    char raw_buf[8] = { 0 };
 
-    /*get raw data and do calibration*/
     if ((fd = open(mConfig->data_path, O_RDONLY)) < 0) {
         LOGI("ProximitySensor: open %s failed, %s!", mConfig->data_path, strerror(errno));
-        return 0;
+        mCalibTries = 0;
+        return;
     }
-    D("ProximitySensor%s %s",__func__, mConfig->data_path);
-
-    for (int i = 0; i < APDS990X_ENABLE_TRY; i++) {
-	char raw_buf[8] = { 0 };
-        usleep(100000);
-
-        //len = read(fd, &buf, sizeof(buf) - 1);
-        len = read(fd, raw_buf, sizeof(raw_buf));
-        if (len < 0) {
-            LOGI("ProximitySensor: read %s failed, %s!", mConfig->data_path, strerror(errno));
-            close(fd);
-            return 0;
-        }
-        sscanf(raw_buf, "%d\n", &raw_data);
-        LOGI("ProximitySensor - path: %s buf: %s, raw_data: %d", mConfig->data_path, raw_buf,raw_data);
 
-        if (raw_data > 0)
-            break;
-    }
+    len = read(fd, raw_buf, sizeof(raw_buf));
     close(fd);
+    if (len < 0) {
+        LOGI("ProximitySensor: read %s failed, %s!", mConfig->data_path, strerror(errno));
+        mCalibTries = 0;
+        return;
+    }
+    sscanf(raw_buf, "%d\n", &raw_data);
+    LOGI("ProximitySensor - path: %s buf: %s, raw_data: %d", mConfig->data_path, raw_buf,raw_data);
+
+    /* no crosstalk reading yet, try again on the next sample */
+    if (raw_data <= 0 && --mCalibTries > 0)
+        return;
+    mCalibTries = 0;
 
     LOGI("ProximitySensor - raw data for calibration:%d", raw_data);
-    if ((newThresh = calibThresh(raw_data)) < 0) {
-        LOGI("ProximitySensor - calibration failed");
-        return 0;
+    newThresh = calibThresh(raw_data) + APDS990X_DISTANCE_THRESH;
+    if (newThresh != thresh) {
+        D("ProximitySensor: set thresh from %d to %d.", thresh, newThresh);
+        if (mThreshold.write(newThresh) < 0) {
+            LOGI("ProximitySensor: write %s failed, %s", mConfig->config_path, strerror(errno));
+            return;
+        }
+        thresh = newThresh;
     }
+}
 
-    newThresh += APDS990X_DISTANCE_THRESH;
-    if(newThresh != thresh)
-    {
-        char raw_buf[8] = { 0 };
+int ProximitySensor::enable(int32_t, int en)
+{
+    int flags = en ? 1 : 0;
 
-        if ((fd = open(mConfig->config_path, O_WRONLY)) < 0) {
-            LOGI("ProximitySensor: open %s failed, %s", mConfig->config_path, strerror(errno));
-            return 0;
-        }
-        D("ProximitySensor: set thresh from %d to %d.", thresh, newThresh);
+    D("ProximitySensor-%s, flags = %d, mEnabled = %d", __func__, flags, mEnabled);
 
-       memset(raw_buf, 0, sizeof(raw_buf));
-       snprintf(raw_buf, sizeof(raw_buf), "%d\n", newThresh);
-       D("ProximitySensor: set thresh to %s.", raw_buf);
+    if (flags == mEnabled)
+        return 0;
 
-       if (write(fd, raw_buf, strlen(raw_buf)) < 0) {
-            LOGI("ProximitySensor: write %s failed, %s", mConfig->config_path, strerror(errno));
-            close(fd);
-            return 0;
-       }
-       thresh = newThresh;
+    if (mActivate.write(flags) < 0) {
+        E("ProximitySensor%s - write %s failed, errno=%d",
+                __func__, mConfig->activate_path, errno);
+        return -1;
+    }
+    D("ProximitySensor%s %s",__func__, mConfig->activate_path);
 
-       D("ProximitySensor: set thresh to %s.", raw_buf);
-       close(fd);
+    mEnabled = flags;
+    if (flags) {
+        /* calibrated by readEvents() once samples arrive */
+        mCalibTries = APDS990X_ENABLE_TRY;
+    } else {
+        mCalibTries = 0;
+        if (mCalibDirty)
+            storeCalib();
     }
 
     return 0;
@@ -237,6 +240,8 @@ int ProximitySensor::readEvents(sensors_event_t* data, int count)
                 inputDataOverrun = 0;
             } else {
                 D("ProximitySensor::%s, in type = EV_SYN, mEnabled = %d", __func__, mEnabled);
+                if (mEnabled && mCalibTries > 0)
+                    calibrate();
                 if (mEnabled) {
                     *data++ = mPendingEvent;
                     count--;
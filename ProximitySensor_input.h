@@ -40,9 +40,23 @@ class ProximitySensor : public SensorBase {
     bool mHasPendingEvent;
     int inputDataOverrun;
     int thresh;
+    /*
+     * Crosstalk calibration runs on the first samples after enable(), not in
+     * it. The SENSOR_CALIB_FILE record is read once and written back on
+     * disable when it changed.
+     */
+    int mCalibTries;            /* samples left to wait for raw data, 0 when idle */
+    bool mCalibLoaded;
+    bool mCalibDirty;
+    off_t mCalibOffset;         /* of the proximity record in SENSOR_CALIB_FILE */
+    ps_calib_t mCalib;
+    SysfsControl mThreshold;    /* config_path */
 
 private:
     int calibThresh(int raw);
+    void calibrate();
+    void loadCalib();
+    void storeCalib();
 
 public:
     ProximitySensor(const sensor_platform_config_t *config);
@@ -16,10 +16,14 @@
 #define LOG_TAG "Sensors"
 
 #include "SensorBase.h"
+#include "InputDeviceIndex.h"
 
 SensorBase::SensorBase(const sensor_platform_config_t *config)
-    : mConfig(config), data_fd(-1)
-{ }
+    : mConfig(config), data_fd(-1), mPollDelay(false)
+{
+    mActivate.setPath(config->activate_path);
+    mPollDelay.setPath(config->poll_path);
+}
 
 SensorBase::~SensorBase()
 {
@@ -54,66 +58,7 @@ int64_t SensorBase::getTimestamp()
 
 int SensorBase::openInputDev(const char* inputName)
 {
-    int fd = -1, clkid = CLOCK_MONOTONIC;
-    const char *sys_dirname = "/sys/class/input";
-    const char *dirname = "/dev/input";
-    char devname[PATH_MAX] = { 0 };
-    char *filename;
-    DIR *dir;
-    struct dirent *de;
-    int len;
-    dir = opendir(sys_dirname);
-
-    if (dir == NULL) {
-        LOGE("%s: opendir failed", __func__);
-        return -1;
-    }
-
-    /*scan the /sys/class instead of /dev to get the
-      device path, this is to avoid close delay of files
-      in /dev/input/event* */
-    strcpy(devname, sys_dirname);
-    filename = devname + strlen(devname);
-    *filename++ = '/';
-    while ((de = readdir(dir))) {
-        if (!strstr(de->d_name, "event"))
-            continue;
-        strcpy(filename, de->d_name);
-        filename += strlen(de->d_name);
-        strcpy(filename, "/device/name");
-        filename -= strlen(de->d_name);
-        fd = open(devname, O_RDONLY);
-        if (fd >= 0) {
-            char name[80];
-            len = read(fd, &name, sizeof(name) - 1);
-            if (len < 1)
-                name[0] = '\0';
-            else
-                name[len-1] = '\0';
-            if (!strcmp(name, inputName)) {
-                close(fd);
-
-                /* save the /dev/input/eventX path before closedir()*/
-                strcpy(devname, dirname);
-                filename = devname + strlen(devname);
-                *filename++ = '/';
-                strcpy(filename, de->d_name);
-                break;
-            }
-            close(fd);
-            fd = -1;
-        }
-    }
-    closedir(dir);
-
-    if (fd < 0)
-        return fd;
-
-    fd = open(devname, O_RDONLY);
-    if (fd >= 0)
-        ioctl(fd, EVIOCSCLOCKID, &clkid);
-
-    return fd;
+    return InputDeviceIndex::openDevice(inputName, O_RDONLY);
 }
 
 static char *trim_space(char *str)
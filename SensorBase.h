@@ -18,6 +18,7 @@
 #define ANDROID_SENSOR_BASE_H
 
 #include "sensors.h"
+#include "SysfsControl.h"
 
 typedef struct sensor_platform_config {
     int handle;
@@ -37,6 +38,8 @@ class SensorBase {
 protected:
     const sensor_platform_config_t *mConfig;
     int   data_fd;
+    SysfsControl mActivate;     /* activate_path */
+    SysfsControl mPollDelay;    /* poll_path, written through */
 
     int openInputDev(const char* inputName);
     int openFile(const char *all_path, int flags);
@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SensorConfigBlob.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static const char *blob_string(const char *strings, uint32_t offset)
+{
+    return offset ? strings + offset : NULL;
+}
+
+int sensor_config_blob_load(const char *file, const char *xml_file,
+                            struct sensor_config_blob *blob,
+                            sensor_platform_config_t **configs,
+                            struct sensor_t **list, int *count)
+{
+    const struct sensor_config_blob_header *header;
+    const struct sensor_config_blob_sensor *records;
+    const char *strings;
+    sensor_platform_config_t *c;
+    struct sensor_t *s;
+    struct stat st;
+    void *map;
+    uint32_t i;
+    int fd;
+
+    fd = open(file, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(*header)) {
+        E("%s: %s is too short\n", __func__, file);
+        close(fd);
+        return -1;
+    }
+
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        E("%s: cannot map %s: %s\n", __func__, file, strerror(errno));
+        return -1;
+    }
+
+    header = (const struct sensor_config_blob_header *)map;
+    if (header->magic != SENSOR_CONFIG_BLOB_MAGIC ||
+        header->version != SENSOR_CONFIG_BLOB_VERSION ||
+        header->size != (uint32_t)st.st_size ||
+        header->count == 0 ||
+        header->record_size != sizeof(struct sensor_config_blob_sensor) ||
+        header->records_offset > header->size ||
+        header->count > (header->size - header->records_offset) / header->record_size ||
+        header->strings_offset > header->size ||
+        header->strings_size == 0 ||
+        header->strings_size > header->size - header->strings_offset) {
+        E("%s: invalid config blob %s, falling back to XML\n", __func__, file);
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    if (!config_source_stamp_matches(xml_file, &header->source)) {
+        E("%s: %s was changed after %s was compiled, falling back to XML\n", __func__, xml_file, file);
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    records = (const struct sensor_config_blob_sensor *)((const char *)map + header->records_offset);
+    strings = (const char *)map + header->strings_offset;
+    if (strings[header->strings_size - 1] != '\0') {
+        E("%s: unterminated string table in %s\n", __func__, file);
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    for (i = 0; i < header->count; i++) {
+        const struct sensor_config_blob_sensor *r = records + i;
+        if (r->name >= header->strings_size ||
+            r->activate_path >= header->strings_size ||
+            r->poll_path >= header->strings_size ||
+            r->data_path >= header->strings_size ||
+            r->config_path >= header->strings_size ||
+            r->sensor_name >= header->strings_size ||
+            r->vendor >= header->strings_size) {
+            E("%s: string out of range in %s\n", __func__, file);
+            munmap(map, st.st_size);
+            return -1;
+        }
+    }
+
+    c = (sensor_platform_config_t *)calloc(header->count, sizeof(sensor_platform_config_t));
+    s = (struct sensor_t *)calloc(header->count, sizeof(struct sensor_t));
+    if (!c || !s) {
+        E("malloc error!\n");
+        free(c);
+        free(s);
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    for (i = 0; i < header->count; i++) {
+        const struct sensor_config_blob_sensor *r = records + i;
+
+        c[i].handle = r->handle;
+        c[i].name = blob_string(strings, r->name);
+        c[i].activate_path = blob_string(strings, r->activate_path);
+        c[i].poll_path = blob_string(strings, r->poll_path);
+        c[i].data_path = blob_string(strings, r->data_path);
+        c[i].config_path = blob_string(strings, r->config_path);
+        memcpy(c[i].mapper, r->mapper, sizeof(c[i].mapper));
+        memcpy(c[i].scale, r->scale, sizeof(c[i].scale));
+        memcpy(c[i].range, r->range, sizeof(c[i].range));
+        c[i].min_delay = r->min_delay;
+        if (r->flags & SENSOR_CONFIG_BLOB_PRIV_DATA)
+            c[i].priv_data = &r->priv_data;
+
+        s[i].name = blob_string(strings, r->sensor_name);
+        s[i].vendor = blob_string(strings, r->vendor);
+        s[i].version = r->version;
+        s[i].handle = r->sensor_handle;
+        s[i].type = r->type;
+        s[i].maxRange = r->max_range;
+        s[i].resolution = r->resolution;
+        s[i].power = r->power;
+        s[i].minDelay = r->min_delay_us;
+    }
+
+    blob->map = map;
+    blob->size = st.st_size;
+    *configs = c;
+    *list = s;
+    *count = header->count;
+    return 0;
+}
+
+void sensor_config_blob_release(struct sensor_config_blob *blob)
+{
+    if (blob->map)
+        munmap(blob->map, blob->size);
+    blob->map = NULL;
+    blob->size = 0;
+}
+
+/*
+ * Append str to the string table in buf unless an identical string is
+ * already there, return its offset or 0 for NULL
+ */
+static uint32_t blob_add_string(char *buf, uint32_t *size, const char *str)
+{
+    uint32_t offset = 1;
+    size_t len;
+
+    if (!str)
+        return 0;
+
+    while (offset < *size) {
+        if (!strcmp(buf + offset, str))
+            return offset;
+        offset += strlen(buf + offset) + 1;
+    }
+
+    len = strlen(str) + 1;
+    memcpy(buf + *size, str, len);
+    offset = *size;
+    *size += len;
+    return offset;
+}
+
+static size_t blob_string_len(const char *str)
+{
+    return str ? strlen(str) + 1 : 0;
+}
+
+int sensor_config_blob_write(const char *file, const char *xml_file,
+                             const sensor_platform_config_t *configs,
+                             const struct sensor_t *list, int count)
+{
+    struct sensor_config_blob_header header;
+    struct sensor_config_blob_sensor *records;
+    char *strings;
+    uint32_t strings_size = 1;
+    size_t max_strings = 1;
+    FILE *fp;
+    int i, ret = -1;
+
+    for (i = 0; i < count; i++) {
+        max_strings += blob_string_len(configs[i].name) +
+                       blob_string_len(configs[i].activate_path) +
+                       blob_string_len(configs[i].poll_path) +
+                       blob_string_len(configs[i].data_path) +
+                       blob_string_len(configs[i].config_path) +
+                       blob_string_len(list[i].name) +
+                       blob_string_len(list[i].vendor);
+    }
+
+    records = (struct sensor_config_blob_sensor *)calloc(count, sizeof(*records));
+    strings = (char *)calloc(1, max_strings);
+    if (!records || !strings) {
+        E("malloc error!\n");
+        goto out;
+    }
+
+    for (i = 0; i < count; i++) {
+        struct sensor_config_blob_sensor *r = records + i;
+
+        r->handle = configs[i].handle;
+        r->name = blob_add_string(strings, &strings_size, configs[i].name);
+        r->activate_path = blob_add_string(strings, &strings_size, configs[i].activate_path);
+        r->poll_path = blob_add_string(strings, &strings_size, configs[i].poll_path);
+        r->data_path = blob_add_string(strings, &strings_size, configs[i].data_path);
+        r->config_path = blob_add_string(strings, &strings_size, configs[i].config_path);
+        memcpy(r->mapper, configs[i].mapper, sizeof(r->mapper));
+        memcpy(r->scale, configs[i].scale, sizeof(r->scale));
+        memcpy(r->range, configs[i].range, sizeof(r->range));
+        r->min_delay = configs[i].min_delay;
+        if (configs[i].priv_data) {
+            r->flags |= SENSOR_CONFIG_BLOB_PRIV_DATA;
+            r->priv_data = *configs[i].priv_data;
+        }
+
+        r->sensor_name = blob_add_string(strings, &strings_size, list[i].name);
+        r->vendor = blob_add_string(strings, &strings_size, list[i].vendor);
+        r->version = list[i].version;
+        r->sensor_handle = list[i].handle;
+        r->type = list[i].type;
+        r->max_range = list[i].maxRange;
+        r->resolution = list[i].resolution;
+        r->power = list[i].power;
+        r->min_delay_us = list[i].minDelay;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic = SENSOR_CONFIG_BLOB_MAGIC;
+    header.version = SENSOR_CONFIG_BLOB_VERSION;
+    header.count = count;
+    header.record_size = sizeof(struct sensor_config_blob_sensor);
+    header.records_offset = sizeof(header);
+    header.strings_offset = header.records_offset + count * header.record_size;
+    header.strings_size = strings_size;
+    header.size = header.strings_offset + header.strings_size;
+    if (config_source_stamp_get(xml_file, &header.source)) {
+        E("%s: cannot read %s: %s\n", __func__, xml_file, strerror(errno));
+        goto out;
+    }
+
+    fp = fopen(file, "wb");
+    if (!fp) {
+        E("%s: cannot create %s: %s\n", __func__, file, strerror(errno));
+        goto out;
+    }
+
+    if (fwrite(&header, sizeof(header), 1, fp) == 1 &&
+        (count == 0 || fwrite(records, header.record_size, count, fp) == (size_t)count) &&
+        fwrite(strings, 1, strings_size, fp) == strings_size)
+        ret = 0;
+    if (fclose(fp))
+        ret = -1;
+    if (ret) {
+        E("%s: write %s error\n", __func__, file);
+        unlink(file);
+    }
+
+out:
+    free(records);
+    free(strings);
+    return ret;
+}
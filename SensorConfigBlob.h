@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_CONFIG_BLOB_H
+#define ANDROID_SENSOR_CONFIG_BLOB_H
+
+#include "sensors.h"
+#include "ConfigSourceStamp.h"
+
+/*
+ * Precompiled form of sensor_hal_config_*.xml of the legacy board configs,
+ * produced at build time by the host build of config.cpp and installed next
+ * to the XML as sensor_hal_config_*.bin. The HAL maps it read-only; paths and
+ * names in sensor_platform_config_t and sensor_t point straight into the
+ * mapping, so nothing is parsed or copied at HAL open. The header records
+ * the XML the blob was compiled from, and a blob whose XML has changed
+ * since is not loaded.
+ *
+ * Layout: header, count records, string table. Strings are referenced by
+ * offset into the string table, offset 0 stands for NULL.
+ */
+#define SENSOR_CONFIG_BLOB_MAGIC        0x42434c53      /* "SLCB" */
+#define SENSOR_CONFIG_BLOB_VERSION      2
+
+struct sensor_config_blob_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;              /* whole blob in bytes */
+    uint32_t count;             /* sensor records */
+    uint32_t record_size;
+    uint32_t records_offset;
+    uint32_t strings_offset;
+    uint32_t strings_size;
+    struct config_source_stamp source;  /* of the XML compiled */
+};
+
+#define SENSOR_CONFIG_BLOB_PRIV_DATA    (1 << 0)
+
+struct sensor_config_blob_sensor {
+    /* sensor_platform_config_t */
+    int32_t handle;
+    uint32_t name;
+    uint32_t activate_path;
+    uint32_t poll_path;
+    uint32_t data_path;
+    uint32_t config_path;
+    int32_t mapper[3];
+    float scale[3];
+    float range[2];
+    int32_t min_delay;
+    uint32_t flags;
+    union sensor_data_t priv_data;
+    /* sensor_t */
+    uint32_t sensor_name;
+    uint32_t vendor;
+    int32_t version;
+    int32_t sensor_handle;
+    int32_t type;
+    float max_range;
+    float resolution;
+    float power;
+    int32_t min_delay_us;
+};
+
+struct sensor_config_blob {
+    void *map;
+    size_t size;
+};
+
+/*
+ * Map file and build count entries of configs and list from it, both arrays
+ * are malloced, strings stay in the mapping until sensor_config_blob_release()
+ * return 0 on success, -1 if there is no valid blob or xml_file changed
+ */
+int sensor_config_blob_load(const char *file, const char *xml_file,
+                            struct sensor_config_blob *blob,
+                            sensor_platform_config_t **configs,
+                            struct sensor_t **list, int *count);
+void sensor_config_blob_release(struct sensor_config_blob *blob);
+
+/* write count entries of configs and list compiled from xml_file to file, return 0 on success */
+int sensor_config_blob_write(const char *file, const char *xml_file,
+                             const sensor_platform_config_t *configs,
+                             const struct sensor_t *list, int count);
+
+#endif  // ANDROID_SENSOR_CONFIG_BLOB_H
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "sensors.h"
+#include "SensorFusion.h"
+
+#define FUSION_KP               1.0f        /* proportional gain of the correction */
+#define FUSION_KI               0.02f       /* integral gain, tracks the gyroscope bias */
+#define FUSION_MAX_BIAS         0.2f        /* rad/s, bound of the integral term */
+#define FUSION_MAX_DT           0.2f        /* s, longer gyroscope gaps are not integrated */
+#define FUSION_ACCEL_MIN        (0.8f * GRAVITY)
+#define FUSION_ACCEL_MAX        (1.2f * GRAVITY)
+#define FUSION_MAG_MIN          10.0f       /* uT */
+#define FUSION_MAG_MAX          100.0f
+#define RAD_TO_DEG              (180.0f / (float)M_PI)
+
+static inline float dot3(const float *a, const float *b)
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static inline void cross3(const float *a, const float *b, float *r)
+{
+    r[0] = a[1] * b[2] - a[2] * b[1];
+    r[1] = a[2] * b[0] - a[0] * b[2];
+    r[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+/* Returns the norm before normalization, v is left alone when it is 0 */
+static inline float normalize3(float *v)
+{
+    float n = sqrtf(dot3(v, v));
+
+    if (n > 0) {
+        float inv = 1.0f / n;
+        v[0] *= inv;
+        v[1] *= inv;
+        v[2] *= inv;
+    }
+    return n;
+}
+
+SensorFusion::SensorFusion()
+{
+    reset(false);
+}
+
+void SensorFusion::reset(bool useMag)
+{
+    memset(&mState, 0, sizeof(mState));
+    mState.q[0] = 1.0f;
+    mGyroTime = 0;
+    mHasAccel = false;
+    mHasMag = false;
+    mInitialized = false;
+    mUseMag = useMag;
+}
+
+void SensorFusion::handleAccel(const float *accel)
+{
+    memcpy(mState.accel, accel, 3 * sizeof(float));
+    mHasAccel = true;
+}
+
+void SensorFusion::handleMag(const float *mag)
+{
+    memcpy(mState.mag, mag, 3 * sizeof(float));
+    mHasMag = true;
+}
+
+void SensorFusion::rotationMatrix(float R[3][3]) const
+{
+    const float *q = mState.q;
+    float xx = q[1] * q[1], yy = q[2] * q[2], zz = q[3] * q[3];
+    float xy = q[1] * q[2], xz = q[1] * q[3], yz = q[2] * q[3];
+    float wx = q[0] * q[1], wy = q[0] * q[2], wz = q[0] * q[3];
+
+    R[0][0] = 1 - 2 * (yy + zz);
+    R[0][1] = 2 * (xy - wz);
+    R[0][2] = 2 * (xz + wy);
+    R[1][0] = 2 * (xy + wz);
+    R[1][1] = 1 - 2 * (xx + zz);
+    R[1][2] = 2 * (yz - wx);
+    R[2][0] = 2 * (xz - wy);
+    R[2][1] = 2 * (yz + wx);
+    R[2][2] = 1 - 2 * (xx + yy);
+}
+
+/* Attitude straight from gravity and, if used, magnetic north */
+void SensorFusion::initialize()
+{
+    float R[3][3], ref[3] = { 0, 1, 0 };
+    float *east = R[0], *north = R[1], *up = R[2];
+    float *q = mState.q;
+    float t, s;
+
+    memcpy(up, mState.accel, sizeof(R[2]));
+    normalize3(up);
+
+    /* Without a compass the device y axis defines north */
+    cross3(mUseMag ? mState.mag : ref, up, east);
+    if (normalize3(east) < 0.1f) {
+        ref[0] = 1;
+        ref[1] = 0;
+        cross3(up, ref, east);
+        normalize3(east);
+    }
+    cross3(up, east, north);
+
+    t = R[0][0] + R[1][1] + R[2][2];
+    if (t > 0) {
+        s = 2.0f * sqrtf(t + 1.0f);
+        q[0] = 0.25f * s;
+        q[1] = (R[2][1] - R[1][2]) / s;
+        q[2] = (R[0][2] - R[2][0]) / s;
+        q[3] = (R[1][0] - R[0][1]) / s;
+    } else if (R[0][0] > R[1][1] && R[0][0] > R[2][2]) {
+        s = 2.0f * sqrtf(1.0f + R[0][0] - R[1][1] - R[2][2]);
+        q[0] = (R[2][1] - R[1][2]) / s;
+        q[1] = 0.25f * s;
+        q[2] = (R[0][1] + R[1][0]) / s;
+        q[3] = (R[0][2] + R[2][0]) / s;
+    } else if (R[1][1] > R[2][2]) {
+        s = 2.0f * sqrtf(1.0f + R[1][1] - R[0][0] - R[2][2]);
+        q[0] = (R[0][2] - R[2][0]) / s;
+        q[1] = (R[0][1] + R[1][0]) / s;
+        q[2] = 0.25f * s;
+        q[3] = (R[1][2] + R[2][1]) / s;
+    } else {
+        s = 2.0f * sqrtf(1.0f + R[2][2] - R[0][0] - R[1][1]);
+        q[0] = (R[1][0] - R[0][1]) / s;
+        q[1] = (R[0][2] + R[2][0]) / s;
+        q[2] = (R[1][2] + R[2][1]) / s;
+        q[3] = 0.25f * s;
+    }
+
+    mInitialized = true;
+}
+
+bool SensorFusion::handleGyro(const float *gyro, int64_t timestamp)
+{
+    float R[3][3], e[3] = { 0, 0, 0 }, w[3], v[3], a[3], m[3];
+    float *q = mState.q;
+    float dt, n;
+    int i;
+
+    if (!mInitialized) {
+        if (!mHasAccel || (mUseMag && !mHasMag))
+            return false;
+        initialize();
+        mGyroTime = timestamp;
+        return true;
+    }
+
+    dt = (timestamp - mGyroTime) * 1e-9f;
+    mGyroTime = timestamp;
+    if (dt <= 0 || dt > FUSION_MAX_DT)
+        return false;
+
+    rotationMatrix(R);
+
+    /* Measured minus estimated direction of up, in device coordinates */
+    memcpy(a, mState.accel, sizeof(a));
+    n = normalize3(a);
+    if (n > FUSION_ACCEL_MIN && n < FUSION_ACCEL_MAX)
+        cross3(a, R[2], e);
+
+    if (mUseMag) {
+        memcpy(m, mState.mag, sizeof(m));
+        n = normalize3(m);
+        if (n > FUSION_MAG_MIN && n < FUSION_MAG_MAX) {
+            /* Expected field: the measured one turned towards north, in device coordinates */
+            float hx = dot3(R[0], m), hy = dot3(R[1], m), hz = dot3(R[2], m);
+            float bn = sqrtf(hx * hx + hy * hy);
+            for (i = 0; i < 3; i++)
+                w[i] = bn * R[1][i] + hz * R[2][i];
+            cross3(m, w, v);
+            /* heading only */
+            n = dot3(v, R[2]);
+            for (i = 0; i < 3; i++)
+                e[i] += n * R[2][i];
+        }
+    }
+
+    for (i = 0; i < 3; i++) {
+        mState.bias[i] += FUSION_KI * e[i] * dt;
+        if (mState.bias[i] > FUSION_MAX_BIAS)
+            mState.bias[i] = FUSION_MAX_BIAS;
+        else if (mState.bias[i] < -FUSION_MAX_BIAS)
+            mState.bias[i] = -FUSION_MAX_BIAS;
+        w[i] = (gyro[i] + FUSION_KP * e[i] + mState.bias[i]) * 0.5f * dt;
+    }
+
+    /* q += q * (0, w) */
+    float qw = q[0], qx = q[1], qy = q[2], qz = q[3];
+    q[0] += -qx * w[0] - qy * w[1] - qz * w[2];
+    q[1] +=  qw * w[0] + qy * w[2] - qz * w[1];
+    q[2] +=  qw * w[1] - qx * w[2] + qz * w[0];
+    q[3] +=  qw * w[2] + qx * w[1] - qy * w[0];
+
+    n = 1.0f / sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    for (i = 0; i < 4; i++)
+        q[i] *= n;
+
+    return true;
+}
+
+void SensorFusion::getRotationVector(float *v) const
+{
+    const float *q = mState.q;
+    float sign = q[0] < 0 ? -1.0f : 1.0f;
+
+    v[0] = sign * q[1];
+    v[1] = sign * q[2];
+    v[2] = sign * q[3];
+    v[3] = sign * q[0];
+}
+
+void SensorFusion::getOrientation(float *v) const
+{
+    float R[3][3];
+
+    rotationMatrix(R);
+    v[0] = atan2f(-R[1][0], R[0][0]) * RAD_TO_DEG;
+    if (v[0] < 0)
+        v[0] += 360.0f;
+    v[1] = atan2f(-R[2][1], R[2][2]) * RAD_TO_DEG;
+    v[2] = asinf(R[2][0] < -1.0f ? -1.0f : (R[2][0] > 1.0f ? 1.0f : R[2][0])) * RAD_TO_DEG;
+}
+
+void SensorFusion::getGravity(float *v) const
+{
+    const float *q = mState.q;
+
+    /* World up in device coordinates */
+    v[0] = GRAVITY * 2 * (q[1] * q[3] - q[0] * q[2]);
+    v[1] = GRAVITY * 2 * (q[2] * q[3] + q[0] * q[1]);
+    v[2] = GRAVITY * (1 - 2 * (q[1] * q[1] + q[2] * q[2]));
+}
+
+void SensorFusion::getLinearAcceleration(float *v) const
+{
+    float g[3];
+
+    getGravity(g);
+    v[0] = mState.accel[0] - g[0];
+    v[1] = mState.accel[1] - g[1];
+    v[2] = mState.accel[2] - g[2];
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SENSOR_FUSION_H
+#define ANDROID_SENSOR_FUSION_H
+
+#include <stdint.h>
+
+/*
+ * Attitude estimation for boards without a sensor hub, fed with the events
+ * of the raw accelerometer, gyroscope and compass sensors.
+ *
+ * Quaternion complementary filter (Mahony): the gyroscope is integrated and
+ * the drift is pulled back towards the gravity measured by the accelerometer
+ * and, when a compass is present, towards magnetic north. The correction has
+ * a proportional term and an integral term that tracks the gyroscope bias.
+ * The magnetic correction is restricted to the vertical axis, so magnetic
+ * disturbances never tilt the estimate. Accelerometer samples far from 1 g
+ * are not used for correction.
+ *
+ * The state is a fixed set of 16 byte aligned float[4] vectors; updates do
+ * not allocate. The attitude q rotates device coordinates into the world
+ * frame (x east, y north, z up) used by the Android rotation vector.
+ */
+class SensorFusion
+{
+    struct state_t {
+        float q[4];         /* w, x, y, z */
+        float bias[4];      /* integral correction of the gyroscope, rad/s */
+        float accel[4];     /* last accelerometer sample, m/s^2 */
+        float mag[4];       /* last compass sample, uT */
+    } __attribute__((aligned(16)));
+
+    state_t mState;
+    int64_t mGyroTime;
+    bool mHasAccel;
+    bool mHasMag;
+    bool mInitialized;
+    bool mUseMag;
+
+    void initialize();
+    void rotationMatrix(float R[3][3]) const;
+
+public:
+    SensorFusion();
+
+    /* Restart from the next samples, useMag selects 9 or 6 axis fusion */
+    void reset(bool useMag);
+
+    void handleAccel(const float *accel);
+    void handleMag(const float *mag);
+    /* Returns true when the attitude moved to timestamp */
+    bool handleGyro(const float *gyro, int64_t timestamp);
+
+    bool isReady() const { return mInitialized; }
+
+    /* x, y, z, w of the attitude, w >= 0 */
+    void getRotationVector(float *v) const;
+    /* azimuth, pitch, roll in degrees, as the orientation sensor */
+    void getOrientation(float *v) const;
+    void getGravity(float *v) const;
+    void getLinearAcceleration(float *v) const;
+};
+
+#endif  // ANDROID_SENSOR_FUSION_H
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <utils/Log.h>
+
+#include "SysfsControl.h"
+
+SysfsControl::SysfsControl(bool cached)
+    : mPathSet(NULL), mFd(-1), mCached(cached), mHasValue(false), mValue(0)
+{ }
+
+SysfsControl::~SysfsControl()
+{
+    if (mFd >= 0)
+        close(mFd);
+    free(mPathSet);
+}
+
+void SysfsControl::setPath(const char *pathset)
+{
+    if (mFd >= 0)
+        close(mFd);
+    mFd = -1;
+    mHasValue = false;
+    free(mPathSet);
+    mPathSet = pathset && pathset[0] ? strdup(pathset) : NULL;
+}
+
+int SysfsControl::resolve()
+{
+    const char *start, *end;
+    char path[PATH_MAX];
+    size_t len;
+
+    if (mFd >= 0 || mPathSet == NULL)
+        return mFd;
+
+    for (start = mPathSet; *start; start = *end ? end + 1 : end) {
+        end = strchr(start, ';');
+        if (end == NULL)
+            end = start + strlen(start);
+
+        while (start < end && isspace(*start))
+            start++;
+        len = end - start;
+        while (len > 0 && isspace(start[len - 1]))
+            len--;
+        if (len == 0 || len >= sizeof(path))
+            continue;
+
+        memcpy(path, start, len);
+        path[len] = '\0';
+        mFd = open(path, O_WRONLY | O_CLOEXEC);
+        if (mFd >= 0) {
+            LOGI("Sensor HAL: Open file %s", path);
+            break;
+        }
+    }
+
+    return mFd;
+}
+
+int SysfsControl::write(int64_t value)
+{
+    char buf[24];
+    int len;
+
+    if (mCached && mHasValue && mValue == value)
+        return 0;
+
+    if (resolve() < 0) {
+        LOGE("%s: cannot open %s", __FUNCTION__, getPath());
+        return -1;
+    }
+
+    /* Drivers parse up to the terminating NUL, which is written as before */
+    len = snprintf(buf, sizeof(buf), "%lld", (long long)value) + 1;
+    if (pwrite(mFd, buf, len, 0) != len) {
+        LOGE("%s: write %s to %s error: %s", __FUNCTION__, buf, getPath(), strerror(errno));
+        close(mFd);
+        mFd = -1;
+        mHasValue = false;
+        return -1;
+    }
+
+    mValue = value;
+    mHasValue = true;
+    return 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SYSFS_CONTROL_H
+#define ANDROID_SYSFS_CONTROL_H
+
+#include <stdint.h>
+
+/*
+ * Write side of a driver control node such as enable or poll_delay, shared
+ * by the legacy (SensorBase) and the scalability (InputEventSensor) sensors.
+ *
+ * The path set is a ';' separated list of candidates; the first one that
+ * opens is kept open for the life of the control. Values are formatted on
+ * the stack and written with pwrite(). A failed write closes the node and
+ * the next write resolves the path set again.
+ *
+ * A cached control remembers the last value, so writing it again costs
+ * nothing. Only nodes no one but this control changes may be cached: the
+ * driver resets poll_delay by itself (on enable, on resume) and several
+ * sensors may share one node, those have to be written through.
+ */
+class SysfsControl
+{
+    char *mPathSet;
+    int mFd;
+    bool mCached;
+    bool mHasValue;
+    int64_t mValue;
+
+    SysfsControl(const SysfsControl &);
+    SysfsControl &operator=(const SysfsControl &);
+
+public:
+    explicit SysfsControl(bool cached = true);
+    ~SysfsControl();
+
+    void setPath(const char *pathset);
+    const char *getPath() const { return mPathSet ? mPathSet : ""; }
+
+    /* Open the node if needed, returns its fd or -1 */
+    int resolve();
+
+    /* Write value as a decimal string, returns 0 or -1 */
+    int write(int64_t value);
+
+    /* Forget the last value, so the next write reaches the driver */
+    void invalidate() { mHasValue = false; }
+};
+
+#endif  // ANDROID_SYSFS_CONTROL_H
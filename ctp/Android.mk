@@ -29,8 +29,15 @@ LOCAL_MODULE_TAGS := optional
 LOCAL_CFLAGS := -DLOG_TAG=\"Sensors\"
 LOCAL_SRC_FILES := config.cpp                   \
                    ../InputEventReader.cpp      \
+                   ../EventLoop.cpp               \
+                   ../InputDeviceIndex.cpp        \
+                   ../SysfsControl.cpp            \
                    ../sensors.cpp               \
-                   ../SensorBase.cpp
+                   ../SensorBase.cpp            \
+                   ../SensorFusion.cpp          \
+                   ../FusionSensor.cpp          \
+                   ../SensorConfigBlob.cpp      \
+                   ../ConfigSourceStamp.cpp
 
 LOCAL_SRC_FILES +=  ../AccelSensor.cpp          \
                     ../LightSensor.cpp          \
@@ -50,6 +57,26 @@ LOCAL_PRELINK_MODULE := false
 
 include $(BUILD_SHARED_LIBRARY)
 
+# Build-time compiler of sensor_hal_config_*.xml into the binary config
+# the HAL maps at open, see SensorConfigBlob.h
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := sensor_hal_config_compiler
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -DLOG_TAG=\"SensorConfigCompiler\" -DSENSOR_CONFIG_COMPILER
+LOCAL_SRC_FILES := config.cpp                   \
+                   ../SensorConfigBlob.cpp      \
+                   ../ConfigSourceStamp.cpp
+
+LOCAL_C_INCLUDES := $(COMMON_INCLUDES) \
+                    $(call include-path-for, libxml2)
+LOCAL_STATIC_LIBRARIES := libxml2 libcutils liblog
+
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(LOCAL_PATH)/../sensor_hal_config.mk
+
 endif # !TARGET_SIMULATOR
 
 endif
@@ -4,7 +4,9 @@ ifeq ($(USE_GENERAL_SENSOR_DRIVER),true)
 LOCAL_PATH := $(call my-dir)
 
 include $(CLEAR_VARS)
-LOCAL_SRC_FILES := sensor_parser.c
+LOCAL_SRC_FILES := sensor_parser.c \
+                sensor_image.c \
+                sensor_sim.c
 LOCAL_C_INCLUDES +=  $(COMMON_INCLUDES) \
                 $(call include-path-for, icu4c-common) \
                 $(call include-path-for, libxml2)
@@ -17,6 +19,8 @@ include $(BUILD_HOST_EXECUTABLE)
 
 #XML driver config for each platform
 SENSOR_DRIVER_XML := $(DEVICE_CONF_PATH)/sensors/sensor_driver_config.xml
+#Image layout, set 2 for compact image once the driver loads it
+SENSOR_CONFIG_IMAGE_VERSION ?= 1
 
 include $(CLEAR_VARS)
 LOCAL_MODULE := sensor_config.bin
@@ -27,6 +31,6 @@ include $(BUILD_SYSTEM)/base_rules.mk
 $(LOCAL_BUILT_MODULE): sensor_parser
 	@echo "Generating Sensor Driver Firmware image..."
 	$(hide)mkdir -p $(dir $@)
-	$(hide)sensor_parser -p -x $(SENSOR_DRIVER_XML) -f $@
+	$(hide)sensor_parser -p -i $(SENSOR_CONFIG_IMAGE_VERSION) -x $(SENSOR_DRIVER_XML) -f $@
 
 endif # USE_GENERAL_SENSOR_DRIVER
@@ -287,6 +287,7 @@ struct sensor_config {
 * @num:how many sensor config in this image
 * @configs:sensor config array of all supported sensors
 */
+#define SENSOR_CONFIG_IMAGE_MAGIC	0x1234
 struct sensor_config_image {
 	__u32 magic;
 	__u32 flags;
@@ -296,6 +297,99 @@ struct sensor_config_image {
 	__u32 configs;
 };
 
+/* Compact sensor config, version 2
+* Same basic info as sensor_config, but odr, range and sysfs tables
+* only take their valid entries, and all indexs refer to the shared
+* action pool of the image instead of a per config action table
+*
+* @size: config size including the variable tables
+* @odr_entries/@range_entries/@sysfs_entries: entries in tables
+* @tables: odr_table[odr_entries], range_table[range_entries],
+*	sysfs_table[sysfs_entries] follow in that order
+*/
+struct sensor_config_v2 {
+	__u16 size;
+
+	__u8 i2c_bus;
+	__u8 test_reg_addr;
+	__u8 i2c_addrs[MAX_I2C_ADDRS];
+	__u8 id[MAX_DEV_IDS];
+	__u8 name[MAX_DEV_NAME_BYTES];
+	__u8 input_name[MAX_DEV_NAME_BYTES];
+	__u8 attr_name[MAX_DEV_NAME_BYTES];
+	__u8 id_reg_addr;
+	__u8 id_reg_flag;
+	__u8 sensor_regs;
+	__u8 event_type;
+
+	__u32 method;
+	__s32 default_poll_interval;
+	__s32 min_poll_interval;
+	__s32 max_poll_interval;
+	__s32 gpio_num;
+	__s32 report_cnt;
+	__s32 report_interval;
+	__u32 irq_flag;
+
+	__s32 shared_nums;
+	__s32 irq_serialize;
+	__s32 default_range;
+
+	__u8 odr_entries;
+	__u8 range_entries;
+	__u8 sysfs_entries;
+	__u8 pad;
+
+	struct lowlevel_action_index indexs[SENSOR_ACTION_RESERVE];
+	__u8 tables[0];
+}__attribute__ ((packed));
+
+/* sensor config image, version 2
+* @magic: SENSOR_CONFIG_IMAGE_V2_MAGIC, never matches version 1
+* @header_size: offset of the first config
+* @size: whole image size
+* @checksum: crc32 (as zlib computes it) of the whole image,
+*		taken with this field set to 0
+* @pool_offset: offset of the shared lowlevel action pool
+* @pool_num: actions in the pool, identical action sequences
+*		of all sensors are stored once
+*/
+#define SENSOR_CONFIG_IMAGE_V2_MAGIC	0x32434753
+#define SENSOR_CONFIG_IMAGE_VERSION	2
+struct sensor_config_image_v2 {
+	__u32 magic;
+	__u16 version;
+	__u16 header_size;
+	__u32 size;
+	__u32 checksum;
+	__u32 flags;
+	__u32 dbg_sensors;
+	__u32 dbg_level;
+	__s32 num;
+	__u32 pool_offset;
+	__u32 pool_num;
+	__u8 configs[0];
+}__attribute__ ((packed));
+
+static inline struct odr *sensor_config_v2_odr(struct sensor_config_v2 *config)
+{
+	return (struct odr *)config->tables;
+}
+
+static inline struct range_setting *
+sensor_config_v2_range(struct sensor_config_v2 *config)
+{
+	return (struct range_setting *)
+		(sensor_config_v2_odr(config) + config->odr_entries);
+}
+
+static inline struct sysfs_entry *
+sensor_config_v2_sysfs(struct sensor_config_v2 *config)
+{
+	return (struct sysfs_entry *)
+		(sensor_config_v2_range(config) + config->range_entries);
+}
+
 #define DATA_STACK_MAX_SIZE	0x20
 #define PRIVATE_MAX_SIZE	0x20
 
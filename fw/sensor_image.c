@@ -0,0 +1,449 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Reader and writer of sensor config image version 2
+ * Variable length tables and one deduplicated action pool
+ * shared by all sensors of the image
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <linux/types.h>
+#include <string.h>
+#include "sensor_driver_config.h"
+#include "sensor_image.h"
+
+/*basic info of sensor_config_v2 is laid out as in sensor_config*/
+#define SENSOR_CONFIG_BASIC_SIZE	offsetof(struct sensor_config, odr_entries)
+typedef char sensor_config_v2_layout[
+	offsetof(struct sensor_config_v2, default_range) ==
+	SENSOR_CONFIG_BASIC_SIZE ? 1 : -1];
+
+/*action table of a version 1 config*/
+#define SENSOR_CONFIG_ACTIONS(config)	\
+	((struct lowlevel_action *)&(config)->actions)
+#define SENSOR_CONFIG_V1_SIZE(num)	\
+	(offsetof(struct sensor_config, actions) + \
+	(num) * sizeof(struct lowlevel_action))
+
+/*all action sequences of all sensors refer to the pool by index*/
+#define MAX_POOL_ACTIONS		0xffff
+#define MAX_INDEXS_PER_CONFIG		(SENSOR_ACTION_RESERVE + \
+	MAX_ODR_SETTING_ENTRIES + MAX_RANGES + 2 * MAX_SYSFS_ENTRIES)
+
+struct image_ref {
+	struct lowlevel_action_index *index;
+	struct lowlevel_action *src;
+	int num;
+};
+
+__u32 sensor_image_crc32(__u32 crc, const void *buf, int len)
+{
+	static __u32 table[256];
+	const __u8 *p = buf;
+	int i, j;
+
+	if (!table[1]) {
+		for (i = 0; i < 256; i++) {
+			__u32 c = i;
+
+			for (j = 0; j < 8; j++)
+				c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+			table[i] = c;
+		}
+	}
+
+	crc = ~crc;
+	while (len-- > 0)
+		crc = table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+static void add_ref(struct image_ref *refs, int *num,
+		struct lowlevel_action_index *index,
+		struct lowlevel_action *table)
+{
+	refs[*num].index = index;
+	refs[*num].src = &table[index->index];
+	refs[*num].num = index->num;
+	(*num)++;
+}
+
+/*longest first, so shorter sequences can be found inside them*/
+static int ref_cmp(const void *a, const void *b)
+{
+	return ((const struct image_ref *)b)->num -
+		((const struct image_ref *)a)->num;
+}
+
+int sensor_image_v2_write(const char *v1, int v1_size,
+				char *out, int out_size)
+{
+	const struct sensor_config_image *image =
+			(const struct sensor_config_image *)v1;
+	struct sensor_config_image_v2 *image2 =
+			(struct sensor_config_image_v2 *)out;
+	struct sensor_config *config;
+	struct lowlevel_action *pool;
+	struct image_ref *refs = NULL;
+	int ref_num = 0;
+	int pool_num = 0;
+	int pos;
+	int i, j;
+
+	if (v1_size < (int)offsetof(struct sensor_config_image, configs) ||
+		image->magic != SENSOR_CONFIG_IMAGE_MAGIC ||
+		out_size < (int)sizeof(*image2)) {
+		printf("[%d]%s Error wrong version 1 image\n",
+					__LINE__, __func__);
+		return -1;
+	}
+
+	refs = malloc(sizeof(*refs) * MAX_INDEXS_PER_CONFIG *
+				(image->num > 0 ? image->num : 1));
+	if (!refs) {
+		printf("[%d]%s Error\n", __LINE__, __func__);
+		return -1;
+	}
+
+	memset(image2, 0, sizeof(*image2));
+	image2->magic = SENSOR_CONFIG_IMAGE_V2_MAGIC;
+	image2->version = SENSOR_CONFIG_IMAGE_VERSION;
+	image2->header_size = sizeof(*image2);
+	image2->flags = image->flags;
+	image2->dbg_sensors = image->dbg_sensors;
+	image2->dbg_level = image->dbg_level;
+	image2->num = image->num;
+	pos = sizeof(*image2);
+
+	config = (struct sensor_config *)&image->configs;
+	for (i = 0; i < image->num; i++)
+	{
+		struct sensor_config_v2 *config2;
+		struct lowlevel_action *table = SENSOR_CONFIG_ACTIONS(config);
+		struct sysfs_entry *sysfs;
+		int len;
+
+		if ((char *)config + config->size > v1 + v1_size ||
+			config->odr_entries > MAX_ODR_SETTING_ENTRIES ||
+			config->range_entries > MAX_RANGES ||
+			config->sysfs_entries > MAX_SYSFS_ENTRIES) {
+			printf("[%d]%s Error wrong config %d\n",
+					__LINE__, __func__, i);
+			goto err;
+		}
+
+		len = sizeof(*config2) +
+			config->odr_entries * sizeof(struct odr) +
+			config->range_entries * sizeof(struct range_setting) +
+			config->sysfs_entries * sizeof(struct sysfs_entry);
+		if (pos + len > out_size)
+			goto err_size;
+
+		config2 = (struct sensor_config_v2 *)(out + pos);
+		memcpy(config2, config, SENSOR_CONFIG_BASIC_SIZE);
+		config2->size = len;
+		config2->default_range = config->default_range;
+		config2->odr_entries = config->odr_entries;
+		config2->range_entries = config->range_entries;
+		config2->sysfs_entries = config->sysfs_entries;
+		config2->pad = 0;
+		memcpy(config2->indexs, config->indexs, sizeof(config->indexs));
+		memcpy(sensor_config_v2_odr(config2), config->odr_table,
+			config->odr_entries * sizeof(struct odr));
+		memcpy(sensor_config_v2_range(config2), config->range_table,
+			config->range_entries * sizeof(struct range_setting));
+		memcpy(sensor_config_v2_sysfs(config2), config->sysfs_table,
+			config->sysfs_entries * sizeof(struct sysfs_entry));
+
+		for (j = 0; j < SENSOR_ACTION_RESERVE; j++)
+			add_ref(refs, &ref_num, &config2->indexs[j], table);
+		for (j = 0; j < config2->odr_entries; j++)
+			add_ref(refs, &ref_num,
+				&sensor_config_v2_odr(config2)[j].index, table);
+		for (j = 0; j < config2->range_entries; j++)
+			add_ref(refs, &ref_num,
+				&sensor_config_v2_range(config2)[j].index, table);
+
+		sysfs = sensor_config_v2_sysfs(config2);
+		for (j = 0; j < config2->sysfs_entries; j++) {
+			if (sysfs[j].type != DATA_ACTION)
+				continue;
+			add_ref(refs, &ref_num,
+				&sysfs[j].action.data.index_show, table);
+			add_ref(refs, &ref_num,
+				&sysfs[j].action.data.index_store, table);
+		}
+
+		pos += len;
+		config = (struct sensor_config *)
+			((char *)config + config->size);
+	}
+
+	/*action sequences only use relative offsets, so any equal run can be shared*/
+	qsort(refs, ref_num, sizeof(*refs), ref_cmp);
+
+	pool = (struct lowlevel_action *)(out + pos);
+	for (i = 0; i < ref_num; i++)
+	{
+		int num = refs[i].num;
+		int start;
+
+		if (!num) {
+			refs[i].index->index = 0;
+			continue;
+		}
+
+		for (start = 0; start + num <= pool_num; start++)
+			if (!memcmp(&pool[start], refs[i].src,
+				num * sizeof(struct lowlevel_action)))
+				break;
+
+		if (start + num > pool_num) {
+			start = pool_num;
+			pool_num += num;
+			if (pool_num > MAX_POOL_ACTIONS || pos +
+				pool_num * (int)sizeof(struct lowlevel_action) > out_size)
+				goto err_size;
+			memcpy(&pool[start], refs[i].src,
+				num * sizeof(struct lowlevel_action));
+		}
+
+		refs[i].index->index = start;
+	}
+
+	image2->pool_offset = pos;
+	image2->pool_num = pool_num;
+	image2->size = pos + pool_num * sizeof(struct lowlevel_action);
+	image2->checksum = 0;
+	image2->checksum = sensor_image_crc32(0, out, image2->size);
+
+	free(refs);
+	return image2->size;
+
+err_size:
+	printf("[%d]%s Error image exceeds %d bytes\n",
+				__LINE__, __func__, out_size);
+err:
+	free(refs);
+	return -1;
+}
+
+static int index_valid(struct lowlevel_action_index *index, __u32 pool_num)
+{
+	return !index->num || index->index + index->num <= pool_num;
+}
+
+int sensor_image_v2_verify(const char *buf, int size)
+{
+	struct sensor_config_image_v2 image2;
+	struct sensor_config_v2 *config2;
+	__u32 pos;
+	int i, j;
+
+	if (size < (int)sizeof(image2)) {
+		printf("[%d]%s Error image too small %d\n",
+				__LINE__, __func__, size);
+		return -1;
+	}
+
+	memcpy(&image2, buf, sizeof(image2));
+	if (image2.magic != SENSOR_CONFIG_IMAGE_V2_MAGIC ||
+		image2.version != SENSOR_CONFIG_IMAGE_VERSION ||
+		image2.header_size < sizeof(image2) ||
+		image2.size > (__u32)size ||
+		image2.pool_offset > image2.size ||
+		image2.pool_num > (image2.size - image2.pool_offset) /
+				sizeof(struct lowlevel_action)) {
+		printf("[%d]%s Error wrong image header\n", __LINE__, __func__);
+		return -1;
+	}
+
+	/*checksum is taken with checksum field cleared*/
+	{
+		__u32 crc, zero = 0;
+
+		crc = sensor_image_crc32(0, buf,
+				offsetof(struct sensor_config_image_v2, checksum));
+		crc = sensor_image_crc32(crc, &zero, sizeof(zero));
+		crc = sensor_image_crc32(crc,
+			buf + offsetof(struct sensor_config_image_v2, flags),
+			image2.size - offsetof(struct sensor_config_image_v2, flags));
+		if (crc != image2.checksum) {
+			printf("[%d]%s Error checksum 0x%08x, expect 0x%08x\n",
+				__LINE__, __func__, crc, image2.checksum);
+			return -1;
+		}
+	}
+
+	pos = image2.header_size;
+	for (i = 0; i < image2.num; i++)
+	{
+		struct sysfs_entry *sysfs;
+
+		config2 = (struct sensor_config_v2 *)(buf + pos);
+		if (pos + sizeof(*config2) > image2.pool_offset ||
+			pos + config2->size > image2.pool_offset ||
+			config2->size != sizeof(*config2) +
+			config2->odr_entries * sizeof(struct odr) +
+			config2->range_entries * sizeof(struct range_setting) +
+			config2->sysfs_entries * sizeof(struct sysfs_entry) ||
+			config2->odr_entries > MAX_ODR_SETTING_ENTRIES ||
+			config2->range_entries > MAX_RANGES ||
+			config2->sysfs_entries > MAX_SYSFS_ENTRIES)
+			goto err;
+
+		for (j = 0; j < SENSOR_ACTION_RESERVE; j++)
+			if (!index_valid(&config2->indexs[j], image2.pool_num))
+				goto err;
+		for (j = 0; j < config2->odr_entries; j++)
+			if (!index_valid(&sensor_config_v2_odr(config2)[j].index,
+						image2.pool_num))
+				goto err;
+		for (j = 0; j < config2->range_entries; j++)
+			if (!index_valid(&sensor_config_v2_range(config2)[j].index,
+						image2.pool_num))
+				goto err;
+
+		sysfs = sensor_config_v2_sysfs(config2);
+		for (j = 0; j < config2->sysfs_entries; j++)
+			if (sysfs[j].type == DATA_ACTION &&
+				(!index_valid(&sysfs[j].action.data.index_show,
+						image2.pool_num) ||
+				!index_valid(&sysfs[j].action.data.index_store,
+						image2.pool_num)))
+				goto err;
+
+		pos += config2->size;
+	}
+
+	return 0;
+err:
+	printf("[%d]%s Error wrong config %d\n", __LINE__, __func__, i);
+	return -1;
+}
+
+/*copy one sequence out of the pool into a version 1 action table*/
+static void expand_index(struct lowlevel_action_index *index,
+		struct lowlevel_action *pool, struct lowlevel_action *table,
+		int *num)
+{
+	if (index->num)
+		memcpy(&table[*num], &pool[index->index],
+			index->num * sizeof(struct lowlevel_action));
+	index->index = *num;
+	*num += index->num;
+}
+
+int sensor_image_v2_expand(const char *buf, int size, char **v1)
+{
+	const struct sensor_config_image_v2 *image2 =
+			(const struct sensor_config_image_v2 *)buf;
+	struct lowlevel_action *pool =
+			(struct lowlevel_action *)(buf + image2->pool_offset);
+	struct sensor_config_image *image;
+	struct sensor_config_v2 *config2;
+	struct sensor_config *config;
+	char *out;
+	int out_size;
+	int i, j;
+
+	/*version 1 stores every sequence once per reference*/
+	out_size = offsetof(struct sensor_config_image, configs);
+	config2 = (struct sensor_config_v2 *)(buf + image2->header_size);
+	for (i = 0; i < image2->num; i++)
+	{
+		struct sysfs_entry *sysfs = sensor_config_v2_sysfs(config2);
+		int num = 0;
+
+		for (j = 0; j < SENSOR_ACTION_RESERVE; j++)
+			num += config2->indexs[j].num;
+		for (j = 0; j < config2->odr_entries; j++)
+			num += sensor_config_v2_odr(config2)[j].index.num;
+		for (j = 0; j < config2->range_entries; j++)
+			num += sensor_config_v2_range(config2)[j].index.num;
+		for (j = 0; j < config2->sysfs_entries; j++)
+			if (sysfs[j].type == DATA_ACTION)
+				num += sysfs[j].action.data.index_show.num +
+				sysfs[j].action.data.index_store.num;
+
+		out_size += SENSOR_CONFIG_V1_SIZE(num);
+		config2 = (struct sensor_config_v2 *)
+			((char *)config2 + config2->size);
+	}
+
+	out = malloc(out_size);
+	if (!out) {
+		printf("Fail to alloc memory %d\n", out_size);
+		return -1;
+	}
+	memset(out, 0, out_size);
+
+	image = (struct sensor_config_image *)out;
+	image->magic = SENSOR_CONFIG_IMAGE_MAGIC;
+	image->flags = image2->flags;
+	image->dbg_sensors = image2->dbg_sensors;
+	image->dbg_level = image2->dbg_level;
+	image->num = image2->num;
+
+	config = (struct sensor_config *)&image->configs;
+	config2 = (struct sensor_config_v2 *)(buf + image2->header_size);
+	for (i = 0; i < image2->num; i++)
+	{
+		struct lowlevel_action *table = SENSOR_CONFIG_ACTIONS(config);
+		int num = 0;
+
+		memcpy(config, config2, SENSOR_CONFIG_BASIC_SIZE);
+		config->default_range = config2->default_range;
+		config->odr_entries = config2->odr_entries;
+		config->range_entries = config2->range_entries;
+		config->sysfs_entries = config2->sysfs_entries;
+		memcpy(config->indexs, config2->indexs, sizeof(config->indexs));
+		memcpy(config->odr_table, sensor_config_v2_odr(config2),
+			config2->odr_entries * sizeof(struct odr));
+		memcpy(config->range_table, sensor_config_v2_range(config2),
+			config2->range_entries * sizeof(struct range_setting));
+		memcpy(config->sysfs_table, sensor_config_v2_sysfs(config2),
+			config2->sysfs_entries * sizeof(struct sysfs_entry));
+
+		for (j = 0; j < SENSOR_ACTION_RESERVE; j++)
+			expand_index(&config->indexs[j], pool, table, &num);
+		for (j = 0; j < config->odr_entries; j++)
+			expand_index(&config->odr_table[j].index, pool, table, &num);
+		for (j = 0; j < config->range_entries; j++)
+			expand_index(&config->range_table[j].index,
+						pool, table, &num);
+		for (j = 0; j < config->sysfs_entries; j++) {
+			struct sysfs_entry *entry = &config->sysfs_table[j];
+
+			if (entry->type != DATA_ACTION)
+				continue;
+			expand_index(&entry->action.data.index_show,
+						pool, table, &num);
+			expand_index(&entry->action.data.index_store,
+						pool, table, &num);
+		}
+
+		config->size = SENSOR_CONFIG_V1_SIZE(num);
+		config = (struct sensor_config *)((char *)config + config->size);
+		config2 = (struct sensor_config_v2 *)
+			((char *)config2 + config2->size);
+	}
+
+	*v1 = out;
+	return out_size;
+}
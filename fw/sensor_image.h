@@ -0,0 +1,27 @@
+#ifndef SENSOR_IMAGE_H
+#define SENSOR_IMAGE_H
+
+/*
+* Reader/writer of sensor config image version 2
+* The parser builds version 1 in memory, the writer packs it into
+* version 2, the reader verifies version 2 and expands it back
+* into version 1 for dump and simulate
+*/
+
+__u32 sensor_image_crc32(__u32 crc, const void *buf, int len);
+
+/* pack version 1 image in v1 of v1_size bytes into out
+*  return size of version 2 image, or -1 if out is too small
+*/
+int sensor_image_v2_write(const char *v1, int v1_size,
+				char *out, int out_size);
+
+/*check magic, version, size and checksum, return 0 if valid*/
+int sensor_image_v2_verify(const char *buf, int size);
+
+/* expand verified version 2 image into a malloced version 1 image
+*  return size of version 1 image, caller frees *v1
+*/
+int sensor_image_v2_expand(const char *buf, int size, char **v1);
+
+#endif
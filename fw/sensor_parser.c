@@ -25,6 +25,7 @@
 #define _LARGEFILE64_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <linux/types.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -35,6 +36,8 @@
 #include <libxml/parser.h>
 #include <libxml/tree.h>
 #include "sensor_driver_config.h"
+#include "sensor_sim.h"
+#include "sensor_image.h"
 #include "sensor_parser.h"
 
 #define SENSOR_PARSER_DBG
@@ -120,32 +123,43 @@ static void display_help(void)
 	"-p         --parser             Parser xml, or Dump firmware\n"
 	"-x file    --xml=file           XML config file\n"
 	"-f file    --firmware=file      Firmware image file\n"
+	"-s         --simulate           Run actions of firmware on mock i2c\n"
+	"-r file    --regs=file          Register values for simulate,\n"
+	"                                one \"addr value\" pair per line\n"
+	"-i n       --image=1/2          Version of generated image, default 1\n"
 	"-q         --quiet=0/1/2/3/	 Print level of debug message\n"
 	"Example:\n"
 	"  ./sensor_parser -p -x sensor_driver_config.xml -f sensor_config.bin\n"
+	"  ./sensor_parser -p -i 2 -x sensor_driver_config.xml -f sensor_config.bin\n"
 	"  ./sensor_parser -f sensor_config.bin > dump\n"
+	"  ./sensor_parser -s -f sensor_config.bin -r regs.txt\n"
 	"\n");
 
 	exit(EXIT_SUCCESS);
 }
 
 /* Option variables*/
-static enum { PARSER = 0, DUMP } parser_dump = DUMP;
+static enum { PARSER = 0, DUMP, SIMULATE } parser_dump = DUMP;
 static const char *xmlfile = NULL;
 static const char *firmwarefile = NULL;
+static const char *regfile = NULL;
+static int image_version = 1;
 /*static const char *dumpfile = NULL;*/
 
 static void process_options(int argc, char *const argv[])
 {
 	for (;;) {
 		int option_index = 0;
-		static const char *short_options = "px:f:q:";
+		static const char *short_options = "px:f:sr:i:q:";
 		static const struct option long_options[] = {
 			{"help", no_argument, 0, 0},
 			{"parser", no_argument, 0, 'p'},
 			{"xml", required_argument, 0, 'x'},
 			{"firmware", required_argument, 0, 'f'},
 /*			{"dump", required_argument, 0, 'd'}, */
+			{"simulate", no_argument, 0, 's'},
+			{"regs", required_argument, 0, 'r'},
+			{"image", required_argument, 0, 'i'},
 			{"quiet", required_argument, 0, 'q'},
 			{0, 0, 0, 0},
 		};
@@ -175,6 +189,21 @@ static void process_options(int argc, char *const argv[])
 					exit(-1);
 				}
 				break;
+			case 's':
+				parser_dump = SIMULATE;
+				break;
+			case 'r':
+				if (!(regfile = strdup(optarg))) {
+					perror("stddup");
+					exit(-1);
+				}
+				break;
+			case 'i':
+				image_version = strtol(optarg, NULL, 0);
+				if (image_version != 1 &&
+					image_version != SENSOR_CONFIG_IMAGE_VERSION)
+					display_help();
+				break;
 			case 'q':
 				dbg_level = strtol(optarg, NULL, 0);
 				break;
@@ -198,22 +227,22 @@ int main(int argc, char *argv[])
 
 	if (parser_dump == PARSER)
 		ret = parser();
+	else if (parser_dump == SIMULATE)
+		ret = simulate();
 	else
 		ret = dump();
 
 	return ret;
 }
 
-static int dump(void)
+/*read the whole firmware image, caller frees *image_buf*/
+static int load_image(char **image_buf)
 {
 	char *buf = NULL;
 	int fd_firm = 0;
 	int size;
 	int ret;
 	struct sensor_config_image image;
-	struct sensor_config_image *image_ptr;
-	struct sensor_config *config;
-	int i;
 
 	/*firmware*/
 	fd_firm = open(firmwarefile, O_RDONLY);
@@ -227,11 +256,14 @@ static int dump(void)
 	ret = read(fd_firm, &image, sizeof(image));
 	if (ret != sizeof(image)) {
 		printf("read file error %d\n", ret);
+		ret = -1;
 		goto err;
 	}
 
-	if (image.magic != 0x1234) {
+	if (image.magic != SENSOR_CONFIG_IMAGE_MAGIC &&
+		image.magic != SENSOR_CONFIG_IMAGE_V2_MAGIC) {
 		printf("wrong firmware image\n");
+		ret = -1;
 		goto err;
 	}
 
@@ -252,9 +284,55 @@ static int dump(void)
 	ret = read(fd_firm, buf, size);
 	if (ret != size) {
 		printf("read file error %d\n", ret);
+		ret = -1;
 		goto err;
 	}
 
+	/*dump and simulate work on version 1 layout*/
+	if (image.magic == SENSOR_CONFIG_IMAGE_V2_MAGIC) {
+		char *v1 = NULL;
+
+		ret = sensor_image_v2_verify(buf, size);
+		if (ret)
+			goto err;
+
+		printf("Image version: %d, pool actions: %d\n",
+			SENSOR_CONFIG_IMAGE_VERSION,
+			((struct sensor_config_image_v2 *)buf)->pool_num);
+
+		size = sensor_image_v2_expand(buf, size, &v1);
+		if (size < 0) {
+			ret = -1;
+			goto err;
+		}
+		free(buf);
+		buf = v1;
+	}
+
+	close(fd_firm);
+	*image_buf = buf;
+	return size;
+err:
+	if (fd_firm > 0)
+		close(fd_firm);
+	if (buf)
+		free(buf);
+
+	return ret;
+}
+
+static int dump(void)
+{
+	char *buf = NULL;
+	int ret;
+	struct sensor_config_image *image_ptr;
+	struct sensor_config *config;
+	int i;
+
+	ret = load_image(&buf);
+	if (ret < 0)
+		return ret;
+
 	/*dump sensor image*/
 	image_ptr = (struct sensor_config_image *)buf;
 	config = (struct sensor_config *)&image_ptr->configs;
@@ -262,19 +340,56 @@ static int dump(void)
 	printf("flags: %d\n", image_ptr->flags);
 	printf("dbg_sensors: %d\n", image_ptr->dbg_sensors);
 	printf("dbg_level: %d\n", image_ptr->dbg_level);
-	for (i = 0; i < image.num; i++)
+	for (i = 0; i < image_ptr->num; i++)
 	{
 		dump_sensor_config(config);
 		config = (struct sensor_config *)
 			((char *)config + config->size);
 	}
 
+	free(buf);
+
+	return 0;
+}
+
+static int simulate(void)
+{
+	char *buf = NULL;
+	int ret;
+	struct sensor_config_image *image_ptr;
+	struct sensor_config *config;
+	struct sim_regfile regs;
+	struct sim_bus bus;
+	int i;
+
+	memset(&regs, 0, sizeof(regs));
+	if (regfile) {
+		ret = sim_regfile_load(&regs, regfile);
+		if (ret < 0)
+			return ret;
+		printf("Preset registers: %d\n", ret);
+	}
+	sim_regfile_bus(&regs, &bus);
+
+	ret = load_image(&buf);
+	if (ret < 0)
+		return ret;
+
+	image_ptr = (struct sensor_config_image *)buf;
+	config = (struct sensor_config *)&image_ptr->configs;
+
 	ret = 0;
-err:
-	if (fd_firm)
-		close(fd_firm);
-	if (buf)
-		free(buf);
+	for (i = 0; i < image_ptr->num; i++)
+	{
+		sim_regfile_reset(&regs, config);
+		if (simulate_sensor_config(config, &bus))
+			ret = -1;
+
+		config = (struct sensor_config *)
+			((char *)config + config->size);
+	}
+
+	free(buf);
 
 	return ret;
 }
@@ -341,7 +456,7 @@ static int parser(void)
 
 	/*init sensor image*/
 	image = (struct sensor_config_image *)buf;
-	image->magic = 0x1234;
+	image->magic = SENSOR_CONFIG_IMAGE_MAGIC;
 	image->num = sensor_num;
 
 	str = (char *)xmlGetProp(root, (const xmlChar*)"flags");
@@ -363,7 +478,7 @@ static int parser(void)
 	}
 
 	config = (struct sensor_config *)&image->configs;
-	size = sizeof(struct sensor_config_image) - sizeof(int *);
+	size = offsetof(struct sensor_config_image, configs);
 	ret = sensor_parser_sensors(root->xmlChildrenNode,
 				sensor_num, config, &size);
 	if (ret)
@@ -372,6 +487,30 @@ static int parser(void)
 		goto out;
 	}
 
+	if (image_version == SENSOR_CONFIG_IMAGE_VERSION) {
+		char *v2 = malloc(MAX_FIRMWARE_SIZE);
+		int v1_size = size;
+
+		if (!v2) {
+			printf("Fail to alloc memory %d\n", MAX_FIRMWARE_SIZE);
+			ret = -1;
+			goto out;
+		}
+
+		size = sensor_image_v2_write(buf, v1_size, v2, MAX_FIRMWARE_SIZE);
+		if (size < 0) {
+			printf("Fail to generate version 2 image\n");
+			free(v2);
+			ret = -1;
+			goto out;
+		}
+		printf("Version 2 image: %d bytes, version 1: %d bytes\n",
+				size, v1_size);
+
+		free(buf);
+		buf = v2;
+	}
+
 	/*write into file*/
 	ret = write(fd, buf, size);
 	if (ret != size)
@@ -577,6 +716,100 @@ static void dump_sensor_config(struct sensor_config *config)
 	}
 }
 
+static void simulate_print_stats(const char *name, struct sim_stats *stats)
+{
+	printf("%-16s %6d %6d %6d %6d %8d %8d %10d\n", name,
+			stats->cycles, stats->i2c_reads, stats->i2c_writes,
+			stats->i2c_bytes, stats->bus_us, stats->sleep_ms,
+			stats->result);
+}
+
+static void simulate_add_stats(struct sim_stats *sum, struct sim_stats *stats)
+{
+	sum->cycles += stats->cycles;
+	sum->i2c_reads += stats->i2c_reads;
+	sum->i2c_writes += stats->i2c_writes;
+	sum->i2c_bytes += stats->i2c_bytes;
+	sum->bus_us += stats->bus_us;
+	sum->sleep_ms += stats->sleep_ms;
+}
+
+/*run actions in the order the driver calls them, so globals carry over*/
+static int simulate_sensor_config(struct sensor_config *config,
+				struct sim_bus *bus)
+{
+	static const enum sensor_action order[] = {
+		INIT, ENABLE, INT_ACK,
+		GET_DATA_X, GET_DATA_Y, GET_DATA_Z,
+		DISABLE, DEINIT,
+	};
+	struct lowlevel_action *action_table =
+			(struct lowlevel_action *)&config->actions;
+	struct sim_context ctx;
+	struct sim_stats stats;
+	struct sim_stats sample;
+	char name[0x20];
+	int ret = 0;
+	int i;
+
+	sim_context_init(&ctx, bus);
+	memset(&sample, 0, sizeof(sample));
+
+	printf("======Sensor Simulation: %s======\n", config->name);
+	printf("%-16s %6s %6s %6s %6s %8s %8s %10s\n", "action", "cycles",
+		"reads", "writes", "bytes", "bus(us)", "sleep", "result");
+
+	for (i = 0; i < ARRAY_SIZE(order); i++) {
+		struct lowlevel_action_index *index = &config->indexs[order[i]];
+
+		if (!index->num)
+			continue;
+
+		if (sim_run_actions(&ctx, &action_table[index->index],
+					index->num, 0, &stats)) {
+			printf("Fail to simulate %s\n",
+					sensor_action_debug[order[i]]);
+			ret = -1;
+			continue;
+		}
+
+		simulate_print_stats(sensor_action_debug[order[i]], &stats);
+		if (order[i] >= GET_DATA_X && order[i] <= GET_DATA_Z)
+			simulate_add_stats(&sample, &stats);
+	}
+	simulate_print_stats("per sample", &sample);
+
+	for (i = 0; i < config->odr_entries; i++) {
+		struct odr *odr = &config->odr_table[i];
+
+		if (sim_run_actions(&ctx, &action_table[odr->index.index],
+					odr->index.num, odr->hz, &stats)) {
+			printf("Fail to simulate odr %dHz\n", odr->hz);
+			ret = -1;
+			continue;
+		}
+
+		snprintf(name, sizeof(name), "odr %dHz", odr->hz);
+		simulate_print_stats(name, &stats);
+	}
+
+	for (i = 0; i < config->range_entries; i++) {
+		struct range_setting *range = &config->range_table[i];
+
+		if (sim_run_actions(&ctx, &action_table[range->index.index],
+					range->index.num, range->range, &stats)) {
+			printf("Fail to simulate range %d\n", range->range);
+			ret = -1;
+			continue;
+		}
+
+		snprintf(name, sizeof(name), "range %d", range->range);
+		simulate_print_stats(name, &stats);
+	}
+
+	return ret;
+}
+
 static int sensor_xmlnode_sort(xmlNodePtr node,
 		xmlNodePtr *NodeBuf, int *cnt_buf)
 {
@@ -903,12 +1136,22 @@ static int sensor_config_init(xmlNodePtr node, struct sensor_config *config)
 		}
 	}
 
+	ret = sensor_coalesce_data_reads(parser);
+	if (ret) {
+		printf("Fail to coalesce data reads, ret:%d\n", ret);
+		ret = -1;
+		goto err;
+	}
+	printf("%s: burst reads save %d i2c transactions, %d per sample\n",
+			config->name, parser->reads_saved,
+			parser->sample_reads_saved);
+
 	/*init others*/
 	config->sensor_regs = (parser->sensor_regs + 1 + 31)/32*32;
 	config->id_reg_flag = parser->id_reg_flag;
 	config->test_reg_addr = parser->test_reg_addr;
 
-	config->size = sizeof(struct sensor_config) - sizeof(int *)
+	config->size = offsetof(struct sensor_config, actions)
 		+ parser->ll_action_num * sizeof(struct lowlevel_action);
 
 	ret = sensor_config_verify(config);
@@ -1486,6 +1729,7 @@ static int sensor_parser_prep(struct sensor_parser *parser)
 static int parser_high2ll_actions(struct sensor_parser *parser, char *high_actions)
 {
 	int ret = 0;
+	int i;
 
 	DBG(LEVEL4, "%s", high_actions);
 
@@ -1510,6 +1754,15 @@ static int parser_high2ll_actions(struct sensor_parser *parser, char *high_actio
 		dump_im_actions(parser);
 #endif
 
+	/*lowlevel actions the program would take unoptimized*/
+	parser->ll_raw_num = 0;
+	for (i = 0; i < parser->im_num; i++) {
+		enum im_op_type type = parser->im_actions[i].type;
+
+		if (type != IM_IF_START && type != IM_ELSE && type != IM_ENDIF)
+			parser->ll_raw_num++;
+	}
+
 	ret = sensor_optimize_im_actions(parser);
 	if (ret) {
 		printf("[%d]%s Error when sensor_optimize_im_actions\n",
@@ -1517,6 +1770,20 @@ static int parser_high2ll_actions(struct sensor_parser *parser, char *high_actio
 		goto err;
 	}
 
+	ret = sensor_fold_im_actions(parser);
+	if (ret) {
+		printf("[%d]%s Error when sensor_fold_im_actions\n",
+					__LINE__, __func__);
+		goto err;
+	}
+
+	ret = sensor_coalesce_im_reads(parser);
+	if (ret) {
+		printf("[%d]%s Error when sensor_coalesce_im_reads\n",
+					__LINE__, __func__);
+		goto err;
+	}
+
 	/*dump_im_actions(parser);*/
 
 	ret = sensor_im2ll_actions(parser);
@@ -1657,6 +1924,8 @@ static int parser_sensor_action(struct sensor_parser *parser,
 	struct lowlevel_action *action_table =
 			(struct lowlevel_action *)&parser->config->actions;
 
+	int reads_saved = parser->reads_saved;
+
 	DBG(LEVEL4, "%s", high_actions);
 
 	ret = parser_high2ll_actions(parser, high_actions);
@@ -1666,6 +1935,12 @@ static int parser_sensor_action(struct sensor_parser *parser,
 		goto err;
 	}
 
+	if (ll_type >= GET_DATA_X && ll_type <= GET_DATA_Z)
+		parser->sample_reads_saved += parser->reads_saved - reads_saved;
+
+	printf("%s %s actions: %d -> %d\n", parser->config->name,
+		sensor_action_debug[ll_type], parser->ll_raw_num, parser->ll_num);
+
 	DBG(LEVEL2, "%d, %d", parser->ll_action_num, parser->ll_num);
 
 	index->index = parser->ll_action_num;
@@ -1684,6 +1959,256 @@ err:
 	return -1;
 }
 
+static inline int sensor_is_ll_read(struct lowlevel_action *action)
+{
+	return action->type == DATA &&
+		action->action.data.op == OP_ACCESS &&
+		action->action.data.operand1.type == OPT_REG_BUF &&
+		action->action.data.operand2.type == OPT_REG;
+}
+
+static inline void sensor_fix_ll_index(struct lowlevel_action_index *index,
+				int pos)
+{
+	if (!index->num)
+		return;
+
+	if (index->index > pos)
+		index->index--;
+	else if (index->index + index->num > pos)
+		index->num--;
+}
+
+/*remove one top level action of packed table and fix all indexes*/
+static void sensor_remove_ll_action(struct sensor_parser *parser, int pos)
+{
+	struct sensor_config *config = parser->config;
+	struct lowlevel_action *action_table =
+			(struct lowlevel_action *)&config->actions;
+	int i;
+
+	memmove(&action_table[pos], &action_table[pos + 1],
+		(parser->ll_action_num - pos - 1) * sizeof(struct lowlevel_action));
+	parser->ll_action_num--;
+
+	for (i = 0; i < SENSOR_ACTION_RESERVE; i++)
+		sensor_fix_ll_index(&config->indexs[i], pos);
+
+	for (i = 0; i < config->odr_entries; i++)
+		sensor_fix_ll_index(&config->odr_table[i].index, pos);
+
+	for (i = 0; i < config->range_entries; i++)
+		sensor_fix_ll_index(&config->range_table[i].index, pos);
+
+	for (i = 0; i < config->sysfs_entries; i++) {
+		struct sysfs_entry *entry = &config->sysfs_table[i];
+
+		if (entry->type != DATA_ACTION)
+			continue;
+		sensor_fix_ll_index(&entry->action.data.index_show, pos);
+		sensor_fix_ll_index(&entry->action.data.index_store, pos);
+	}
+}
+
+/*flag is known to auto increment if any read uses it for multi bytes*/
+static int sensor_flag_can_burst(struct sensor_parser *parser, int flag)
+{
+	struct lowlevel_action *action_table =
+			(struct lowlevel_action *)&parser->config->actions;
+	int i;
+
+	for (i = 0; i < parser->ll_action_num; i++) {
+		struct operand *reg = &action_table[i].action.data.operand2;
+
+		if (sensor_is_ll_read(&action_table[i]) &&
+			reg->data.reg.flag == flag && reg->data.reg.len > 1)
+			return 1;
+	}
+
+	return 0;
+}
+
+/*any register write in actions, only those touching [lo, hi) if hi > lo*/
+static int sensor_ll_writes_regs(struct lowlevel_action *actions, int num,
+				int lo, int hi)
+{
+	int i;
+
+	for (i = 0; i < num; i++) {
+		struct lowlevel_action *action = &actions[i];
+		struct operand *reg = &action->action.data.operand1;
+
+		if (action->type != DATA || action->action.data.op != OP_ACCESS ||
+			reg->type != OPT_REG)
+			continue;
+
+		if (hi <= lo || (reg->data.reg.addr < hi &&
+				reg->data.reg.addr + reg->data.reg.len > lo))
+			return 1;
+	}
+
+	return 0;
+}
+
+/*programs the driver may run between two reports while sampling:
+*  interrupt ack, odr, range and sysfs actions
+*/
+static int sensor_runtime_writes_regs(struct sensor_parser *parser,
+				int lo, int hi)
+{
+	struct sensor_config *config = parser->config;
+	struct lowlevel_action *action_table =
+			(struct lowlevel_action *)&config->actions;
+	struct lowlevel_action_index *index = &config->indexs[INT_ACK];
+	int i;
+
+	if (sensor_ll_writes_regs(&action_table[index->index],
+				index->num, lo, hi))
+		return 1;
+
+	for (i = 0; i < config->odr_entries; i++) {
+		index = &config->odr_table[i].index;
+		if (sensor_ll_writes_regs(&action_table[index->index],
+					index->num, lo, hi))
+			return 1;
+	}
+
+	for (i = 0; i < config->range_entries; i++) {
+		index = &config->range_table[i].index;
+		if (sensor_ll_writes_regs(&action_table[index->index],
+					index->num, lo, hi))
+			return 1;
+	}
+
+	for (i = 0; i < config->sysfs_entries; i++) {
+		struct sysfs_entry *entry = &config->sysfs_table[i];
+
+		if (entry->type != DATA_ACTION)
+			continue;
+
+		index = &entry->action.data.index_show;
+		if (sensor_ll_writes_regs(&action_table[index->index],
+					index->num, lo, hi))
+			return 1;
+
+		index = &entry->action.data.index_store;
+		if (sensor_ll_writes_regs(&action_table[index->index],
+					index->num, lo, hi))
+			return 1;
+	}
+
+	return 0;
+}
+
+/* driver evaluates get_data_x/y/z back to back for every report
+*  (see the order in simulate_sensor_config), so the leading reads of
+*  x, y and z can be folded into one burst read at the start of x,
+*  and y/z extract from register buf. That only holds if nothing
+*  changes the registers between the burst and the folded reads:
+*  - x writes no registers, else nothing is folded
+*  - y writes no registers, else z is not folded
+*  - no action that may run between reports writes into the burst
+*    range, else nothing is folded
+*/
+static int sensor_coalesce_data_reads(struct sensor_parser *parser)
+{
+	struct sensor_config *config = parser->config;
+	struct lowlevel_action *action_table =
+			(struct lowlevel_action *)&config->actions;
+	struct lowlevel_action_index *index = &config->indexs[GET_DATA_X];
+	struct lowlevel_action_index *data_index;
+	struct operand *reg, *regbuf;
+	int folds[GET_DATA_Z - GET_DATA_X + 1];
+	int lo, hi, burst, last;
+	int i, j;
+
+	if (!index->num || !sensor_is_ll_read(&action_table[index->index]))
+		return 0;
+
+	if (sensor_ll_writes_regs(&action_table[index->index],
+				index->num, 0, 0))
+		return 0;
+
+	data_index = &config->indexs[GET_DATA_Y];
+	last = sensor_ll_writes_regs(&action_table[data_index->index],
+				data_index->num, 0, 0) ? GET_DATA_Y : GET_DATA_Z;
+
+	reg = &action_table[index->index].action.data.operand2;
+	lo = reg->data.reg.addr;
+	hi = lo + reg->data.reg.len;
+	burst = sensor_flag_can_burst(parser, reg->data.reg.flag);
+
+	/*find the burst range and how many leading reads each fold*/
+	memset(folds, 0, sizeof(folds));
+	for (i = GET_DATA_X; i <= last; i++) {
+		/*first action of x is the burst read itself*/
+		int pos = (i == GET_DATA_X);
+
+		data_index = &config->indexs[i];
+		for (; pos < data_index->num; pos++) {
+			struct lowlevel_action *action =
+				&action_table[data_index->index + pos];
+			struct operand *oper = &action->action.data.operand2;
+			int start, end;
+
+			if (!sensor_is_ll_read(action) ||
+				oper->data.reg.flag != reg->data.reg.flag)
+				break;
+
+			start = oper->data.reg.addr;
+			end = start + oper->data.reg.len;
+			if (start > hi || end < lo)
+				break;
+
+			/*reads something new, which needs auto increment*/
+			if ((start < lo || end > hi) && !burst)
+				break;
+
+			start = start < lo ? start : lo;
+			end = end > hi ? end : hi;
+			if (end - start > SENSOR_MAX_BURST_LEN)
+				break;
+
+			lo = start;
+			hi = end;
+			folds[i - GET_DATA_X]++;
+		}
+	}
+
+	if (sensor_runtime_writes_regs(parser, lo, hi)) {
+		DBG(LEVEL1, "registers 0x%x-0x%x written between reports, keep reads",
+			lo, hi - 1);
+		return 0;
+	}
+
+	for (i = GET_DATA_X; i <= last; i++) {
+		int pos = (i == GET_DATA_X);
+
+		data_index = &config->indexs[i];
+		for (j = 0; j < folds[i - GET_DATA_X]; j++) {
+			struct operand *oper = &action_table[data_index->index +
+						pos].action.data.operand2;
+
+			DBG(LEVEL1, "fold read 0x%x %d of %d into 0x%x %d",
+				oper->data.reg.addr, oper->data.reg.len,
+				i, lo, hi - lo);
+
+			sensor_remove_ll_action(parser, data_index->index + pos);
+
+			parser->reads_saved++;
+			parser->sample_reads_saved++;
+		}
+	}
+
+	/*y or z may be packed before x, so locate its read again*/
+	reg = &action_table[index->index].action.data.operand2;
+	regbuf = &action_table[index->index].action.data.operand1;
+	regbuf->data.reg.addr = reg->data.reg.addr = lo;
+	regbuf->data.reg.len = reg->data.reg.len = hi - lo;
+
+	return 0;
+}
+
 /*remove comment, space, tab, \r, \n
 * replace ; with \n
 * add \n behind if()/else/endif
@@ -2626,6 +3151,418 @@ err:
 	return ret;
 }
 
+/*constant values known while walking one action program*/
+struct im_fold_state {
+	int known[PRIVATE_MAX_SIZE];
+	int value[PRIVATE_MAX_SIZE];
+	int before_known;
+	int before;
+};
+
+static inline int sensor_is_im_data(struct im_action *action)
+{
+	return action->type >= IM_ASSIGN && action->type <= IM_MAX;
+}
+
+static inline int sensor_im_reads(struct im_action *action,
+				int type, int index)
+{
+	int op_num;
+
+	if (!sensor_is_im_data(action))
+		return 0;
+
+	op_num = im_op_attrs[search_imops_by_type(action->type)].op_num;
+
+	/*operand1 of = is the destination*/
+	if (action->type != IM_ASSIGN && action->operand1.type == type &&
+		(type == IM_BEFORE || action->operand1.data.index == index))
+		return 1;
+
+	if (op_num == 2 && action->operand2.type == type &&
+		(type == IM_BEFORE || action->operand2.data.index == index))
+		return 1;
+
+	return 0;
+}
+
+/*replace local/global/before operand by its known constant*/
+static void sensor_fold_operand(struct im_operand *oper,
+				struct im_fold_state *state)
+{
+	if ((oper->type == IM_LOCAL || oper->type == IM_GLOBAL) &&
+		state->known[oper->data.index]) {
+		oper->data.immediate = state->value[oper->data.index];
+		oper->type = IM_IMM;
+	} else if (oper->type == IM_BEFORE && state->before_known) {
+		oper->type = IM_IMM;
+		oper->data.immediate = state->before;
+	}
+}
+
+static void sensor_fold_data(struct im_action *action,
+				struct im_fold_state *state)
+{
+	struct im_operand *op1 = &action->operand1;
+	struct im_operand *op2 = &action->operand2;
+	int op_num = im_op_attrs[search_imops_by_type(action->type)].op_num;
+	int imm;
+
+	if (action->type == IM_ASSIGN) {
+		sensor_fold_operand(op2, state);
+
+		if (op1->type == IM_LOCAL || op1->type == IM_GLOBAL) {
+			state->known[op1->data.index] = (op2->type == IM_IMM);
+			state->value[op1->data.index] = op2->data.immediate;
+			state->before_known = (op2->type == IM_IMM);
+			state->before = op2->data.immediate;
+		} else {
+			/*register access, result depends on device*/
+			state->before_known = 0;
+		}
+		return;
+	}
+
+	sensor_fold_operand(op1, state);
+	if (op_num == 2)
+		sensor_fold_operand(op2, state);
+
+	state->before_known = 0;
+
+	/*only ops sensor_parser_preprocess handles, without host UB*/
+	if (action->type < IM_LOGIC_EQ || action->type > IM_BIT_NOR ||
+		op1->type != IM_IMM || (op_num == 2 && op2->type != IM_IMM))
+		return;
+
+	if ((action->type == IM_ARI_DIV || action->type == IM_ARI_MOD) &&
+		op2->data.immediate == 0)
+		return;
+
+	if ((action->type == IM_BIT_LSL || action->type == IM_BIT_LSR) &&
+		(op2->data.immediate < 0 || op2->data.immediate > 31))
+		return;
+
+	if (action->type == IM_BIT_NOR)
+		sensor_parser_preprocess(action->type, 0,
+				op1->data.immediate, &imm);
+	else
+		sensor_parser_preprocess(action->type, op1->data.immediate,
+				op2->data.immediate, &imm);
+
+	state->before_known = 1;
+	state->before = imm;
+}
+
+static void sensor_fold_merge(struct im_fold_state *state,
+				struct im_fold_state *other)
+{
+	int i;
+
+	for (i = 0; i < PRIVATE_MAX_SIZE; i++) {
+		if (state->known[i] && (!other->known[i] ||
+				state->value[i] != other->value[i]))
+			state->known[i] = 0;
+	}
+
+	if (state->before_known && (!other->before_known ||
+				state->before != other->before))
+		state->before_known = 0;
+}
+
+/* fold im actions [start, end) into out, propagating constants
+*  if/else whose condition folds to a constant is replaced by the
+*  taken branch, and actions after a return are dropped
+*/
+static int sensor_fold_block(struct im_action *in, int start, int end,
+		struct im_action *out, int *num, struct im_fold_state *state,
+		int *returned)
+{
+	int i, j;
+
+	*returned = 0;
+
+	for (i = start; i < end; i++)
+	{
+		struct im_action *action = &in[i];
+
+		if (action->type == IM_IF) {
+			int if_start = -1, if_else = -1, if_end = -1;
+			int depth = 0;
+			int if_pos = *num;
+			int pure = 1;
+			int ret_if, ret_else;
+			struct im_fold_state state_else;
+
+			for (j = i + 1; j < end && if_end < 0; j++) {
+				if (if_start < 0) {
+					if (in[j].type == IM_IF_START)
+						if_start = j;
+				} else if (in[j].type == IM_IF) {
+					depth++;
+				} else if (in[j].type == IM_ELSE && !depth) {
+					if_else = j;
+				} else if (in[j].type == IM_ENDIF) {
+					if (!depth)
+						if_end = j;
+					else
+						depth--;
+				}
+			}
+
+			if (if_start < 0 || if_end < 0) {
+				printf("[%d]%s Error unbalanced if\n",
+						__LINE__, __func__);
+				return -1;
+			}
+
+			out[(*num)++] = *action;
+			if (sensor_fold_block(in, i + 1, if_start, out, num,
+						state, &ret_if))
+				return -1;
+
+			if (state->before_known) {
+				/*drop if marker, keep condition only for its stores*/
+				for (j = if_pos + 1; j < *num; j++) {
+					if (out[j].type == IM_ASSIGN)
+						pure = 0;
+					out[j - 1] = out[j];
+				}
+				(*num)--;
+				if (pure)
+					*num = if_pos;
+
+				DBG(LEVEL1, "if(%d) folded", state->before);
+
+				if (state->before) {
+					if (sensor_fold_block(in, if_start + 1,
+						if_else < 0 ? if_end : if_else,
+						out, num, state, returned))
+						return -1;
+				} else if (if_else >= 0) {
+					if (sensor_fold_block(in, if_else + 1,
+						if_end, out, num, state, returned))
+						return -1;
+				}
+
+				if (*returned)
+					return 0;
+
+				i = if_end;
+				continue;
+			}
+
+			out[(*num)++] = in[if_start];
+			state_else = *state;
+			if (sensor_fold_block(in, if_start + 1,
+					if_else < 0 ? if_end : if_else,
+					out, num, state, &ret_if))
+				return -1;
+
+			ret_else = 0;
+			if (if_else >= 0) {
+				out[(*num)++] = in[if_else];
+				if (sensor_fold_block(in, if_else + 1, if_end,
+					out, num, &state_else, &ret_else))
+					return -1;
+			}
+			out[(*num)++] = in[if_end];
+
+			if (ret_if && ret_else) {
+				*returned = 1;
+				return 0;
+			} else if (ret_if) {
+				*state = state_else;
+			} else if (!ret_else) {
+				sensor_fold_merge(state, &state_else);
+			}
+
+			i = if_end;
+			continue;
+		}
+
+		if (action->type == IM_RETURN) {
+			out[(*num)++] = *action;
+			*returned = 1;
+			return 0;
+		}
+
+		if (action->type == IM_SLEEP) {
+			if (action->operand1.data.ms == 0)
+				continue;
+
+			/*back to back sleeps become one*/
+			if (*num && out[*num - 1].type == IM_SLEEP) {
+				out[*num - 1].operand1.data.ms +=
+						action->operand1.data.ms;
+				continue;
+			}
+
+			out[(*num)++] = *action;
+			continue;
+		}
+
+		if (!sensor_is_im_data(action)) {
+			printf("[%d]%s Error im tpye:%d\n",
+					__LINE__, __func__, action->type);
+			return -1;
+		}
+
+		out[*num] = *action;
+		sensor_fold_data(&out[*num], state);
+		(*num)++;
+	}
+
+	return 0;
+}
+
+/*whether output of action i can be seen by a later action*/
+static int sensor_before_live(struct im_action *actions, int num, int i)
+{
+	for (i++; i < num; i++)
+	{
+		if (actions[i].type == IM_SLEEP || actions[i].type == IM_IF)
+			continue;
+
+		if (!sensor_is_im_data(&actions[i]))
+			return 1;
+
+		return sensor_im_reads(&actions[i], IM_BEFORE, 0);
+	}
+
+	/*result of last action is output of the program*/
+	return 1;
+}
+
+static int sensor_local_live(struct im_action *actions, int num,
+				int i, int index)
+{
+	for (i++; i < num; i++)
+	{
+		if (sensor_im_reads(&actions[i], IM_LOCAL, index))
+			return 1;
+	}
+
+	return 0;
+}
+
+/* dataflow optimizer of one action program
+*  propagate constants through locals and before, fold if/else with
+*  constant condition, merge sleeps, then drop local stores and
+*  operations whose result is never read
+*/
+static int sensor_fold_im_actions(struct sensor_parser *parser)
+{
+	struct im_action *out;
+	struct im_fold_state state;
+	int num = 0;
+	int returned;
+	int removed;
+	int i, j;
+
+	out = malloc(sizeof(struct im_action) * IM_ACTION_MAX_NUM);
+	if (!out) {
+		printf("[%d]%s Error\n", __LINE__, __func__);
+		return -1;
+	}
+
+	memset(&state, 0, sizeof(state));
+	if (sensor_fold_block(parser->im_actions, 0, parser->im_num,
+				out, &num, &state, &returned)) {
+		free(out);
+		return -1;
+	}
+
+	do {
+		removed = 0;
+
+		for (i = 0, j = 0; i < num; i++)
+		{
+			struct im_action *action = &out[i];
+			int dead = 0;
+
+			if (action->type == IM_ASSIGN &&
+				action->operand1.type == IM_LOCAL)
+				dead = !sensor_local_live(out, num, i,
+						action->operand1.data.index);
+			else if (sensor_is_im_data(action) &&
+				action->type != IM_ASSIGN)
+				dead = 1;
+
+			if (dead && !sensor_before_live(out, num, i)) {
+				removed++;
+				continue;
+			}
+
+			out[j++] = *action;
+		}
+
+		num = j;
+	} while (removed);
+
+	DBG(LEVEL1, "folded %d to %d", parser->im_num, num);
+
+	memcpy(parser->im_actions, out, num * sizeof(struct im_action));
+	parser->im_num = num;
+
+	free(out);
+	return 0;
+}
+
+static inline int sensor_is_im_read(struct im_action *action)
+{
+	return action->type == IM_ASSIGN &&
+		action->operand1.type == IM_REGBUF &&
+		action->operand2.type == IM_REG;
+}
+
+/* merge readreg of contiguous registers into one burst read
+*  regbuf is addressed like the registers, so later regbuf_
+*  operands extract the same bytes from the wider read.
+*  Auto increment depends on flag, so only merge reads sharing
+*  a flag that is already used for a multi byte read.
+*/
+static int sensor_coalesce_im_reads(struct sensor_parser *parser)
+{
+	struct im_action *actions = parser->im_actions;
+	int i, num = 0;
+	int merged = 0;
+
+	for (i = 0; i < parser->im_num; i++)
+	{
+		struct im_action *prev = num ? &actions[num - 1] : NULL;
+		struct im_action *action = &actions[i];
+
+		if (prev && sensor_is_im_read(prev) &&
+			sensor_is_im_read(action) &&
+			prev->operand2.data.reg.flag ==
+				action->operand2.data.reg.flag &&
+			prev->operand2.data.reg.addr + prev->operand2.data.reg.len
+				== action->operand2.data.reg.addr &&
+			(prev->operand2.data.reg.len > 1 ||
+				action->operand2.data.reg.len > 1) &&
+			prev->operand2.data.reg.len + action->operand2.data.reg.len
+				<= SENSOR_MAX_BURST_LEN) {
+
+			prev->operand1.data.reg.len += action->operand2.data.reg.len;
+			prev->operand2.data.reg.len += action->operand2.data.reg.len;
+			DBG(LEVEL1, "burst read 0x%x %d", prev->operand2.data.reg.addr,
+					prev->operand2.data.reg.len);
+
+			merged++;
+			continue;
+		}
+
+		if (num != i)
+			actions[num] = *action;
+		num++;
+	}
+
+	parser->im_num = num;
+	parser->reads_saved += merged;
+
+	return 0;
+}
+
 static int sensor_im2ll_actions(struct sensor_parser *parser)
 {
 	struct im_action *im_actions = parser->im_actions;
@@ -2708,6 +3645,9 @@ static int sensor_trans_ll(struct sensor_parser *parser,
 	int index;
 	struct lowlevel_action *ll_action = &parser->ll_actions[parser->ll_top];
 
+	/*unused bytes of the union must not differ between equal actions*/
+	memset(ll_action, 0, sizeof(*ll_action));
+
 	switch (im_action->type) {
 	case IM_IF:
 		DBG(LEVEL2, "if");
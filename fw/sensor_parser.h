@@ -98,6 +98,8 @@ struct sensor_parser {
 	int high_num;
 	int im_num;
 	int ll_num;
+	/*ll_num before optimization*/
+	int ll_raw_num;
 
 	/*index of im/ll_actions to be translate, used when do trans*/
 	int im_top;
@@ -107,10 +109,19 @@ struct sensor_parser {
 	int sensor_regs;
 	int id_reg_flag;
 	int test_reg_addr;
+
+	/*i2c read transactions removed by burst coalescing*/
+	int reads_saved;
+	int sample_reads_saved;
 };
 
+/*longest burst read, bounded by i2c block transfer*/
+#define SENSOR_MAX_BURST_LEN		0x20
+
+static int load_image(char **image_buf);
 static int dump(void);
 static int parser(void);
+static int simulate(void);
 
 static int sensor_xmlnode_sort(xmlNodePtr node,
 			xmlNodePtr *NodeBuf, int *cnt_buf);
@@ -151,6 +162,9 @@ static int sensor_im2ll_actions(struct sensor_parser *parser);
 static int sensor_parser_preprocess(enum im_op_type type,
 				int op1, int op2, int *output);
 static int sensor_optimize_im_actions(struct sensor_parser *parser);
+static int sensor_fold_im_actions(struct sensor_parser *parser);
+static int sensor_coalesce_im_reads(struct sensor_parser *parser);
+static int sensor_coalesce_data_reads(struct sensor_parser *parser);
 
 static int sensor_tran_im_ops(struct sensor_parser *parser,
 				enum im_op_type type);
@@ -171,5 +185,7 @@ static void dump_im_actions(struct sensor_parser *parser);
 static void dump_ll_actions(struct sensor_parser *parser);
 
 static void dump_sensor_config(struct sensor_config *config);
+static int simulate_sensor_config(struct sensor_config *config,
+				struct sim_bus *bus);
 
 #endif
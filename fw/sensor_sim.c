@@ -0,0 +1,497 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Simulator for General Sensor Driver Config
+ * Interpret lowlevel actions of config firmware image
+ * against a mock i2c register file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <linux/types.h>
+#include <string.h>
+#include "sensor_driver_config.h"
+#include "sensor_sim.h"
+
+/*returned by sim_exec_actions when a RETURN action is hit*/
+#define SIM_RETURNED		1
+
+static int sim_regfile_read(struct sim_bus *bus, __u8 addr, __u8 flag,
+				__u8 *buf, int len)
+{
+	struct sim_regfile *regfile = bus->priv;
+
+	/*register address auto increments, wrap like the device does*/
+	while (len-- > 0)
+		*buf++ = regfile->regs[addr++];
+
+	return 0;
+}
+
+static int sim_regfile_write(struct sim_bus *bus, __u8 addr, __u8 flag,
+				__u8 *buf, int len)
+{
+	struct sim_regfile *regfile = bus->priv;
+
+	while (len-- > 0)
+		regfile->regs[addr++] = *buf++;
+
+	return 0;
+}
+
+void sim_regfile_bus(struct sim_regfile *regfile, struct sim_bus *bus)
+{
+	bus->read = sim_regfile_read;
+	bus->write = sim_regfile_write;
+	bus->priv = regfile;
+}
+
+/*register file: one "addr value" pair per line, # starts a comment*/
+int sim_regfile_load(struct sim_regfile *regfile, const char *file)
+{
+	FILE *fp;
+	char line[0x80];
+	int num = 0;
+
+	memset(regfile, 0, sizeof(*regfile));
+
+	fp = fopen(file, "r");
+	if (!fp) {
+		printf("open file error %s\n", file);
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		char *ptr = line, *end_ptr;
+		long addr, value;
+
+		while (*ptr == ' ' || *ptr == '\t')
+			ptr++;
+		if (*ptr == '#' || *ptr == '\n' || *ptr == '\0')
+			continue;
+
+		addr = strtol(ptr, &end_ptr, 0);
+		if (end_ptr == ptr)
+			goto err;
+		ptr = end_ptr;
+		value = strtol(ptr, &end_ptr, 0);
+		if (end_ptr == ptr || addr < 0 || addr >= SIM_REGS)
+			goto err;
+
+		regfile->preset[addr] = value;
+		regfile->preset_mask[addr] = 1;
+		num++;
+	}
+
+	fclose(fp);
+	return num;
+err:
+	printf("Wrong register file line: %s", line);
+	fclose(fp);
+	return -1;
+}
+
+/*clear registers but make the id register match the first device id*/
+void sim_regfile_reset(struct sim_regfile *regfile,
+			struct sensor_config *config)
+{
+	int i;
+
+	memset(regfile->regs, 0, sizeof(regfile->regs));
+
+	if (config->id_reg_addr != SENSOR_INVALID_REG)
+		regfile->regs[config->id_reg_addr] = config->id[0];
+
+	for (i = 0; i < SIM_REGS; i++)
+		if (regfile->preset_mask[i])
+			regfile->regs[i] = regfile->preset[i];
+}
+
+void sim_context_init(struct sim_context *ctx, struct sim_bus *bus)
+{
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->bus = bus;
+}
+
+/*bus time of one transaction, 9 bits per byte plus start and stop*/
+static int sim_bus_us(int bytes)
+{
+	return (bytes * 9 + 2) * 1000000 / SIM_I2C_HZ;
+}
+
+static __s32 sim_bytes_value(__u8 *bytes, int len)
+{
+	__s32 value = 0;
+
+	/*lowest address is least significant, as on little endian host*/
+	while (len-- > 0)
+		value = (value << 8) | bytes[len];
+
+	return value;
+}
+
+static void sim_value_bytes(__s32 value, __u8 *bytes, int len)
+{
+	while (len-- > 0) {
+		*bytes++ = value & 0xff;
+		value >>= 8;
+	}
+}
+
+static int sim_operand_value(struct sim_context *ctx,
+			struct operand *oper, __s32 *value)
+{
+	switch (oper->type) {
+	case OPT_IMM:
+		*value = oper->data.immediate;
+		break;
+	case OPT_REG_BUF:
+		if (oper->data.reg.len > sizeof(__s32))
+			goto err;
+		*value = sim_bytes_value(&ctx->regbuf[oper->data.reg.addr],
+						oper->data.reg.len);
+		break;
+	case OPT_INDEX:
+		if (oper->data.index < 0 ||
+			oper->data.index >= PRIVATE_MAX_SIZE)
+			goto err;
+		*value = ctx->private_data[oper->data.index];
+		break;
+	case OPT_BEFORE:
+		*value = ctx->before;
+		break;
+	case OPT_REG:
+	default:
+		goto err;
+	}
+
+	return 0;
+err:
+	printf("[%d]%s Error operand %d\n", __LINE__, __func__, oper->type);
+	return -1;
+}
+
+/*endian ops take raw bytes from register buf, or the bytes of a value*/
+static int sim_endian(struct sim_context *ctx, __u8 op,
+			struct operand *oper, __s32 *output)
+{
+	__u8 raw[sizeof(__s32)];
+	__u8 *b = raw;
+	__s32 value;
+
+	if (oper->type == OPT_REG_BUF) {
+		b = &ctx->regbuf[oper->data.reg.addr];
+	} else {
+		if (sim_operand_value(ctx, oper, &value))
+			return -1;
+		sim_value_bytes(value, raw, sizeof(raw));
+	}
+
+	switch (op) {
+	case OP_ENDIAN_BE16:
+		*output = (__s16)((b[0] << 8) | b[1]);
+		break;
+	case OP_ENDIAN_BE16_UN:
+		*output = (__u16)((b[0] << 8) | b[1]);
+		break;
+	case OP_ENDIAN_BE24:
+		*output = (b[0] << 16) | (b[1] << 8) | b[2];
+		break;
+	case OP_ENDIAN_BE32:
+		*output = (b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+		break;
+	case OP_ENDIAN_LE16:
+		*output = (__s16)((b[1] << 8) | b[0]);
+		break;
+	case OP_ENDIAN_LE16_UN:
+		*output = (__u16)((b[1] << 8) | b[0]);
+		break;
+	case OP_ENDIAN_LE24:
+		*output = (b[2] << 16) | (b[1] << 8) | b[0];
+		break;
+	case OP_ENDIAN_LE32:
+		*output = (b[3] << 24) | (b[2] << 16) | (b[1] << 8) | b[0];
+		break;
+	default:
+		return -1;
+	}
+
+	return 0;
+}
+
+/* = operation
+*  regbuf = reg: i2c read into register buf
+*  reg = value: i2c write, value is firstly written into register buf
+*  regbuf/index = value: plain store
+*/
+static int sim_access(struct sim_context *ctx, struct data_action *data,
+			__s32 *output)
+{
+	struct operand *dst = &data->operand1;
+	struct operand *src = &data->operand2;
+	struct sim_stats *stats = ctx->stats;
+	__s32 value;
+	int len;
+
+	if (dst->type == OPT_REG_BUF && src->type == OPT_REG) {
+		len = src->data.reg.len;
+		if (dst->data.reg.addr + len > SIM_REGS || ctx->bus->read(ctx->bus,
+			src->data.reg.addr, src->data.reg.flag,
+			&ctx->regbuf[dst->data.reg.addr], len)) {
+			printf("[%d]%s Fail to read reg 0x%02x\n",
+				__LINE__, __func__, src->data.reg.addr);
+			return -1;
+		}
+
+		stats->i2c_reads++;
+		stats->i2c_bytes += len;
+		stats->bus_us += sim_bus_us(len + 3);
+
+		*output = sim_bytes_value(&ctx->regbuf[dst->data.reg.addr],
+				len < sizeof(__s32) ? len : sizeof(__s32));
+		return 0;
+	}
+
+	if (sim_operand_value(ctx, src, &value))
+		return -1;
+
+	switch (dst->type) {
+	case OPT_REG:
+		len = dst->data.reg.len;
+		if (len > sizeof(__s32))
+			return -1;
+
+		sim_value_bytes(value, &ctx->regbuf[dst->data.reg.addr], len);
+		if (ctx->bus->write(ctx->bus, dst->data.reg.addr,
+			dst->data.reg.flag, &ctx->regbuf[dst->data.reg.addr], len)) {
+			printf("[%d]%s Fail to write reg 0x%02x\n",
+				__LINE__, __func__, dst->data.reg.addr);
+			return -1;
+		}
+
+		stats->i2c_writes++;
+		stats->i2c_bytes += len;
+		stats->bus_us += sim_bus_us(len + 2);
+		break;
+	case OPT_REG_BUF:
+		if (dst->data.reg.len > sizeof(__s32))
+			return -1;
+		sim_value_bytes(value, &ctx->regbuf[dst->data.reg.addr],
+						dst->data.reg.len);
+		break;
+	case OPT_INDEX:
+		if (dst->data.index < 0 || dst->data.index >= PRIVATE_MAX_SIZE)
+			return -1;
+		ctx->private_data[dst->data.index] = value;
+		break;
+	default:
+		printf("[%d]%s Error dst operand %d\n",
+				__LINE__, __func__, dst->type);
+		return -1;
+	}
+
+	*output = value;
+	return 0;
+}
+
+static int sim_data(struct sim_context *ctx, struct data_action *data)
+{
+	__s32 op1, op2;
+	__s32 ret;
+
+	if (data->op == OP_ACCESS) {
+		if (sim_access(ctx, data, &ret))
+			return -1;
+		ctx->before = ret;
+		return 0;
+	}
+
+	if (data->op >= OP_ENDIAN_BE16 && data->op <= OP_ENDIAN_LE32) {
+		if (sim_endian(ctx, data->op, &data->operand1, &ret))
+			return -1;
+		ctx->before = ret;
+		return 0;
+	}
+
+	if (sim_operand_value(ctx, &data->operand1, &op1))
+		return -1;
+
+	/*single operand*/
+	if (data->op == OP_BIT_NOR) {
+		ctx->before = ~op1;
+		return 0;
+	}
+
+	if (sim_operand_value(ctx, &data->operand2, &op2))
+		return -1;
+
+	switch (data->op) {
+	case OP_MIN:
+		ret = op1 < op2 ? op1 : op2;
+		break;
+	case OP_MAX:
+		ret = op1 > op2 ? op1 : op2;
+		break;
+
+	case OP_LOGIC_EQ:
+		ret = (op1 == op2);
+		break;
+	case OP_LOGIC_NEQ:
+		ret = (op1 != op2);
+		break;
+	case OP_LOGIC_GREATER:
+		ret = (op1 > op2);
+		break;
+	case OP_LOGIC_LESS:
+		ret = (op1 < op2);
+		break;
+	case OP_LOGIC_GE:
+		ret = (op1 >= op2);
+		break;
+	case OP_LOGIC_LE:
+		ret = (op1 <= op2);
+		break;
+	case OP_LOGIC_AND:
+		ret = (op1 && op2);
+		break;
+	case OP_LOGIC_OR:
+		ret = (op1 || op2);
+		break;
+
+	case OP_ARI_ADD:
+		ret = (op1 + op2);
+		break;
+	case OP_ARI_SUB:
+		ret = (op1 - op2);
+		break;
+	case OP_ARI_MUL:
+		ret = (op1 * op2);
+		break;
+	case OP_ARI_DIV:
+	case OP_ARI_MOD:
+		if (!op2) {
+			printf("[%d]%s Error divided by zero\n",
+						__LINE__, __func__);
+			return -1;
+		}
+		ret = data->op == OP_ARI_DIV ? op1 / op2 : op1 % op2;
+		break;
+
+	case OP_BIT_OR:
+		ret = (op1 | op2);
+		break;
+	case OP_BIT_AND:
+		ret = (op1 & op2);
+		break;
+	case OP_BIT_LSL:
+		ret = (op1 << op2);
+		break;
+	case OP_BIT_LSR:
+		ret = (op1 >> op2);
+		break;
+
+	default:
+		printf("[%d]%s Error op:%d\n", __LINE__, __func__, data->op);
+		return -1;
+	}
+
+	ctx->before = ret;
+	return 0;
+}
+
+/*same layout as dump_ll_action: ifelse is followed by con, if, else*/
+static int sim_exec_actions(struct sim_context *ctx,
+			struct lowlevel_action *actions, int num)
+{
+	int i;
+	int ret;
+
+	for (i = 0; i < num; i++, actions++)
+	{
+		ctx->stats->cycles++;
+
+		switch (actions->type) {
+		case DATA:
+			if (sim_data(ctx, &actions->action.data))
+				return -1;
+			break;
+
+		case SLEEP:
+			ctx->stats->sleep_ms += actions->action.sleep.ms;
+			break;
+
+		case RETURN:
+			return SIM_RETURNED;
+
+		case IFELSE: {
+			int num_con, num_if, num_else;
+
+			num_con = actions->action.ifelse.num_con;
+			num_if = actions->action.ifelse.num_if;
+			num_else = actions->action.ifelse.num_else;
+
+			if (num_con < 0 || num_if < 0 || num_else < 0 ||
+				i + num_con + num_if + num_else >= num) {
+				printf("[%d]%s Error ifelse %d:%d:%d\n", __LINE__,
+					__func__, num_con, num_if, num_else);
+				return -1;
+			}
+
+			ret = sim_exec_actions(ctx, actions + 1, num_con);
+			if (ret)
+				return ret;
+
+			if (ctx->before)
+				ret = sim_exec_actions(ctx,
+					actions + 1 + num_con, num_if);
+			else
+				ret = sim_exec_actions(ctx,
+					actions + 1 + num_con + num_if, num_else);
+			if (ret)
+				return ret;
+
+			i += (num_con + num_if + num_else);
+			actions += (num_con + num_if + num_else);
+			break;
+		}
+
+		default:
+			printf("[%d]%s Error wrong lowlevel actions %d\n",
+					__LINE__, __func__, actions->type);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*run one sensor action, input is the value seen by "input" operand*/
+int sim_run_actions(struct sim_context *ctx, struct lowlevel_action *actions,
+			int num, __s32 input, struct sim_stats *stats)
+{
+	int ret;
+
+	memset(stats, 0, sizeof(*stats));
+	memset(ctx->private_data, 0,
+		PRIVATE_MAX_SIZE / 2 * sizeof(ctx->private_data[0]));
+	ctx->before = input;
+	ctx->stats = stats;
+
+	ret = sim_exec_actions(ctx, actions, num);
+	stats->result = ctx->before;
+	ctx->stats = NULL;
+
+	return ret < 0 ? ret : 0;
+}
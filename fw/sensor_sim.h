@@ -0,0 +1,83 @@
+#ifndef SENSOR_SIM_H
+#define SENSOR_SIM_H
+
+/*
+* Userspace interpreter of lowlevel_action programs
+* Executes the packed actions of a sensor config image against
+* a pluggable i2c bus and counts what each sensor action costs
+*/
+
+/*bus clock used to estimate i2c transfer time*/
+#define SIM_I2C_HZ		400000
+#define SIM_REGS		0x100
+#define SIM_REGBUF_SIZE		(SIM_REGS + sizeof(__s32))
+
+/*
+* i2c bus seen by the interpreter
+* @read: read len bytes starting at register addr into buf
+* @write: write len bytes of buf starting at register addr
+* flag is the access flag of the register, e.g. auto increment bit
+* return 0 on success
+*/
+struct sim_bus {
+	int (*read)(struct sim_bus *bus, __u8 addr, __u8 flag,
+				__u8 *buf, int len);
+	int (*write)(struct sim_bus *bus, __u8 addr, __u8 flag,
+				__u8 *buf, int len);
+	void *priv;
+};
+
+/*
+* mock register file, default implementation of sim_bus
+* @regs: current register values
+* @preset: values loaded from register file, reapplied on reset
+* @preset_mask: nonzero if preset value is valid
+*/
+struct sim_regfile {
+	__u8 regs[SIM_REGS];
+	__u8 preset[SIM_REGS];
+	__u8 preset_mask[SIM_REGS];
+};
+
+/*
+* cost of one executed sensor action
+* @cycles: executed lowlevel actions
+* @i2c_reads, @i2c_writes: i2c transactions
+* @i2c_bytes: data bytes moved on the bus
+* @bus_us: estimated bus time at SIM_I2C_HZ
+* @sleep_ms: accumulated sleep
+* @result: output of the last operation or return
+*/
+struct sim_stats {
+	int cycles;
+	int i2c_reads;
+	int i2c_writes;
+	int i2c_bytes;
+	int bus_us;
+	int sleep_ms;
+	int result;
+};
+
+/*
+* execution state shared by all sensor actions of one sensor
+* global variables live in the upper half of private_data and
+* are kept across actions, local ones are cleared per action
+*/
+struct sim_context {
+	struct sim_bus *bus;
+	__u8 regbuf[SIM_REGBUF_SIZE];
+	__s32 private_data[PRIVATE_MAX_SIZE];
+	__s32 before;
+	struct sim_stats *stats;
+};
+
+void sim_regfile_bus(struct sim_regfile *regfile, struct sim_bus *bus);
+int sim_regfile_load(struct sim_regfile *regfile, const char *file);
+void sim_regfile_reset(struct sim_regfile *regfile,
+			struct sensor_config *config);
+
+void sim_context_init(struct sim_context *ctx, struct sim_bus *bus);
+int sim_run_actions(struct sim_context *ctx, struct lowlevel_action *actions,
+			int num, __s32 input, struct sim_stats *stats);
+
+#endif
@@ -31,8 +31,15 @@ LOCAL_MODULE_TAGS := optional
 LOCAL_CFLAGS := -DLOG_TAG=\"Sensors\" -DENABLE_ACCEL_ZCAL
 LOCAL_SRC_FILES := config.cpp                   \
                    ../InputEventReader.cpp      \
+                   ../EventLoop.cpp               \
+                   ../InputDeviceIndex.cpp        \
+                   ../SysfsControl.cpp            \
                    ../sensors.cpp               \
-                   ../SensorBase.cpp
+                   ../SensorBase.cpp            \
+                   ../SensorFusion.cpp          \
+                   ../FusionSensor.cpp          \
+                   ../SensorConfigBlob.cpp      \
+                   ../ConfigSourceStamp.cpp
 
 LOCAL_SRC_FILES +=  ../AccelSensor.cpp          \
                     ../LightSensor.cpp          \
@@ -60,7 +67,8 @@ LOCAL_MODULE_TAGS := optional
 LOCAL_CFLAGS := -DLOG_TAG=\"AccelerometerSimpleCalibration\"
 LOCAL_SHARED_LIBRARIES := liblog libcutils
 LOCAL_SRC_FILES := ../scalability/sensorcalibration/AccelerometerSimpleCalibration/accelerometer_simple_calibration.c \
-		   ../scalability/sensorcalibration/AccelerometerSimpleCalibration/accelerometer_simple_zcalibration.c
+		   ../scalability/sensorcalibration/AccelerometerSimpleCalibration/accelerometer_simple_zcalibration.c \
+		   ../scalability/sensorcalibration/AccelerometerSimpleCalibration/accelerometer_simple_calibration_window.c
 
 include $(BUILD_STATIC_LIBRARY)
 
@@ -72,10 +80,31 @@ LOCAL_MODULE_TAGS := optional
 LOCAL_CFLAGS := -DLOG_TAG=\"AccelerometerSimpleCalibration\"
 LOCAL_SHARED_LIBRARIES := liblog libcutils
 LOCAL_SRC_FILES := ../scalability/sensorcalibration/AccelerometerSimpleCalibration/accelerometer_simple_calibration.c \
-		   ../scalability/sensorcalibration/AccelerometerSimpleCalibration/accelerometer_simple_zcalibration.c
+		   ../scalability/sensorcalibration/AccelerometerSimpleCalibration/accelerometer_simple_zcalibration.c \
+		   ../scalability/sensorcalibration/AccelerometerSimpleCalibration/accelerometer_simple_calibration_window.c
 
 include $(BUILD_SHARED_LIBRARY)
 
+# Build-time compiler of sensor_hal_config_*.xml into the binary config
+# the HAL maps at open, see SensorConfigBlob.h
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := sensor_hal_config_compiler
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -DLOG_TAG=\"SensorConfigCompiler\" -DSENSOR_CONFIG_COMPILER
+LOCAL_SRC_FILES := config.cpp                   \
+                   ../SensorConfigBlob.cpp      \
+                   ../ConfigSourceStamp.cpp
+
+LOCAL_C_INCLUDES := $(COMMON_INCLUDES) \
+                    external/libxml2/include
+LOCAL_STATIC_LIBRARIES := libxml2 libcutils liblog
+
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(LOCAL_PATH)/../sensor_hal_config.mk
+
 endif # !TARGET_SIMULATOR
 
 else # USE_GENERAL_SENSOR_DRIVER True 
@@ -95,8 +124,15 @@ LOCAL_MODULE_TAGS := optional
 LOCAL_CFLAGS := -DLOG_TAG=\"Sensors\"
 LOCAL_SRC_FILES := config_general.cpp           \
                    ../InputEventReader.cpp      \
+                   ../EventLoop.cpp               \
+                   ../InputDeviceIndex.cpp        \
+                   ../SysfsControl.cpp            \
                    ../sensors.cpp               \
-                   ../SensorBase.cpp
+                   ../SensorBase.cpp            \
+                   ../SensorFusion.cpp          \
+                   ../FusionSensor.cpp          \
+                   ../SensorConfigBlob.cpp      \
+                   ../ConfigSourceStamp.cpp
 
 LOCAL_SRC_FILES +=  ../AccelSensor.cpp          \
                     ../LightSensor_input_general.cpp    \
@@ -116,6 +152,26 @@ LOCAL_PRELINK_MODULE := false
 
 include $(BUILD_SHARED_LIBRARY)
 
+# Build-time compiler of sensor_hal_config_*.xml into the binary config
+# the HAL maps at open, see SensorConfigBlob.h
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := sensor_hal_config_compiler
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -DLOG_TAG=\"SensorConfigCompiler\" -DSENSOR_CONFIG_COMPILER
+LOCAL_SRC_FILES := config_general.cpp           \
+                   ../SensorConfigBlob.cpp      \
+                   ../ConfigSourceStamp.cpp
+
+LOCAL_C_INCLUDES := $(COMMON_INCLUDES) \
+                    external/libxml2/include
+LOCAL_STATIC_LIBRARIES := libxml2 libcutils liblog
+
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(LOCAL_PATH)/../sensor_hal_config.mk
+
 endif # !TARGET_SIMULATOR
 
 endif # USE_GENERAL_SENSOR_DRIVER
@@ -15,13 +15,16 @@
  */
 
 #include "../sensors.h"
+#include "../SensorConfigBlob.h"
 
+#ifndef SENSOR_CONFIG_COMPILER
 #include "../LightSensor.h"
 #include "../ProximitySensor.h"
 #include "../AccelSensor.h"
 #include "../GyroSensor.h"
 #include "../CompassSensor.h"
 #include "../PressureSensor.h"
+#endif
 
 #include <stdlib.h>
 #include <string.h>
@@ -32,9 +35,12 @@
 static sensor_platform_config_t *sensor_configs;
 static struct sensor_t *sensor_list;
 static int sensor_count;
+static struct sensor_config_blob sensor_blob;
 void (* sensor_platform_finalize)();
 
 static int sensor_config_init_xml();
+static int sensor_config_init_blob(const char *file, const char *xml_file);
+static int sensor_config_load_xml(const char *file);
 static int sensor_config_init_sensors(xmlNodePtr node);
 static int sensor_config_get_platform_data(xmlNodePtr node, sensor_platform_config_t * config, const xmlChar *type);
 static int sensor_config_get_sensor(xmlNodePtr node, struct sensor_t *sensor_item, const xmlChar *type);
@@ -72,6 +78,7 @@ const struct sensor_t* get_platform_sensor_list(int *sensor_num)
     return sensor_list;
 }
 
+#ifndef SENSOR_CONFIG_COMPILER
 SensorBase **get_platform_sensors()
 {
     int num = sensor_count;
@@ -105,13 +112,12 @@ SensorBase **get_platform_sensors()
 
     return platform_sensors;
 }
+#endif
 
 static int sensor_config_init_xml() {
-    xmlDocPtr doc;
-    xmlNodePtr root;
     char buf[PROPERTY_VALUE_MAX];
     char *file_prefix = "/system/etc/sensor_hal_config_";
-    char file[PROPERTY_VALUE_MAX + 34];
+    char file[PROPERTY_VALUE_MAX + 34], xml_file[PROPERTY_VALUE_MAX + 34];
     int ret = -1;
 
     ret = property_get("ro.sensors.mapper", buf, NULL);
@@ -119,9 +125,46 @@ static int sensor_config_init_xml() {
         LOGE("Get sensors mapper property error! Use default config.\n");
 	strcpy(buf, "default");
     }
+    strcpy(xml_file, file_prefix);
+    strcat(xml_file, buf);
+    strcat(xml_file, ".xml");
     strcpy(file, file_prefix);
     strcat(file, buf);
-    strcat(file, ".xml");
+    strcat(file, ".bin");
+    if (!sensor_config_init_blob(file, xml_file))
+        return 0;
+
+    return sensor_config_load_xml(xml_file);
+}
+
+/* Precompiled config, see SensorConfigBlob.h */
+static int sensor_config_init_blob(const char *file, const char *xml_file) {
+    if (sensor_config_blob_load(file, xml_file, &sensor_blob, &sensor_configs, &sensor_list, &sensor_count))
+        return -1;
+    D("config blob: %s\n", file);
+
+    platform_sensors = (SensorBase **)calloc(sensor_count, sizeof(SensorBase *));
+    if (!platform_sensors) {
+        LOGE("malloc error!\n");
+        free(sensor_configs);
+        free(sensor_list);
+        sensor_configs = NULL;
+        sensor_list = NULL;
+        sensor_count = 0;
+        sensor_config_blob_release(&sensor_blob);
+        return -1;
+    }
+
+    dump();
+    sensor_platform_finalize = sensor_config_finalize;
+    return 0;
+}
+
+static int sensor_config_load_xml(const char *file) {
+    xmlDocPtr doc;
+    xmlNodePtr root;
+    int ret = -1;
+
     D("config file: %s\n", file);
 
     doc = xmlReadFile(file, NULL, XML_PARSE_NOBLANKS);
@@ -458,6 +501,15 @@ static char *generate_string(xmlChar *str) {
 static void sensor_config_finalize() {
     int i = 0;
 
+    if (sensor_blob.map) {
+        /* strings live in the mapping */
+        free(sensor_configs);
+        free(sensor_list);
+        free(platform_sensors);
+        sensor_config_blob_release(&sensor_blob);
+        return;
+    }
+
     if (sensor_configs) {
         for (i = 0; i < sensor_count; i++) {
             if ((sensor_configs + i)->name)
@@ -518,3 +570,22 @@ static void dump() {
         D("minDelay: %d\n", (sensor_list + i)->minDelay);
     }
 }
+
+#ifdef SENSOR_CONFIG_COMPILER
+/* Host build: compile the XML config into the blob sensor_config_init_blob() maps */
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <config.xml> <config.bin>\n", argv[0]);
+        return 1;
+    }
+
+    if (sensor_config_load_xml(argv[1]) ||
+        sensor_config_blob_write(argv[2], argv[1], sensor_configs, sensor_list, sensor_count)) {
+        fprintf(stderr, "%s: cannot compile %s\n", argv[0], argv[1]);
+        return 1;
+    }
+
+    return 0;
+}
+#endif
@@ -27,7 +27,15 @@ LOCAL_MODULE_PATH := $(TARGET_OUT_SHARED_LIBRARIES)/hw
 LOCAL_MODULE_TAGS := optional
 
 LOCAL_CFLAGS := -DLOG_TAG=\"Sensors\"
+# libsensorhub records start with the hub timestamp of the sample
+ifeq ($(SENSORHUB_EVENT_TIMESTAMP),true)
+LOCAL_CFLAGS += -DSENSORHUB_EVENT_TIMESTAMP
+endif
 LOCAL_SRC_FILES := SensorHAL.cpp    \
+                   ../EventLoop.cpp \
+                   ../InputDeviceIndex.cpp \
+                   ../SysfsControl.cpp     \
+                   ../ConfigSourceStamp.cpp \
                    DirectSensor.cpp \
                    PlatformConfig.cpp \
                    PSHSensor.cpp \
@@ -37,6 +45,10 @@ LOCAL_SRC_FILES := SensorHAL.cpp    \
                    MiscSensor.cpp \
                    PSHCommonSensor.cpp \
                    SensorHubHelper.cpp \
+                   SensorHubBinding.cpp \
+                   SensorHubStream.cpp \
+                   SensorHubDecimator.cpp \
+                   TimestampEstimator.cpp \
                    PedometerSensor.cpp \
                    PhysicalActivitySensor.cpp \
                    GestureSensor.cpp \
@@ -44,6 +56,7 @@ LOCAL_SRC_FILES := SensorHAL.cpp    \
                    AudioClassifierSensor.cpp
 
 LOCAL_C_INCLUDES := $(COMMON_INCLUDES) \
+                    $(LOCAL_PATH)/.. \
                     $(call include-path-for, stlport) \
                     $(call include-path-for, stlport)/stl \
                     $(call include-path-for, stlport)/using/h/ \
@@ -70,7 +83,7 @@ LOCAL_MODULE_TAGS := optional
 LOCAL_CFLAGS := -DLOG_TAG=\"SensorCalibration\"
 
 LOCAL_SHARED_LIBRARIES := liblog libcutils
-LOCAL_STATIC_LIBRARIES := libcompassgenericcalibration
+LOCAL_STATIC_LIBRARIES := libcompassgenericcalibration libgyroscopegenericcalibration
 
 LOCAL_SRC_FILES := sensorcalibration/SensorCalibration.c
 
@@ -92,6 +105,78 @@ LOCAL_SRC_FILES := sensorcalibration/CompassGenericCalibration/CompassGenericCal
 
 include $(BUILD_STATIC_LIBRARY)
 
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := libgyroscopegenericcalibration
+LOCAL_MODULE_PATH := $(TARGET_OUT_STATIC_LIBRARIES)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -DLOG_TAG=\"GyroscopeGenericCalibration\"
+# Zero-rate offset of the board's gyroscope in rad/s, if above the default
+ifneq ($(SENSOR_GYRO_CAL_MAX_BIAS),)
+LOCAL_CFLAGS += -DGYRO_CAL_MAX_BIAS=$(SENSOR_GYRO_CAL_MAX_BIAS)f
+endif
+
+LOCAL_SHARED_LIBRARIES := liblog libcutils
+
+LOCAL_SRC_FILES := sensorcalibration/GyroscopeGenericCalibration/GyroscopeGenericCalibration.c
+
+include $(BUILD_STATIC_LIBRARY)
+
+# libsensorhub stand-in and binding, for running the PSH sensor classes on
+# the host, see SensorHubStub.hpp
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := libsensorhubstub
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -DLOG_TAG=\"SensorHubStub\"
+LOCAL_SRC_FILES := SensorHubStub.cpp \
+                   SensorHubBinding.cpp
+
+LOCAL_C_INCLUDES := $(COMMON_INCLUDES) \
+                    $(call include-path-for, libsensorhub)
+
+include $(BUILD_HOST_STATIC_LIBRARY)
+
+# Build-time compiler of sensor_hal_config_*.xml into the binary config
+# PlatformConfig maps at HAL open
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := sensor_hal_config_compiler
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -DLOG_TAG=\"SensorConfigCompiler\"
+LOCAL_SRC_FILES := PlatformConfigCompiler.cpp \
+                   PlatformConfig.cpp \
+                   SensorDevice.cpp \
+                   ../ConfigSourceStamp.cpp
+
+LOCAL_C_INCLUDES := $(COMMON_INCLUDES) \
+                    $(LOCAL_PATH)/.. \
+                    $(call include-path-for, libxml2)
+
+LOCAL_STATIC_LIBRARIES := libxml2 libcutils liblog
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# Generator of the decimation filter tables checked in as
+# SensorHubDecimatorTaps.hpp, rerun it after changing the filter design:
+#   $ sensorhal_decimator_gen > SensorHubDecimatorTaps.hpp
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := sensorhal_decimator_gen
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_SRC_FILES := SensorHubDecimatorGen.cpp
+
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(LOCAL_PATH)/../sensor_hal_config.mk
+
+# Changes LOCAL_PATH, keep last
+include $(LOCAL_PATH)/tests/Android.mk
+
 endif # !TARGET_SIMULATOR
 
 endif
@@ -429,7 +429,7 @@ int AudioClassifierSensor::getPollfd() {
     return mResultPipe[0];
 }
 
-int AudioClassifierSensor::getData(std::queue<sensors_event_t> &eventQue) {
+int AudioClassifierSensor::getData() {
     LOGI("getData");
     int *p_audio_data;
     int size, numEventReceived = 0;
@@ -484,7 +484,7 @@ int AudioClassifierSensor::getData(std::queue<sensors_event_t> &eventQue) {
         event.data[1] = (static_cast<float>(ndBResult));
         event.timestamp = getTimestamp();
         LOGI("Event value is %d", *p_audio_data);
-        eventQue.push(event);
+        eventRing.push(event);
         numEventReceived++;
         size = size - unit_size;
         p = p + unit_size;
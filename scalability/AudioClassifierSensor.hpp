@@ -62,7 +62,7 @@ class AudioClassifierSensor : public PSHSensor
 public:
     AudioClassifierSensor(SensorDevice &device);
     virtual ~AudioClassifierSensor();
-    virtual int getData(std::queue<sensors_event_t> &eventQue);
+    virtual int getData();
     virtual int activate(int handle, int enabled);
     virtual int setDelay(int32_t handle, int64_t ns);
     virtual int getPollfd();
@@ -7,6 +7,7 @@ DirectSensor::DirectSensor(SensorDevice &mDevice, struct PlatformData &mData)
 {
         Calibration = NULL;
         DriverCalibration = NULL;
+        driverCalibrationPending = false;
         calibrationMethodsHandle = NULL;
         if (data.calibrationFunc.length() > 0 || (data.driverCalibrationFunc.length() > 0 && data.driverCalibrationInterface.length() > 0)) {
                 calibrationMethodsHandle = dlopen("/system/lib/libsensorcalibration.so", RTLD_LAZY);
@@ -12,6 +12,7 @@ protected:
         void* calibrationMethodsHandle;
         void (*Calibration)(struct sensors_event_t* event, calibration_flag_t flag, const char* configFile);
         void (*DriverCalibration)(struct sensors_event_t* event, calibration_flag_t flag, const char* configFile, const char* configNode);
+        bool driverCalibrationPending;  /* armed by activate(), run on the first sample */
 public:
         DirectSensor(SensorDevice &mDevice, struct PlatformData &mData);
         ~DirectSensor();
@@ -19,7 +20,7 @@ public:
         virtual int getPollfd() = 0;
         virtual int activate(int handle, int enabled) { return 0;}
         virtual int setDelay(int handle, int64_t ns) { return 0; }
-        virtual int getData(std::queue<sensors_event_t> &eventQue) = 0;
+        virtual int getData() = 0;
         virtual bool selftest() = 0;
 };
 
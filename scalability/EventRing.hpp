@@ -0,0 +1,70 @@
+#ifndef _EVENT_RING_HPP_
+#define _EVENT_RING_HPP_
+#include <hardware/sensors.h>
+#include <cutils/atomic.h>
+#include <stdint.h>
+
+#define CACHE_LINE_SIZE         64
+/* Must be a power of two and hold at least one full getData() read (512 bytes of 4-byte pipe records) */
+#define EVENT_RING_CAPACITY     128
+
+/*
+ * Fixed-capacity single-producer/single-consumer ring of sensor events.
+ * The producer is Sensor::getData(), the consumer is sensorPoll(). Head and
+ * tail live on separate cache lines and are published with acquire/release
+ * semantics, so no lock and no heap allocation is needed on the event path.
+ */
+class EventRing {
+        sensors_event_t slots[EVENT_RING_CAPACITY];
+        volatile int32_t head __attribute__((aligned(CACHE_LINE_SIZE)));   /* written by producer */
+        char headPad[CACHE_LINE_SIZE - sizeof(int32_t)];
+        volatile int32_t tail __attribute__((aligned(CACHE_LINE_SIZE)));   /* written by consumer */
+        char tailPad[CACHE_LINE_SIZE - sizeof(int32_t)];
+        uint32_t overruns;
+public:
+        EventRing() : head(0), tail(0), overruns(0) {}
+
+        /* Indices run freely and wrap; differences are taken unsigned */
+        int size() const
+        {
+                return static_cast<uint32_t>(android_atomic_acquire_load(&head)) -
+                       static_cast<uint32_t>(android_atomic_acquire_load(&tail));
+        }
+
+        bool empty() const { return size() == 0; }
+
+        int space() const { return EVENT_RING_CAPACITY - size(); }
+
+        uint32_t getOverruns() const { return overruns; }
+
+        /* Producer side: returns false and drops the event if the ring is full */
+        bool push(const sensors_event_t &event)
+        {
+                uint32_t h = head;
+
+                if (h - static_cast<uint32_t>(android_atomic_acquire_load(&tail)) >= EVENT_RING_CAPACITY) {
+                        overruns++;
+                        return false;
+                }
+
+                slots[h & (EVENT_RING_CAPACITY - 1)] = event;
+                android_atomic_release_store(static_cast<int32_t>(h + 1), &head);
+                return true;
+        }
+
+        /* Consumer side: copies up to count events into data, returns the number copied */
+        int drain(sensors_event_t *data, int count)
+        {
+                uint32_t t = tail;
+                int avail = static_cast<uint32_t>(android_atomic_acquire_load(&head)) - t;
+                int n = avail < count ? avail : count;
+
+                for (int i = 0; i < n; i++)
+                        data[i] = slots[(t + i) & (EVENT_RING_CAPACITY - 1)];
+
+                android_atomic_release_store(static_cast<int32_t>(t + n), &tail);
+                return n;
+        }
+};
+
+#endif
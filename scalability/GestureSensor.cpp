@@ -21,7 +21,6 @@
 #include <poll.h>
 #include <unistd.h>
 #include <dirent.h>
-#include <sys/select.h>
 
 #include <cutils/log.h>
 #include <utils/AndroidThreads.h>
@@ -37,21 +36,28 @@ GestureSensor::GestureSensor(SensorDevice &device)
         : PSHSensor(device),
           mEnabled(0)
 {
-        mPollingThreadIDGyro= THREAD_NOT_STARTED;
-        mPollingThreadIDProximity = THREAD_NOT_STARTED;
-        mPollingThreadIDAccel = THREAD_NOT_STARTED;
+        mPollingThreadID = THREAD_NOT_STARTED;
         mFlagProximity = false;
-        mHandleGyro= PSH_SESSION_NOT_OPENED;
-        mHandleProximity = PSH_SESSION_NOT_OPENED;
-        mHandleAccel = PSH_SESSION_NOT_OPENED;
-        mWakeFdsGyro[0] = mWakeFdsGyro[1] = PIPE_NOT_OPENED;
-        mWakeFdsProximity[0] = mWakeFdsProximity[1] = PIPE_NOT_OPENED;
-        mWakeFdsAccel[0] = mWakeFdsAccel[1] = PIPE_NOT_OPENED;
+        memset(mDataGyro, 0, sizeof(mDataGyro));
+        /* accel, gyro and proximity are shared with the plain sensors at the highest requested rate */
+        mStreamGyro = SensorHubStream::getStream(SENSOR_GYRO);
+        mStreamProximity = SensorHubStream::getStream(SENSOR_PROXIMITY);
+        mStreamAccel = SensorHubStream::getStream(SENSOR_ACCELEROMETER);
+        mClientGyro = SENSORHUB_STREAM_NO_CLIENT;
+        mClientProximity = SENSORHUB_STREAM_NO_CLIENT;
+        mClientAccel = SENSORHUB_STREAM_NO_CLIENT;
+        mWakeFds[0] = mWakeFds[1] = PIPE_NOT_OPENED;
         mResultPipe[0] = mResultPipe[1] = PIPE_NOT_OPENED;
         mInitGesture = false;
 
         // Establish result pipe to sensor HAL
-        pipe(mResultPipe);
+        if (pipe(mResultPipe) == 0) {
+                /* a full pipe already guarantees a wakeup, getData() drains it */
+                fcntl(mResultPipe[0], F_SETFL, O_NONBLOCK);
+                fcntl(mResultPipe[1], F_SETFL, O_NONBLOCK);
+        } else {
+                mResultPipe[0] = mResultPipe[1] = PIPE_NOT_OPENED;
+        }
 
         // Start to load libgesture library
         mLibraryHandle = NULL;
@@ -83,6 +89,7 @@ GestureSensor::GestureSensor(SensorDevice &device)
 GestureSensor::~GestureSensor()
 {
         LOGI("~GestureSensor %d\n", mEnabled);
+        Stop_worker();
         Stop_accel();
         Stop_gyro();
         Stop_proximity();
@@ -115,12 +122,13 @@ int GestureSensor::activate(int32_t handle, int en)
                 return 0;
 
         if (en == 1) {
-                bool proximityThreadStarted = Start_proximity();
-                bool gyroThreadStarted = Start_gyro();
-                bool acclThreadStarted = Start_accel();
+                bool proximityStarted = Start_proximity();
+                bool gyroStarted = Start_gyro();
+                bool acclStarted = Start_accel();
 
-                if (!acclThreadStarted || !proximityThreadStarted || !gyroThreadStarted) {
-                        LOGE("Failed to start gesture or proximity thread");
+                if (!acclStarted || !proximityStarted || !gyroStarted || !Start_worker()) {
+                        LOGE("Failed to start gesture worker");
+                        Stop_worker();
                         Stop_accel();
                         Stop_gyro();
                         Stop_proximity();
@@ -128,6 +136,7 @@ int GestureSensor::activate(int32_t handle, int en)
                 }
                 mEnabled = 1;
         } else {
+                Stop_worker();
                 Stop_accel();
                 Stop_gyro();
                 Stop_proximity();
@@ -160,36 +169,27 @@ bool GestureSensor::selftest()
                 return false;
         }
 }
-int GestureSensor::getData(queue<sensors_event_t> & eventQue)
+int GestureSensor::getData()
 {
-        int size, numEventReceived = 0;
-        char buf[512];
-        int *p_gesture_data;
-        int unit_size = sizeof(*p_gesture_data);
-
-        LOGI("GestureSensor - getData");
+        char doorbell[64];
+        sensors_event_t results[16];
+        int n, numEventReceived = 0;
 
         if (mResultPipe[0] == PIPE_NOT_OPENED) {
                 LOGI("invalid status ");
                 return 0;
         }
-        size = (512 / unit_size) * unit_size;
-
-        LOGI("Try to read %d", size);
-        size = read(mResultPipe[0], buf, size);
-        LOGI("Actually read %d", size);
 
-        char *p = buf;
-        while (size > 0) {
-                p_gesture_data = (int *)(p);
-                event.data[0] = (*p_gesture_data);
-                LOGI("Event value is %d", *p_gesture_data);
+        /* Clear the wakeups before draining, a result queued after this rings again */
+        while (read(mResultPipe[0], doorbell, sizeof(doorbell)) == sizeof(doorbell))
+                ;
 
-                eventQue.push(event);
-                numEventReceived++;
-
-                size = size - unit_size;
-                p = p + unit_size;
+        while ((n = mResults.drain(results, ARRAY_SIZE(results))) > 0) {
+                for (int i = 0; i < n; i++) {
+                        LOGI("Event value is %d", static_cast<int>(results[i].data[0]));
+                        eventRing.push(results[i]);
+                }
+                numEventReceived += n;
         }
 
         LOGI("GestureSensor - read %d events", numEventReceived);
@@ -219,350 +219,223 @@ int GestureSensor::getGestureFromString(char *gesture)
 }
 
 /* Additional Method */
-/* thread to process raw accel and gyro data with libgesture */
-void* GestureSensor::PollingThread_accel(void *source)
+/* run libgesture on accel samples, with the latest gyro sample and proximity state */
+void GestureSensor::processAccel(int count)
 {
-        LOGD("context thread start: wait for accel data");
-        GestureSensor* tSrc = static_cast<GestureSensor*>(source);
-
-        int fd = methods.psh_get_fd(tSrc->mHandleAccel);
-        char* buf = new char[GS_BUF_SIZE];
-        int size = 0;
-        struct accel_data *p_accel_data;
-        fd_set listen_fds, read_fds;
-        int ret, max_fd;
-
-        FD_ZERO(&read_fds);
-        FD_SET(fd, &read_fds);
-        FD_SET(tSrc->mWakeFdsAccel[0], &read_fds);
-
-        if (fd > tSrc->mWakeFdsAccel[0])
-                max_fd = fd;
-        else
-                max_fd = tSrc->mWakeFdsAccel[0];
-
-        while ((ret = (select(max_fd +1, &read_fds, NULL, NULL, NULL)) >= 0)) {
-                /* if sensor is shut down, return */
-                if (FD_ISSET(tSrc->mWakeFdsAccel[0], &read_fds)) {
-                        LOGD("context thread end - gesture");
-                        break;
-                }
-                /* get accel sensor data */
-                size = read(fd, buf, GS_BUF_SIZE);
-                char *p = buf;
-                p_accel_data = (struct accel_data *)buf;
-                while (size > 0) {
-                        short data[6];
-                        data[0] = p_accel_data->x;
-                        data[1] = p_accel_data->y;
-                        data[2] = p_accel_data->z;
-                        tSrc->mMutexGyro.lock();
-                        data[3] = tSrc->mDataGyro[0];
-                        data[4] = tSrc->mDataGyro[1];
-                        data[5] = tSrc->mDataGyro[2];
-                        tSrc->mMutexGyro.unlock();
-                        //LOGD("%hd %hd %hd %hd %hd %hd", data[0], data[1], data[2], data[3], data[4], data[5]);
-
-                        /* process with libgesture */
-                        /* CAUTION: this function is not multi-thread safe */
-                        tSrc->mMutexAccel.lock();
-                        char *gesture = (*tSrc->mGestureProcessSingleData)(data, false, false);
-                        tSrc->mMutexAccel.unlock();
-
-                        /* if gesture is detected */
-                        if (gesture != NULL) {
-                                LOGD("-- gesture: %s", gesture);
-                                /* change EarTouchL to EarTouch, same as EarTouchLBack */
-                                if (strcmp(gesture, "EarTouchL ") == 0)
-                                        strcpy(gesture, "EarTouch ");
-                                else if (strcmp(gesture, "EarTouchLBack ") == 0)
-                                        strcpy(gesture, "EarTouchBack ");
-                                tSrc->mMutexProximity.lock();
-                                bool f1 = tSrc->mFlagProximity;
-                                tSrc->mMutexProximity.unlock();
-                                bool f2 = (strcmp(gesture, "EarTouch ") == 0);
-                                /* eartouch end with prox = 1, others end with prox = 0 */
-                                if ((f1 && f2) || ((!f1) && (!f2))) {
-                                        int gestureResult = getGestureFromString(gesture);
-                                        if (gestureResult != INVALID_GESTURE_RESULT) {
-                                                LOGI("write into result pipe start");
-                                                write(tSrc->mResultPipe[1], (char*)(&gestureResult),
-                                                      sizeof(gestureResult));
-                                                LOGI("write into result pipe end");
-                                        }
+        for (int i = 0; i < count; i++) {
+                short data[6];
+                data[0] = mAccelData[i].x;
+                data[1] = mAccelData[i].y;
+                data[2] = mAccelData[i].z;
+                data[3] = mDataGyro[0];
+                data[4] = mDataGyro[1];
+                data[5] = mDataGyro[2];
+                //LOGD("%hd %hd %hd %hd %hd %hd", data[0], data[1], data[2], data[3], data[4], data[5]);
+
+                /* process with libgesture */
+                /* CAUTION: this function is not multi-thread safe, only the worker calls it */
+                char *gesture = (*mGestureProcessSingleData)(data, false, false);
+
+                /* if gesture is detected */
+                if (gesture != NULL) {
+                        LOGD("-- gesture: %s", gesture);
+                        /* change EarTouchL to EarTouch, same as EarTouchLBack */
+                        if (strcmp(gesture, "EarTouchL ") == 0)
+                                strcpy(gesture, "EarTouch ");
+                        else if (strcmp(gesture, "EarTouchLBack ") == 0)
+                                strcpy(gesture, "EarTouchBack ");
+                        bool f1 = mFlagProximity;
+                        bool f2 = (strcmp(gesture, "EarTouch ") == 0);
+                        /* eartouch end with prox = 1, others end with prox = 0 */
+                        if ((f1 && f2) || ((!f1) && (!f2))) {
+                                int gestureResult = getGestureFromString(gesture);
+                                if (gestureResult != INVALID_GESTURE_RESULT) {
+                                        sensors_event_t result = event;
+                                        result.data[0] = gestureResult;
+                                        result.timestamp = getTimestamp();
+                                        if (mResults.push(result))
+                                                write(mResultPipe[1], "g", 1);
+                                        else
+                                                LOGE("gesture result queue full, dropped %d", gestureResult);
                                 }
                         }
-                        delete [] gesture;
-                        size = size - sizeof(struct accel_data);
-                        p = p + sizeof(struct accel_data);
-                        p_accel_data = (struct accel_data *)p;
                 }
-                FD_SET(fd, &read_fds);
-                FD_SET(tSrc->mWakeFdsAccel[0], &read_fds);
+                delete [] gesture;
         }
-        delete [] buf;
-        pthread_exit(NULL);
-        return NULL;
 }
 
-/* thread to process proximity data */
-void* GestureSensor::PollingThread_proximity(void *source)
+/* keep the latest gyro sample for processAccel() */
+void GestureSensor::processGyro(int count)
 {
-        LOGD("context thread start: wait for proximity data");
-        GestureSensor* termSrc = static_cast<GestureSensor*>(source);
-
-        int fd = methods.psh_get_fd(termSrc->mHandleProximity);
-        char* buf = new char[PX_BUF_SIZE];
-        int size = 0;
-        struct ps_phy_data *p_ps_phy_data;
-        fd_set listen_fds, read_fds;
-        int ret, max_fd;
-
-        FD_ZERO(&read_fds);
-        FD_SET(fd, &read_fds);
-        FD_SET(termSrc->mWakeFdsProximity[0], &read_fds);
-
-        if (fd > termSrc->mWakeFdsProximity[0])
-                max_fd = fd;
-        else
-                max_fd = termSrc->mWakeFdsProximity[0];
+        if (count <= 0)
+                return;
+        mDataGyro[0] = mGyroData[count - 1].x;
+        mDataGyro[1] = mGyroData[count - 1].y;
+        mDataGyro[2] = mGyroData[count - 1].z;
+}
+
+/* keep the latest proximity state for processAccel() */
+void GestureSensor::processProximity(int count)
+{
+        if (count <= 0)
+                return;
+        LOGD("-- proximity: %d", mProximityData[count - 1].near);
+        mFlagProximity = mProximityData[count - 1].near == 1;
+}
 
-        while ((ret = (select(max_fd +1, &read_fds, NULL, NULL, NULL)) >= 0)) {
+/* worker thread: one poll set for all three streams */
+void* GestureSensor::PollingThread(void *source)
+{
+        LOGD("context thread start: wait for accel, gyro and proximity data");
+        GestureSensor* tSrc = static_cast<GestureSensor*>(source);
+        struct pollfd polls[4];
+        ssize_t size;
+
+        /* proximity and gyro first, so accel samples of the same wakeup see their latest state */
+        polls[0].fd = tSrc->mWakeFds[0];
+        polls[1].fd = tSrc->mStreamProximity->getFd(tSrc->mClientProximity);
+        polls[2].fd = tSrc->mStreamGyro->getFd(tSrc->mClientGyro);
+        polls[3].fd = tSrc->mStreamAccel->getFd(tSrc->mClientAccel);
+        for (int i = 0; i < 4; i++)
+                polls[i].events = POLLIN;
+
+        while (true) {
+                for (int i = 0; i < 4; i++)
+                        polls[i].revents = 0;
+                if (poll(polls, 4, -1) < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        LOGE("context thread poll error: %s", strerror(errno));
+                        break;
+                }
                 /* if sensor is shut down, return */
-                if (FD_ISSET(termSrc->mWakeFdsProximity[0], &read_fds)) {
-                        LOGD("context thread end - proximity");
+                if (polls[0].revents & POLLIN) {
+                        LOGD("context thread end - gesture");
                         break;
                 }
-                /* get proximity sensor data */
-                size = read(fd, buf, PX_BUF_SIZE);
-                char *p = buf;
-                p_ps_phy_data = (struct ps_phy_data *) buf;
-                while (size > 0) {
-                        LOGD("-- proximity: %d", p_ps_phy_data->near);
-                        termSrc->mMutexProximity.lock();
-                        if (p_ps_phy_data->near == 1)
-                                termSrc->mFlagProximity = true;
-                        else
-                                termSrc->mFlagProximity = false;
-                        termSrc->mMutexProximity.unlock();
-                        size = size - (sizeof(struct ps_phy_data));
-                        p = p + sizeof(struct ps_phy_data);
-                        p_ps_phy_data = (struct ps_phy_data *)p;
+                /* streams deliver whole records, the buffers hold a whole number of them */
+                if (polls[1].revents & POLLIN) {
+                        size = read(polls[1].fd, tSrc->mProximityData, sizeof(tSrc->mProximityData));
+                        if (size > 0)
+                                tSrc->processProximity(size / sizeof(struct ps_phy_data));
+                }
+                if (polls[2].revents & POLLIN) {
+                        size = read(polls[2].fd, tSrc->mGyroData, sizeof(tSrc->mGyroData));
+                        if (size > 0)
+                                tSrc->processGyro(size / sizeof(struct gyro_raw_data));
+                }
+                if (polls[3].revents & POLLIN) {
+                        size = read(polls[3].fd, tSrc->mAccelData, sizeof(tSrc->mAccelData));
+                        if (size > 0)
+                                tSrc->processAccel(size / sizeof(struct accel_data));
                 }
-                FD_SET(fd, &read_fds);
-                FD_SET(termSrc->mWakeFdsProximity[0], &read_fds);
         }
-        delete [] buf;
-        pthread_exit(NULL);
         return NULL;
 }
 
-/* thread to process gyro data */
-void* GestureSensor::PollingThread_gyro(void *source)
+bool GestureSensor::Start_worker()
 {
-        LOGD("context thread start: wait for gyro data");
-        GestureSensor* termSrc = static_cast<GestureSensor*>(source);
-
-        int fd = methods.psh_get_fd(termSrc->mHandleGyro);
-        char* buf = new char[GS_BUF_SIZE];
-        int size = 0;
-        struct gyro_raw_data *p_gyro_raw_data;
-        fd_set listen_fds, read_fds;
-        int ret, max_fd;
-
-        FD_ZERO(&read_fds);
-        FD_SET(fd, &read_fds);
-        FD_SET(termSrc->mWakeFdsGyro[0], &read_fds);
-
-        if (fd > termSrc->mWakeFdsGyro[0])
-                max_fd = fd;
-        else
-                max_fd = termSrc->mWakeFdsGyro[0];
+        LOGD("init pthread - gesture");
+        if (pipe(mWakeFds) < 0) {
+                mWakeFds[0] = mWakeFds[1] = PIPE_NOT_OPENED;
+                return false;
+        }
+        if (pthread_create(&mPollingThreadID, NULL, PollingThread, this) != 0) {
+                mPollingThreadID = THREAD_NOT_STARTED;
+                return false;
+        }
+        return true;
+}
 
-        while ((ret = (select(max_fd +1, &read_fds, NULL, NULL, NULL)) >= 0)) {
-                /* if sensor is shut down, return */
-                if (FD_ISSET(termSrc->mWakeFdsGyro[0], &read_fds)) {
-                        LOGD("context thread end - gyro");
-                        break;
-                }
-                /* get gyro sensor data */
-                size = read(fd, buf, PX_BUF_SIZE);
-                char *p = buf;
-                p_gyro_raw_data = (struct gyro_raw_data *)buf;
-                while (size > 0) {
-                        termSrc->mMutexGyro.lock();
-                        termSrc->mDataGyro[0] = p_gyro_raw_data->x;
-                        termSrc->mDataGyro[1] = p_gyro_raw_data->y;
-                        termSrc->mDataGyro[2] = p_gyro_raw_data->z;
-                        termSrc->mMutexGyro.unlock();
-                        size = size - sizeof(struct gyro_raw_data);
-                        p = p + sizeof(struct gyro_raw_data);
-                        p_gyro_raw_data = (struct gyro_raw_data *)p;
-                }
-                FD_SET(fd, &read_fds);
-                FD_SET(termSrc->mWakeFdsGyro[0], &read_fds);
+void GestureSensor::Stop_worker()
+{
+        if (mPollingThreadID != THREAD_NOT_STARTED) {
+                LOGD("stop pthread - gesture");
+                write(mWakeFds[1], "a", 1);
+                pthread_join(mPollingThreadID, NULL);
+                mPollingThreadID = THREAD_NOT_STARTED;
         }
-        delete [] buf;
-        pthread_exit(NULL);
-        return NULL;
+        if (mWakeFds[0] != PIPE_NOT_OPENED)
+                close(mWakeFds[0]);
+        if (mWakeFds[1] != PIPE_NOT_OPENED)
+                close(mWakeFds[1]);
+        mWakeFds[0] = mWakeFds[1] = PIPE_NOT_OPENED;
 }
 
 /* start gesture algorithm, and start accel in psh */
-/* start accel polling thread */
 bool GestureSensor::Start_accel()
 {
-        mMutexAccel.lock();
         bool r = (*mGestureInit)(0, NULL);  /* use default model */
-        mMutexAccel.unlock();
         mInitGesture = true;
         if (r == true) {
                 LOGD("init psh sensor hub - accel");
-                mHandleAccel = methods.psh_open_session(SENSOR_ACCELEROMETER);
-                if (mHandleAccel != PSH_SESSION_NOT_OPENED) {
-                        error_t ret;
-                        ret = methods.psh_start_streaming(mHandleAccel,
-                                                          GS_SAMPLE_RATE, GS_BUF_DELAY);
-                        if (ret == ERROR_NONE) {
-                                LOGD("init pthread - accel");
-                                pipe(mWakeFdsAccel);
-                                int err = pthread_create(&mPollingThreadIDAccel, NULL,
-                                                         PollingThread_accel, this);
-                                if (err == 0)
-                                        return true;
-                        }
-                }
+                mClientAccel = mStreamAccel->attach();
+                if (mClientAccel != SENSORHUB_STREAM_NO_CLIENT &&
+                    mStreamAccel->start(mClientAccel, GS_SAMPLE_RATE, GS_BUF_DELAY) > 0)
+                        return true;
         }
         Stop_accel();
         LOGE("psh & algorithm start return false - gesture");
         return false;
 }
 
-/* stop gesture algorithm, and stop accel in psh */
-/* stop accel polling thread */
+/* stop gesture algorithm, and stop accel in psh, the worker is already stopped */
 void GestureSensor::Stop_accel()
 {
         if (mInitGesture == true) {
                 LOGD("stop algorithm - gesture");
-                mMutexAccel.lock();
                 (*mGestureClose)();
-                mMutexAccel.unlock();
                 mInitGesture = false;
         }
-        if (mHandleAccel != PSH_SESSION_NOT_OPENED) {
+        if (mClientAccel != SENSORHUB_STREAM_NO_CLIENT) {
                 LOGD("stop sensor hub - accel");
-                methods.psh_stop_streaming(mHandleAccel);
-                methods.psh_close_session(mHandleAccel);
-                mHandleAccel = PSH_SESSION_NOT_OPENED;
-        }
-        if (mPollingThreadIDAccel != THREAD_NOT_STARTED) {
-                LOGD("stop pthread - accel");
-                write(mWakeFdsAccel[1], "a", 1);
-                if (mPollingThreadIDAccel != THREAD_NOT_STARTED) {
-                        pthread_join(mPollingThreadIDAccel, NULL);
-                        mPollingThreadIDAccel = THREAD_NOT_STARTED;
-                }
+                mStreamAccel->detach(mClientAccel);
+                mClientAccel = SENSORHUB_STREAM_NO_CLIENT;
         }
-        if (mWakeFdsAccel[0] != PIPE_NOT_OPENED)
-                close(mWakeFdsAccel[0]);
-        if (mWakeFdsAccel[1] != PIPE_NOT_OPENED)
-                close(mWakeFdsAccel[1]);
-        mWakeFdsAccel[0] = mWakeFdsAccel[1] = PIPE_NOT_OPENED;
 }
 
 /* start proximity in psh */
-/* start proximity polling thread */
 bool GestureSensor::Start_proximity()
 {
         LOGD("init psh sensor hub - proximity");
-        mHandleProximity = methods.psh_open_session(SENSOR_PROXIMITY);
-        if (mHandleProximity != PSH_SESSION_NOT_OPENED) {
-                error_t ret;
-                ret = methods.psh_start_streaming(mHandleProximity,
-                                                  PX_SAMPLE_RATE, PX_BUF_DELAY);
-                if (ret == ERROR_NONE) {
-                        LOGD("init pthread - proximity");
-                        pipe(mWakeFdsProximity);
-                        int err = pthread_create(&mPollingThreadIDProximity, NULL,
-                                                 PollingThread_proximity, this);
-                        if (err == 0)
-                                return true;
-                }
-        }
+        mClientProximity = mStreamProximity->attach();
+        if (mClientProximity != SENSORHUB_STREAM_NO_CLIENT &&
+            mStreamProximity->start(mClientProximity, PX_SAMPLE_RATE, PX_BUF_DELAY) > 0)
+                return true;
         Stop_proximity();
         LOGE("psh start return false - proximity");
         return false;
 }
 
 /* stop proximity in psh */
-/* stop proximity polling thread */
 void GestureSensor::Stop_proximity()
 {
-        if (mHandleProximity != PSH_SESSION_NOT_OPENED) {
+        if (mClientProximity != SENSORHUB_STREAM_NO_CLIENT) {
                 LOGD("stop sensor hub - proximity");
-                methods.psh_stop_streaming(mHandleProximity);
-                methods.psh_close_session(mHandleProximity);
-                mHandleProximity = PSH_SESSION_NOT_OPENED;
+                mStreamProximity->detach(mClientProximity);
+                mClientProximity = SENSORHUB_STREAM_NO_CLIENT;
         }
-        if (mPollingThreadIDProximity != THREAD_NOT_STARTED) {
-                LOGD("stop pthread - proximity");
-                write(mWakeFdsProximity[1], "a", 1);
-                if (mPollingThreadIDProximity != THREAD_NOT_STARTED) {
-                        pthread_join(mPollingThreadIDProximity, NULL);
-                        mPollingThreadIDProximity = THREAD_NOT_STARTED;
-                }
-        }
-        if (mWakeFdsProximity[0] != PIPE_NOT_OPENED)
-                close(mWakeFdsProximity[0]);
-        if (mWakeFdsProximity[1] != PIPE_NOT_OPENED)
-                close(mWakeFdsProximity[1]);
-        mWakeFdsProximity[0] = mWakeFdsProximity[1] = PIPE_NOT_OPENED;
 }
 
 /* start gyro in psh */
-/* start gyro polling thread */
 bool GestureSensor::Start_gyro()
 {
         LOGD("init psh sensor hub - gyro");
-        mHandleGyro = methods.psh_open_session(SENSOR_GYRO);
-        if (mHandleGyro != PSH_SESSION_NOT_OPENED) {
-                error_t ret;
-                ret = methods.psh_start_streaming(mHandleGyro,
-                                                  GS_SAMPLE_RATE, GS_BUF_DELAY);
-                if (ret == ERROR_NONE) {
-                        LOGD("init pthread - gyro");
-                        pipe(mWakeFdsGyro);
-                        int err = pthread_create(&mPollingThreadIDGyro, NULL,
-                                                 PollingThread_gyro, this);
-                        if (err == 0)
-                                return true;
-                }
-        }
+        mClientGyro = mStreamGyro->attach();
+        if (mClientGyro != SENSORHUB_STREAM_NO_CLIENT &&
+            mStreamGyro->start(mClientGyro, GS_SAMPLE_RATE, GS_BUF_DELAY) > 0)
+                return true;
         Stop_gyro();
         LOGE("psh start return false - gyro");
         return false;
 }
 
 /* stop gyro in psh */
-/* stop gyro polling thread */
 void GestureSensor::Stop_gyro()
 {
-        if (mHandleGyro != PSH_SESSION_NOT_OPENED) {
+        if (mClientGyro != SENSORHUB_STREAM_NO_CLIENT) {
                 LOGD("stop sensor hub - gyro");
-                methods.psh_stop_streaming(mHandleGyro);
-                methods.psh_close_session(mHandleGyro);
-                mHandleGyro = NULL;
-        }
-        if (mPollingThreadIDGyro != THREAD_NOT_STARTED) {
-                LOGD("stop pthread - gyro");
-                write(mWakeFdsGyro[1], "a", 1);
-                if (mPollingThreadIDGyro != THREAD_NOT_STARTED) {
-                        pthread_join(mPollingThreadIDGyro, NULL);
-                        mPollingThreadIDGyro = THREAD_NOT_STARTED;
-                }
+                mStreamGyro->detach(mClientGyro);
+                mClientGyro = SENSORHUB_STREAM_NO_CLIENT;
         }
-        if (mWakeFdsGyro[0] != PIPE_NOT_OPENED)
-                close(mWakeFdsGyro[0]);
-        if (mWakeFdsGyro[1] != PIPE_NOT_OPENED)
-                close(mWakeFdsGyro[1]);
-        mWakeFdsGyro[0] = mWakeFdsGyro[1] = PIPE_NOT_OPENED;
 }
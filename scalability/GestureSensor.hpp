@@ -22,8 +22,8 @@
 #include <sys/cdefs.h>
 #include <sys/types.h>
 #include <dlfcn.h>
-#include <utils/Mutex.h>
 #include "PSHSensor.hpp"
+#include "SensorHubStream.hpp"
 
 /*****************************************************************************/
 /*
@@ -45,17 +45,13 @@
  *   Number Nine
  *   Number Zero
  *
- * When this virtual sensor is enabled, three threads will be started
- * One thread tracking proximity data
- * The thread tracking gyro data, and do glyph-gesture detection algorithm
- * The other thread is monitering proximity status to improve precision of glyph detection
+ * When this virtual sensor is enabled, one worker thread is started
+ * It tracks proximity and gyro data and runs the glyph-gesture detection algorithm
+ * on accel data, using proximity status to improve precision of glyph detection
  *
- * There's a pipe setup between the thread which runs algorithm and sensor manager to
- * report gesture event
+ * Gesture events are handed to sensor manager through an in-process queue
  */
 
-using android::Mutex;
-
 #define SYMBOL_GESTURE_PROCESS_SINGLE_DATA "gesture_process_single_data"
 #define SYMBOL_GESTURE_INIT "gesture_initial"
 #define SYMBOL_GESTURE_CLOSE "gesture_close"
@@ -72,7 +68,7 @@ public:
         GestureSensor() {};
         GestureSensor(SensorDevice &device);
         virtual ~GestureSensor();
-        virtual int getData(std::queue<sensors_event_t> &eventQue);
+        virtual int getData();
         virtual int activate(int32_t handle, int enabled);
         virtual int setDelay(int32_t handle, int64_t ns);
         virtual int getPollfd();
@@ -80,45 +76,43 @@ public:
 
 private:
         /**
-         * Thread starts when sensor is activated, stops when sensor is deactivated
-         * In thread, read PSH accel output, and call libgesture libgesturespotting API
-         * to process data;
+         * Worker starts when sensor is activated, stops when sensor is deactivated
+         * It polls the accel, gyro and proximity streams in one poll set, keeps the
+         * latest gyro sample and proximity state, and feeds every accel sample
+         * together with them to libgesture. Detected gestures are queued on
+         * mResults and the HAL poll loop is woken through mResultPipe.
          */
-        static void*            PollingThread_accel(void* data);
+        static void*            PollingThread(void* data);
+        bool                    Start_worker();
+        void                    Stop_worker();
+        pthread_t               mPollingThreadID;
+        int                     mWakeFds[2];
+
         bool                    Start_accel();
         void                    Stop_accel();
-        pthread_t               mPollingThreadIDAccel;
-        handle_t                mHandleAccel;
-        int                     mWakeFdsAccel[2];
-        Mutex                   mMutexAccel;
+        void                    processAccel(int count);
+        SensorHubStream*        mStreamAccel;
+        int                     mClientAccel;
+        struct accel_data       mAccelData[GS_BUF_SIZE / sizeof(struct accel_data)];
 
-        /**
-         * Thread starts when sensor is activated, stops when sensor is deactivated
-         * In thread, read PSH gyro output
-         */
-        static void*            PollingThread_gyro(void* data);
         bool                    Start_gyro();
         void                    Stop_gyro();
-        pthread_t               mPollingThreadIDGyro;
-        handle_t                mHandleGyro;
-        int                     mWakeFdsGyro[2];
+        void                    processGyro(int count);
+        SensorHubStream*        mStreamGyro;
+        int                     mClientGyro;
+        struct gyro_raw_data    mGyroData[GS_BUF_SIZE / sizeof(struct gyro_raw_data)];
         short                   mDataGyro[3];
-        Mutex                   mMutexGyro;
 
-
-        /**
-         * Thread starts when sensor is activated, stops when sensor is deactivated
-         * In thread, read PSH proximity sensor output, and update mFlagProximity
-         */
-        static void*            PollingThread_proximity(void* data);
         bool                    Start_proximity();
         void                    Stop_proximity();
-        pthread_t               mPollingThreadIDProximity;
-        handle_t                mHandleProximity;
-        int                     mWakeFdsProximity[2];
+        void                    processProximity(int count);
+        SensorHubStream*        mStreamProximity;
+        int                     mClientProximity;
+        struct ps_phy_data      mProximityData[PX_BUF_SIZE / sizeof(struct ps_phy_data)];
         bool                    mFlagProximity;
-        Mutex                   mMutexProximity;
 
+        /* worker -> poll thread, the pipe only carries wakeups */
+        EventRing               mResults;
         int                     mResultPipe[2];
 
         /**
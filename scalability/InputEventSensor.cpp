@@ -1,68 +1,34 @@
 #include "InputEventSensor.hpp"
-#include <sstream>
+#include "InputDeviceIndex.h"
 #include <cerrno>
-#include <dirent.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <sys/ioctl.h>
-#include <linux/input.h>
-#define EVENT_NAME_MAX  256
 
 InputEventSensor::InputEventSensor(SensorDevice &mDevice, struct PlatformData &mData)
-        :DirectSensor(mDevice, mData)
+        :DirectSensor(mDevice, mData), delayControl(false)
 {
         inputDataOverrun = false;
+        readCalls = 0;
+        samplesDecoded = 0;
+        activateControl.setPath(data.activateInterface.c_str());
+        delayControl.setPath(data.setDelayInterface.c_str());
+        for (int i = AXIS_X; i < AXIS_W; i++) {
+                axisTable[i].index = device.getMapper(i);
+                axisTable[i].scale = device.getScale(i);
+                rawData[i] = 0;
+        }
+        if (device.getFifoMaxEventCount() == 0)
+                device.setFifoMaxEventCount(INPUT_EVENT_FIFO_SIZE);
 }
 
 int InputEventSensor::getPollfd()
 {
-        DIR *dir;
-        struct dirent *entry;
-        const std::string inputDir = "/dev/input/";
-        std::string file;
-        char name[EVENT_NAME_MAX];
-        int fd;
-
         if (pollfd >= 0)
                 return pollfd;
 
-        dir = opendir(inputDir.c_str());
-        if (dir == NULL) {
-                LOGE("opendir error: %s: %s; error number: %d\n", inputDir.c_str(), strerror(errno), errno );
-                return -1;
-        }
-
-        while ((entry = readdir(dir))) {
-                if (entry->d_type != DT_CHR)
-                        continue;
-
-                file = inputDir + entry->d_name;
-                fd = open(file.c_str(), O_RDWR);
-                if (fd < 0) {
-                        LOGE("open error: %s: %s; error number: %d\n", file.c_str(), strerror(errno), errno);
-                        closedir( dir );
-                        return -1;
-                }
-
-                name[sizeof(name) -1] = 0;
-                if (ioctl(fd, EVIOCGNAME(sizeof(name) - 1), name) < 1) {
-                        close(fd);
-                        continue;
-                }
-
-                if (data.name.compare(name) == 0) {
-                        unsigned int clockId = CLOCK_MONOTONIC;
-                        /* Set desired clock as monotonic to record timestamp of event
-                         * Fixme: this ioctl is supported since Linux 3.4
-	                 */
-                        ioctl(fd, EVIOCSCLOCKID, &clockId);
-                        pollfd = fd;
-                        break;
-                }
-
-                close(fd);
-        }
-        closedir(dir);
+        pollfd = InputDeviceIndex::openDevice(data.name.c_str(), O_RDWR);
+        if (pollfd < 0)
+                LOGE("%s: cannot find input device %s", __FUNCTION__, data.name.c_str());
 
         return pollfd;
 }
@@ -85,10 +51,20 @@ int InputEventSensor::activate(int handle, int enabled) {
                 else if (!enabled && activated)
                         Calibration(&event, STORE_DATA, data.calibrationFile.c_str());
         }
-        result =writeToFile(data.activateInterface, handle, static_cast<int64_t>(enabled));
-
-        if (DriverCalibration != NULL && enabled != 0 && result == 0 && activated == 0)
-                DriverCalibration(&event, CALIBRATION_DATA, data.driverCalibrationFile.c_str(), data.driverCalibrationInterface.c_str());
+        /* The driver may have dropped enable on suspend, or another sensor on the node cleared it */
+        if (enabled)
+                activateControl.invalidate();
+        result =writeToFile(activateControl, handle, static_cast<int64_t>(enabled));
+
+        if (DriverCalibration != NULL) {
+                if (enabled && !activated && result == 0) {
+                        DriverCalibration(&event, READ_DATA, data.driverCalibrationFile.c_str(), data.driverCalibrationInterface.c_str());
+                        driverCalibrationPending = true;
+                } else if (!enabled && activated) {
+                        driverCalibrationPending = false;
+                        DriverCalibration(&event, STORE_DATA, data.driverCalibrationFile.c_str(), data.driverCalibrationInterface.c_str());
+                }
+        }
 
         activated = enabled;
 
@@ -110,14 +86,30 @@ int InputEventSensor::setDelay(int handle, int64_t ns) {
         if (minDelay == 0 || data.setDelayInterface.length() == 0)
                 return 0;
 
-        return writeToFile(data.setDelayInterface, handle, delay);
+        return writeToFile(delayControl, handle, delay);
+}
+
+int InputEventSensor::batch(int handle, int flags, int64_t period_ns, int64_t timeout) {
+        if (flags & SENSORS_BATCH_DRY_RUN)
+                return 0;
+
+        /* Input drivers have no FIFO, samples are held back in the event ring instead */
+        maxReportLatency = timeout;
+
+        return setDelay(handle, period_ns);
 }
 
-int InputEventSensor::getData(std::queue<sensors_event_t> &eventQue) {
-        struct input_event inputEvent[32];
-        int count, ret;
+int InputEventSensor::getData() {
+        int count, ret, samples = 0;
+
+        /* Every sample ends with an EV_SYN, so never read more events than the ring can hold */
+        count = eventRing.space();
+        if (count > INPUT_EVENT_BATCH)
+                count = INPUT_EVENT_BATCH;
+        if (count == 0)
+                return 0;
 
-        ret = read(pollfd, inputEvent, 32 * sizeof(struct input_event));
+        ret = read(pollfd, inputEvents, count * sizeof(struct input_event));
         if (ret < 0 || ret % sizeof(struct input_event)) {
                 LOGE("Read input event error! ret: %d", ret);
                 return -1;
@@ -126,20 +118,15 @@ int InputEventSensor::getData(std::queue<sensors_event_t> &eventQue) {
         count = ret / sizeof(struct input_event);
 
         for (int i = 0; i < count; i++) {
-                if ((inputEvent[i].type == EV_REL || inputEvent[i].type == EV_ABS) && !inputDataOverrun) {
-                        float value = static_cast<float>(inputEvent[i].value);
-                        if ((inputEvent[i].type == EV_REL && inputEvent[i].code == REL_X) ||
-                            (inputEvent[i].type == EV_ABS && inputEvent[i].code == ABS_X))
-                                event.data[device.getMapper(AXIS_X)] = value * device.getScale(AXIS_X);
-                        else if ((inputEvent[i].type == EV_REL && inputEvent[i].code == REL_Y) ||
-                                 (inputEvent[i].type == EV_ABS && inputEvent[i].code == ABS_Y))
-                                event.data[device.getMapper(AXIS_Y)] = value * device.getScale(AXIS_Y);
-                        else if ((inputEvent[i].type == EV_REL && inputEvent[i].code == REL_Z) ||
-                                 (inputEvent[i].type == EV_ABS && inputEvent[i].code == ABS_Z))
-                                event.data[device.getMapper(AXIS_Z)] = value * device.getScale(AXIS_Z);
+                const struct input_event &inputEvent = inputEvents[i];
+
+                /* REL_X/Y/Z and ABS_X/Y/Z share codes 0..2 */
+                if ((inputEvent.type == EV_REL || inputEvent.type == EV_ABS) && !inputDataOverrun) {
+                        if (inputEvent.code < AXIS_W)
+                                rawData[inputEvent.code] = static_cast<float>(inputEvent.value) * axisTable[inputEvent.code].scale;
                 }
-                else if (inputEvent[i].type == EV_SYN) {
-                        if (inputEvent[i].code == SYN_DROPPED) {
+                else if (inputEvent.type == EV_SYN) {
+                        if (inputEvent.code == SYN_DROPPED) {
                                 LOGE("input event overrun");
                                 inputDataOverrun = true;
                         }
@@ -147,17 +134,29 @@ int InputEventSensor::getData(std::queue<sensors_event_t> &eventQue) {
                                 inputDataOverrun = false;
                         }
                         else {
-                                event.timestamp = timevalToNano(inputEvent[i].time);
+                                for (int axis = AXIS_X; axis < AXIS_W; axis++)
+                                        event.data[axisTable[axis].index] = rawData[axis];
+                                event.timestamp = timevalToNano(inputEvent.time);
+                                if (driverCalibrationPending) {
+                                        driverCalibrationPending = false;
+                                        DriverCalibration(&event, CALIBRATION_DATA, data.driverCalibrationFile.c_str(), data.driverCalibrationInterface.c_str());
+                                }
                                 if (Calibration != NULL)
                                         Calibration(&event, CALIBRATION_DATA, data.calibrationFile.c_str());
                                 else if (device.getEventProperty() == VECTOR)
                                         event.acceleration.status = SENSOR_STATUS_ACCURACY_MEDIUM;
-                                eventQue.push(event);
+                                eventRing.push(event);
+                                samples++;
                         }
                 }
         }
 
-        return 0;
+        readCalls++;
+        samplesDecoded += samples;
+        LOGV("%s: %s %d samples from %d events, %u samples / %u reads",
+             __FUNCTION__, data.name.c_str(), samples, count, samplesDecoded, readCalls);
+
+        return samples;
 }
 
 bool InputEventSensor::selftest() {
@@ -166,62 +165,18 @@ bool InputEventSensor::selftest() {
         return false;
 }
 
-int InputEventSensor::openFile(std::string &pathset) {
-        std::string path;
-        size_t pos, start = 0;
-        int fd;
-
-        pos = pathset.find(';');
-        if (pos == std::string::npos) {
-                fd = open(pathset.c_str(), O_WRONLY);
-        }
-        else {
-                while (pos != std::string::npos) {
-                        path = pathset.substr(start, pos - start);
-                        fd = open(path.c_str(), O_WRONLY);
-                        if (fd >= 0)
-                                break;
-                        start = pos + 1;
-                        pos = pathset.find(';', start);
-                }
-                if (start < pathset.size() && fd < 0) {
-                        path = pathset.substr(start);
-                        fd = open(path.c_str(), O_WRONLY);
-                }
-        }
-
-        return fd;
-}
-
-int InputEventSensor::writeToFile(std::string &pathset, int handle, int64_t value) {
-        int fd, ret;
-        std::ostringstream ss;
-
+int InputEventSensor::writeToFile(SysfsControl &control, int handle, int64_t value) {
         if (handle != device.getHandle()) {
                 LOGE("%s: line: %d: %s handle not match! handle: %d required handle: %d",
                      __FUNCTION__, __LINE__, data.name.c_str(), device.getHandle(), handle);
                 return -1;
         }
 
-        fd = openFile(pathset);
-        if (fd < 0) {
-                LOGE("%s: line: %d: Cannot open the driver interface for activate: %s",
-                     __FUNCTION__, __LINE__, data.activateInterface.c_str());
-                return fd;
-        }
-
-        ss<<value;
-
-        ret = write(fd, ss.str().c_str(), ss.str().size() + 1);
-
-        if (ret != static_cast<int>(ss.str().size() + 1)) {
-                LOGE("%s: line: %d: write activate error: %d",
-                     __FUNCTION__, __LINE__, ret);
-                close(fd);
+        if (control.write(value) < 0) {
+                LOGE("%s: line: %d: write driver interface error: %s",
+                     __FUNCTION__, __LINE__, control.getPath());
                 return -1;
         }
 
-        close(fd);
-
         return 0;
 }
@@ -1,11 +1,33 @@
 #ifndef _INPUT_EVENT_SENSOR_HPP_
 #define _INPUT_EVENT_SENSOR_HPP_
 
+#include <linux/input.h>
 #include "DirectSensor.hpp"
+#include "SysfsControl.h"
+
+#define INPUT_EVENT_BATCH       128
+/* Samples held back by the HAL side batching window, see Sensor::getBatchDelay() */
+#define INPUT_EVENT_FIFO_SIZE   (EVENT_RING_CAPACITY / 2)
 
 class InputEventSensor : public DirectSensor {
-        int openFile(std::string &pathset);
-        int writeToFile(std::string &pathset, int handle, int64_t value);
+        /* Device axis (ABS_X/REL_X ...) to event.data slot and scale, resolved once from SensorDevice */
+        struct axis_decode_t {
+                int index;
+                float scale;
+        } axisTable[AXIS_W];
+        /*
+         * Last decoded value per device axis. Drivers only report the axes that
+         * changed, and the calibration rewrites event in place, so every sample
+         * is rebuilt from these instead of from the previous calibrated event.
+         */
+        float rawData[AXIS_W];
+        struct input_event inputEvents[INPUT_EVENT_BATCH];
+        unsigned int readCalls;
+        unsigned int samplesDecoded;
+        /* Driver enable and poll delay nodes, opened on first write and kept open, see SysfsControl */
+        SysfsControl activateControl;
+        SysfsControl delayControl;
+        int writeToFile(SysfsControl &control, int handle, int64_t value);
         bool inputDataOverrun;
 public:
         InputEventSensor(SensorDevice &mDevice, struct PlatformData &mData);
@@ -17,7 +39,8 @@ public:
         int getPollfd();
         int activate(int handle, int enabled);
         int setDelay(int handle, int64_t ns);
-        int getData(std::queue<sensors_event_t> &eventQue);
+        int batch(int handle, int flags, int64_t period_ns, int64_t timeout);
+        int getData();
         bool selftest();
 };
 
@@ -58,8 +58,15 @@ int MiscSensor::activate(int handle, int enabled) {
                 return -1;
         }
 
-        if (DriverCalibration != NULL && enabled != 0 && activated == 0)
-                DriverCalibration(&event, CALIBRATION_DATA, data.driverCalibrationFile.c_str(), data.driverCalibrationInterface.c_str());
+        if (DriverCalibration != NULL) {
+                if (enabled && !activated) {
+                        DriverCalibration(&event, READ_DATA, data.driverCalibrationFile.c_str(), data.driverCalibrationInterface.c_str());
+                        driverCalibrationPending = true;
+                } else if (!enabled && activated) {
+                        driverCalibrationPending = false;
+                        DriverCalibration(&event, STORE_DATA, data.driverCalibrationFile.c_str(), data.driverCalibrationInterface.c_str());
+                }
+        }
 
         activated = enabled;
 
@@ -105,18 +112,23 @@ int MiscSensor::setDelay(int handle, int64_t ns)
         return 0;
 }
 
-int MiscSensor::getData(std::queue<sensors_event_t> &eventQue) {
+int MiscSensor::getData() {
         int count, ret;
         sensors_misc_event_t miscEvent[32];
 
         ret = read(pollfd, miscEvent, sizeof(miscEvent));
 
+        if (ret > 0 && driverCalibrationPending) {
+                driverCalibrationPending = false;
+                DriverCalibration(&event, CALIBRATION_DATA, data.driverCalibrationFile.c_str(), data.driverCalibrationInterface.c_str());
+        }
+
         if (ret == sizeof(int)) {
                 event.data[0] = static_cast<float>(miscEvent[0].value) * device.getScale(0);
                 event.timestamp = getTimestamp();
                 if (Calibration != NULL)
                         Calibration(&event, CALIBRATION_DATA, NULL);
-                eventQue.push(event);
+                eventRing.push(event);
                 return 0;
         }
         else if (ret % sizeof(sensors_misc_event_t) != 0) {
@@ -144,7 +156,7 @@ int MiscSensor::getData(std::queue<sensors_event_t> &eventQue) {
                                 Calibration(&event, CALIBRATION_DATA, NULL);
                         else if (device.getEventProperty() == VECTOR)
                                 event.acceleration.status = SENSOR_STATUS_ACCURACY_MEDIUM;
-                        eventQue.push(event);
+                        eventRing.push(event);
                 default:
                         LOGW("%s line: %d unknown axis: %d", __FUNCTION__, __LINE__, miscEvent[i].axis);
                         break;
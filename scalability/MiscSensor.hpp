@@ -14,7 +14,7 @@ public:
         int getPollfd();
         int activate(int handle, int enabled);
         int setDelay(int handle, int64_t ns);
-        int getData(std::queue<sensors_event_t> &eventQue);
+        int getData();
         bool selftest();
 };
 
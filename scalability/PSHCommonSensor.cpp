@@ -1,4 +1,5 @@
 #include "PSHCommonSensor.hpp"
+#include <poll.h>
 
 int PSHCommonSensor::getPollfd()
 {
@@ -11,6 +12,14 @@ int PSHCommonSensor::getPollfd()
         }
 
         psh_sensor_t PSHType = SensorHubHelper::getType(device.getType(), device.getSubname());
+        sharedStream = SensorHubStream::getStream(PSHType);
+        if (sharedStream != NULL) {
+                /* Read the session directly while no virtual sensor shares it */
+                streamClient = sharedStream->attach(true);
+                pollfd = sharedStream->getFd(streamClient);
+                return pollfd;
+        }
+
         sensorHandle = methods.psh_open_session(PSHType);
         if (sensorHandle == NULL) {
                 LOGE("psh_open_session error!");
@@ -23,6 +32,15 @@ int PSHCommonSensor::getPollfd()
 }
 
 int PSHCommonSensor::activate(int handle, int enabled) {
+        if (sharedStream != NULL) {
+                if (streamClient == SENSORHUB_STREAM_NO_CLIENT)
+                        return -1;
+                if (activated && enabled == 0)
+                        sharedStream->stop(streamClient);
+                activated = enabled != 0;
+                return 0;
+        }
+
         if (methods.psh_start_streaming == NULL || methods.psh_stop_streaming == NULL || sensorHandle == NULL) {
                 LOGE("psh_start_streaming/psh_stop_streaming/sensorHandle not initialized!");
                 return -1;
@@ -43,7 +61,7 @@ int PSHCommonSensor::activate(int handle, int enabled) {
 
 int PSHCommonSensor::setDelay(int handle, int64_t ns) {
         int dataRate = 5;
-        int bufferDelay = 0;
+        int bufferDelay = this->bufferDelay;
         streaming_flag flag = STOP_WHEN_SCREEN_OFF;
         int delay = 200;
         int minDelay = device.getMinDelay() / US_TO_MS;
@@ -84,6 +102,17 @@ int PSHCommonSensor::setDelay(int handle, int64_t ns) {
                 return -1;
         }
 
+        if (sharedStream != NULL) {
+                /* The stream may run faster for other clients, we are fed every n-th sample */
+                dataRate = sharedStream->start(streamClient, dataRate, bufferDelay, flag);
+                if (dataRate <= 0) {
+                        LOGE("%s: start shared stream error name:%s", __FUNCTION__, device.getName());
+                        return -1;
+                }
+                timestamps.reset(getTimestamp(), minDelay == 0 ? 0 : NS_TO_MS * 1000LL / dataRate);
+                return 0;
+        }
+
         error_t err;
         /* Wait for libsensorhub interface sync */
         if (flag == STOP_WHEN_SCREEN_OFF)
@@ -96,14 +125,40 @@ int PSHCommonSensor::setDelay(int handle, int64_t ns) {
                 return -1;
         }
 
-        last_timestamp = getTimestamp();
+        /* On-change sessions are configured with a zero minDelay and carry no rate */
+        timestamps.reset(getTimestamp(), minDelay == 0 ? 0 : NS_TO_MS * 1000LL / dataRate);
         return 0;
 }
 
-int PSHCommonSensor::getData(std::queue<sensors_event_t> &eventQue) {
-        int count = 32;
+int PSHCommonSensor::batch(int handle, int flags, int64_t period_ns, int64_t timeout) {
+        if (flags & SENSORS_BATCH_DRY_RUN)
+                return 0;
+
+        /* Max report latency is handed to the hub as its buffer delay */
+        bufferDelay = timeout / NS_TO_MS;
+
+        return setDelay(handle, period_ns);
+}
+
+void PSHCommonSensor::flushEvents() {
+        struct pollfd pfd;
+
+        /* Collect what the hub already delivered so it precedes the flush complete event */
+        pfd.fd = pollfd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (pollfd >= 0 && poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN))
+                getData();
+
+        Sensor::flushEvents();
+}
+
+int PSHCommonSensor::getData() {
+        int count = SENSORHUB_EVENT_BATCH;
+        int fd = sharedStream != NULL ? sharedStream->getReadFd(streamClient) : pollfd;
+        int64_t delay = sharedStream != NULL ? sharedStream->getDelay(streamClient) : 0;
 
-        count = SensorHubHelper::readSensorhubEvents(device, pollfd, sensorhubEvent, count, last_timestamp);
+        count = SensorHubHelper::readSensorhubEvents(device, fd, stream, sensorhubEvent, count, timestamps, delay);
         for (int i = 0; i < count; i++) {
                 if (device.getType() == SENSOR_TYPE_STEP_COUNTER) {
                         event.u64.step_counter = sensorhubEvent[i].step_counter;
@@ -116,7 +171,7 @@ int PSHCommonSensor::getData(std::queue<sensors_event_t> &eventQue) {
                                 event.acceleration.status = sensorhubEvent[i].accuracy;
                 }
                 event.timestamp = sensorhubEvent[i].timestamp;
-                eventQue.push(event);
+                eventRing.push(event);
         }
 
         return 0;
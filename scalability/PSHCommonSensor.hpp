@@ -2,25 +2,41 @@
 #define _PSH_COMMON_SENSOR_HPP_
 
 #include "PSHSensor.hpp"
+#include "SensorHubStream.hpp"
+
+#define SENSORHUB_EVENT_BATCH   32
 
 class PSHCommonSensor : public PSHSensor {
-        struct sensorhub_event_t sensorhubEvent[32];
-        int64_t last_timestamp;
+        struct sensorhub_event_t sensorhubEvent[SENSORHUB_EVENT_BATCH];
+        struct sensorhub_stream_t stream;
+        TimestampEstimator timestamps;
+        int bufferDelay;        /* ms the hub may buffer samples, from batch() */
+        /* Physical streams are shared with the virtual sensors built on them */
+        SensorHubStream *sharedStream;
+        int streamClient;
 public:
         PSHCommonSensor(SensorDevice &mDevice) :PSHSensor(mDevice)
         {
-                memset(sensorhubEvent, 0, 32 * sizeof(struct sensorhub_event_t));
-                last_timestamp = 0;
+                memset(sensorhubEvent, 0, SENSORHUB_EVENT_BATCH * sizeof(struct sensorhub_event_t));
+                bufferDelay = 0;
+                sharedStream = NULL;
+                streamClient = SENSORHUB_STREAM_NO_CLIENT;
+                SensorHubHelper::initStream(device.getType(), stream, SENSORHUB_EVENT_BATCH);
         }
         ~PSHCommonSensor()
         {
+                if (sharedStream != NULL)
+                        sharedStream->detach(streamClient);
                 if (sensorHandle != NULL)
                         methods.psh_close_session(sensorHandle);
+                SensorHubHelper::releaseStream(stream);
         }
         int getPollfd();
         int activate(int handle, int enabled);
         int setDelay(int handle, int64_t ns);
-        int getData(std::queue<sensors_event_t> &eventQue);
+        int batch(int handle, int flags, int64_t period_ns, int64_t timeout);
+        int getData();
+        void flushEvents();
         bool selftest();
 };
 
@@ -401,7 +401,7 @@ bool PedometerSensor::selftest()
         return false;
 }
 
-int PedometerSensor::getData(std::queue<sensors_event_t> &eventQue)
+int PedometerSensor::getData()
 {
         int size, numEventReceived = 0;
         char buf[512];
@@ -428,7 +428,7 @@ int PedometerSensor::getData(std::queue<sensors_event_t> &eventQue)
                 event.data[0] = (*p_pedometer_data);
                 LOGI("Event value is %d", *p_pedometer_data);
 
-                eventQue.push(event);
+                eventRing.push(event);
                 numEventReceived++;
 
                 size = size - unit_size;
@@ -57,7 +57,7 @@ public:
         virtual int getPollfd();
         virtual int activate(int handle, int enabled);
         virtual int setDelay(int handle, int64_t ns);
-        virtual int getData(std::queue<sensors_event_t> &eventQue);
+        virtual int getData();
         virtual bool selftest();
 private:
         // Stop current worker thread
@@ -78,7 +78,8 @@ PhysicalActivitySensor::PhysicalActivitySensor(SensorDevice &device)
         mPSHCn = 0;
 
         mPAHandle = PSH_SESSION_NOT_OPENED;
-        mAccHandle = PSH_SESSION_NOT_OPENED;
+        mAccStream = SensorHubStream::getStream(SENSOR_ACCELEROMETER);
+        mAccClient = SENSORHUB_STREAM_NO_CLIENT;
 
         mLibActivityInstant = NULL;
         mActivityInstantInit = NULL;
@@ -161,13 +162,13 @@ inline void PhysicalActivitySensor::connectToPSH()
         }
 
         // Establish accelemeter connection to PSH
-        mAccHandle = methods.psh_open_session(SENSOR_ACCELEROMETER);
-        if (mAccHandle == PSH_SESSION_NOT_OPENED) {
-                LOGE("psh_open_session failed. retry once");
+        mAccClient = mAccStream->attach();
+        if (mAccClient == SENSORHUB_STREAM_NO_CLIENT) {
+                LOGE("accel stream attach failed. retry once");
                 usleep(SLEEP_ON_FAIL_USEC);
-                mAccHandle = methods.psh_open_session(SENSOR_ACCELEROMETER);
-                if (mAccHandle == PSH_SESSION_NOT_OPENED) {
-                        LOGE("psh_open_session failed.");
+                mAccClient = mAccStream->attach();
+                if (mAccClient == SENSORHUB_STREAM_NO_CLIENT) {
+                        LOGE("accel stream attach failed.");
                         methods.psh_close_session(mPAHandle);
                         mPAHandle = PSH_SESSION_NOT_OPENED;
                         return;
@@ -178,7 +179,7 @@ inline void PhysicalActivitySensor::connectToPSH()
 inline bool PhysicalActivitySensor::isConnectToPSH()
 {
         if (mPAHandle != PSH_SESSION_NOT_OPENED
-            && mAccHandle != PSH_SESSION_NOT_OPENED)
+            && mAccClient != SENSORHUB_STREAM_NO_CLIENT)
                 return true;
         else
                 return false;
@@ -189,10 +190,10 @@ inline void PhysicalActivitySensor::disconnectFromPSH()
         // close connections
         if (mPAHandle != PSH_SESSION_NOT_OPENED)
                 methods.psh_close_session(mPAHandle);
-        if (mAccHandle != PSH_SESSION_NOT_OPENED)
-                methods.psh_close_session(mAccHandle);
+        if (mAccClient != SENSORHUB_STREAM_NO_CLIENT)
+                mAccStream->detach(mAccClient);
         mPAHandle = PSH_SESSION_NOT_OPENED;
-        mAccHandle = PSH_SESSION_NOT_OPENED;
+        mAccClient = SENSORHUB_STREAM_NO_CLIENT;
 }
 
 inline bool PhysicalActivitySensor::setupResultPipe()
@@ -447,6 +448,8 @@ void* PhysicalActivitySensor::workerThread(void *data)
         struct phy_activity_data actData;
         Client *client = NULL;
         Client *tmpClient = NULL;
+        // Results period, 0 while it is up to the instant algorithm
+        int64_t period = 0;
         // Get current delay
         int64_t delay;
         {
@@ -460,20 +463,22 @@ void* PhysicalActivitySensor::workerThread(void *data)
         // start streaming and get read fd
         if (instantMode) {
                 // instant mode, open accelerometer stream
-                if (methods.psh_start_streaming(src->mAccHandle, 100, 10) != ERROR_NONE) {
-                        LOGE("psh_start_streaming failed.");
+                if (src->mAccStream->start(src->mAccClient, 100, 10) <= 0) {
+                        LOGE("accel stream start failed.");
                         usleep(SLEEP_ON_FAIL_USEC);
-                        if (methods.psh_start_streaming(src->mAccHandle, 100, 10) != ERROR_NONE) {
-                                LOGE("psh_start_streaming failed.");
+                        if (src->mAccStream->start(src->mAccClient, 100, 10) <= 0) {
+                                LOGE("accel stream start failed.");
                                 return NULL;
                         }
                 }
-                psh_fd = methods.psh_get_fd(src->mAccHandle);
+                psh_fd = src->mAccStream->getFd(src->mAccClient);
         } else {
                 // none-instant mode, open physical activity stream
                 // parameters 1 and 0 are just place holders
                 int paDelay = getPADelay(delay);
                 int param = (paDelay << 16) | paDelay;
+                // one result every paDelay classification intervals of PA_INTERVAL seconds
+                period = static_cast<int64_t>(paDelay * PA_INTERVAL * 1000) * NS_TO_MS;
                 if (methods.psh_set_property(src->mPAHandle,
                                              PROP_ACT_N, &param) != ERROR_NONE) {
                         LOGE("psh_set_property n failed.");
@@ -507,7 +512,9 @@ void* PhysicalActivitySensor::workerThread(void *data)
         if (instantMode) {
                 (*src->mActivityInstantInit)(ActCB, data);
         }
-        src->last_timestamp = getTimestamp();
+        // the instant algorithm reports when it closes a window, not at the
+        // 100 Hz accel rate, so its results are stamped on arrival
+        src->timestamps.reset(getTimestamp(), period);
 
         // let's poll
         while (poll(polls, 2, -1) > 0) {
@@ -562,13 +569,10 @@ void* PhysicalActivitySensor::workerThread(void *data)
         }
 
         // close streaming
-        handle_t pshSession;
+        handle_t pshSession = src->mPAHandle;
         if (instantMode) {
-                pshSession = src->mAccHandle;
-        } else {
-                pshSession = src->mPAHandle;
-        }
-        if (pshSession != PSH_SESSION_NOT_OPENED) {
+                src->mAccStream->stop(src->mAccClient);
+        } else if (pshSession != PSH_SESSION_NOT_OPENED) {
                 if (methods.psh_stop_streaming(pshSession) != ERROR_NONE) {
                         LOGE("psh_stop_streaming failed.");
                         usleep(SLEEP_ON_FAIL_USEC);
@@ -593,10 +597,8 @@ int PhysicalActivitySensor::getPollfd()
         return mResultPipe[0];
 }
 
-int PhysicalActivitySensor::getData(std::queue<sensors_event_t> &eventQue)
+int PhysicalActivitySensor::getData()
 {
-        int64_t current_timestamp, timestamp_step;
-        int i;
 
         int size, numEventReceived = 0;
         char buf[512];
@@ -616,27 +618,23 @@ int PhysicalActivitySensor::getData(std::queue<sensors_event_t> &eventQue)
         LOGI("Actually read %d", size);
 
         char *p = buf;
-        current_timestamp = getTimestamp();
-        int count = size / unit_size;
-        timestamp_step = (current_timestamp - last_timestamp) / count;
+        timestamps.update(getTimestamp(), size / unit_size);
 
-        i = 0;
         while (size > 0) {
                 p_activity_data = (int *)p;
                 for (int k = 0; k < OUTPUT_SIZE; k++)
                         event.data[k] = (*(p_activity_data+k));
-                event.timestamp = last_timestamp + timestamp_step * (i + 1);
+                event.timestamp = timestamps.next();
                 LOGI("Event value is %f, %f, %f, %f, %f, %f, %f, %f, %f, %f",
                     event.data[0], event.data[1], event.data[2], event.data[3],
                     event.data[4], event.data[5], event.data[6], event.data[7],
                     event.data[8], event.data[9]);
-                eventQue.push(event);
+                eventRing.push(event);
                 numEventReceived++;
 
                 size = size - unit_size;
                 p = p + unit_size;
         }
-        last_timestamp = current_timestamp;
 
         LOGI("PhysicalActivitySensor - read %d events", numEventReceived);
         return numEventReceived;
@@ -27,6 +27,7 @@
 #include <utils/Mutex.h>
 #include "activity.h"
 #include "PSHSensor.hpp"
+#include "SensorHubStream.hpp"
 
 /*****************************************************************************/
 /*
@@ -73,7 +74,7 @@ public:
         PhysicalActivitySensor() {};
         PhysicalActivitySensor(SensorDevice &device);
         virtual ~PhysicalActivitySensor();
-        virtual int getData(std::queue<sensors_event_t> &eventQue);
+        virtual int getData();
         virtual int activate(int32_t handle, int enabled);
         virtual int setDelay(int32_t handle, int64_t ns);
         virtual int getPollfd();
@@ -122,13 +123,14 @@ private:
         int64_t     mCurrentDelay;
 
         handle_t    mPAHandle;
-        handle_t    mAccHandle;
+        SensorHubStream *mAccStream;   // instant mode accel, shared with the other accel users
+        int         mAccClient;
 
         int         mWakeFDs[2];
         pthread_t   mWorkerThread;  // only one thread running at one time
 
         int         mResultPipe[2];
-        int64_t     last_timestamp;
+        TimestampEstimator timestamps;
 
         // for instant mode calculation
         short mPSHCn;  // result from lab algorithm
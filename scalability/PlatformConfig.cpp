@@ -1,13 +1,18 @@
 #include <iostream>
 #include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <cutils/properties.h>
 #include "PlatformConfig.hpp"
+#include "PlatformConfigBlob.hpp"
 #include "VirtualSensor.hpp"
 
 PlatformConfig::PlatformConfig()
 {
-        xmlDocPtr doc;
-        xmlNodePtr root;
         std::string file;
         std::string prop;
         char buf[PROPERTY_VALUE_MAX];
@@ -21,30 +26,267 @@ PlatformConfig::PlatformConfig()
         else {
                 prop=buf;
         }
-        file="/system/etc/sensor_hal_config_"+prop+".xml";
+        file="/system/etc/sensor_hal_config_"+prop;
+
+        if (loadBlob(file+".bin", file+".xml"))
+                return;
+
+        loadXML(file+".xml");
+}
+
+PlatformConfig::PlatformConfig(const char *xmlFile)
+{
+        loadXML(xmlFile);
+}
+
+bool PlatformConfig::loadXML(std::string file)
+{
+        xmlDocPtr doc;
+        xmlNodePtr root;
 
         doc = xmlReadFile(file.c_str(), NULL, XML_PARSE_NOBLANKS);
         if (doc==NULL) {
                 LOGE("XML Document not parsed successfully.\n");
-                return;
+                return false;
         }
 
         root=xmlDocGetRootElement(doc);
         if (root==NULL) {
                 LOGE("Empty XML document\n");
                 xmlFreeDoc(doc);
-                return;
+                return false;
         }
 
         if (xmlStrcmp(root->name, (const xmlChar *)"sensor_hal_config")) {
                 LOGE("Wrong XML document, cannot find \"sensor_hal_config\" element!\n");
                 xmlFreeDoc(doc);
-                return;
+                return false;
         }
 
         initXML(root->xmlChildrenNode);
 
         xmlFreeDoc(doc);
+        return true;
+}
+
+static const char *blobString(const char *strings, uint32_t size, uint32_t offset)
+{
+        return offset < size ? strings + offset : "";
+}
+
+bool PlatformConfig::loadBlob(std::string file, std::string xmlFile)
+{
+        const struct platform_config_blob_header *header;
+        const struct platform_config_blob_sensor *records;
+        const char *strings;
+        struct stat st;
+        void *map;
+        int fd;
+
+        fd = open(file.c_str(), O_RDONLY);
+        if (fd < 0)
+                return false;
+
+        if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(*header)) {
+                LOGE("%s: %s is too short", __FUNCTION__, file.c_str());
+                close(fd);
+                return false;
+        }
+
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+                LOGE("%s: cannot map %s: %s", __FUNCTION__, file.c_str(), strerror(errno));
+                return false;
+        }
+
+        header = reinterpret_cast<const struct platform_config_blob_header *>(map);
+        if (header->magic != PLATFORM_CONFIG_BLOB_MAGIC ||
+            header->version != PLATFORM_CONFIG_BLOB_VERSION ||
+            header->size != (uint32_t)st.st_size ||
+            header->recordSize != sizeof(struct platform_config_blob_sensor) ||
+            header->recordsOffset > header->size ||
+            header->count > (header->size - header->recordsOffset) / header->recordSize ||
+            header->stringsOffset > header->size ||
+            header->stringsSize == 0 ||
+            header->stringsSize > header->size - header->stringsOffset) {
+                LOGE("%s: invalid config blob %s, falling back to XML", __FUNCTION__, file.c_str());
+                munmap(map, st.st_size);
+                return false;
+        }
+
+        if (!config_source_stamp_matches(xmlFile.c_str(), &header->source)) {
+                LOGW("%s: %s was changed after %s was compiled, falling back to XML",
+                     __FUNCTION__, xmlFile.c_str(), file.c_str());
+                munmap(map, st.st_size);
+                return false;
+        }
+
+        records = reinterpret_cast<const struct platform_config_blob_sensor *>(
+                reinterpret_cast<const char *>(map) + header->recordsOffset);
+        strings = reinterpret_cast<const char *>(map) + header->stringsOffset;
+        /* Every string offset resolves inside the table once it is terminated */
+        if (strings[header->stringsSize - 1] != '\0') {
+                LOGE("%s: unterminated string table in %s", __FUNCTION__, file.c_str());
+                munmap(map, st.st_size);
+                return false;
+        }
+
+        for (uint32_t i = 0; i < header->count; i++) {
+                const struct platform_config_blob_sensor *r = records + i;
+                const char *name = blobString(strings, header->stringsSize, r->name);
+                const char *vendor = blobString(strings, header->stringsSize, r->vendor);
+                SensorDevice mSensor;
+
+                mSensor.setId(i);
+                mSensor.setHandle(mSensor.idToHandle(i));
+                mSensor.setType(r->type);
+                mSensor.setEventProperty(static_cast<sensors_event_property_t>(r->eventProperty));
+                mSensor.setCategory(static_cast<sensor_category_t>(r->category));
+                mSensor.setSubname(static_cast<sensors_subname>(r->subname));
+                if (name[0] != '\0')
+                        mSensor.setName(name);
+                if (vendor[0] != '\0')
+                        mSensor.setVendor(vendor);
+                mSensor.setVersion(r->version);
+                mSensor.setMaxRange(r->maxRange);
+                mSensor.setResolution(r->resolution);
+                mSensor.setPower(r->power);
+                mSensor.setMinDelay(r->minDelay);
+                mSensor.setFifoReservedEventCount(r->fifoReservedEventCount);
+                mSensor.setFifoMaxEventCount(r->fifoMaxEventCount);
+                for (int j = 0; j < PLATFORM_CONFIG_BLOB_AXES; j++) {
+                        mSensor.setMapper(j, r->mapper[j]);
+                        mSensor.setScale(j, r->scale[j]);
+                }
+                devices.push_back(mSensor);
+
+                if (!(r->flags & PLATFORM_CONFIG_BLOB_HAS_DATA))
+                        continue;
+
+                struct PlatformData mData;
+                mData.name = blobString(strings, header->stringsSize, r->dataName);
+                mData.activateInterface = blobString(strings, header->stringsSize, r->activateInterface);
+                mData.setDelayInterface = blobString(strings, header->stringsSize, r->setDelayInterface);
+                mData.dataInterface = blobString(strings, header->stringsSize, r->dataInterface);
+                mData.calibrationFile = blobString(strings, header->stringsSize, r->calibrationFile);
+                mData.calibrationFunc = blobString(strings, header->stringsSize, r->calibrationFunc);
+                mData.driverCalibrationInterface = blobString(strings, header->stringsSize, r->driverCalibrationInterface);
+                mData.driverCalibrationFile = blobString(strings, header->stringsSize, r->driverCalibrationFile);
+                mData.driverCalibrationFunc = blobString(strings, header->stringsSize, r->driverCalibrationFunc);
+                mData.driverNodeType = static_cast<sensor_driver_node_type>(r->driverNodeType);
+                mData.filterLength = (r->flags & PLATFORM_CONFIG_BLOB_FILTER) != 0;
+                configs.insert(std::map<int,struct PlatformData>::value_type(i, mData));
+        }
+
+        munmap(map, st.st_size);
+        return true;
+}
+
+/* Offset of str in the string table, appending it the first time it is seen */
+static uint32_t blobAddString(std::string &strings, std::map<std::string, uint32_t> &offsets, const std::string &str)
+{
+        std::map<std::string, uint32_t>::iterator it;
+        uint32_t offset;
+
+        if (str.length() == 0)
+                return 0;
+
+        it = offsets.find(str);
+        if (it != offsets.end())
+                return it->second;
+
+        offset = strings.length();
+        strings.append(str.c_str(), str.length() + 1);
+        offsets.insert(std::map<std::string, uint32_t>::value_type(str, offset));
+        return offset;
+}
+
+bool PlatformConfig::writeBlob(const char *blobFile, const char *xmlFile)
+{
+        struct platform_config_blob_header header;
+        std::vector<struct platform_config_blob_sensor> records(devices.size());
+        std::map<std::string, uint32_t> offsets;
+        std::string strings(1, '\0');
+        FILE *fp;
+        bool ret;
+
+        for (unsigned int i = 0; i < devices.size(); i++) {
+                struct platform_config_blob_sensor *r = &records[i];
+                SensorDevice &device = devices[i];
+                std::map<int,struct PlatformData>::iterator it = configs.find(i);
+
+                memset(r, 0, sizeof(*r));
+                r->name = blobAddString(strings, offsets, device.getName() ? device.getName() : "");
+                r->vendor = blobAddString(strings, offsets, device.getVendor() ? device.getVendor() : "");
+                r->version = device.getVersion();
+                r->type = device.getType();
+                r->category = device.getCategory();
+                r->eventProperty = device.getEventProperty();
+                r->subname = device.getSubname();
+                r->maxRange = device.getMaxRange();
+                r->resolution = device.getResolution();
+                r->power = device.getPower();
+                r->minDelay = device.getMinDelay();
+                r->fifoReservedEventCount = device.getFifoReservedEventCount();
+                r->fifoMaxEventCount = device.getFifoMaxEventCount();
+                for (int j = 0; j < PLATFORM_CONFIG_BLOB_AXES; j++) {
+                        r->mapper[j] = device.getMapper(j);
+                        r->scale[j] = device.getScale(j);
+                }
+
+                if (it == configs.end())
+                        continue;
+
+                struct PlatformData &mData = it->second;
+                r->flags = PLATFORM_CONFIG_BLOB_HAS_DATA;
+                if (mData.filterLength)
+                        r->flags |= PLATFORM_CONFIG_BLOB_FILTER;
+                r->driverNodeType = mData.driverNodeType;
+                r->dataName = blobAddString(strings, offsets, mData.name);
+                r->activateInterface = blobAddString(strings, offsets, mData.activateInterface);
+                r->setDelayInterface = blobAddString(strings, offsets, mData.setDelayInterface);
+                r->dataInterface = blobAddString(strings, offsets, mData.dataInterface);
+                r->calibrationFile = blobAddString(strings, offsets, mData.calibrationFile);
+                r->calibrationFunc = blobAddString(strings, offsets, mData.calibrationFunc);
+                r->driverCalibrationInterface = blobAddString(strings, offsets, mData.driverCalibrationInterface);
+                r->driverCalibrationFile = blobAddString(strings, offsets, mData.driverCalibrationFile);
+                r->driverCalibrationFunc = blobAddString(strings, offsets, mData.driverCalibrationFunc);
+        }
+
+        memset(&header, 0, sizeof(header));
+        header.magic = PLATFORM_CONFIG_BLOB_MAGIC;
+        header.version = PLATFORM_CONFIG_BLOB_VERSION;
+        header.count = records.size();
+        header.recordSize = sizeof(struct platform_config_blob_sensor);
+        header.recordsOffset = sizeof(header);
+        header.stringsOffset = header.recordsOffset + header.count * header.recordSize;
+        header.stringsSize = strings.length();
+        header.size = header.stringsOffset + header.stringsSize;
+        if (config_source_stamp_get(xmlFile, &header.source) < 0) {
+                LOGE("%s: cannot read %s: %s", __FUNCTION__, xmlFile, strerror(errno));
+                return false;
+        }
+
+        fp = fopen(blobFile, "wb");
+        if (fp == NULL) {
+                LOGE("%s: cannot create %s: %s", __FUNCTION__, blobFile, strerror(errno));
+                return false;
+        }
+
+        ret = fwrite(&header, sizeof(header), 1, fp) == 1;
+        if (ret && header.count > 0)
+                ret = fwrite(&records[0], header.recordSize, header.count, fp) == header.count;
+        if (ret)
+                ret = fwrite(strings.data(), 1, strings.length(), fp) == strings.length();
+        if (fclose(fp) != 0)
+                ret = false;
+        if (!ret) {
+                LOGE("%s: write %s error", __FUNCTION__, blobFile);
+                unlink(blobFile);
+        }
+
+        return ret;
 }
 
 bool PlatformConfig::initXML(xmlNodePtr node)
@@ -106,6 +348,7 @@ bool PlatformConfig::addPlatformData(xmlNodePtr node, std::string type)
         }
         else
                 mData.driverNodeType = INPUT_EVENT;
+        mData.filterLength = false;
 
         while (p != NULL) {
                 str = xmlNodeGetContent(p);
@@ -276,6 +519,12 @@ bool PlatformConfig::addSensorDevice(xmlNodePtr node, std::string type, std::str
                 else if ((!xmlStrcmp(p->name, (const xmlChar *)"minDelay"))) {
                         mSensor.setMinDelay(atoi(reinterpret_cast<char *>(str)));
                 }
+                else if ((!xmlStrcmp(p->name, (const xmlChar *)"fifoReservedEventCount"))) {
+                        mSensor.setFifoReservedEventCount(atoi(reinterpret_cast<char *>(str)));
+                }
+                else if ((!xmlStrcmp(p->name, (const xmlChar *)"fifoMaxEventCount"))) {
+                        mSensor.setFifoMaxEventCount(atoi(reinterpret_cast<char *>(str)));
+                }
                 xmlFree(str);
                 p = p->next;
         }
@@ -14,6 +14,8 @@ class PlatformConfig {
         std::vector<SensorDevice> devices;
         int count;
         bool initialized;
+        bool loadBlob(std::string file, std::string xmlFile);
+        bool loadXML(std::string file);
         bool initXML(xmlNodePtr node);
         bool addPlatformData(xmlNodePtr node, std::string type);
         bool addSensorDevice(xmlNodePtr node, std::string type, std::string category);
@@ -25,6 +27,10 @@ class PlatformConfig {
         float getUnit(std::string unitName);
 public:
         PlatformConfig();
+        /* Parse the given XML only, used by the build-time config compiler */
+        PlatformConfig(const char *xmlFile);
+        /* Compile the parsed config into blobFile, stamped with the XML it came from */
+        bool writeBlob(const char *blobFile, const char *xmlFile);
         unsigned int size() { return devices.size(); }
         bool getPlatformData(int id, struct PlatformData &data);
         bool getSensorDevice(int id, SensorDevice &device);
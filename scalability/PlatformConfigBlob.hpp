@@ -0,0 +1,67 @@
+#ifndef _PLATFORM_CONFIG_BLOB_HPP_
+#define _PLATFORM_CONFIG_BLOB_HPP_
+#include <stdint.h>
+#include "ConfigSourceStamp.h"
+
+/*
+ * Precompiled form of sensor_hal_config_<mapper>.xml, produced at build time
+ * by sensor_hal_config_compiler and installed next to the XML as
+ * sensor_hal_config_<mapper>.bin. The HAL maps it read-only and builds its
+ * tables straight from the records, so libxml2 is only touched when no blob
+ * is installed or the XML next to it is not the one it was compiled from.
+ *
+ * Layout: header, count records, string table. Strings are stored once,
+ * NUL terminated, and referenced by offset into the string table; offset 0
+ * is the empty string. All fields are in the byte order of the target.
+ */
+#define PLATFORM_CONFIG_BLOB_MAGIC      0x42434853      /* "SHCB" */
+#define PLATFORM_CONFIG_BLOB_VERSION    2
+#define PLATFORM_CONFIG_BLOB_AXES       4
+
+struct platform_config_blob_header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t size;                  /* whole blob in bytes */
+        uint32_t count;                 /* sensor records */
+        uint32_t recordSize;            /* sizeof(struct platform_config_blob_sensor) */
+        uint32_t recordsOffset;
+        uint32_t stringsOffset;
+        uint32_t stringsSize;
+        struct config_source_stamp source;      /* of the XML compiled */
+};
+
+#define PLATFORM_CONFIG_BLOB_HAS_DATA   (1 << 0)        /* sensor has a platform_config element */
+#define PLATFORM_CONFIG_BLOB_FILTER     (1 << 1)        /* PlatformData::filterLength */
+
+struct platform_config_blob_sensor {
+        /* SensorDevice, id and handle follow from the record index */
+        uint32_t name;
+        uint32_t vendor;
+        int32_t version;
+        int32_t type;
+        uint32_t category;
+        uint32_t eventProperty;
+        uint32_t subname;
+        float maxRange;
+        float resolution;
+        float power;
+        int32_t minDelay;
+        uint32_t fifoReservedEventCount;
+        uint32_t fifoMaxEventCount;
+        int32_t mapper[PLATFORM_CONFIG_BLOB_AXES];
+        float scale[PLATFORM_CONFIG_BLOB_AXES];
+        /* PlatformData */
+        uint32_t flags;
+        uint32_t driverNodeType;
+        uint32_t dataName;
+        uint32_t activateInterface;
+        uint32_t setDelayInterface;
+        uint32_t dataInterface;
+        uint32_t calibrationFile;
+        uint32_t calibrationFunc;
+        uint32_t driverCalibrationInterface;
+        uint32_t driverCalibrationFile;
+        uint32_t driverCalibrationFunc;
+};
+
+#endif
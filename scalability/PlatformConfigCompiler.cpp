@@ -0,0 +1,28 @@
+#include <cstdio>
+#include "PlatformConfig.hpp"
+
+/*
+ * Build-time compiler of sensor_hal_config_<mapper>.xml into the binary
+ * blob PlatformConfig maps at HAL open, see PlatformConfigBlob.hpp.
+ * usage: sensor_hal_config_compiler <config.xml> <config.bin>
+ */
+int main(int argc, char **argv)
+{
+        if (argc != 3) {
+                fprintf(stderr, "usage: %s <config.xml> <config.bin>\n", argv[0]);
+                return 1;
+        }
+
+        PlatformConfig config(argv[1]);
+        if (config.size() == 0) {
+                fprintf(stderr, "%s: no sensor found in %s\n", argv[0], argv[1]);
+                return 1;
+        }
+
+        if (!config.writeBlob(argv[2], argv[1])) {
+                fprintf(stderr, "%s: cannot write %s\n", argv[0], argv[2]);
+                return 1;
+        }
+
+        return 0;
+}
@@ -1,8 +1,12 @@
 #include "Sensor.hpp"
+#include <cerrno>
 
 Sensor::Sensor()
 {
         pollfd = -1;
+        maxReportLatency = 0;
+        batchStart = 0;
+        flushRequests = 0;
         memset(&event, 0, sizeof(sensors_event_t));
         event.version = sizeof(sensors_event_t);
 }
@@ -10,6 +14,9 @@ Sensor::Sensor()
 Sensor::Sensor(SensorDevice &mDevice)
 {
         pollfd = -1;
+        maxReportLatency = 0;
+        batchStart = 0;
+        flushRequests = 0;
         device = mDevice;
         memset(&event, 0, sizeof(sensors_event_t));
         event.version = sizeof(sensors_event_t);
@@ -21,3 +28,49 @@ void Sensor::resetEventHandle()
 {
         event.sensor = device.getHandle();
 }
+
+int Sensor::batch(int handle, int flags, int64_t period_ns, int64_t timeout)
+{
+        /* No FIFO: only continuous reporting is supported */
+        if (timeout != 0)
+                return -EINVAL;
+
+        if (flags & SENSORS_BATCH_DRY_RUN)
+                return 0;
+
+        return setDelay(handle, period_ns);
+}
+
+void Sensor::flushEvents()
+{
+        sensors_event_t meta;
+
+        memset(&meta, 0, sizeof(sensors_event_t));
+        meta.version = META_DATA_VERSION;
+        meta.type = SENSOR_TYPE_META_DATA;
+        meta.meta_data.what = META_DATA_FLUSH_COMPLETE;
+        meta.meta_data.sensor = device.getHandle();
+
+        /* Deliver whatever is held back together with the flush complete events */
+        batchStart = 0;
+
+        while (hasFlushRequest()) {
+                if (!eventRing.push(meta)) {
+                        LOGW("%s: event ring full, flush of %s postponed", __FUNCTION__, device.getName());
+                        break;
+                }
+                android_atomic_dec(&flushRequests);
+        }
+}
+
+int64_t Sensor::getBatchDelay(int64_t now)
+{
+        int64_t delay;
+
+        /* Release early when half full so getData() always has room for a full read */
+        if (maxReportLatency == 0 || eventRing.size() >= EVENT_RING_CAPACITY / 2)
+                return 0;
+
+        delay = batchStart + maxReportLatency - now;
+        return delay > 0 ? delay : 0;
+}
@@ -2,7 +2,7 @@
 #define _SENSOR_HPP_
 #include "SensorDevice.hpp"
 #include "utils.hpp"
-#include <queue>
+#include "EventRing.hpp"
 
 #define SENSOR_NOPOLL   0x7fffffff
 #define NS_TO_MS 1000000
@@ -14,17 +14,33 @@ protected:
         SensorDevice device;
         sensors_event_t event;
         int pollfd;
+        EventRing eventRing;
+        int64_t maxReportLatency;       /* ns, HAL side batching window, 0 reports at once */
+        int64_t batchStart;             /* when the oldest held back event was queued */
+        volatile int32_t flushRequests; /* flush() calls not answered yet */
 public:
         Sensor();
         Sensor(SensorDevice &device);
         virtual ~Sensor() {}
         SensorDevice& getDevice() { return device; }
+        EventRing& getEventRing() { return eventRing; }
         void resetEventHandle();
         virtual int getPollfd() = 0;
         virtual int activate(int handle, int enabled) { return 0; }
         virtual int setDelay(int handle, int64_t ns) { return 0; }
-        virtual int getData(std::queue<sensors_event_t> &eventQue) = 0;
+        virtual int batch(int handle, int flags, int64_t period_ns, int64_t timeout);
+        virtual int getData() = 0;
         virtual bool selftest() = 0;
+        /* Any thread: ask the poll thread to answer with a flush complete event */
+        void requestFlush() { android_atomic_inc(&flushRequests); }
+        bool hasFlushRequest() { return android_atomic_acquire_load(&flushRequests) > 0; }
+        /* Poll thread: release held back events and queue the flush complete events */
+        virtual void flushEvents();
+        void startBatch(int64_t now) { batchStart = now; }
+        /* Any thread: report at once again, held back events become due */
+        void stopBatch() { maxReportLatency = 0; }
+        /* Poll thread: ns left before held back events must be delivered, 0 if due */
+        int64_t getBatchDelay(int64_t now);
 };
 
 #endif
@@ -24,6 +24,8 @@ SensorDevice::SensorDevice(const SensorDevice &device)
         dev.resolution = device.dev.resolution;
         dev.power = device.dev.power;
         dev.minDelay = device.dev.minDelay;
+        dev.fifoReservedEventCount = device.dev.fifoReservedEventCount;
+        dev.fifoMaxEventCount = device.dev.fifoMaxEventCount;
         id = device.id;
         category = device.category;
         subname = device.subname;
@@ -66,6 +68,8 @@ SensorDevice& SensorDevice::operator=(const SensorDevice &device)
         dev.resolution = device.dev.resolution;
         dev.power = device.dev.power;
         dev.minDelay = device.dev.minDelay;
+        dev.fifoReservedEventCount = device.dev.fifoReservedEventCount;
+        dev.fifoMaxEventCount = device.dev.fifoMaxEventCount;
         id = device.id;
         category = device.category;
         subname = device.subname;
@@ -91,6 +91,10 @@ public:
         void setPower(float power) { dev.power = power; }
         int32_t getMinDelay() { return dev.minDelay; }
         void setMinDelay(int32_t minDelay) { dev.minDelay = minDelay; }
+        uint32_t getFifoReservedEventCount() { return dev.fifoReservedEventCount; }
+        void setFifoReservedEventCount(uint32_t count) { dev.fifoReservedEventCount = count; }
+        uint32_t getFifoMaxEventCount() { return dev.fifoMaxEventCount; }
+        void setFifoMaxEventCount(uint32_t count) { dev.fifoMaxEventCount = count; }
         void copyItem(struct sensor_t* item) { memcpy(item, &dev, sizeof(struct sensor_t)); }
 };
 
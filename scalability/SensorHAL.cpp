@@ -7,7 +7,8 @@
 #include "PhysicalActivitySensor.hpp"
 #include "GestureSensor.hpp"
 #include "AudioClassifierSensor.hpp"
-#include <poll.h>
+#include <errno.h>
+#include "EventLoop.h"
 
 static int open(const struct hw_module_t* module, const char* id,
                 struct hw_device_t** device);
@@ -16,13 +17,29 @@ static struct hw_module_methods_t sensors_module_methods = {
 open: open,
 };
 
+/* Per sensor state kept by the HAL, indexed by sensor id */
+struct SensorState {
+        bool active;
+        bool queued;            /* in SensorModule::pending, poll thread only */
+        bool batched;           /* batch() was called, period and timeout are valid */
+        int flags;
+        int64_t period;
+        int64_t timeout;
+};
+
 struct SensorModule {
         struct sensor_t* list;
         std::vector<Sensor*> sensors;
-        struct pollfd *pollfds;
+        EventLoop *loop;
+        /* Sensors with events left in their ring, touched by the poll thread only */
+        Sensor **pending;
+        int pendingNum;
+        struct SensorState *state;
         int count;
 };
 
+#define SENSOR_POLL_MAX_READY   32
+
 static struct SensorModule mModule;
 
 static int get_sensors_list(struct sensors_module_t* module, struct sensor_t const** list)
@@ -154,11 +171,16 @@ static bool initSensors()
                 mModule.sensors[i]->getDevice().copyItem(mModule.list + i);
         }
 
-        mModule.pollfds = new struct pollfd[mModule.count];
-        for (int i = 0; i < mModule.count; i++) {
-                mModule.pollfds[i].fd = mModule.sensors[i]->getPollfd();
-                mModule.pollfds[i].events = POLLIN;
-                mModule.pollfds[i].revents = 0;
+        mModule.pending = new Sensor*[mModule.count];
+        mModule.pendingNum = 0;
+        mModule.state = new SensorState[mModule.count];
+        memset(mModule.state, 0, mModule.count * sizeof(struct SensorState));
+
+        /* Sensor fds are added to the loop when the sensor is activated */
+        mModule.loop = new EventLoop();
+        if (!mModule.loop->isValid()) {
+                LOGE("%s: line: %d create event loop error", __FUNCTION__, __LINE__);
+                return false;
         }
 
         return true;
@@ -173,7 +195,33 @@ int sensorActivate(struct sensors_poll_device_t *dev, int handle, int enabled)
                 return -1;
         }
 
-        return mModule.sensors[id]->activate(handle, enabled);
+        Sensor *sensor = mModule.sensors[id];
+        struct SensorState &state = mModule.state[id];
+        int err = sensor->activate(handle, enabled);
+        if (err != 0)
+                return err;
+
+        state.active = enabled;
+        if (enabled) {
+                /* Virtual sensors only accept rate changes while enabled, so batch() waits for activate() */
+                if (state.batched) {
+                        err = sensor->batch(handle, state.flags, state.period, state.timeout);
+                        if (err != 0)
+                                LOGE("%s: line:%d batch error: handle: %d; err: %d",
+                                     __FUNCTION__, __LINE__, handle, err);
+                }
+                mModule.loop->add(sensor->getPollfd(), sensor);
+        } else {
+                mModule.loop->remove(sensor->getPollfd());
+                /* Batch parameters do not outlive the activation they were set for */
+                state.batched = false;
+                state.flags = 0;
+                state.period = 0;
+                state.timeout = 0;
+                sensor->stopBatch();
+        }
+
+        return 0;
 }
 
 int sensorSetDelay(struct sensors_poll_device_t *dev, int handle, int64_t ns)
@@ -188,34 +236,126 @@ int sensorSetDelay(struct sensors_poll_device_t *dev, int handle, int64_t ns)
 
 }
 
+int sensorBatch(struct sensors_poll_device_1* dev, int handle, int flags, int64_t period_ns, int64_t timeout)
+{
+        int id = SensorDevice::handleToId(handle);
+        if (id < 0 || id >= mModule.count) {
+                LOGE("%s: line:%d Invalid handle: handle: %d; id: %d",
+                     __FUNCTION__, __LINE__, handle, id);
+                return -EINVAL;
+        }
+
+        Sensor *sensor = mModule.sensors[id];
+        struct SensorState &state = mModule.state[id];
+        int err = sensor->batch(handle, flags | SENSORS_BATCH_DRY_RUN, period_ns, timeout);
+        if (err != 0 || (flags & SENSORS_BATCH_DRY_RUN))
+                return err;
+
+        state.flags = flags;
+        state.period = period_ns;
+        state.timeout = timeout;
+        state.batched = true;
+
+        /* Applied by sensorActivate() otherwise */
+        if (!state.active)
+                return 0;
+
+        return sensor->batch(handle, flags, period_ns, timeout);
+}
+
+int sensorFlush(struct sensors_poll_device_1* dev, int handle)
+{
+        int id = SensorDevice::handleToId(handle);
+        if (id < 0 || id >= mModule.count) {
+                LOGE("%s: line:%d Invalid handle: handle: %d; id: %d",
+                     __FUNCTION__, __LINE__, handle, id);
+                return -EINVAL;
+        }
+
+        Sensor *sensor = mModule.sensors[id];
+        if (!mModule.state[id].active || sensor->getDevice().getType() == SENSOR_TYPE_SIGNIFICANT_MOTION)
+                return -EINVAL;
+
+        /* The ring is only written by the poll thread, hand the request over */
+        sensor->requestFlush();
+        mModule.loop->wake();
+
+        return 0;
+}
+
+/*
+ * Flushed sensors keep the batch start flushEvents() reset, so the flush
+ * complete event is delivered at once instead of after the batching window.
+ */
+static void queueSensor(Sensor *sensor, int64_t now, bool flushed)
+{
+        struct SensorState &state = mModule.state[sensor->getDevice().getId()];
+
+        if (state.queued || sensor->getEventRing().empty())
+                return;
+
+        state.queued = true;
+        if (!flushed)
+                sensor->startBatch(now);
+        mModule.pending[mModule.pendingNum++] = sensor;
+}
+
 int sensorPoll(struct sensors_poll_device_t *dev, sensors_event_t* data, int count)
 {
-        static std::queue<sensors_event_t> eventQue;
+        Sensor *ready[SENSOR_POLL_MAX_READY];
         int eventNum = 0;
-        int num, err;
+        int num, kept, timeout;
+        int64_t now, delay, minDelay;
+        bool woken;
 
         while (true) {
-                while (eventQue.size() > 0 && eventNum <= count) {
-                        data[eventNum] = eventQue.front();
-                        eventQue.pop();
-                        eventNum++;
+                /*
+                 * Drain the rings of sensors whose batching window is over,
+                 * keep the ones left non-empty and track the next deadline.
+                 */
+                now = getTimestamp();
+                minDelay = -1;
+                kept = 0;
+                for (int i = 0; i < mModule.pendingNum; i++) {
+                        Sensor *sensor = mModule.pending[i];
+                        EventRing &ring = sensor->getEventRing();
+                        delay = sensor->getBatchDelay(now);
+                        if (delay == 0 && eventNum < count)
+                                eventNum += ring.drain(data + eventNum, count - eventNum);
+                        if (ring.empty()) {
+                                mModule.state[sensor->getDevice().getId()].queued = false;
+                                continue;
+                        }
+                        mModule.pending[kept++] = sensor;
+                        if (minDelay < 0 || delay < minDelay)
+                                minDelay = delay;
                 }
+                mModule.pendingNum = kept;
 
                 if (eventNum > 0)
                         return eventNum;
 
-                num = poll(mModule.pollfds, mModule.count, -1);
-                if (num <= 0) {
-                        err = errno;
-                        LOGE("%s: line: %d poll error: %d %s", __FUNCTION__, __LINE__, err, strerror(err));
-                        return -err;
+                timeout = minDelay < 0 ? -1 : static_cast<int>((minDelay + NS_TO_MS - 1) / NS_TO_MS);
+                num = mModule.loop->wait(reinterpret_cast<void **>(ready), SENSOR_POLL_MAX_READY, timeout, &woken);
+                if (num < 0) {
+                        LOGE("%s: line: %d epoll error: %d %s", __FUNCTION__, __LINE__, -num, strerror(-num));
+                        return num;
+                }
+
+                now = getTimestamp();
+                for (int i = 0; i < num; i++) {
+                        ready[i]->getData();
+                        queueSensor(ready[i], now, false);
                 }
-                for (int i = 0; i < mModule.count; i++) {
-                        if (mModule.pollfds[i].revents & POLLIN)
-                                mModule.sensors[i]->getData(eventQue);
-                        else if (mModule.pollfds[i].revents != 0)
-                                LOGE("%s: line: %d poll error: %d fd: %d type: %d", __FUNCTION__, __LINE__, mModule.pollfds[i].revents, mModule.pollfds[i].fd, mModule.sensors[i]->getDevice().getType());
-                        mModule.pollfds[i].revents = 0;
+
+                if (woken) {
+                        for (int i = 0; i < mModule.count; i++) {
+                                Sensor *sensor = mModule.sensors[i];
+                                if (!sensor->hasFlushRequest())
+                                        continue;
+                                sensor->flushEvents();
+                                queueSensor(sensor, now, true);
+                        }
                 }
         }
 
@@ -230,8 +370,12 @@ int close(struct hw_device_t* device)
                 if (mModule.sensors[i])
                         delete mModule.sensors[i];
         }
-        if (mModule.pollfds)
-                delete [] mModule.pollfds;
+        if (mModule.pending)
+                delete [] mModule.pending;
+        if (mModule.state)
+                delete [] mModule.state;
+        if (mModule.loop)
+                delete mModule.loop;
 
         return 0;
 }
@@ -240,15 +384,17 @@ int close(struct hw_device_t* device)
 static int open(const struct hw_module_t* module, const char* id,
                 struct hw_device_t** device)
 {
-        static struct sensors_poll_device_t dev;
+        static struct sensors_poll_device_1 dev;
 
         dev.common.tag = HARDWARE_DEVICE_TAG;
-        dev.common.version = 0;
+        dev.common.version = SENSORS_DEVICE_API_VERSION_1_1;
         dev.common.module  = const_cast<hw_module_t*>(module);
         dev.common.close   = close;
         dev.activate       = sensorActivate;
         dev.setDelay       = sensorSetDelay;
         dev.poll           = sensorPoll;
+        dev.batch          = sensorBatch;
+        dev.flush          = sensorFlush;
 
         *device = &dev.common;
 
@@ -0,0 +1,72 @@
+#include <dlfcn.h>
+#include <cstring>
+#include <utils/Log.h>
+#include "SensorHubBinding.hpp"
+
+struct sensor_hub_methods SensorHubBinding::methods;
+void *SensorHubBinding::library = NULL;
+const struct sensor_hub_methods *SensorHubBinding::replacement = NULL;
+bool SensorHubBinding::loaded = false;
+pthread_mutex_t SensorHubBinding::lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_once_t SensorHubBinding::once = PTHREAD_ONCE_INIT;
+
+const struct sensor_hub_methods &SensorHubBinding::getMethods()
+{
+        pthread_once(&once, load);
+        return methods;
+}
+
+bool SensorHubBinding::install(const struct sensor_hub_methods &table)
+{
+        /* Too late once bound, the table in use stays */
+        pthread_mutex_lock(&lock);
+        if (!loaded)
+                replacement = &table;
+        pthread_mutex_unlock(&lock);
+
+        return memcmp(&getMethods(), &table, sizeof(table)) == 0;
+}
+
+#define SENSORHUB_RESOLVE(name)                                                         \
+        do {                                                                            \
+                table.name = reinterpret_cast<__typeof__(table.name)>(dlsym(library, #name)); \
+                if (table.name == NULL) {                                               \
+                        LOGE("dlsym: %s error!", #name);                                \
+                        dlclose(library);                                               \
+                        library = NULL;                                                 \
+                        return;                                                         \
+                }                                                                       \
+        } while (0)
+
+void SensorHubBinding::load()
+{
+        struct sensor_hub_methods table;
+        const struct sensor_hub_methods *installed;
+
+        pthread_mutex_lock(&lock);
+        loaded = true;
+        installed = replacement;
+        pthread_mutex_unlock(&lock);
+
+        if (installed != NULL) {
+                methods = *installed;
+                return;
+        }
+
+        library = dlopen(SENSORHUB_LIBRARY, RTLD_LAZY);
+        if (library == NULL) {
+                LOGE("dlopen: %s error!", SENSORHUB_LIBRARY);
+                return;
+        }
+
+        /* Publish nothing unless every method resolves */
+        SENSORHUB_RESOLVE(psh_open_session);
+        SENSORHUB_RESOLVE(psh_close_session);
+        SENSORHUB_RESOLVE(psh_get_fd);
+        SENSORHUB_RESOLVE(psh_start_streaming);
+        SENSORHUB_RESOLVE(psh_start_streaming_with_flag);
+        SENSORHUB_RESOLVE(psh_stop_streaming);
+        SENSORHUB_RESOLVE(psh_set_property);
+
+        methods = table;
+}
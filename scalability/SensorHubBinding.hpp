@@ -0,0 +1,45 @@
+#ifndef _SENSOR_HUB_BINDING_HPP_
+#define _SENSOR_HUB_BINDING_HPP_
+#include <pthread.h>
+#include <libsensorhub.h>
+
+#define SENSORHUB_LIBRARY       "/system/lib/libsensorhub.so"
+
+struct sensor_hub_methods {
+        handle_t (*psh_open_session)(psh_sensor_t sensor_type);
+        void (*psh_close_session)(handle_t handle);
+        int (*psh_get_fd)(handle_t handle);
+        error_t (*psh_start_streaming)(handle_t handle, int data_rate, int buffer_delay);
+        error_t (*psh_start_streaming_with_flag)(handle_t handle, int data_rate, int buffer_delay, streaming_flag flag);
+        error_t (*psh_stop_streaming)(handle_t handle);
+        error_t (*psh_set_property)(handle_t handle, property_type prop_type, void *value);
+};
+
+/*
+ * Process-wide binding to libsensorhub shared by all PSH sensors. The library
+ * is opened and resolved once, when the first PSH sensor is created, and stays
+ * loaded for the life of the process. The method table is all or nothing: if
+ * any symbol is missing every entry stays NULL, so callers keep checking a
+ * single entry for NULL.
+ *
+ * A replacement table, e.g. SensorHubStub::getMethods(), can be installed
+ * before the first PSH sensor is created to run the sensors without a hub.
+ */
+class SensorHubBinding {
+        friend class PSHSensor;
+        static struct sensor_hub_methods methods;
+        static void *library;
+        static const struct sensor_hub_methods *replacement;
+        static bool loaded;     /* load() has run, replacement is no longer read */
+        static pthread_mutex_t lock;
+        static pthread_once_t once;
+        static void load();
+public:
+        /* Binds on first call, safe to call from any thread */
+        static const struct sensor_hub_methods &getMethods();
+        static bool isValid() { return getMethods().psh_open_session != NULL; }
+        /* Returns false if the binding is already in use with another table */
+        static bool install(const struct sensor_hub_methods &table);
+};
+
+#endif
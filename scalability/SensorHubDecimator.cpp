@@ -0,0 +1,85 @@
+#include "SensorHubDecimator.hpp"
+#include "SensorHubDecimatorTaps.hpp"
+
+bool SensorHubDecimator::setup(unsigned int ratio, const struct decimator_record_ops *ops, size_t unitSize)
+{
+        if (ops == NULL || unitSize > DECIMATOR_MAX_UNIT || ratio < 2 || ratio > DECIMATOR_MAX_RATIO)
+                return false;
+
+        taps = decimatorTaps[ratio].taps;
+        count = decimatorTaps[ratio].count;
+        delay = decimatorTaps[ratio].delay;
+        pick = count - 1 - delay;
+
+        this->ratio = ratio;
+        this->ops = ops;
+        this->unitSize = unitSize;
+        reset();
+        return true;
+}
+
+void SensorHubDecimator::reset()
+{
+        for (int i = 0; i < DECIMATOR_BRANCHES; i++)
+                branches[i].active = false;
+        phase = 0;
+        next = 0;
+        primed = false;
+}
+
+bool SensorHubDecimator::feed(const char *record, char *out)
+{
+        int axes[3];
+        bool ready = false;
+
+        /* A new output starts every ratio inputs */
+        if (phase == 0) {
+                struct branch_t &branch = branches[next];
+                branch.active = true;
+                branch.tap = 0;
+                branch.acc[0] = branch.acc[1] = branch.acc[2] = 0;
+                next = (next + 1) % DECIMATOR_BRANCHES;
+        }
+        if (++phase == ratio)
+                phase = 0;
+
+        ops->load(record, axes);
+
+        for (int i = 0; i < DECIMATOR_BRANCHES; i++) {
+                struct branch_t &branch = branches[i];
+                if (!branch.active)
+                        continue;
+
+                int tap = taps[branch.tap];
+                branch.acc[0] += tap * axes[0];
+                branch.acc[1] += tap * axes[1];
+                branch.acc[2] += tap * axes[2];
+
+                if (branch.tap == pick)
+                        memcpy(branch.record, record, unitSize);
+
+                if (++branch.tap < count)
+                        continue;
+
+                for (int j = 0; j < 3; j++)
+                        branch.acc[j] = (branch.acc[j] + (1 << (DECIMATOR_SHIFT - 1))) >> DECIMATOR_SHIFT;
+                memcpy(out, branch.record, unitSize);
+                ops->store(out, branch.acc);
+                branch.active = false;
+                ready = true;
+        }
+
+        return ready;
+}
+
+bool SensorHubDecimator::push(const char *record, char *out)
+{
+        if (!primed) {
+                /* Hold the first sample over the taps before the picked one, nothing completes yet */
+                for (int i = 0; i < pick; i++)
+                        feed(record, out);
+                primed = true;
+        }
+
+        return feed(record, out);
+}
@@ -0,0 +1,115 @@
+#ifndef _SENSOR_HUB_DECIMATOR_HPP_
+#define _SENSOR_HUB_DECIMATOR_HPP_
+#include <limits>
+#include <string.h>
+
+#define DECIMATOR_MAX_UNIT      32      /* bytes, largest record filtered */
+#define DECIMATOR_SPAN          8       /* filter length in output periods, taps = 8 * ratio + 1 */
+#define DECIMATOR_BRANCHES      (DECIMATOR_SPAN + 1)    /* outputs in flight */
+#define DECIMATOR_MAX_RATIO     20
+#define DECIMATOR_MAX_TAPS      (DECIMATOR_SPAN * DECIMATOR_MAX_RATIO + 1)
+#define DECIMATOR_SHIFT         14      /* taps are Q14 */
+
+/* Filter of one ratio, see SensorHubDecimatorTaps.hpp */
+struct decimator_taps_t {
+        const short *taps;
+        int count;
+        int delay;              /* group delay at DC in inputs */
+};
+
+/* Access to the three axes of a libsensorhub record */
+struct decimator_record_ops {
+        void (*load)(const char *record, int *axes);
+        void (*store)(char *record, const int *axes);
+};
+
+template <typename record_t> struct DecimatorRecord {
+        static void load(const char *record, int *axes)
+        {
+                record_t r;
+                memcpy(&r, record, sizeof(r));
+                axes[0] = r.x;
+                axes[1] = r.y;
+                axes[2] = r.z;
+        }
+        static void store(char *record, const int *axes)
+        {
+                record_t r;
+                memcpy(&r, record, sizeof(r));
+                r.x = clamp(axes[0], r.x);
+                r.y = clamp(axes[1], r.y);
+                r.z = clamp(axes[2], r.z);
+                memcpy(record, &r, sizeof(r));
+        }
+        template <typename axis_t> static axis_t clamp(int value, axis_t)
+        {
+                if (value > std::numeric_limits<axis_t>::max())
+                        return std::numeric_limits<axis_t>::max();
+                if (value < std::numeric_limits<axis_t>::min())
+                        return std::numeric_limits<axis_t>::min();
+                return value;
+        }
+        static const struct decimator_record_ops ops;
+};
+
+template <typename record_t> const struct decimator_record_ops DecimatorRecord<record_t>::ops = {
+        DecimatorRecord<record_t>::load,
+        DecimatorRecord<record_t>::store,
+};
+
+/*
+ * Anti-aliased decimation of a record stream by an integer ratio, used by
+ * SensorHubStream for clients slower than the session.
+ *
+ * The low-pass FIR filter of every ratio is generated at build time by
+ * SensorHubDecimatorGen into SensorHubDecimatorTaps.hpp, and setup() only
+ * looks it up. It is the minimum phase version of a Q14 Kaiser windowed
+ * sinc with 8 * ratio + 1 taps and the cutoff below the output Nyquist
+ * frequency, flat within 1 dB up to 0.4 times the output Nyquist frequency
+ * and at least 40 dB down from the output Nyquist frequency on, so nothing
+ * the output cannot represent folds back into it above that level
+ * (tests/SensorHubDecimatorTest checks every ratio). Only the kept outputs
+ * are computed: every input adds into the DECIMATOR_BRANCHES outputs it
+ * contributes to, each through its own phase of the filter, so the cost
+ * per input is fixed and no input history is kept.
+ *
+ * Minimum phase keeps the delay of an output behind the newest input it
+ * includes, getDelay(), under two output periods where the linear phase
+ * filter would hold it at half its length. An output is the input record
+ * that many inputs back with its axes replaced by the filtered values, so
+ * its timestamp is that of the sample the output stands for; readers that
+ * stamp on arrival subtract getDelay() input periods. The first input is
+ * repeated to fill the filter up to that record, so the first output stands
+ * for the first input.
+ */
+class SensorHubDecimator {
+        struct branch_t {
+                bool active;
+                int tap;
+                int acc[3];
+                char record[DECIMATOR_MAX_UNIT];
+        };
+        const short *taps;
+        int count;
+        int delay;
+        int pick;               /* tap whose input record an output carries */
+        unsigned int ratio;
+        unsigned int phase;
+        bool primed;
+        const struct decimator_record_ops *ops;
+        size_t unitSize;
+        struct branch_t branches[DECIMATOR_BRANCHES];
+        int next;
+
+        bool feed(const char *record, char *out);
+public:
+        /* Returns false above DECIMATOR_MAX_RATIO, the caller then picks every ratio-th record */
+        bool setup(unsigned int ratio, const struct decimator_record_ops *ops, size_t unitSize);
+        void reset();
+        /* Inputs an output lags the newest input it includes */
+        int getDelay() { return delay; }
+        /* Returns true when record completed an output, stored in out */
+        bool push(const char *record, char *out);
+};
+
+#endif
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <complex>
+#include "SensorHubDecimator.hpp"
+
+typedef std::complex<double> complex_t;
+
+/*
+ * Build-time generator of the Q14 filter tables SensorHubDecimator looks
+ * up for every ratio it supports, so no filter is designed on the
+ * arbitration path. The output is checked in as SensorHubDecimatorTaps.hpp:
+ * usage: sensorhal_decimator_gen > SensorHubDecimatorTaps.hpp
+ */
+
+/* Filter design, frequencies relative to the output Nyquist frequency */
+#define DECIMATOR_CUTOFF        0.63    /* -6 dB point of the linear phase prototype */
+#define DECIMATOR_KAISER_BETA   4.5     /* about 50 dB of stopband rejection */
+/* Points of the spectrum the minimum phase filter is derived on, a power of 2 */
+#define DECIMATOR_FFT_SIZE      8192
+/* Floor of the prototype's magnitude before its log, its stopband zeros have none */
+#define DECIMATOR_FFT_FLOOR     1e-6
+
+/* Zeroth order modified Bessel function of the first kind, for the Kaiser window */
+static double besselI0(double x)
+{
+        double sum = 1, term = 1;
+
+        for (int k = 1; k < 32 && term > sum * 1e-12; k++) {
+                term *= (x / (2 * k)) * (x / (2 * k));
+                sum += term;
+        }
+        return sum;
+}
+
+/* In place radix 2 FFT, inverse when sign is positive */
+static void fft(complex_t *a, int n, int sign)
+{
+        for (int i = 1, j = 0; i < n; i++) {
+                int bit = n >> 1;
+                for (; j & bit; bit >>= 1)
+                        j ^= bit;
+                j ^= bit;
+                if (i < j) {
+                        complex_t t = a[i];
+                        a[i] = a[j];
+                        a[j] = t;
+                }
+        }
+
+        for (int len = 2; len <= n; len <<= 1) {
+                complex_t w = std::polar(1.0, sign * 2 * M_PI / len);
+                for (int i = 0; i < n; i += len) {
+                        complex_t u = 1;
+                        for (int j = 0; j < len / 2; j++) {
+                                complex_t x = a[i + j], y = a[i + j + len / 2] * u;
+                                a[i + j] = x + y;
+                                a[i + j + len / 2] = x - y;
+                                u *= w;
+                        }
+                }
+        }
+
+        if (sign > 0)
+                for (int i = 0; i < n; i++)
+                        a[i] /= n;
+}
+
+/*
+ * Kaiser windowed sinc, turned into the minimum phase filter with the same
+ * magnitude through its folded cepstrum: the linear phase prototype delays
+ * everything by half its length, the minimum phase one by less than two
+ * output periods at low frequencies.
+ *
+ * Stores the taps oldest input first, as the decimator applies them, with
+ * unity gain at DC and returns the tap count; delay is the group delay at
+ * DC in inputs, rounded.
+ */
+static int design(unsigned int ratio, short *taps, int &delay)
+{
+        static complex_t a[DECIMATOR_FFT_SIZE];
+        double filter[DECIMATOR_MAX_TAPS], sum = 0, moment = 0;
+        int count = DECIMATOR_SPAN * ratio + 1, center = count / 2, total = 0, peak = 0;
+        double fc = DECIMATOR_CUTOFF * 0.5 / ratio;     /* cycles per input sample */
+
+        for (int n = 0; n < count; n++) {
+                double k = n - center, w = k / center;
+                double sinc = k == 0 ? 2 * fc : sin(2 * M_PI * fc * k) / (M_PI * k);
+                filter[n] = sinc * besselI0(DECIMATOR_KAISER_BETA * sqrt(1 - w * w));
+                sum += filter[n];
+        }
+
+        /* Cepstrum of the log magnitude, folded onto positive quefrencies */
+        for (int i = 0; i < DECIMATOR_FFT_SIZE; i++)
+                a[i] = i < count ? filter[i] / sum : 0;
+        fft(a, DECIMATOR_FFT_SIZE, -1);
+        for (int i = 0; i < DECIMATOR_FFT_SIZE; i++)
+                a[i] = log(std::max(std::abs(a[i]), DECIMATOR_FFT_FLOOR));
+        fft(a, DECIMATOR_FFT_SIZE, 1);
+        for (int i = 1; i < DECIMATOR_FFT_SIZE / 2; i++)
+                a[i] *= 2;
+        for (int i = DECIMATOR_FFT_SIZE / 2 + 1; i < DECIMATOR_FFT_SIZE; i++)
+                a[i] = 0;
+        fft(a, DECIMATOR_FFT_SIZE, -1);
+        for (int i = 0; i < DECIMATOR_FFT_SIZE; i++)
+                a[i] = std::exp(a[i]);
+        fft(a, DECIMATOR_FFT_SIZE, 1);
+
+        /* a[n] weighs the input n samples before the newest, its tail past count is negligible */
+        sum = 0;
+        for (int n = 0; n < count; n++)
+                sum += a[n].real();
+
+        /* Rounding left over goes to the largest tap */
+        for (int n = 0; n < count; n++) {
+                short tap = static_cast<short>(floor(a[n].real() / sum * (1 << DECIMATOR_SHIFT) + 0.5));
+                taps[count - 1 - n] = tap;
+                total += tap;
+                if (abs(tap) > abs(taps[count - 1 - peak]))
+                        peak = n;
+        }
+        taps[count - 1 - peak] += (1 << DECIMATOR_SHIFT) - total;
+
+        for (int n = 0; n < count; n++)
+                moment += n * static_cast<double>(taps[count - 1 - n]);
+        delay = static_cast<int>(floor(moment / (1 << DECIMATOR_SHIFT) + 0.5));
+
+        return count;
+}
+
+int main()
+{
+        short taps[DECIMATOR_MAX_TAPS];
+        int counts[DECIMATOR_MAX_RATIO + 1], delays[DECIMATOR_MAX_RATIO + 1];
+
+        printf("/* Generated by sensorhal_decimator_gen (SensorHubDecimatorGen.cpp), do not edit */\n");
+        printf("#ifndef _SENSOR_HUB_DECIMATOR_TAPS_HPP_\n");
+        printf("#define _SENSOR_HUB_DECIMATOR_TAPS_HPP_\n");
+        printf("\n");
+        printf("/*\n");
+        printf(" * Minimum phase Kaiser windowed sinc, beta %.1f, cutoff %.2f times the output\n",
+               DECIMATOR_KAISER_BETA, DECIMATOR_CUTOFF);
+        printf(" * Nyquist frequency, Q%d, oldest input first\n", DECIMATOR_SHIFT);
+        printf(" */\n");
+
+        for (unsigned int ratio = 2; ratio <= DECIMATOR_MAX_RATIO; ratio++) {
+                int count = counts[ratio] = design(ratio, taps, delays[ratio]);
+
+                printf("static const short decimatorTaps%u[%d] = {", ratio, count);
+                for (int n = 0; n < count; n++)
+                        printf("%s%6d,", n % 10 == 0 ? "\n       " : "", taps[n]);
+                printf("\n};\n");
+        }
+
+        printf("\n/* Indexed by ratio: taps, tap count, group delay in inputs */\n");
+        printf("static const struct decimator_taps_t decimatorTaps[DECIMATOR_MAX_RATIO + 1] = {\n");
+        printf("        { NULL, 0, 0 },\n");
+        printf("        { NULL, 0, 0 },\n");
+        for (unsigned int ratio = 2; ratio <= DECIMATOR_MAX_RATIO; ratio++)
+                printf("        { decimatorTaps%u, %d, %d },\n", ratio, counts[ratio], delays[ratio]);
+        printf("};\n");
+        printf("\n");
+        printf("#endif\n");
+
+        return 0;
+}
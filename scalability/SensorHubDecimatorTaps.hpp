@@ -0,0 +1,252 @@
+/* Generated by sensorhal_decimator_gen (SensorHubDecimatorGen.cpp), do not edit */
+#ifndef _SENSOR_HUB_DECIMATOR_TAPS_HPP_
+#define _SENSOR_HUB_DECIMATOR_TAPS_HPP_
+
+/*
+ * Minimum phase Kaiser windowed sinc, beta 4.5, cutoff 0.63 times the output
+ * Nyquist frequency, Q14, oldest input first
+ */
+static const short decimatorTaps2[17] = {
+            8,   -12,   -50,     6,   199,   281,  -118,  -920, -1317,  -398,
+         1815,  4102,  5030,  4198,  2447,   932,   181,
+};
+static const short decimatorTaps3[25] = {
+            9,    -4,   -23,   -34,   -10,    62,   153,   191,    96,  -167,
+         -530,  -824,  -838,  -418,   430,  1520,  2547,  3210,  3335,  2944,
+         2219,  1413,   737,   293,    73,
+};
+static const short decimatorTaps4[33] = {
+            8,     0,   -11,   -22,   -25,   -12,    21,    70,   119,   142,
+          113,    14,  -153,  -358,  -547,  -652,  -608,  -376,    44,   608,
+         1233,  1816,  2259,  2492,  2488,  2269,  1895,  1444,   995,   611,
+          325,   140,    42,
+};
+static const short decimatorTaps5[41] = {
+            8,     2,    -6,   -13,   -19,   -20,   -12,     6,    34,    67,
+           97,   112,   103,    59,   -21,  -134,  -265,  -392,  -488,  -524,
+         -477,  -332,   -89,   239,   622,  1023,  1399,  1709,  1919,  2011,
+         1984,  1847,  1624,  1349,  1054,   771,   523,   324,   178,    83,
+           29,
+};
+static const short decimatorTaps6[49] = {
+            7,     3,    -3,    -8,   -13,   -17,   -17,   -12,     0,    17,
+           38,    61,    81,    92,    90,    69,    26,   -37,  -117,  -208,
+         -298,  -375,  -425,  -434,  -392,  -293,  -137,    71,   320,   594,
+          872,  1134,  1360,  1534,  1642,  1680,  1650,  1556,  1411,  1229,
+         1028,   824,   629,   456,   310,   196,   112,    56,    22,
+};
+static const short decimatorTaps7[57] = {
+            7,     3,    -1,    -5,    -9,   -13,   -15,   -14,   -11,    -3,
+            8,    23,    39,    56,    70,    78,    78,    67,    44,     6,
+          -44,  -104,  -170,  -237,  -298,  -345,  -370,  -368,  -333,  -262,
+         -154,   -12,   159,   350,   554,   758,   951,  1123,  1264,  1366,
+         1426,  1441,  1412,  1344,  1243,  1116,   974,   823,   673,   532,
+          404,   293,   202,   130,    77,    41,    17,
+};
+static const short decimatorTaps8[65] = {
+            6,     3,     0,    -3,    -6,    -9,   -12,   -13,   -12,   -10,
+           -5,     3,    14,    26,    38,    51,    61,    68,    69,    63,
+           49,    26,    -6,   -47,   -93,  -144,  -196,  -244,  -285,  -314,
+         -326,  -319,  -289,  -235,  -157,   -55,    68,   207,   358,   515,
+          671,   819,   954,  1069,  1159,  1222,  1255,  1261,  1234,  1182,
+         1108,  1016,   910,   797,   681,   568,   460,   362,   275,   201,
+          140,    93,    57,    31,    14,
+};
+static const short decimatorTaps9[73] = {
+            6,     3,     1,    -2,    -4,    -7,    -9,   -11,   -12,   -11,
+           -9,    -5,     1,     8,    17,    27,    37,    46,    54,    60,
+           61,    58,    50,    35,    14,   -14,   -47,   -84,  -124,  -165,
+         -204,  -239,  -266,  -284,  -290,  -281,  -256,  -214,  -155,   -79,
+           12,   117,   231,   352,   476,   599,   717,   825,   920,   999,
+         1060,  1100,  1121,  1118,  1096,  1056,  1000,   930,   850,   763,
+          672,   581,   491,   407,   329,   259,   198,   146,   103,    69,
+           44,    25,    12,
+};
+static const short decimatorTaps10[81] = {
+            5,     3,     1,    -1,    -3,    -5,    -7,    -9,   -10,   -10,
+          -10,    -8,    -5,    -1,     4,    11,    19,    27,    35,    43,
+           49,    53,    55,    54,    48,    38,    24,     5,   -19,   -46,
+          -77,  -109,  -142,  -175,  -204,  -229,  -248,  -259,  -260,  -250,
+         -229,  -195,  -149,   -90,   -20,    60,   149,   244,   344,   444,
+          544,   639,   728,   807,   875,   931,   972,   998,  1012,  1004,
+          985,   953,   909,   855,   792,   723,   651,   577,   503,   431,
+          363,   300,   242,   191,   147,   109,    79,    54,    35,    20,
+           10,
+};
+static const short decimatorTaps11[89] = {
+            5,     3,     2,     0,    -2,    -4,    -6,    -7,    -8,    -9,
+           -9,    -9,    -8,    -5,    -2,     2,     7,    13,    20,    27,
+           33,    39,    45,    48,    50,    49,    46,    39,    29,    15,
+           -2,   -22,   -45,   -71,   -97,  -125,  -151,  -177,  -199,  -217,
+         -230,  -236,  -235,  -226,  -208,  -180,  -143,   -96,   -41,    22,
+           93,   168,   249,   331,   414,   496,   575,   649,   717,   776,
+          826,   866,   895,   912,   920,   912,   895,   869,   833,   790,
+          740,   685,   627,   566,   505,   444,   385,   329,   276,   228,
+          185,   147,   113,    85,    62,    43,    28,    17,     9,
+};
+static const short decimatorTaps12[97] = {
+            5,     3,     2,     0,    -1,    -3,    -4,    -6,    -7,    -8,
+           -9,    -9,    -8,    -7,    -5,    -3,     1,     5,     9,    15,
+           20,    26,    32,    37,    41,    44,    46,    45,    43,    38,
+           31,    21,     9,    -6,   -24,   -44,   -65,   -87,  -110,  -133,
+         -155,  -174,  -191,  -204,  -213,  -217,  -214,  -206,  -190,  -167,
+         -136,   -99,   -55,    -4,    53,   114,   179,   247,   317,   387,
+          456,   522,   585,   643,   695,   740,   777,   806,   827,   838,
+          841,   835,   821,   799,   770,   734,   694,   649,   601,   551,
+          499,   448,   397,   348,   301,   257,   216,   178,   145,   115,
+           90,    68,    50,    35,    24,    15,     8,
+};
+static const short decimatorTaps13[105] = {
+            4,     3,     2,     1,    -1,    -2,    -3,    -5,    -6,    -7,
+           -8,    -8,    -8,    -8,    -7,    -5,    -3,     0,     3,     7,
+           11,    16,    20,    25,    30,    34,    38,    41,    42,    42,
+           41,    37,    32,    25,    15,     4,   -10,   -25,   -42,   -61,
+          -80,   -99,  -119,  -137,  -155,  -170,  -183,  -193,  -199,  -200,
+         -197,  -189,  -175,  -155,  -130,   -99,   -62,   -20,    26,    76,
+          130,   187,   246,   305,   364,   423,   480,   533,   583,   629,
+          669,   704,   732,   753,   768,   775,   776,   770,   757,   738,
+          714,   685,   651,   614,   574,   532,   489,   445,   401,   358,
+          316,   276,   238,   203,   171,   142,   116,    93,    73,    56,
+           41,    30,    20,    13,     7,
+};
+static const short decimatorTaps14[113] = {
+            4,     3,     2,     1,     0,    -1,    -3,    -4,    -5,    -6,
+           -7,    -7,    -7,    -7,    -7,    -6,    -5,    -3,    -1,     2,
+            5,     8,    12,    16,    20,    25,    28,    32,    35,    37,
+           39,    39,    38,    36,    32,    26,    19,    10,     0,   -12,
+          -26,   -41,   -57,   -73,   -90,  -107,  -123,  -138,  -152,  -165,
+         -174,  -182,  -185,  -186,  -182,  -174,  -162,  -145,  -124,   -98,
+          -67,   -33,     6,    48,    93,   140,   190,   241,   292,   343,
+          394,   442,   489,   533,   573,   609,   641,   668,   689,   705,
+          716,   723,   720,   714,   703,   687,   666,   641,   613,   582,
+          549,   513,   476,   438,   401,   363,   326,   290,   256,   223,
+          193,   165,   139,   115,    94,    76,    60,    46,    35,    25,
+           18,    11,     7,
+};
+static const short decimatorTaps15[121] = {
+            4,     3,     2,     1,     0,    -1,    -2,    -3,    -4,    -5,
+           -6,    -6,    -7,    -7,    -7,    -7,    -6,    -5,    -3,    -2,
+            1,     3,     6,     9,    13,    16,    20,    24,    27,    30,
+           33,    35,    36,    36,    36,    34,    31,    27,    22,    15,
+            6,    -3,   -14,   -26,   -39,   -53,   -67,   -82,   -96,  -111,
+         -124,  -137,  -148,  -158,  -165,  -171,  -173,  -173,  -169,  -162,
+         -151,  -137,  -118,   -96,   -71,   -42,   -10,    26,    64,   104,
+          146,   189,   234,   278,   323,   367,   409,   450,   489,   525,
+          557,   587,   612,   633,   650,   662,   670,   674,   672,   666,
+          656,   642,   625,   604,   580,   554,   525,   495,   463,   431,
+          398,   365,   332,   300,   269,   239,   210,   184,   159,   136,
+          115,    96,    79,    64,    51,    39,    30,    22,    15,    10,
+            6,
+};
+static const short decimatorTaps16[129] = {
+            4,     3,     2,     1,     0,    -1,    -2,    -2,    -3,    -4,
+           -5,    -6,    -6,    -6,    -7,    -7,    -6,    -6,    -5,    -3,
+           -2,     0,     2,     5,     7,    10,    14,    17,    20,    23,
+           26,    29,    31,    33,    34,    35,    34,    33,    31,    27,
+           23,    17,    11,     3,    -6,   -16,   -27,   -39,   -51,   -64,
+          -77,   -90,  -102,  -115,  -126,  -136,  -146,  -153,  -159,  -162,
+         -163,  -162,  -158,  -151,  -141,  -128,  -112,   -92,   -70,   -45,
+          -17,    13,    46,    80,   117,   154,   193,   232,   272,   311,
+          349,   386,   422,   456,   488,   517,   543,   566,   586,   603,
+          615,   624,   629,   635,   628,   622,   613,   601,   585,   567,
+          546,   524,   499,   473,   446,   417,   389,   360,   331,   302,
+          274,   247,   221,   196,   173,   151,   131,   112,    95,    79,
+           66,    53,    43,    33,    26,    19,    14,     9,     6,
+};
+static const short decimatorTaps17[137] = {
+            4,     3,     2,     1,     0,     0,    -1,    -2,    -3,    -3,
+           -4,    -5,    -5,    -6,    -6,    -6,    -6,    -6,    -5,    -4,
+           -3,    -2,    -1,     1,     3,     6,     8,    11,    14,    16,
+           19,    22,    24,    27,    29,    30,    32,    32,    32,    31,
+           29,    27,    24,    19,    14,     8,     1,    -7,   -16,   -26,
+          -36,   -47,   -58,   -69,   -81,   -92,  -103,  -113,  -123,  -132,
+         -139,  -145,  -150,  -152,  -153,  -151,  -148,  -141,  -133,  -122,
+         -108,   -92,   -73,   -52,   -28,    -2,    26,    55,    86,   119,
+          152,   187,   221,   256,   291,   325,   358,   390,   421,   450,
+          476,   501,   523,   542,   558,   571,   582,   589,   593,   594,
+          592,   587,   579,   568,   555,   539,   521,   502,   481,   458,
+          434,   410,   384,   359,   333,   307,   282,   257,   233,   210,
+          188,   167,   147,   128,   111,    95,    81,    68,    56,    46,
+           37,    29,    23,    17,    12,     8,     5,
+};
+static const short decimatorTaps18[145] = {
+            3,     3,     2,     1,     1,     0,    -1,    -2,    -2,    -3,
+           -4,    -4,    -5,    -5,    -5,    -6,    -6,    -6,    -5,    -5,
+           -4,    -3,    -2,    -1,     1,     2,     4,     7,     9,    11,
+           14,    16,    19,    21,    23,    25,    27,    29,    30,    30,
+           30,    30,    28,    26,    24,    20,    16,    11,     5,    -2,
+           -9,   -17,   -26,   -35,   -44,   -54,   -65,   -75,   -85,   -95,
+         -104,  -113,  -121,  -128,  -134,  -139,  -142,  -144,  -144,  -143,
+         -139,  -133,  -125,  -115,  -103,   -89,   -73,   -54,   -34,   -11,
+           13,    38,    66,    94,   123,   154,   184,   215,   246,   277,
+          308,   337,   366,   393,   419,   444,   466,   486,   504,   520,
+          533,   544,   552,   558,   561,   565,   558,   554,   546,   537,
+          525,   511,   496,   479,   460,   441,   420,   398,   376,   353,
+          330,   307,   284,   262,   240,   218,   198,   178,   159,   141,
+          125,   109,    95,    81,    69,    58,    49,    40,    32,    26,
+           20,    15,    11,     8,     5,
+};
+static const short decimatorTaps19[153] = {
+            3,     3,     2,     1,     1,     0,    -1,    -1,    -2,    -2,
+           -3,    -4,    -4,    -5,    -5,    -5,    -5,    -6,    -5,    -5,
+           -5,    -4,    -3,    -2,    -1,     0,     2,     3,     5,     7,
+            9,    12,    14,    16,    18,    20,    22,    24,    26,    27,
+           28,    29,    29,    28,    27,    26,    24,    21,    17,    13,
+            8,     3,    -3,   -10,   -18,   -25,   -34,   -42,   -51,   -60,
+          -70,   -79,   -88,   -96,  -104,  -112,  -119,  -125,  -130,  -133,
+         -136,  -137,  -137,  -135,  -131,  -126,  -119,  -110,   -99,   -86,
+          -72,   -56,   -38,   -18,     3,    26,    49,    74,   100,   127,
+          154,   182,   210,   237,   265,   292,   319,   345,   369,   393,
+          415,   436,   454,   471,   486,   499,   510,   519,   525,   529,
+          531,   539,   528,   524,   517,   509,   498,   486,   473,   457,
+          441,   424,   405,   386,   366,   346,   326,   305,   285,   264,
+          244,   225,   205,   187,   169,   152,   136,   121,   107,    94,
+           81,    70,    60,    51,    42,    35,    28,    23,    18,    14,
+           10,     7,     5,
+};
+static const short decimatorTaps20[161] = {
+            3,     3,     2,     1,     1,     0,     0,    -1,    -2,    -2,
+           -3,    -3,    -4,    -4,    -4,    -5,    -5,    -5,    -5,    -5,
+           -5,    -5,    -4,    -3,    -3,    -2,     0,     1,     2,     4,
+            6,     8,    10,    12,    14,    16,    18,    20,    21,    23,
+           25,    26,    27,    27,    27,    27,    26,    25,    23,    21,
+           18,    15,    11,     6,     1,    -5,   -11,   -18,   -25,   -32,
+          -40,   -48,   -56,   -65,   -73,   -81,   -89,   -96,  -103,  -110,
+         -115,  -120,  -124,  -127,  -129,  -130,  -129,  -127,  -124,  -119,
+         -113,  -105,   -95,   -84,   -71,   -57,   -41,   -24,    -5,    14,
+           35,    57,    80,   104,   128,   153,   178,   203,   228,   253,
+          278,   302,   325,   347,   369,   389,   408,   425,   441,   456,
+          468,   479,   488,   495,   500,   504,   501,   504,   502,   498,
+          492,   484,   475,   464,   452,   438,   424,   409,   392,   375,
+          358,   340,   321,   303,   284,   266,   247,   229,   212,   194,
+          178,   162,   146,   132,   118,   105,    93,    81,    71,    61,
+           52,    44,    37,    31,    25,    20,    16,    12,     9,     7,
+            4,
+};
+
+/* Indexed by ratio: taps, tap count, group delay in inputs */
+static const struct decimator_taps_t decimatorTaps[DECIMATOR_MAX_RATIO + 1] = {
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { decimatorTaps2, 17, 3 },
+        { decimatorTaps3, 25, 5 },
+        { decimatorTaps4, 33, 7 },
+        { decimatorTaps5, 41, 9 },
+        { decimatorTaps6, 49, 10 },
+        { decimatorTaps7, 57, 12 },
+        { decimatorTaps8, 65, 14 },
+        { decimatorTaps9, 73, 16 },
+        { decimatorTaps10, 81, 18 },
+        { decimatorTaps11, 89, 19 },
+        { decimatorTaps12, 97, 21 },
+        { decimatorTaps13, 105, 23 },
+        { decimatorTaps14, 113, 25 },
+        { decimatorTaps15, 121, 27 },
+        { decimatorTaps16, 129, 29 },
+        { decimatorTaps17, 137, 30 },
+        { decimatorTaps18, 145, 32 },
+        { decimatorTaps19, 153, 34 },
+        { decimatorTaps20, 161, 36 },
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "PSHSensor.hpp"
+#include <cerrno>
 
 psh_sensor_t SensorHubHelper::getType(int sensorType, sensors_subname subname)
 {
@@ -95,7 +96,7 @@ void SensorHubHelper::getStartStreamingParameters(int sensorType, int &dataRate,
         }
 }
 
-bool SensorHubHelper::setPSHPropertyIfNeeded(int sensorType, struct sensor_hub_methods methods, handle_t handler) {
+bool SensorHubHelper::setPSHPropertyIfNeeded(int sensorType, const struct sensor_hub_methods &methods, handle_t handler) {
         switch (sensorType) {
         case SENSOR_TYPE_SHAKE: {
                 int sensitivity = SHAKE_SEN_MEDIUM;
@@ -199,64 +200,214 @@ int SensorHubHelper::getMoveDetectEvent(struct md_data data)
         }
 }
 
-size_t SensorHubHelper::getUnitSize(int sensorType)
+/*
+ * Per sensor type decoding of libsensorhub records. Each specialization names
+ * its payload struct and converts one record; decodeRecords() instantiates a
+ * tight loop per type, selected once per session through sensorhubDecoders.
+ */
+template <int sensorType> struct SensorhubRecord;
+
+#define SENSORHUB_RECORD(type, payload)                                                 \
+template <> struct SensorhubRecord<type> {                                              \
+        typedef struct payload data_t;                                                  \
+        static inline void decode(struct SensorDevice &device, const data_t &record,   \
+                                  struct sensorhub_event_t &event);                     \
+};                                                                                      \
+inline void SensorhubRecord<type>::decode(struct SensorDevice &device, const data_t &record, \
+                                          struct sensorhub_event_t &event)
+
+SENSORHUB_RECORD(SENSOR_TYPE_ACCELEROMETER, accel_data)
 {
-        switch (sensorType) {
-        case SENSOR_TYPE_ACCELEROMETER:
-                return sizeof(struct accel_data);
-        case SENSOR_TYPE_MAGNETIC_FIELD:
-                return sizeof(struct compass_raw_data);
-        case SENSOR_TYPE_ORIENTATION:
-                return sizeof(struct orientation_data);
-        case SENSOR_TYPE_GYROSCOPE:
-                return sizeof(struct gyro_raw_data);
-        case SENSOR_TYPE_LIGHT:
-                return sizeof(struct als_raw_data);
-        case SENSOR_TYPE_PRESSURE:
-                return sizeof(struct baro_raw_data);
-        case SENSOR_TYPE_PROXIMITY:
-                return sizeof(struct ps_phy_data);
-        case SENSOR_TYPE_GRAVITY:
-                return sizeof(struct gravity_data);
-        case SENSOR_TYPE_LINEAR_ACCELERATION:
-                return sizeof(struct linear_accel_data);
-        case SENSOR_TYPE_ROTATION_VECTOR:
-                return sizeof(struct rotation_vector_data);
-        case SENSOR_TYPE_GESTURE_FLICK:
-                return sizeof(struct gesture_flick_data);
-        case SENSOR_TYPE_GESTURE:
-                return sizeof(struct gs_data);
-        case SENSOR_TYPE_PHYSICAL_ACTIVITY:
-                return sizeof(struct phy_activity_data);
-        case SENSOR_TYPE_TERMINAL:
-                return sizeof(struct tc_data);
-        case SENSOR_TYPE_PEDOMETER:
-                return sizeof(struct pedometer_data);
-        case SENSOR_TYPE_SHAKE:
-                return sizeof(struct shaking_data);
-        case SENSOR_TYPE_SIMPLE_TAPPING:
-                return sizeof(struct stap_data);
-        case SENSOR_TYPE_MOVE_DETECT:
-                return sizeof(struct md_data);
-        case SENSOR_TYPE_STEP_DETECTOR:
-                return sizeof(struct stepdetector_data);
-        case SENSOR_TYPE_STEP_COUNTER:
-                return sizeof(struct stepcounter_data);
-        case SENSOR_TYPE_SIGNIFICANT_MOTION:
-                return sizeof(struct sm_data);
-        case SENSOR_TYPE_GAME_ROTATION_VECTOR:
-                return sizeof(struct game_rotation_vector_data);
-        case SENSOR_TYPE_GEOMAGNETIC_ROTATION_VECTOR:
-                return sizeof(struct geomagnetic_rotation_vector_data);
-        case SENSOR_TYPE_TEMPERATURE:
-        case SENSOR_TYPE_RELATIVE_HUMIDITY:
-        case SENSOR_TYPE_AMBIENT_TEMPERATURE:
-        case SENSOR_TYPE_AUDIO_CLASSIFICATION:
-        default:
-                LOGE("%s: Unsupported Sensor Type: %d", __FUNCTION__, sensorType);
-                break;
+        event.data[0] = record.x;
+        event.data[1] = record.y;
+        event.data[2] = record.z;
+        event.accuracy = SENSOR_STATUS_ACCURACY_MEDIUM;
+        SensorHubHelper::accelFilter(device, event);
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_MAGNETIC_FIELD, compass_raw_data)
+{
+        event.data[0] = record.x;
+        event.data[1] = record.y;
+        event.data[2] = record.z;
+        event.accuracy = record.accuracy ? SENSOR_STATUS_ACCURACY_HIGH : SENSOR_STATUS_ACCURACY_LOW;
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_ORIENTATION, orientation_data)
+{
+        event.data[0] = record.azimuth;
+        event.data[1] = record.pitch;
+        event.data[2] = record.roll;
+        event.accuracy = SENSOR_STATUS_ACCURACY_MEDIUM;
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_GYROSCOPE, gyro_raw_data)
+{
+        event.data[0] = record.x;
+        event.data[1] = record.y;
+        event.data[2] = record.z;
+        event.accuracy = record.accuracy ? SENSOR_STATUS_ACCURACY_HIGH : SENSOR_STATUS_ACCURACY_LOW;
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_LIGHT, als_raw_data)
+{
+        event.data[0] = record.lux;
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_PRESSURE, baro_raw_data)
+{
+        event.data[0] = record.p;
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_PROXIMITY, ps_phy_data)
+{
+        event.data[0] = record.near == 0 ? 1 : 0;
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_GRAVITY, gravity_data)
+{
+        event.data[0] = record.x;
+        event.data[1] = record.y;
+        event.data[2] = record.z;
+        event.accuracy = SENSOR_STATUS_ACCURACY_MEDIUM;
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_LINEAR_ACCELERATION, linear_accel_data)
+{
+        event.data[0] = record.x;
+        event.data[1] = record.y;
+        event.data[2] = record.z;
+        event.accuracy = SENSOR_STATUS_ACCURACY_MEDIUM;
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_ROTATION_VECTOR, rotation_vector_data)
+{
+        event.data[0] = record.x;
+        event.data[1] = record.y;
+        event.data[2] = record.z;
+        event.data[3] = record.w;
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_GESTURE_FLICK, gesture_flick_data)
+{
+        event.data[0] = SensorHubHelper::getGestureFlickEvent(record);
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_TERMINAL, tc_data)
+{
+        event.data[0] = SensorHubHelper::getTerminalEvent(record);
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_SHAKE, shaking_data)
+{
+        event.data[0] = SensorHubHelper::getShakeEvent(record);
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_SIMPLE_TAPPING, stap_data)
+{
+        event.data[0] = SensorHubHelper::getSimpleTappingEvent(record);
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_MOVE_DETECT, md_data)
+{
+        event.data[0] = SensorHubHelper::getMoveDetectEvent(record);
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_STEP_DETECTOR, stepdetector_data)
+{
+        event.data[0] = record.state;
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_STEP_COUNTER, stepcounter_data)
+{
+        event.step_counter = record.num;
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_SIGNIFICANT_MOTION, sm_data)
+{
+        event.data[0] = record.state;
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_GAME_ROTATION_VECTOR, game_rotation_vector_data)
+{
+        event.data[0] = record.x;
+        event.data[1] = record.y;
+        event.data[2] = record.z;
+        event.data[3] = record.w;
+}
+
+SENSORHUB_RECORD(SENSOR_TYPE_GEOMAGNETIC_ROTATION_VECTOR, geomagnetic_rotation_vector_data)
+{
+        event.data[0] = record.x;
+        event.data[1] = record.y;
+        event.data[2] = record.z;
+        event.data[3] = record.w;
+}
+
+template <int sensorType>
+static void decodeRecords(struct SensorDevice &device, const byte *stream,
+                          struct sensorhub_event_t *events, size_t count)
+{
+        typedef typename SensorhubRecord<sensorType>::data_t data_t;
+        const data_t *records = reinterpret_cast<const data_t *>(stream);
+
+        for (size_t i = 0; i < count; i++)
+                SensorhubRecord<sensorType>::decode(device, records[i], events[i]);
+}
+
+#define SENSORHUB_DECODER(type) \
+        { type, sizeof(SensorhubRecord<type>::data_t), decodeRecords<type> }
+
+static const struct {
+        int sensorType;
+        size_t unitSize;
+        sensorhub_decoder_t decode;
+} sensorhubDecoders[] = {
+        SENSORHUB_DECODER(SENSOR_TYPE_ACCELEROMETER),
+        SENSORHUB_DECODER(SENSOR_TYPE_MAGNETIC_FIELD),
+        SENSORHUB_DECODER(SENSOR_TYPE_ORIENTATION),
+        SENSORHUB_DECODER(SENSOR_TYPE_GYROSCOPE),
+        SENSORHUB_DECODER(SENSOR_TYPE_LIGHT),
+        SENSORHUB_DECODER(SENSOR_TYPE_PRESSURE),
+        SENSORHUB_DECODER(SENSOR_TYPE_PROXIMITY),
+        SENSORHUB_DECODER(SENSOR_TYPE_GRAVITY),
+        SENSORHUB_DECODER(SENSOR_TYPE_LINEAR_ACCELERATION),
+        SENSORHUB_DECODER(SENSOR_TYPE_ROTATION_VECTOR),
+        SENSORHUB_DECODER(SENSOR_TYPE_GESTURE_FLICK),
+        SENSORHUB_DECODER(SENSOR_TYPE_TERMINAL),
+        SENSORHUB_DECODER(SENSOR_TYPE_SHAKE),
+        SENSORHUB_DECODER(SENSOR_TYPE_SIMPLE_TAPPING),
+        SENSORHUB_DECODER(SENSOR_TYPE_MOVE_DETECT),
+        SENSORHUB_DECODER(SENSOR_TYPE_STEP_DETECTOR),
+        SENSORHUB_DECODER(SENSOR_TYPE_STEP_COUNTER),
+        SENSORHUB_DECODER(SENSOR_TYPE_SIGNIFICANT_MOTION),
+        SENSORHUB_DECODER(SENSOR_TYPE_GAME_ROTATION_VECTOR),
+        SENSORHUB_DECODER(SENSOR_TYPE_GEOMAGNETIC_ROTATION_VECTOR),
+};
+
+bool SensorHubHelper::initStream(int sensorType, struct sensorhub_stream_t &stream, size_t capacity)
+{
+        memset(&stream, 0, sizeof(stream));
+
+        for (size_t i = 0; i < sizeof(sensorhubDecoders) / sizeof(sensorhubDecoders[0]); i++) {
+                if (sensorhubDecoders[i].sensorType != sensorType)
+                        continue;
+                stream.unitSize = sensorhubDecoders[i].unitSize;
+                stream.decode = sensorhubDecoders[i].decode;
+                stream.capacity = capacity;
+                stream.buffer = new byte[stream.unitSize * capacity];
+                return true;
         }
-        return -1;
+
+        LOGE("%s: Unsupported Sensor Type: %d", __FUNCTION__, sensorType);
+        return false;
+}
+
+void SensorHubHelper::releaseStream(struct sensorhub_stream_t &stream)
+{
+        if (stream.buffer != NULL)
+                delete[] stream.buffer;
+        memset(&stream, 0, sizeof(stream));
 }
 
 void SensorHubHelper::accelFilter(struct SensorDevice &device, struct sensorhub_event_t &event)
@@ -286,205 +437,52 @@ void SensorHubHelper::accelFilter(struct SensorDevice &device, struct sensorhub_
         z = event.data[2];
 }
 
-ssize_t SensorHubHelper::readSensorhubEvents(struct SensorDevice &device, int fd,
-		struct sensorhub_event_t* events, size_t count, int64_t &last_timestamp)
+ssize_t SensorHubHelper::readSensorhubEvents(struct SensorDevice &device, int fd, struct sensorhub_stream_t &stream,
+		struct sensorhub_event_t* events, size_t count, TimestampEstimator &estimator, int64_t delay)
 {
-        int sensorType;
-        int64_t current_timestamp, timestamp_step;
+        int64_t hubTs = 0;
+        ssize_t streamSize;
 
         if (fd < 0)
                 return fd;
 
+        if (stream.buffer == NULL)
+                return -1;
+
+        if (count > stream.capacity)
+                count = stream.capacity;
+
         if (count <= 0)
                 return 0;
 
-        sensorType = device.getType();
-        size_t unitSize = getUnitSize(sensorType);
-        size_t streamSize = unitSize * count;
-        byte* stream = new byte[streamSize];
+        streamSize = read(fd, reinterpret_cast<void *>(stream.buffer), stream.unitSize * count);
 
-        streamSize = read(fd, reinterpret_cast<void *>(stream), streamSize);
+        /* Shared stream readers may find their source switched since the poll */
+        if (streamSize < 0 && errno == EAGAIN)
+                return 0;
 
-        if (streamSize % unitSize != 0) {
+        if (streamSize < 0 || streamSize % stream.unitSize != 0) {
                 LOGE("%s line: %d: invalid stream size: type: %d size: %d",
-                     __FUNCTION__, __LINE__, sensorType, streamSize);
-                delete[] stream;
+                     __FUNCTION__, __LINE__, device.getType(), streamSize);
                 return -1;
         }
 
-        count = streamSize / unitSize;
-        current_timestamp = getTimestamp();
-        timestamp_step = (current_timestamp - last_timestamp) / count;
-        switch (sensorType) {
-        case SENSOR_TYPE_ACCELEROMETER:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = (reinterpret_cast<struct accel_data*>(stream))[i].x;
-                        events[i].data[1] = (reinterpret_cast<struct accel_data*>(stream))[i].y;
-                        events[i].data[2] = (reinterpret_cast<struct accel_data*>(stream))[i].z;
-                        events[i].accuracy = SENSOR_STATUS_ACCURACY_MEDIUM;
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                        accelFilter(device, events[i]);
-                }
-                break;
-        case SENSOR_TYPE_MAGNETIC_FIELD:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = (reinterpret_cast<struct compass_raw_data *>(stream))[i].x;
-                        events[i].data[1] = (reinterpret_cast<struct compass_raw_data *>(stream))[i].y;
-                        events[i].data[2] = (reinterpret_cast<struct compass_raw_data *>(stream))[i].z;
-                        if((reinterpret_cast<struct compass_raw_data *>(stream))[i].accuracy)
-                                events[i].accuracy = SENSOR_STATUS_ACCURACY_HIGH;
-                        else
-                                events[i].accuracy = SENSOR_STATUS_ACCURACY_LOW;
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_ORIENTATION:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = (reinterpret_cast<struct orientation_data*>(stream))[i].azimuth;
-                        events[i].data[1] = (reinterpret_cast<struct orientation_data*>(stream))[i].pitch;
-                        events[i].data[2] = (reinterpret_cast<struct orientation_data*>(stream))[i].roll;
-                        events[i].accuracy = SENSOR_STATUS_ACCURACY_MEDIUM;
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_GYROSCOPE:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = (reinterpret_cast<struct gyro_raw_data*>(stream))[i].x;
-                        events[i].data[1] = (reinterpret_cast<struct gyro_raw_data*>(stream))[i].y;
-                        events[i].data[2] = (reinterpret_cast<struct gyro_raw_data*>(stream))[i].z;
-                        if ((reinterpret_cast<struct gyro_raw_data*>(stream))[i].accuracy)
-                                events[i].accuracy = SENSOR_STATUS_ACCURACY_HIGH;
-                        else
-                                events[i].accuracy = SENSOR_STATUS_ACCURACY_LOW;
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_LIGHT:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = (reinterpret_cast<struct als_raw_data *>(stream))[i].lux;
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_PRESSURE:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = (reinterpret_cast<struct baro_raw_data*>(stream))[i].p;
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_PROXIMITY:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = (reinterpret_cast<struct ps_phy_data*>(stream))[i].near == 0 ? 1 : 0;
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_GRAVITY:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = (reinterpret_cast<struct gravity_data*>(stream))[i].x;
-                        events[i].data[1] = (reinterpret_cast<struct gravity_data*>(stream))[i].y;
-                        events[i].data[2] = (reinterpret_cast<struct gravity_data*>(stream))[i].z;
-                        events[i].accuracy = SENSOR_STATUS_ACCURACY_MEDIUM;
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_LINEAR_ACCELERATION:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = (reinterpret_cast<struct linear_accel_data*>(stream))[i].x;
-                        events[i].data[1] = (reinterpret_cast<struct linear_accel_data*>(stream))[i].y;
-                        events[i].data[2] = (reinterpret_cast<struct linear_accel_data*>(stream))[i].z;
-                        events[i].accuracy = SENSOR_STATUS_ACCURACY_MEDIUM;
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_ROTATION_VECTOR:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = (reinterpret_cast<struct rotation_vector_data*>(stream))[i].x;
-                        events[i].data[1] = (reinterpret_cast<struct rotation_vector_data*>(stream))[i].y;
-                        events[i].data[2] = (reinterpret_cast<struct rotation_vector_data*>(stream))[i].z;
-                        events[i].data[3] = (reinterpret_cast<struct rotation_vector_data*>(stream))[i].w;
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_GESTURE_FLICK:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = getGestureFlickEvent((reinterpret_cast<struct gesture_flick_data*>(stream))[i]);
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_TERMINAL:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = getTerminalEvent((reinterpret_cast<struct tc_data*>(stream))[i]);
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_SHAKE:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = getShakeEvent((reinterpret_cast<struct shaking_data*>(stream))[i]);
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_SIMPLE_TAPPING:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = getSimpleTappingEvent((reinterpret_cast<struct stap_data*>(stream))[i]);
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_MOVE_DETECT:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = getMoveDetectEvent((reinterpret_cast<struct md_data*>(stream))[i]);
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_STEP_DETECTOR:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = ((reinterpret_cast<struct stepdetector_data*>(stream))[i]).state;
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_STEP_COUNTER:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].step_counter = ((reinterpret_cast<struct stepcounter_data*>(stream))[i]).num;
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_SIGNIFICANT_MOTION:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = ((reinterpret_cast<struct sm_data*>(stream))[i]).state;
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_GAME_ROTATION_VECTOR:
-                for (unsigned int i = 0; i < count; i++) {
-                        events[i].data[0] = (reinterpret_cast<struct game_rotation_vector_data*>(stream))[i].x;
-                        events[i].data[1] = (reinterpret_cast<struct game_rotation_vector_data*>(stream))[i].y;
-                        events[i].data[2] = (reinterpret_cast<struct game_rotation_vector_data*>(stream))[i].z;
-                        events[i].data[3] = (reinterpret_cast<struct game_rotation_vector_data*>(stream))[i].w;
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_GEOMAGNETIC_ROTATION_VECTOR:
-                for (unsigned int i = 0; i < count; i++) {
-                        LOGI("geomagnetic_rotation_vector event");
-                        events[i].data[0] = (reinterpret_cast<struct geomagnetic_rotation_vector_data*>(stream))[i].x;
-                        events[i].data[1] = (reinterpret_cast<struct geomagnetic_rotation_vector_data*>(stream))[i].y;
-                        events[i].data[2] = (reinterpret_cast<struct geomagnetic_rotation_vector_data*>(stream))[i].z;
-                        events[i].data[3] = (reinterpret_cast<struct geomagnetic_rotation_vector_data*>(stream))[i].w;
-                        events[i].timestamp = last_timestamp + timestamp_step * (i + 1);
-                }
-                break;
-        case SENSOR_TYPE_TEMPERATURE:
-        case SENSOR_TYPE_RELATIVE_HUMIDITY:
-        case SENSOR_TYPE_AMBIENT_TEMPERATURE:
-        case SENSOR_TYPE_AUDIO_CLASSIFICATION:
-        case SENSOR_TYPE_GESTURE:
-        case SENSOR_TYPE_PHYSICAL_ACTIVITY:
-        case SENSOR_TYPE_PEDOMETER:
-        default:
-                LOGE("%s: Unsupported Sensor Type: %d", __FUNCTION__, sensorType);
-                break;
-        }
-        last_timestamp = current_timestamp;
+        count = streamSize / stream.unitSize;
+        stream.decode(device, stream.buffer, events, count);
 
-        delete[] stream;
+#ifdef SENSORHUB_EVENT_TIMESTAMP
+        /* Every record starts with the hub timestamp */
+        if (count > 0)
+                memcpy(&hubTs, stream.buffer + (count - 1) * stream.unitSize, sizeof(hubTs));
+#endif
+        /* Filtered records stand for samples older than their arrival, hub stamps included */
+        estimator.update(getTimestamp() - delay, count, hubTs);
+        for (unsigned int i = 0; i < count; i++) {
+#ifdef SENSORHUB_EVENT_TIMESTAMP
+                memcpy(&hubTs, stream.buffer + i * stream.unitSize, sizeof(hubTs));
+#endif
+                events[i].timestamp = estimator.next(hubTs);
+        }
 
         return count;
 }
@@ -5,6 +5,7 @@
 #include <unistd.h>
 #include <libsensorhub.h>
 #include "SensorDevice.hpp"
+#include "TimestampEstimator.hpp"
 
 typedef unsigned char byte;
 
@@ -17,14 +18,27 @@ struct sensorhub_event_t {
         int64_t timestamp;
 };
 
+typedef void (*sensorhub_decoder_t)(struct SensorDevice &device, const byte *stream,
+                                    struct sensorhub_event_t *events, size_t count);
+
+/* Read buffer of one PSH session, sized once for its record type */
+struct sensorhub_stream_t {
+        byte *buffer;
+        size_t unitSize;
+        size_t capacity;        /* in records */
+        sensorhub_decoder_t decode;
+};
+
 class SensorHubHelper {
         struct sensorhub_event_t sensorhubEvent;
-        static size_t getUnitSize(int sensorType);
 public:
         static psh_sensor_t getType(int sensorType, sensors_subname subname);
-        static ssize_t readSensorhubEvents(struct SensorDevice &device, int fd, struct sensorhub_event_t* event, size_t count, int64_t &last_timestamp);
+        static bool initStream(int sensorType, struct sensorhub_stream_t &stream, size_t capacity);
+        static void releaseStream(struct sensorhub_stream_t &stream);
+        /* delay: ns the records lag their arrival by, see SensorHubStream::getDelay() */
+        static ssize_t readSensorhubEvents(struct SensorDevice &device, int fd, struct sensorhub_stream_t &stream, struct sensorhub_event_t* event, size_t count, TimestampEstimator &estimator, int64_t delay = 0);
         static void getStartStreamingParameters(int sensorType, int &dataRate, int &bufferDelay, streaming_flag &flag);
-        static bool setPSHPropertyIfNeeded(int sensorType, struct sensor_hub_methods methods, handle_t handler);
+        static bool setPSHPropertyIfNeeded(int sensorType, const struct sensor_hub_methods &methods, handle_t handler);
         static int getGestureFlickEvent(struct gesture_flick_data data);
         static int getTerminalEvent(struct tc_data data);
         static int getShakeEvent(struct shaking_data data);
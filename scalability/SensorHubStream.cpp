@@ -0,0 +1,542 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <utils/Log.h>
+#include "SensorHubStream.hpp"
+
+static const struct {
+        psh_sensor_t type;
+        size_t unitSize;
+        const struct decimator_record_ops *filter;      /* NULL: decimate by picking records */
+} sharedStreams[] = {
+        { SENSOR_ACCELEROMETER, sizeof(struct accel_data), &DecimatorRecord<struct accel_data>::ops },
+        { SENSOR_GYRO, sizeof(struct gyro_raw_data), &DecimatorRecord<struct gyro_raw_data>::ops },
+        { SENSOR_PROXIMITY, sizeof(struct ps_phy_data), NULL },
+};
+
+#define SHARED_STREAM_COUNT     (sizeof(sharedStreams) / sizeof(sharedStreams[0]))
+
+static SensorHubStream *streams[SHARED_STREAM_COUNT];
+static pthread_mutex_t streamsLock = PTHREAD_MUTEX_INITIALIZER;
+
+SensorHubStream *SensorHubStream::getStream(psh_sensor_t type)
+{
+        SensorHubStream *stream = NULL;
+
+        pthread_mutex_lock(&streamsLock);
+        for (size_t i = 0; i < SHARED_STREAM_COUNT; i++) {
+                if (sharedStreams[i].type != type)
+                        continue;
+                /* Created on first use and kept for the life of the process */
+                if (streams[i] == NULL)
+                        streams[i] = new SensorHubStream(type, sharedStreams[i].unitSize, sharedStreams[i].filter);
+                stream = streams[i];
+                break;
+        }
+        pthread_mutex_unlock(&streamsLock);
+
+        return stream;
+}
+
+SensorHubStream::SensorHubStream(psh_sensor_t type, size_t unitSize, const struct decimator_record_ops *filterOps)
+        :type(type), unitSize(unitSize), filterOps(filterOps)
+{
+        session = NULL;
+        rate = 0;
+        bufferDelay = 0;
+        flag = STOP_WHEN_SCREEN_OFF;
+        pump = 0;
+        wakeFds[0] = wakeFds[1] = -1;
+        passthrough = SENSORHUB_STREAM_NO_CLIENT;
+        memset(clients, 0, sizeof(clients));
+}
+
+int SensorHubStream::attach(bool passthrough)
+{
+        Mutex::Autolock _l(lock);
+
+        for (int i = 0; i < SENSORHUB_STREAM_CLIENTS; i++) {
+                struct client_t &client = clients[i];
+                if (client.attached)
+                        continue;
+                if (pipe(client.fds) < 0) {
+                        LOGE("%s: pipe error: %s", __FUNCTION__, strerror(errno));
+                        return SENSORHUB_STREAM_NO_CLIENT;
+                }
+                /* A client that falls behind loses records instead of stalling the others */
+                fcntl(client.fds[1], F_SETFL, O_NONBLOCK);
+                fcntl(client.fds[0], F_SETFD, FD_CLOEXEC);
+                fcntl(client.fds[1], F_SETFD, FD_CLOEXEC);
+                client.pollFd = -1;
+                if (passthrough) {
+                        struct epoll_event ev;
+                        ev.events = EPOLLIN;
+                        ev.data.fd = client.fds[0];
+                        client.pollFd = epoll_create(2);
+                        if (client.pollFd < 0 || epoll_ctl(client.pollFd, EPOLL_CTL_ADD, client.fds[0], &ev) < 0) {
+                                LOGE("%s: epoll error: %s", __FUNCTION__, strerror(errno));
+                                if (client.pollFd >= 0)
+                                        close(client.pollFd);
+                                close(client.fds[0]);
+                                close(client.fds[1]);
+                                return SENSORHUB_STREAM_NO_CLIENT;
+                        }
+                        /* The source may change between the poll and the read, never block on the pipe */
+                        fcntl(client.fds[0], F_SETFL, O_NONBLOCK);
+                }
+                client.attached = true;
+                client.rate = 0;
+                client.configured = false;
+                return i;
+        }
+
+        LOGE("%s: no free client on stream %d", __FUNCTION__, type);
+        return SENSORHUB_STREAM_NO_CLIENT;
+}
+
+void SensorHubStream::detach(int client)
+{
+        if (client < 0 || client >= SENSORHUB_STREAM_CLIENTS)
+                return;
+
+        stop(client);
+
+        Mutex::Autolock _l(lock);
+        if (!clients[client].attached)
+                return;
+        close(clients[client].fds[0]);
+        close(clients[client].fds[1]);
+        if (clients[client].pollFd >= 0)
+                close(clients[client].pollFd);
+        clients[client].attached = false;
+}
+
+int SensorHubStream::getFd(int client)
+{
+        if (client < 0 || client >= SENSORHUB_STREAM_CLIENTS || !clients[client].attached)
+                return -1;
+        if (clients[client].pollFd >= 0)
+                return clients[client].pollFd;
+        return clients[client].fds[0];
+}
+
+int SensorHubStream::getReadFd(int client)
+{
+        Mutex::Autolock _l(lock);
+
+        if (client < 0 || client >= SENSORHUB_STREAM_CLIENTS || !clients[client].attached)
+                return -1;
+        if (client == passthrough)
+                return SensorHubBinding::getMethods().psh_get_fd(session);
+        return clients[client].fds[0];
+}
+
+int64_t SensorHubStream::getDelay(int client)
+{
+        Mutex::Autolock _l(lock);
+
+        if (client < 0 || client >= SENSORHUB_STREAM_CLIENTS || !clients[client].attached ||
+            clients[client].rate == 0 || !clients[client].filtered || rate <= 0)
+                return 0;
+        return clients[client].filter.getDelay() * 1000000000LL / rate;
+}
+
+int SensorHubStream::start(int client, int rate, int bufferDelay, streaming_flag flag)
+{
+        Mutex::Autolock _c(control);
+
+        if (client < 0 || client >= SENSORHUB_STREAM_CLIENTS || !clients[client].attached || rate <= 0)
+                return -1;
+
+        {
+                Mutex::Autolock _l(lock);
+                /* A stopped client restarts its filter, whatever its ratio */
+                if (clients[client].rate == 0)
+                        clients[client].configured = false;
+                clients[client].rate = rate;
+                clients[client].bufferDelay = bufferDelay;
+                clients[client].flag = flag;
+        }
+
+        if (arbitrate() < 0) {
+                {
+                        Mutex::Autolock _l(lock);
+                        clients[client].rate = 0;
+                }
+                arbitrate();
+                return -1;
+        }
+
+        return this->rate / clients[client].decimation;
+}
+
+void SensorHubStream::stop(int client)
+{
+        Mutex::Autolock _c(control);
+
+        if (client < 0 || client >= SENSORHUB_STREAM_CLIENTS)
+                return;
+
+        {
+                Mutex::Autolock _l(lock);
+                if (clients[client].rate == 0)
+                        return;
+                clients[client].rate = 0;
+        }
+
+        arbitrate();
+}
+
+/* Called with control held: bring the session in line with the started clients */
+int SensorHubStream::arbitrate()
+{
+        const struct sensor_hub_methods &methods = SensorHubBinding::getMethods();
+        int maxRate = 0, minDelay = -1;
+        streaming_flag maxFlag = STOP_WHEN_SCREEN_OFF;
+
+        {
+                Mutex::Autolock _l(lock);
+                for (int i = 0; i < SENSORHUB_STREAM_CLIENTS; i++) {
+                        struct client_t &client = clients[i];
+                        if (!client.attached || client.rate == 0)
+                                continue;
+                        if (client.rate > maxRate)
+                                maxRate = client.rate;
+                        if (minDelay < 0 || client.bufferDelay < minDelay)
+                                minDelay = client.bufferDelay;
+                        /* Reporting with the screen off beats computing only, which beats stopping */
+                        if (client.flag == NO_STOP_WHEN_SCREEN_OFF || maxFlag == STOP_WHEN_SCREEN_OFF)
+                                maxFlag = client.flag;
+                }
+        }
+
+        if (maxRate == 0) {
+                {
+                        Mutex::Autolock _l(lock);
+                        setPassthrough(SENSORHUB_STREAM_NO_CLIENT);
+                }
+                closeSession();
+                return 0;
+        }
+
+        if (session == NULL && !openSession())
+                return -1;
+
+        if (maxRate != rate || minDelay != bufferDelay || maxFlag != flag) {
+                error_t err;
+                if (maxFlag == STOP_WHEN_SCREEN_OFF)
+                        err = methods.psh_start_streaming(session, maxRate, minDelay);
+                else
+                        err = methods.psh_start_streaming_with_flag(session, maxRate, minDelay, maxFlag);
+                if (err != ERROR_NONE) {
+                        LOGE("%s: psh_start_streaming(_with_flag) error %d type: %d rate: %d",
+                             __FUNCTION__, err, type, maxRate);
+                        return -1;
+                }
+                rate = maxRate;
+                bufferDelay = minDelay;
+                flag = maxFlag;
+        }
+
+        Mutex::Autolock _l(lock);
+        int started = 0, single = SENSORHUB_STREAM_NO_CLIENT;
+        for (int i = 0; i < SENSORHUB_STREAM_CLIENTS; i++) {
+                struct client_t &client = clients[i];
+                if (!client.attached || client.rate == 0)
+                        continue;
+                unsigned int decimation = rate / client.rate;
+                if (decimation == 0)
+                        decimation = 1;
+                /* Clients whose ratio did not change keep their filter history and phase */
+                if (!client.configured || decimation != client.decimation) {
+                        client.decimation = decimation;
+                        client.phase = 0;
+                        client.filtered = decimation > 1 &&
+                                client.filter.setup(decimation, filterOps, unitSize);
+                        client.configured = true;
+                }
+                started++;
+                single = i;
+        }
+
+        /* A lone client at the session rate needs no pump: hand it the session */
+        if (started == 1 && clients[single].pollFd >= 0 && clients[single].decimation == 1)
+                setPassthrough(single);
+        else
+                setPassthrough(SENSORHUB_STREAM_NO_CLIENT);
+
+        return 0;
+}
+
+/* Called with lock held: move the passthrough client's epoll set between session and pipe */
+void SensorHubStream::setPassthrough(int client)
+{
+        const struct sensor_hub_methods &methods = SensorHubBinding::getMethods();
+        struct epoll_event ev;
+        char drain[256];
+
+        if (client == passthrough)
+                return;
+
+        ev.events = EPOLLIN;
+        if (passthrough != SENSORHUB_STREAM_NO_CLIENT) {
+                struct client_t &old = clients[passthrough];
+                epoll_ctl(old.pollFd, EPOLL_CTL_DEL, methods.psh_get_fd(session), NULL);
+                ev.data.fd = old.fds[0];
+                epoll_ctl(old.pollFd, EPOLL_CTL_ADD, old.fds[0], &ev);
+        }
+        if (client != SENSORHUB_STREAM_NO_CLIENT) {
+                struct client_t &next = clients[client];
+                epoll_ctl(next.pollFd, EPOLL_CTL_DEL, next.fds[0], NULL);
+                /* Whatever the pump queued is older than what the session holds now */
+                while (read(next.fds[0], drain, sizeof(drain)) > 0)
+                        ;
+                ev.data.fd = methods.psh_get_fd(session);
+                epoll_ctl(next.pollFd, EPOLL_CTL_ADD, ev.data.fd, &ev);
+        }
+        passthrough = client;
+
+        /* Let the pump start or stop reading the session */
+        write(wakeFds[1], "w", 1);
+}
+
+bool SensorHubStream::openSession()
+{
+        const struct sensor_hub_methods &methods = SensorHubBinding::getMethods();
+
+        if (methods.psh_open_session == NULL) {
+                LOGE("%s: libsensorhub not initialized!", __FUNCTION__);
+                return false;
+        }
+
+        session = methods.psh_open_session(type);
+        if (session == NULL) {
+                LOGE("%s: psh_open_session error! type: %d", __FUNCTION__, type);
+                return false;
+        }
+
+        if (pipe(wakeFds) < 0) {
+                LOGE("%s: pipe error: %s", __FUNCTION__, strerror(errno));
+                wakeFds[0] = wakeFds[1] = -1;
+                methods.psh_close_session(session);
+                session = NULL;
+                return false;
+        }
+
+        if (pthread_create(&pump, NULL, pumpThread, this) != 0) {
+                LOGE("%s: pthread_create error", __FUNCTION__);
+                close(wakeFds[0]);
+                close(wakeFds[1]);
+                wakeFds[0] = wakeFds[1] = -1;
+                methods.psh_close_session(session);
+                session = NULL;
+                return false;
+        }
+
+        rate = 0;
+        return true;
+}
+
+/* Called with control held: replace a failed session by a new one with the same parameters */
+bool SensorHubStream::reopenSession()
+{
+        const struct sensor_hub_methods &methods = SensorHubBinding::getMethods();
+        handle_t fresh, stale;
+        error_t err = ERROR_NONE;
+
+        fresh = methods.psh_open_session(type);
+        if (fresh == NULL)
+                return false;
+
+        if (rate != 0) {
+                if (flag == STOP_WHEN_SCREEN_OFF)
+                        err = methods.psh_start_streaming(fresh, rate, bufferDelay);
+                else
+                        err = methods.psh_start_streaming_with_flag(fresh, rate, bufferDelay, flag);
+        }
+        if (err != ERROR_NONE) {
+                methods.psh_close_session(fresh);
+                return false;
+        }
+
+        {
+                Mutex::Autolock _l(lock);
+                if (passthrough != SENSORHUB_STREAM_NO_CLIENT) {
+                        struct epoll_event ev;
+                        ev.events = EPOLLIN;
+                        ev.data.fd = methods.psh_get_fd(fresh);
+                        epoll_ctl(clients[passthrough].pollFd, EPOLL_CTL_DEL, methods.psh_get_fd(session), NULL);
+                        epoll_ctl(clients[passthrough].pollFd, EPOLL_CTL_ADD, ev.data.fd, &ev);
+                }
+                stale = session;
+                session = fresh;
+        }
+        methods.psh_close_session(stale);
+
+        return true;
+}
+
+/* Pump side: retry reopenSession() until it works, false if the stream is stopped meanwhile */
+bool SensorHubStream::recoverSession()
+{
+        struct pollfd wake;
+        int delay = SENSORHUB_STREAM_RETRY_MS;
+
+        wake.fd = wakeFds[0];
+        wake.events = POLLIN;
+        while (true) {
+                wake.revents = 0;
+                if (poll(&wake, 1, delay) > 0 && wokenToStop())
+                        return false;
+                /* closeSession() joins the pump with control held, so never wait for it */
+                if (control.tryLock() != 0)
+                        continue;
+                bool reopened = reopenSession();
+                control.unlock();
+                if (reopened) {
+                        LOGI("%s: stream %d session reopened", __FUNCTION__, type);
+                        return true;
+                }
+                if (delay < SENSORHUB_STREAM_RETRY_MAX_MS)
+                        delay *= 2;
+        }
+}
+
+/* Pump side: consume the wake pipe, true if the stream is being closed */
+bool SensorHubStream::wokenToStop()
+{
+        char buf[16];
+        ssize_t size = read(wakeFds[0], buf, sizeof(buf));
+
+        return size > 0 && memchr(buf, 's', size) != NULL;
+}
+
+void SensorHubStream::closeSession()
+{
+        const struct sensor_hub_methods &methods = SensorHubBinding::getMethods();
+
+        if (session == NULL)
+                return;
+
+        write(wakeFds[1], "s", 1);
+        pthread_join(pump, NULL);
+        close(wakeFds[0]);
+        close(wakeFds[1]);
+        wakeFds[0] = wakeFds[1] = -1;
+
+        if (rate != 0)
+                methods.psh_stop_streaming(session);
+        methods.psh_close_session(session);
+        session = NULL;
+        rate = 0;
+        bufferDelay = 0;
+        flag = STOP_WHEN_SCREEN_OFF;
+}
+
+void *SensorHubStream::pumpThread(void *data)
+{
+        SensorHubStream *stream = static_cast<SensorHubStream *>(data);
+        const struct sensor_hub_methods &methods = SensorHubBinding::getMethods();
+        size_t bufferSize = stream->unitSize * SENSORHUB_STREAM_BATCH;
+        char *buffer = new char[bufferSize];
+        char *scratch = new char[bufferSize];
+        size_t pending = 0;
+        struct pollfd polls[2];
+
+        polls[0].fd = stream->wakeFds[0];
+        polls[0].events = POLLIN;
+        polls[1].fd = methods.psh_get_fd(stream->session);
+
+        while (true) {
+                {
+                        /* With a passthrough client only errors are watched, the client reads the data */
+                        Mutex::Autolock _l(stream->lock);
+                        polls[1].events = stream->passthrough == SENSORHUB_STREAM_NO_CLIENT ? POLLIN : 0;
+                }
+                polls[0].revents = polls[1].revents = 0;
+                if (poll(polls, 2, -1) < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        LOGE("%s: poll error: %s", __FUNCTION__, strerror(errno));
+                        break;
+                }
+                if (polls[0].revents & POLLIN) {
+                        if (stream->wokenToStop())
+                                break;
+                        continue;
+                }
+
+                bool failed = false;
+                if (polls[1].revents & POLLIN) {
+                        ssize_t size = read(polls[1].fd, buffer + pending, bufferSize - pending);
+                        if (size > 0) {
+                                /* The session may split a record across reads, keep the tail for the next one */
+                                pending += size;
+                                size_t count = pending / stream->unitSize;
+                                stream->pumpRecords(buffer, count, scratch);
+                                pending -= count * stream->unitSize;
+                                if (pending > 0)
+                                        memmove(buffer, buffer + count * stream->unitSize, pending);
+                        } else if (size == 0 || (errno != EINTR && errno != EAGAIN)) {
+                                failed = true;
+                        }
+                } else if (polls[1].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                        failed = true;
+                }
+
+                if (failed) {
+                        LOGE("%s: read error on stream %d, reopening the session", __FUNCTION__, stream->type);
+                        pending = 0;
+                        if (!stream->recoverSession())
+                                break;
+                        Mutex::Autolock _l(stream->lock);
+                        polls[1].fd = methods.psh_get_fd(stream->session);
+                }
+        }
+
+        delete[] buffer;
+        delete[] scratch;
+        return NULL;
+}
+
+void SensorHubStream::pumpRecords(const char *records, size_t count, char *scratch)
+{
+        Mutex::Autolock _l(lock);
+
+        for (int i = 0; i < SENSORHUB_STREAM_CLIENTS; i++) {
+                struct client_t &client = clients[i];
+                const char *out = records;
+                size_t n = 0;
+
+                /* The passthrough client reads the session itself */
+                if (!client.attached || client.rate == 0 || i == passthrough)
+                        continue;
+
+                if (client.decimation <= 1) {
+                        n = count;
+                } else if (client.filtered) {
+                        for (size_t r = 0; r < count; r++) {
+                                if (client.filter.push(records + r * unitSize, scratch + n * unitSize))
+                                        n++;
+                        }
+                        out = scratch;
+                } else {
+                        for (size_t r = 0; r < count; r++) {
+                                if (client.phase == 0) {
+                                        memcpy(scratch + n * unitSize, records + r * unitSize, unitSize);
+                                        n++;
+                                }
+                                if (++client.phase == client.decimation)
+                                        client.phase = 0;
+                        }
+                        out = scratch;
+                }
+
+                /* At most SENSORHUB_STREAM_BATCH records, well below PIPE_BUF: written whole or not at all */
+                if (n > 0 && write(client.fds[1], out, n * unitSize) < 0 && errno != EAGAIN)
+                        LOGE("%s: write error on stream %d: %s", __FUNCTION__, type, strerror(errno));
+        }
+}
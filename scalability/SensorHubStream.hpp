@@ -0,0 +1,102 @@
+#ifndef _SENSOR_HUB_STREAM_HPP_
+#define _SENSOR_HUB_STREAM_HPP_
+#include <pthread.h>
+#include <utils/Mutex.h>
+#include "SensorHubBinding.hpp"
+#include "SensorHubDecimator.hpp"
+
+using android::Mutex;
+
+#define SENSORHUB_STREAM_CLIENTS        4
+#define SENSORHUB_STREAM_BATCH          64      /* records moved per wakeup of the pump */
+#define SENSORHUB_STREAM_NO_CLIENT      -1
+#define SENSORHUB_STREAM_RETRY_MS       100     /* first delay before reopening a failed session */
+#define SENSORHUB_STREAM_RETRY_MAX_MS   2000
+
+/*
+ * Rate arbitration for the physical PSH streams (accelerometer, gyroscope,
+ * proximity). The plain sensor and the virtual sensors built on top of it
+ * (gesture, physical activity) all attach to the same stream instead of
+ * opening a hub session each.
+ *
+ * The stream runs one hub session at the highest rate and the lowest buffer
+ * delay any started client asked for; a client that wants to keep running
+ * with the screen off keeps the whole session running. One pump thread reads
+ * the session and decimates it for each client by n = stream rate / client
+ * rate into the client's own pipe, so a client sees the records it would
+ * have read from a private session at (at least) its own rate. Accelerometer
+ * and gyroscope records go through an anti-aliasing SensorHubDecimator for
+ * n up to DECIMATOR_MAX_RATIO; otherwise every n-th record is passed on.
+ * A client's filter and phase only restart when its n changes. Filtered
+ * records keep the timestamp of the sample they stand for but arrive
+ * getDelay() later, which readers stamping on arrival take off.
+ *
+ * A client attached with passthrough polls an epoll fd instead: while it is
+ * the only started client it watches the session itself and the pump stays
+ * off the data path, otherwise it watches the client's pipe. Such a client
+ * must read from getReadFd() every time, as the source changes underneath.
+ *
+ * If reading the session fails the pump reopens it with the same
+ * parameters, retrying with a growing delay until it succeeds or the stream
+ * is stopped, so clients see a gap instead of a stream that ends silently.
+ *
+ * Records keep the libsensorhub layout, so readers keep parsing them from
+ * the fd returned by getFd() (getReadFd() for passthrough clients).
+ */
+class SensorHubStream {
+        struct client_t {
+                bool attached;
+                int fds[2];             /* pump writes fds[1], the client reads fds[0] */
+                int pollFd;             /* passthrough clients: epoll on fds[0] or the session, else -1 */
+                int rate;               /* Hz, 0 while stopped */
+                int bufferDelay;        /* ms */
+                streaming_flag flag;
+                unsigned int decimation;
+                bool configured;        /* decimation, phase and filter set up since start() */
+                unsigned int phase;
+                bool filtered;
+                SensorHubDecimator filter;
+        };
+        psh_sensor_t type;
+        size_t unitSize;
+        const struct decimator_record_ops *filterOps;
+        handle_t session;
+        int rate;
+        int bufferDelay;
+        streaming_flag flag;
+        pthread_t pump;
+        int wakeFds[2];                 /* "w": passthrough changed, "s": stop */
+        int passthrough;                /* client reading the session directly, or SENSORHUB_STREAM_NO_CLIENT */
+        Mutex control;                  /* serializes start/stop of the session */
+        Mutex lock;                     /* protects clients, taken by the pump per batch */
+        struct client_t clients[SENSORHUB_STREAM_CLIENTS];
+
+        SensorHubStream(psh_sensor_t type, size_t unitSize, const struct decimator_record_ops *filterOps);
+        int arbitrate();
+        bool openSession();
+        void closeSession();
+        bool reopenSession();
+        bool recoverSession();
+        bool wokenToStop();
+        void setPassthrough(int client);
+        static void *pumpThread(void *data);
+        void pumpRecords(const char *records, size_t count, char *scratch);
+public:
+        /* Stream of a physical sensor, NULL if sessions of that type are not shared */
+        static SensorHubStream *getStream(psh_sensor_t type);
+
+        /* Returns a client id or SENSORHUB_STREAM_NO_CLIENT */
+        int attach(bool passthrough = false);
+        void detach(int client);
+        /* fd to poll for records */
+        int getFd(int client);
+        /* fd to read the records from once getFd() is readable */
+        int getReadFd(int client);
+        /* ns the client's records lag their arrival by, the delay of its filter */
+        int64_t getDelay(int client);
+        /* Returns the rate the client is fed at, or -1 */
+        int start(int client, int rate, int bufferDelay, streaming_flag flag = STOP_WHEN_SCREEN_OFF);
+        void stop(int client);
+};
+
+#endif
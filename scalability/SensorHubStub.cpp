@@ -0,0 +1,136 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <utils/Log.h>
+#include "SensorHubStub.hpp"
+
+struct stub_session {
+        psh_sensor_t type;
+        int fds[2];
+        bool streaming;
+        int dataRate;
+        int bufferDelay;
+        streaming_flag flag;
+};
+
+static int openSessions;
+
+static handle_t stubOpenSession(psh_sensor_t sensor_type)
+{
+        struct stub_session *session;
+
+        if (sensor_type <= SENSOR_INVALID || sensor_type >= SENSOR_MAX)
+                return NULL;
+
+        session = new struct stub_session();
+        if (pipe(session->fds) < 0) {
+                LOGE("%s: pipe error", __FUNCTION__);
+                delete session;
+                return NULL;
+        }
+        fcntl(session->fds[0], F_SETFL, O_NONBLOCK);
+        fcntl(session->fds[1], F_SETFL, O_NONBLOCK);
+        session->type = sensor_type;
+        openSessions++;
+
+        return session;
+}
+
+static void stubCloseSession(handle_t handle)
+{
+        struct stub_session *session = static_cast<struct stub_session *>(handle);
+
+        if (session == NULL)
+                return;
+
+        close(session->fds[0]);
+        close(session->fds[1]);
+        delete session;
+        openSessions--;
+}
+
+static int stubGetFd(handle_t handle)
+{
+        struct stub_session *session = static_cast<struct stub_session *>(handle);
+
+        return session != NULL ? session->fds[0] : -1;
+}
+
+static error_t stubStartStreamingWithFlag(handle_t handle, int data_rate, int buffer_delay, streaming_flag flag)
+{
+        struct stub_session *session = static_cast<struct stub_session *>(handle);
+
+        if (session == NULL || data_rate < 0 || buffer_delay < 0)
+                return static_cast<error_t>(-1);
+
+        session->streaming = true;
+        session->dataRate = data_rate;
+        session->bufferDelay = buffer_delay;
+        session->flag = flag;
+
+        return ERROR_NONE;
+}
+
+static error_t stubStartStreaming(handle_t handle, int data_rate, int buffer_delay)
+{
+        return stubStartStreamingWithFlag(handle, data_rate, buffer_delay, STOP_WHEN_SCREEN_OFF);
+}
+
+static error_t stubStopStreaming(handle_t handle)
+{
+        struct stub_session *session = static_cast<struct stub_session *>(handle);
+
+        if (session == NULL)
+                return static_cast<error_t>(-1);
+
+        session->streaming = false;
+        return ERROR_NONE;
+}
+
+static error_t stubSetProperty(handle_t handle, property_type prop_type, void *value)
+{
+        if (handle == NULL || value == NULL)
+                return static_cast<error_t>(-1);
+        return ERROR_NONE;
+}
+
+static const struct sensor_hub_methods stubMethods = {
+        stubOpenSession,
+        stubCloseSession,
+        stubGetFd,
+        stubStartStreaming,
+        stubStartStreamingWithFlag,
+        stubStopStreaming,
+        stubSetProperty,
+};
+
+const struct sensor_hub_methods &SensorHubStub::getMethods()
+{
+        return stubMethods;
+}
+
+ssize_t SensorHubStub::inject(handle_t handle, const void *records, size_t size)
+{
+        struct stub_session *session = static_cast<struct stub_session *>(handle);
+
+        if (session == NULL || !session->streaming)
+                return -1;
+
+        return write(session->fds[1], records, size);
+}
+
+bool SensorHubStub::getStreaming(handle_t handle, int &dataRate, int &bufferDelay)
+{
+        struct stub_session *session = static_cast<struct stub_session *>(handle);
+
+        if (session == NULL || !session->streaming)
+                return false;
+
+        dataRate = session->dataRate;
+        bufferDelay = session->bufferDelay;
+        return true;
+}
+
+int SensorHubStub::getOpenSessions()
+{
+        return openSessions;
+}
@@ -0,0 +1,25 @@
+#ifndef _SENSOR_HUB_STUB_HPP_
+#define _SENSOR_HUB_STUB_HPP_
+#include <sys/types.h>
+#include "SensorHubBinding.hpp"
+
+/*
+ * In-process stand-in for libsensorhub, for running the PSH sensor classes on
+ * a host without a sensor hub. Every session owns a pipe: its read end is what
+ * psh_get_fd() returns, and inject() writes records into it as the hub would
+ * while the session streams.
+ *
+ * Usage: SensorHubBinding::install(SensorHubStub::getMethods()) before the
+ * first PSH sensor is created.
+ */
+class SensorHubStub {
+public:
+        static const struct sensor_hub_methods &getMethods();
+        /* Queue size bytes of records on the session, fails unless it is streaming */
+        static ssize_t inject(handle_t handle, const void *records, size_t size);
+        /* Streaming parameters last requested on the session, false if stopped */
+        static bool getStreaming(handle_t handle, int &dataRate, int &bufferDelay);
+        static int getOpenSessions();
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "TimestampEstimator.hpp"
+
+void TimestampEstimator::reset(int64_t now, int64_t period_ns)
+{
+        period = period_ns > 0 ? period_ns : 0;
+        /* On-change streams keep no rate estimate and are stamped on arrival */
+        samples = period > 0 ? TIMESTAMP_RATE_SEED : 0;
+        elapsed = period * samples;
+        lastTimestamp = now;
+        lastArrival = now;
+        step = 0;
+        limit = now;
+        hubOffset = 0;
+        hubOffsetValid = false;
+}
+
+void TimestampEstimator::update(int64_t now, int count, int64_t hubTs)
+{
+        int64_t interval, span, err;
+        bool resync = false;
+
+        if (count <= 0)
+                return;
+
+        interval = now - lastArrival;
+        lastArrival = now;
+        limit = now;
+
+        if (hubTs != 0) {
+                /* Delivery latency only ever adds to now - hubTs, so track its minimum */
+                if (!hubOffsetValid) {
+                        hubOffset = now - hubTs;
+                        hubOffsetValid = true;
+                } else {
+                        hubOffset += interval >> TIMESTAMP_OFFSET_CREEP_SHIFT;
+                        if (now - hubTs < hubOffset)
+                                hubOffset = now - hubTs;
+                }
+        }
+
+        if (period == 0) {
+                step = (now - lastTimestamp) / count;
+                return;
+        }
+
+        span = period * count;
+        err = now - (lastTimestamp + span);
+        if (err < 0) {
+                /* Running ahead of the arrival time, squeeze the batch so it ends at now */
+                step = (now - lastTimestamp) / count;
+        } else if (err > span) {
+                /* Stream stalled or rate changed, restart the phase from this batch */
+                lastTimestamp = now - span;
+                step = period;
+                resync = true;
+        } else {
+                step = period + (err >> TIMESTAMP_PHASE_SHIFT) / count;
+        }
+
+        if (!resync && samples > 0 && interval > 0) {
+                elapsed += interval;
+                samples += count;
+                if (samples >= TIMESTAMP_RATE_WINDOW) {
+                        elapsed /= 2;
+                        samples /= 2;
+                }
+                period = elapsed / samples;
+        }
+}
+
+int64_t TimestampEstimator::next(int64_t hubTs)
+{
+        int64_t timestamp;
+
+        if (hubTs != 0 && hubOffsetValid)
+                timestamp = hubTs + hubOffset;
+        else
+                timestamp = lastTimestamp + step;
+
+        if (timestamp > limit)
+                timestamp = limit;
+        if (timestamp <= lastTimestamp)
+                timestamp = lastTimestamp + 1;
+
+        lastTimestamp = timestamp;
+        return timestamp;
+}
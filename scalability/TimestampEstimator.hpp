@@ -0,0 +1,47 @@
+#ifndef _TIMESTAMP_ESTIMATOR_HPP_
+#define _TIMESTAMP_ESTIMATOR_HPP_
+#include <stdint.h>
+
+/* Samples the rate estimate is averaged over before older history is halved */
+#define TIMESTAMP_RATE_WINDOW           256
+/* Weight of the nominal period when the estimate is seeded */
+#define TIMESTAMP_RATE_SEED             8
+/* Fraction of the phase error absorbed per batch, as a shift */
+#define TIMESTAMP_PHASE_SHIFT           3
+/* Upward creep of the hub clock offset per ns elapsed, as a shift (~244 ppm) */
+#define TIMESTAMP_OFFSET_CREEP_SHIFT    12
+
+/*
+ * Reconstructs CLOCK_MONOTONIC sample times for a stream that is read in
+ * batches. Batches are spaced with a per-session rate estimate instead of
+ * being spread over the last read interval, so delivery jitter does not leak
+ * into the timestamps. The accumulated phase error against the arrival time
+ * is corrected slowly, and large gaps resync the stream.
+ *
+ * When the hub stamps each sample, those stamps are mapped onto
+ * CLOCK_MONOTONIC through an offset that tracks the lower envelope of
+ * arrival - hub time and may creep upward to follow clock drift.
+ *
+ * Usage per read: update(now, count, hubTs of the last sample) and then
+ * next(hubTs) once for every sample, in order.
+ */
+class TimestampEstimator {
+        int64_t period;         /* ns per sample, 0 until known */
+        int64_t elapsed;        /* arrival time accumulated for the rate estimate */
+        int64_t samples;        /* samples accumulated for the rate estimate */
+        int64_t lastTimestamp;  /* last timestamp handed out */
+        int64_t lastArrival;
+        int64_t step;           /* spacing of the current batch */
+        int64_t limit;          /* arrival time of the current batch */
+        int64_t hubOffset;      /* CLOCK_MONOTONIC - hub time */
+        bool hubOffsetValid;
+public:
+        TimestampEstimator() { reset(0, 0); }
+        /* Start of a session; period_ns is the nominal rate or 0 for on-change streams */
+        void reset(int64_t now, int64_t period_ns);
+        void update(int64_t now, int count, int64_t hubTs = 0);
+        int64_t next(int64_t hubTs = 0);
+        int64_t getPeriod() { return period; }
+};
+
+#endif
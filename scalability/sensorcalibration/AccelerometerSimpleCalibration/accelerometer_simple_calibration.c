@@ -6,6 +6,7 @@
  */
 
 #include "accelerometer_simple_calibration.h"
+#include "accelerometer_simple_calibration_window.h"
 #include <string.h>
 #include <math.h>
 #include <fcntl.h>
@@ -14,18 +15,13 @@
 #include <errno.h>
 #include <cutils/log.h>
 
-#define ACCEL_SIMP_CAL_BUF_LENGTH       50
 #define ACCEL_SIMP_CAL_NOISE_DENSITY    (0.025 * GRAVITY_EARTH)
 #define ACCEL_SIMP_CAL_DIRECTION_OFFSET 3.2
 #define ACCEL_SIMP_CAL_MODEL_OFFSET     1.2
 
 struct accelerometer_simple_calibration_t {
-        float buf[ACCEL_AXIS_MAX][ACCEL_SIMP_CAL_BUF_LENGTH];
-        float average[ACCEL_AXIS_MAX];
-        float sum[ACCEL_AXIS_MAX];
-        float model;
-        int index;
-        int size;
+        struct accel_simp_cal_window_t window;
+        float model;                    /* of the window average, valid once the window is full */
         struct accelerometer_simple_calibration_samples samples;
         int samples_collected_this_time;
         int initialized;
@@ -35,61 +31,28 @@ static int need_recalibrate = 0;
 
 static void accel_simp_cal_collect_data(struct accelerometer_simple_calibration_event_t* event, struct accelerometer_simple_calibration_t* asc)
 {
-        int i;
-
-        if (asc->size < ACCEL_SIMP_CAL_BUF_LENGTH)
-                asc->size++;
-        else
-                for (i = 0; i < ACCEL_AXIS_MAX; i++) {
-                        asc->sum[i] -= asc->buf[i][asc->index];
-                }
-
-        for (i = 0; i < ACCEL_AXIS_MAX; i++) {
-                asc->buf[i][asc->index] = event->data[i];
-                asc->sum[i] += event->data[i];
-                asc->average[i] = asc->sum[i] / asc->size;
-        }
-        asc->model = sqrt(asc->average[ACCEL_AXIS_X] * asc->average[ACCEL_AXIS_X] + asc->average[ACCEL_AXIS_Y] * asc->average[ACCEL_AXIS_Y] + asc->average[ACCEL_AXIS_Z] * asc->average[ACCEL_AXIS_Z]);
-
-        asc->index++;
-        if (asc->index >= ACCEL_SIMP_CAL_BUF_LENGTH)
-                asc->index = 0;
+        accel_simp_cal_window_push(&asc->window, event->data);
 }
 
 static void accel_simp_cal_clear_data(struct accelerometer_simple_calibration_t* asc)
 {
-        int i;
-        asc->index = 0;
-        asc->size = 0;
-        for (i = 0; i < ACCEL_AXIS_MAX; i++) {
-                asc->average[i] = 0;
-                asc->sum[i] = 0;
-        }
+        accel_simp_cal_window_clear(&asc->window);
 }
 
 static int accel_simp_cal_sample_out_range(struct accelerometer_simple_calibration_t* asc)
 {
-        int i, j;
-        float noise[ACCEL_AXIS_MAX];
+        if (asc->window.size < ACCEL_SIMP_CAL_BUF_LENGTH)
+                return 1;
 
-        if (asc->size < ACCEL_SIMP_CAL_BUF_LENGTH) {
+        asc->model = accel_simp_cal_window_model(&asc->window);
+        if (asc->model < GRAVITY_EARTH - ACCEL_SIMP_CAL_MODEL_OFFSET || asc->model > GRAVITY_EARTH + ACCEL_SIMP_CAL_MODEL_OFFSET) {
+                LOGW("Incorrect asc->model: %f", asc->model);
                 return 1;
-        } else {
-                if (asc->model < GRAVITY_EARTH - ACCEL_SIMP_CAL_MODEL_OFFSET || asc->model > GRAVITY_EARTH + ACCEL_SIMP_CAL_MODEL_OFFSET) {
-                        LOGW("Incorrect asc->model: %f", asc->model);
-                        return 1;
-                }
-                for (j = 0; j < ACCEL_SIMP_CAL_BUF_LENGTH; j++) {
-                        for (i = 0; i < ACCEL_AXIS_MAX; i++) {
-                                noise[i] = asc->buf[i][j] - asc->average[i];
-                                if (noise[i] < -ACCEL_SIMP_CAL_NOISE_DENSITY || noise[i] > ACCEL_SIMP_CAL_NOISE_DENSITY) {
-                                        LOGW("Noise too large: asc->index: %d coordinate: %d value: %lf asc->average: %lf noise: %lf",
-                                             j, i, asc->buf[i][j], asc->average[i], noise[i]);
-                                        return 1;
-                                }
-                        }
-                }
         }
+
+        if (!accel_simp_cal_window_stationary(&asc->window, ACCEL_SIMP_CAL_NOISE_DENSITY))
+                return 1;
+
         return 0;
 }
 
@@ -102,7 +65,7 @@ static void accel_simp_cal_sampling(struct accelerometer_simple_calibration_even
                 return;
         }
 
-        if (asc->average[ACCEL_AXIS_X] < GRAVITY_EARTH + ACCEL_SIMP_CAL_MODEL_OFFSET && asc->average[ACCEL_AXIS_X] > GRAVITY_EARTH - ACCEL_SIMP_CAL_DIRECTION_OFFSET) {
+        if (asc->window.average[ACCEL_AXIS_X] < GRAVITY_EARTH + ACCEL_SIMP_CAL_MODEL_OFFSET && asc->window.average[ACCEL_AXIS_X] > GRAVITY_EARTH - ACCEL_SIMP_CAL_DIRECTION_OFFSET) {
                 LOGI("data x positive");
                 if (asc->samples.sampled[ACCEL_AXIS_X]) {
                         LOGI("data x positive had collected");
@@ -110,14 +73,14 @@ static void accel_simp_cal_sampling(struct accelerometer_simple_calibration_even
                         return;
                 }
                 for (i = 0; i < ACCEL_AXIS_MAX; i++) {
-                        asc->samples.samples[ACCEL_AXIS_X][i] = asc->average[i];
+                        asc->samples.samples[ACCEL_AXIS_X][i] = asc->window.average[i];
                 }
                 asc->samples.sampled[ACCEL_AXIS_X] = 1;
                 asc->samples.samples_collected++;
                 asc->samples_collected_this_time++;
                 accel_simp_cal_clear_data(asc);
                 LOGI("data x positive has collected");
-        } else if (asc->average[ACCEL_AXIS_X] > -ACCEL_SIMP_CAL_MODEL_OFFSET - GRAVITY_EARTH && asc->average[ACCEL_AXIS_X] < ACCEL_SIMP_CAL_DIRECTION_OFFSET - GRAVITY_EARTH) {
+        } else if (asc->window.average[ACCEL_AXIS_X] > -ACCEL_SIMP_CAL_MODEL_OFFSET - GRAVITY_EARTH && asc->window.average[ACCEL_AXIS_X] < ACCEL_SIMP_CAL_DIRECTION_OFFSET - GRAVITY_EARTH) {
                 LOGI("data x negative");
                 if (asc->samples.sampled[ACCEL_AXIS_Y]) {
                         LOGI("data x negative had collected");
@@ -125,14 +88,14 @@ static void accel_simp_cal_sampling(struct accelerometer_simple_calibration_even
                         return;
                 }
                 for (i = 0; i < ACCEL_AXIS_MAX; i++) {
-                        asc->samples.samples[ACCEL_AXIS_Y][i] = asc->average[i];
+                        asc->samples.samples[ACCEL_AXIS_Y][i] = asc->window.average[i];
                 }
                 asc->samples.sampled[ACCEL_AXIS_Y] = 1;
                 asc->samples.samples_collected++;
                 asc->samples_collected_this_time++;
                 accel_simp_cal_clear_data(asc);
                 LOGI("data x negative has collected");
-        } else if (asc->average[ACCEL_AXIS_Y] < GRAVITY_EARTH + ACCEL_SIMP_CAL_MODEL_OFFSET && asc->average[ACCEL_AXIS_Y] > GRAVITY_EARTH - ACCEL_SIMP_CAL_DIRECTION_OFFSET) {
+        } else if (asc->window.average[ACCEL_AXIS_Y] < GRAVITY_EARTH + ACCEL_SIMP_CAL_MODEL_OFFSET && asc->window.average[ACCEL_AXIS_Y] > GRAVITY_EARTH - ACCEL_SIMP_CAL_DIRECTION_OFFSET) {
                 LOGI("data y positive");
                 if (asc->samples.sampled[ACCEL_AXIS_Z]) {
                         LOGI("data y positive had collected");
@@ -140,14 +103,14 @@ static void accel_simp_cal_sampling(struct accelerometer_simple_calibration_even
                         return;
                 }
                 for (i = 0; i < ACCEL_AXIS_MAX; i++) {
-                        asc->samples.samples[2][i] = asc->average[i];
+                        asc->samples.samples[2][i] = asc->window.average[i];
                 }
                 asc->samples.sampled[2] = 1;
                 asc->samples.samples_collected++;
                 asc->samples_collected_this_time++;
                 accel_simp_cal_clear_data(asc);
                 LOGI("data y positive has collected");
-        } else if (asc->average[ACCEL_AXIS_Y] > -ACCEL_SIMP_CAL_MODEL_OFFSET - GRAVITY_EARTH && asc->average[ACCEL_AXIS_Y] < ACCEL_SIMP_CAL_DIRECTION_OFFSET - GRAVITY_EARTH) {
+        } else if (asc->window.average[ACCEL_AXIS_Y] > -ACCEL_SIMP_CAL_MODEL_OFFSET - GRAVITY_EARTH && asc->window.average[ACCEL_AXIS_Y] < ACCEL_SIMP_CAL_DIRECTION_OFFSET - GRAVITY_EARTH) {
                 LOGI("data y negative");
                 if (asc->samples.sampled[ACCEL_AXIS_MAX]) {
                         LOGI("data y negative had collected");
@@ -155,14 +118,14 @@ static void accel_simp_cal_sampling(struct accelerometer_simple_calibration_even
                         return;
                 }
                 for (i = 0; i < ACCEL_AXIS_MAX; i++) {
-                        asc->samples.samples[ACCEL_AXIS_MAX][i] = asc->average[i];
+                        asc->samples.samples[ACCEL_AXIS_MAX][i] = asc->window.average[i];
                 }
                 asc->samples.sampled[ACCEL_AXIS_MAX] = 1;
                 asc->samples.samples_collected++;
                 asc->samples_collected_this_time++;
                 accel_simp_cal_clear_data(asc);
                 LOGI("data y negative has collected");
-        } else if (asc->average[2] < GRAVITY_EARTH + ACCEL_SIMP_CAL_MODEL_OFFSET && asc->average[2] > GRAVITY_EARTH - ACCEL_SIMP_CAL_DIRECTION_OFFSET) {
+        } else if (asc->window.average[2] < GRAVITY_EARTH + ACCEL_SIMP_CAL_MODEL_OFFSET && asc->window.average[2] > GRAVITY_EARTH - ACCEL_SIMP_CAL_DIRECTION_OFFSET) {
                 LOGI("data z positive");
                 if (asc->samples.sampled[4]) {
                         LOGI("data z positive had collected");
@@ -170,14 +133,14 @@ static void accel_simp_cal_sampling(struct accelerometer_simple_calibration_even
                         return;
                 }
                 for (i = 0; i < ACCEL_AXIS_MAX; i++) {
-                        asc->samples.samples[4][i] = asc->average[i];
+                        asc->samples.samples[4][i] = asc->window.average[i];
                 }
                 asc->samples.sampled[4] = 1;
                 asc->samples.samples_collected++;
                 asc->samples_collected_this_time++;
                 accel_simp_cal_clear_data(asc);
                 LOGI("data z positive has collected");
-        } else if (asc->average[2] > -ACCEL_SIMP_CAL_MODEL_OFFSET - GRAVITY_EARTH && asc->average[2] < ACCEL_SIMP_CAL_DIRECTION_OFFSET - GRAVITY_EARTH) {
+        } else if (asc->window.average[2] > -ACCEL_SIMP_CAL_MODEL_OFFSET - GRAVITY_EARTH && asc->window.average[2] < ACCEL_SIMP_CAL_DIRECTION_OFFSET - GRAVITY_EARTH) {
                 LOGI("data z negative");
                 if (asc->samples.sampled[5]) {
                         LOGI("data z negative had collected");
@@ -185,7 +148,7 @@ static void accel_simp_cal_sampling(struct accelerometer_simple_calibration_even
                         return;
                 }
                 for (i = 0; i < ACCEL_AXIS_MAX; i++) {
-                        asc->samples.samples[5][i] = asc->average[i];
+                        asc->samples.samples[5][i] = asc->window.average[i];
                 }
                 asc->samples.sampled[5] = 1;
                 asc->samples.samples_collected++;
@@ -193,7 +156,7 @@ static void accel_simp_cal_sampling(struct accelerometer_simple_calibration_even
                 accel_simp_cal_clear_data(asc);
                 LOGI("data z negative has collected");
         } else {
-                LOGI("Other data %lf %lf %lf", asc->average[ACCEL_AXIS_X], asc->average[ACCEL_AXIS_Y], asc->average[2]);
+                LOGI("Other data %lf %lf %lf", asc->window.average[ACCEL_AXIS_X], asc->window.average[ACCEL_AXIS_Y], asc->window.average[2]);
                 accel_simp_cal_collect_data(event, asc);
         }
 
@@ -358,6 +321,7 @@ int accel_simp_cal_calibration(struct accelerometer_simple_calibration_event_t*
                 configFile = "/data/accel_simple_cal_default.conf";
 
         if (!asc.initialized) {
+                accel_simp_cal_window_init(&asc.window, ACCEL_SIMP_CAL_BUF_LENGTH);
                 ret = accel_simp_cal_read_samples(&asc.samples, configFile);
                 if (ret < 0) {
                         LOGW("%s line:%d, read samples error!", __FUNCTION__, __LINE__);
@@ -15,6 +15,10 @@
 #define ACCEL_SIMP_CAL_SAMPLES_COUNT  6
 #define ACCEL_SIMP_ZCAL_SAMPLES_COUNT 2
 
+/* Samples averaged per orientation, also size the window buffers */
+#define ACCEL_SIMP_CAL_BUF_LENGTH     50
+#define ACCEL_SIMP_ZCAL_BUF_LENGTH    12
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2013 Han, He <he.han@intel.com>
+ * Version: 1.0
+ * Author: Han, He <he.han@intel.com>
+ * Date: Aug 26th, 2013
+ */
+
+#include "accelerometer_simple_calibration_window.h"
+#include <math.h>
+#include <cutils/log.h>
+
+#define DEQUE_AT(window, deque, n)      ((deque)->slot[((deque)->head + (n)) % (window)->length])
+
+void accel_simp_cal_window_init(struct accel_simp_cal_window_t* window, int length)
+{
+        if (length > ACCEL_SIMP_CAL_WINDOW_MAX_LENGTH) {
+                LOGE("%s: window length %d cut to %d", __FUNCTION__, length, ACCEL_SIMP_CAL_WINDOW_MAX_LENGTH);
+                length = ACCEL_SIMP_CAL_WINDOW_MAX_LENGTH;
+        }
+        window->length = length;
+        accel_simp_cal_window_clear(window);
+}
+
+void accel_simp_cal_window_clear(struct accel_simp_cal_window_t* window)
+{
+        int i;
+
+        window->index = 0;
+        window->size = 0;
+        for (i = 0; i < ACCEL_AXIS_MAX; i++) {
+                window->average[i] = 0;
+                window->sum[i] = 0;
+                window->min[i].head = window->min[i].count = 0;
+                window->max[i].head = window->max[i].count = 0;
+        }
+}
+
+/* Drop the sample leaving the window, then the ones the new sample dominates */
+static void accel_simp_cal_deque_push(struct accel_simp_cal_window_t* window, struct accel_simp_cal_deque_t* deque,
+                                      int axis, float value, int is_max)
+{
+        float last;
+
+        /* Deque slots are all in the window, so the slot being reused can only be the oldest */
+        if (deque->count > 0 && deque->slot[deque->head] == window->index) {
+                deque->head = (deque->head + 1) % window->length;
+                deque->count--;
+        }
+
+        while (deque->count > 0) {
+                last = window->buf[axis][DEQUE_AT(window, deque, deque->count - 1)];
+                if (is_max ? last > value : last < value)
+                        break;
+                deque->count--;
+        }
+
+        DEQUE_AT(window, deque, deque->count) = window->index;
+        deque->count++;
+}
+
+void accel_simp_cal_window_push(struct accel_simp_cal_window_t* window, const float* data)
+{
+        int i;
+
+        if (window->size < window->length)
+                window->size++;
+        else
+                for (i = 0; i < ACCEL_AXIS_MAX; i++) {
+                        window->sum[i] -= window->buf[i][window->index];
+                }
+
+        for (i = 0; i < ACCEL_AXIS_MAX; i++) {
+                accel_simp_cal_deque_push(window, &window->min[i], i, data[i], 0);
+                accel_simp_cal_deque_push(window, &window->max[i], i, data[i], 1);
+                window->buf[i][window->index] = data[i];
+                window->sum[i] += data[i];
+                window->average[i] = window->sum[i] / window->size;
+        }
+
+        window->index++;
+        if (window->index >= window->length)
+                window->index = 0;
+}
+
+float accel_simp_cal_window_model(const struct accel_simp_cal_window_t* window)
+{
+        return sqrt(window->average[ACCEL_AXIS_X] * window->average[ACCEL_AXIS_X] + window->average[ACCEL_AXIS_Y] * window->average[ACCEL_AXIS_Y] + window->average[ACCEL_AXIS_Z] * window->average[ACCEL_AXIS_Z]);
+}
+
+int accel_simp_cal_window_stationary(const struct accel_simp_cal_window_t* window, double noise)
+{
+        int i;
+        float low, high;
+
+        if (window->size == 0)
+                return 1;
+
+        for (i = 0; i < ACCEL_AXIS_MAX; i++) {
+                low = window->buf[i][window->min[i].slot[window->min[i].head]] - window->average[i];
+                high = window->buf[i][window->max[i].slot[window->max[i].head]] - window->average[i];
+                if (low < -noise || high > noise) {
+                        LOGW("Noise too large: coordinate: %d asc->average: %lf noise: %lf %lf",
+                             i, window->average[i], low, high);
+                        return 0;
+                }
+        }
+
+        return 1;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2013 Han, He <he.han@intel.com>
+ * Version: 1.0
+ * Author: Han, He <he.han@intel.com>
+ * Date: Aug 26th, 2013
+ */
+
+#ifndef _ACCELEROMETER_SIMPLE_CALIBRATION_WINDOW_H_
+#define _ACCELEROMETER_SIMPLE_CALIBRATION_WINDOW_H_
+
+#include "accelerometer_simple_calibration.h"
+
+#define ACCEL_SIMP_CAL_WINDOW_MAX_LENGTH        ACCEL_SIMP_CAL_BUF_LENGTH
+
+#if ACCEL_SIMP_ZCAL_BUF_LENGTH > ACCEL_SIMP_CAL_WINDOW_MAX_LENGTH
+#error "accelerometer simple zcalibration window does not fit the window buffers"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sliding window over the last length samples of each axis, updated in
+ * constant time per sample: a running sum for the mean and a monotonic deque
+ * per axis for the min and the max, holding the buffer slots of the samples
+ * that can still become the extreme of the window.
+ *
+ * Every sample of the window lies within noise of the mean exactly when the
+ * min and the max do, so the stationary test only looks at those two.
+ */
+struct accel_simp_cal_deque_t {
+        int slot[ACCEL_SIMP_CAL_WINDOW_MAX_LENGTH];
+        int head;
+        int count;
+};
+
+struct accel_simp_cal_window_t {
+        float buf[ACCEL_AXIS_MAX][ACCEL_SIMP_CAL_WINDOW_MAX_LENGTH];
+        float average[ACCEL_AXIS_MAX];
+        float sum[ACCEL_AXIS_MAX];
+        struct accel_simp_cal_deque_t min[ACCEL_AXIS_MAX];
+        struct accel_simp_cal_deque_t max[ACCEL_AXIS_MAX];
+        int length;
+        int index;                      /* slot of the next sample */
+        int size;
+};
+
+void accel_simp_cal_window_init(struct accel_simp_cal_window_t* window, int length);
+void accel_simp_cal_window_clear(struct accel_simp_cal_window_t* window);
+void accel_simp_cal_window_push(struct accel_simp_cal_window_t* window, const float* data);
+/* Magnitude of the mean */
+float accel_simp_cal_window_model(const struct accel_simp_cal_window_t* window);
+/* 1 if every sample of the window is within noise of the mean */
+int accel_simp_cal_window_stationary(const struct accel_simp_cal_window_t* window, double noise);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -6,6 +6,7 @@
  */
 
 #include "accelerometer_simple_calibration.h"
+#include "accelerometer_simple_calibration_window.h"
 #include <string.h>
 #include <math.h>
 #include <fcntl.h>
@@ -14,18 +15,13 @@
 #include <errno.h>
 #include <cutils/log.h>
 
-#define ACCEL_SIMP_ZCAL_BUF_LENGTH       12
 #define ACCEL_SIMP_ZCAL_NOISE_DENSITY    (0.025 * GRAVITY_EARTH)
 #define ACCEL_SIMP_ZCAL_DIRECTION_SCALE  (0.970287525f)
 #define ACCEL_SIMP_ZCAL_MODEL_OFFSET     1.2
 
 struct accelerometer_simple_zcalibration_t {
-        float buf[ACCEL_AXIS_MAX][ACCEL_SIMP_ZCAL_BUF_LENGTH];
-        float average[ACCEL_AXIS_MAX];
-        float sum[ACCEL_AXIS_MAX];
-        float model;
-        int index;
-        int size;
+        struct accel_simp_cal_window_t window;
+        float model;                    /* of the window average, valid once the window is full */
         struct accelerometer_simple_zcalibration_samples samples;
         int samples_collected_this_time;
         int initialized;
@@ -35,61 +31,28 @@ static int need_rezcalibrate = 0;
 
 static void accel_simp_zcal_collect_data(struct accelerometer_simple_calibration_event_t* event, struct accelerometer_simple_zcalibration_t* asc)
 {
-        int i;
-
-        if (asc->size < ACCEL_SIMP_ZCAL_BUF_LENGTH)
-                asc->size++;
-        else
-                for (i = 0; i < ACCEL_AXIS_MAX; i++) {
-                        asc->sum[i] -= asc->buf[i][asc->index];
-                }
-
-        for (i = 0; i < ACCEL_AXIS_MAX; i++) {
-                asc->buf[i][asc->index] = event->data[i];
-                asc->sum[i] += event->data[i];
-                asc->average[i] = asc->sum[i] / asc->size;
-        }
-        asc->model = sqrt(asc->average[ACCEL_AXIS_X] * asc->average[ACCEL_AXIS_X] + asc->average[ACCEL_AXIS_Y] * asc->average[ACCEL_AXIS_Y] + asc->average[ACCEL_AXIS_Z] * asc->average[ACCEL_AXIS_Z]);
-
-        asc->index++;
-        if (asc->index >= ACCEL_SIMP_ZCAL_BUF_LENGTH)
-                asc->index = 0;
+        accel_simp_cal_window_push(&asc->window, event->data);
 }
 
 static void accel_simp_zcal_clear_data(struct accelerometer_simple_zcalibration_t* asc)
 {
-        int i;
-        asc->index = 0;
-        asc->size = 0;
-        for (i = 0; i < ACCEL_AXIS_MAX; i++) {
-                asc->average[i] = 0;
-                asc->sum[i] = 0;
-        }
+        accel_simp_cal_window_clear(&asc->window);
 }
 
 static int accel_simp_zcal_sample_out_range(struct accelerometer_simple_zcalibration_t* asc)
 {
-        int i, j;
-        float noise[ACCEL_AXIS_MAX];
+        if (asc->window.size < ACCEL_SIMP_ZCAL_BUF_LENGTH)
+                return 1;
 
-        if (asc->size < ACCEL_SIMP_ZCAL_BUF_LENGTH) {
+        asc->model = accel_simp_cal_window_model(&asc->window);
+        if (asc->model < GRAVITY_EARTH - ACCEL_SIMP_ZCAL_MODEL_OFFSET || asc->model > GRAVITY_EARTH + ACCEL_SIMP_ZCAL_MODEL_OFFSET) {
+                LOGW("Incorrect asc->model: %f", asc->model);
                 return 1;
-        } else {
-                if (asc->model < GRAVITY_EARTH - ACCEL_SIMP_ZCAL_MODEL_OFFSET || asc->model > GRAVITY_EARTH + ACCEL_SIMP_ZCAL_MODEL_OFFSET) {
-                        LOGW("Incorrect asc->model: %f", asc->model);
-                        return 1;
-                }
-                for (j = 0; j < ACCEL_SIMP_ZCAL_BUF_LENGTH; j++) {
-                        for (i = 0; i < ACCEL_AXIS_MAX; i++) {
-                                noise[i] = asc->buf[i][j] - asc->average[i];
-                                if (noise[i] < -ACCEL_SIMP_ZCAL_NOISE_DENSITY || noise[i] > ACCEL_SIMP_ZCAL_NOISE_DENSITY) {
-                                        LOGW("Noise too large: asc->index: %d coordinate: %d value: %lf asc->average: %lf noise: %lf",
-                                             j, i, asc->buf[i][j], asc->average[i], noise[i]);
-                                        return 1;
-                                }
-                        }
-                }
         }
+
+        if (!accel_simp_cal_window_stationary(&asc->window, ACCEL_SIMP_ZCAL_NOISE_DENSITY))
+                return 1;
+
         return 0;
 }
 
@@ -102,7 +65,7 @@ static void accel_simp_zcal_sampling(struct accelerometer_simple_calibration_eve
                 return;
         }
 
-        if (asc->average[ACCEL_AXIS_Z] > asc->model * ACCEL_SIMP_ZCAL_DIRECTION_SCALE) {
+        if (asc->window.average[ACCEL_AXIS_Z] > asc->model * ACCEL_SIMP_ZCAL_DIRECTION_SCALE) {
                 LOGD("data z positive");
                 if (asc->samples.sampled[0]) {
                         LOGD("data z positive had collected");
@@ -114,7 +77,7 @@ static void accel_simp_zcal_sampling(struct accelerometer_simple_calibration_eve
                 asc->samples.samples_collected++;
                 accel_simp_zcal_clear_data(asc);
                 LOGD("data z positive has collected");
-        } else if (asc->average[ACCEL_AXIS_Z] < -asc->model * ACCEL_SIMP_ZCAL_DIRECTION_SCALE) {
+        } else if (asc->window.average[ACCEL_AXIS_Z] < -asc->model * ACCEL_SIMP_ZCAL_DIRECTION_SCALE) {
                 LOGD("data z negative");
                 if (asc->samples.sampled[1]) {
                         LOGD("data z negative had collected");
@@ -128,7 +91,7 @@ static void accel_simp_zcal_sampling(struct accelerometer_simple_calibration_eve
                 LOGD("data z negative has collected");
 
         } else {
-                LOGD("Other data %lf %lf %lf", asc->average[ACCEL_AXIS_X], asc->average[ACCEL_AXIS_Y], asc->average[ACCEL_AXIS_Z]);
+                LOGD("Other data %lf %lf %lf", asc->window.average[ACCEL_AXIS_X], asc->window.average[ACCEL_AXIS_Y], asc->window.average[ACCEL_AXIS_Z]);
                 accel_simp_zcal_collect_data(event, asc);
         }
 
@@ -159,6 +122,11 @@ int accel_simp_zcal_calibration(struct accelerometer_simple_calibration_event_t*
         int ret = -EAGAIN;
         static struct accelerometer_simple_zcalibration_t asc;
 
+        if (!asc.initialized) {
+                accel_simp_cal_window_init(&asc.window, ACCEL_SIMP_ZCAL_BUF_LENGTH);
+                asc.initialized = 1;
+        }
+
         if (need_rezcalibrate == 1) {
                 LOGW("%s line:%d, need rezcalibrate!", __FUNCTION__, __LINE__);
                 memset(&asc.samples, 0, sizeof(asc.samples));
@@ -20,6 +20,10 @@
 #include "vec.h"
 #include "traits.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 // -----------------------------------------------------------------------
 
 namespace android {
@@ -277,6 +281,102 @@ public:
     void operator << (const vec<TYPE, R>& rhs) { base::operator[](0) = rhs; }
 };
 
+// -----------------------------------------------------------------------
+// Fixed size kernels, picked by operator* in place of the generic loops.
+// Storage is column major: m[c] is a contiguous column of R elements.
+
+namespace helpers {
+
+template <typename TYPE>
+inline void mul33(TYPE* res, const TYPE* a, const TYPE* b) {
+    for (size_t c=0 ; c<3 ; c++) {
+        const TYPE b0 = b[c*3], b1 = b[c*3+1], b2 = b[c*3+2];
+        res[c*3]   = a[0]*b0 + a[3]*b1 + a[6]*b2;
+        res[c*3+1] = a[1]*b0 + a[4]*b1 + a[7]*b2;
+        res[c*3+2] = a[2]*b0 + a[5]*b1 + a[8]*b2;
+    }
+}
+
+template <typename TYPE>
+inline void mul33v(TYPE* res, const TYPE* a, const TYPE* b) {
+    res[0] = a[0]*b[0] + a[3]*b[1] + a[6]*b[2];
+    res[1] = a[1]*b[0] + a[4]*b[1] + a[7]*b[2];
+    res[2] = a[2]*b[0] + a[5]*b[1] + a[8]*b[2];
+}
+
+template <>
+inline mat<float, 3, 3> PURE doMul<float, 3, 3, 3>(
+        const mat<float, 3, 3>& lhs, const mat<float, 3, 3>& rhs) {
+    mat<float, 3, 3> res;
+    mul33(&res[0][0], &lhs[0][0], &rhs[0][0]);
+    return res;
+}
+
+template <>
+inline mat<double, 3, 3> PURE doMul<double, 3, 3, 3>(
+        const mat<double, 3, 3>& lhs, const mat<double, 3, 3>& rhs) {
+    mat<double, 3, 3> res;
+    mul33(&res[0][0], &lhs[0][0], &rhs[0][0]);
+    return res;
+}
+
+template <>
+inline mat<float, 1, 3> PURE doMul<float, 1, 3, 3>(
+        const mat<float, 3, 3>& lhs, const mat<float, 1, 3>& rhs) {
+    mat<float, 1, 3> res;
+    mul33v(&res[0][0], &lhs[0][0], &rhs[0][0]);
+    return res;
+}
+
+template <>
+inline mat<double, 1, 3> PURE doMul<double, 1, 3, 3>(
+        const mat<double, 3, 3>& lhs, const mat<double, 1, 3>& rhs) {
+    mat<double, 1, 3> res;
+    mul33v(&res[0][0], &lhs[0][0], &rhs[0][0]);
+    return res;
+}
+
+#if defined(__SSE2__)
+// each result column is a sum of lhs columns scaled by one rhs element
+template <>
+inline mat<float, 4, 4> PURE doMul<float, 4, 4, 4>(
+        const mat<float, 4, 4>& lhs, const mat<float, 4, 4>& rhs) {
+    mat<float, 4, 4> res;
+    const __m128 a0 = _mm_loadu_ps(&lhs[0][0]);
+    const __m128 a1 = _mm_loadu_ps(&lhs[1][0]);
+    const __m128 a2 = _mm_loadu_ps(&lhs[2][0]);
+    const __m128 a3 = _mm_loadu_ps(&lhs[3][0]);
+    for (size_t c=0 ; c<4 ; c++) {
+        __m128 v = _mm_mul_ps(a0, _mm_set1_ps(rhs[c][0]));
+        v = _mm_add_ps(v, _mm_mul_ps(a1, _mm_set1_ps(rhs[c][1])));
+        v = _mm_add_ps(v, _mm_mul_ps(a2, _mm_set1_ps(rhs[c][2])));
+        v = _mm_add_ps(v, _mm_mul_ps(a3, _mm_set1_ps(rhs[c][3])));
+        _mm_storeu_ps(&res[c][0], v);
+    }
+    return res;
+}
+
+template <>
+inline mat<double, 4, 4> PURE doMul<double, 4, 4, 4>(
+        const mat<double, 4, 4>& lhs, const mat<double, 4, 4>& rhs) {
+    mat<double, 4, 4> res;
+    for (size_t c=0 ; c<4 ; c++) {
+        __m128d lo = _mm_setzero_pd();
+        __m128d hi = _mm_setzero_pd();
+        for (size_t k=0 ; k<4 ; k++) {
+            const __m128d b = _mm_set1_pd(rhs[c][k]);
+            lo = _mm_add_pd(lo, _mm_mul_pd(_mm_loadu_pd(&lhs[k][0]), b));
+            hi = _mm_add_pd(hi, _mm_mul_pd(_mm_loadu_pd(&lhs[k][2]), b));
+        }
+        _mm_storeu_pd(&res[c][0], lo);
+        _mm_storeu_pd(&res[c][2], hi);
+    }
+    return res;
+}
+#endif
+
+}; // namespace helpers
+
 // -----------------------------------------------------------------------
 // matrix functions
 
@@ -380,6 +480,64 @@ mat<T, N, N> PURE invert(const mat<T, N, N>& src) {
     return inverse;
 }
 
+// closed form 3x3 inversion through the adjugate
+template<typename T>
+mat<T, 3, 3> PURE invert(const mat<T, 3, 3>& src) {
+    mat<T, 3, 3> inverse;
+    inverse[0][0] = src[1][1] * src[2][2] - src[2][1] * src[1][2];
+    inverse[0][1] = src[2][1] * src[0][2] - src[0][1] * src[2][2];
+    inverse[0][2] = src[0][1] * src[1][2] - src[1][1] * src[0][2];
+    inverse[1][0] = src[2][0] * src[1][2] - src[1][0] * src[2][2];
+    inverse[1][1] = src[0][0] * src[2][2] - src[2][0] * src[0][2];
+    inverse[1][2] = src[1][0] * src[0][2] - src[0][0] * src[1][2];
+    inverse[2][0] = src[1][0] * src[2][1] - src[2][0] * src[1][1];
+    inverse[2][1] = src[2][0] * src[0][1] - src[0][0] * src[2][1];
+    inverse[2][2] = src[0][0] * src[1][1] - src[1][0] * src[0][1];
+
+    const T det = src[0][0] * inverse[0][0] + src[1][0] * inverse[0][1]
+            + src[2][0] * inverse[0][2];
+    return inverse * (1 / det);
+}
+
+// -----------------------------------------------------------------------
+// Solve A.x = b for a symmetric positive definite A, such as normal
+// equations, by Cholesky factorization. Only the lower triangle of A is
+// read. Returns false if A is not positive definite.
+template<typename T, size_t N>
+bool cholesky_solve(const mat<T, N, N>& A, const mat<T, 1, N>& b, mat<T, 1, N>& x) {
+    mat<T, N, N> L;
+
+    for (size_t j=0 ; j<N ; j++) {
+        T d = A[j][j];
+        for (size_t k=0 ; k<j ; k++)
+            d -= L[k][j] * L[k][j];
+        if (!(d > 0))
+            return false;
+        L[j][j] = sqrt(d);
+        for (size_t i=j+1 ; i<N ; i++) {
+            T v = A[j][i];
+            for (size_t k=0 ; k<j ; k++)
+                v -= L[k][i] * L[k][j];
+            L[j][i] = v / L[j][j];
+        }
+    }
+
+    // forward substitution L.y = b, then back substitution L'.x = y
+    for (size_t i=0 ; i<N ; i++) {
+        T v = b[0][i];
+        for (size_t k=0 ; k<i ; k++)
+            v -= L[k][i] * x[0][k];
+        x[0][i] = v / L[i][i];
+    }
+    for (size_t i=N ; i-- > 0 ;) {
+        T v = x[0][i];
+        for (size_t k=i+1 ; k<N ; k++)
+            v -= L[i][k] * x[0][k];
+        x[0][i] = v / L[i][i];
+    }
+    return true;
+}
+
 // -----------------------------------------------------------------------
 
 typedef mat<float, 2, 2> mat22_t;
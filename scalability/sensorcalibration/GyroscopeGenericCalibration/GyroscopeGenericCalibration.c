@@ -0,0 +1,237 @@
+#include <string.h>
+#include <math.h>
+#include <cutils/log.h>
+#include "GyroscopeGenericCalibration.h"
+
+/*
+ * Online bias estimation: the stream is cut into windows of at least
+ * GYRO_CAL_WINDOW_NS and GYRO_CAL_MIN_SAMPLES samples. A window whose
+ * variance is below GYRO_CAL_STILL_VARIANCE on every axis and whose mean is
+ * a plausible bias looks still: within GYRO_CAL_MAX_BIAS, the zero-rate
+ * offset of the part, or twice a larger stored bias. A slow steady turn
+ * looks still too, so only consecutive still windows whose means agree
+ * within GYRO_CAL_AGREEMENT count as rest: GYRO_CAL_STILL_WINDOWS of them
+ * to follow a bias within GYRO_CAL_MAX_DRIFT of the known one, and
+ * GYRO_CAL_NEW_BIAS_WINDOWS, longer than a steady turn lasts, to learn a
+ * first or a different one. The run's mean is folded into the bias.
+ * Any other window, or a gap, restarts the run, so moving the device never
+ * moves the bias.
+ */
+#define GYRO_CAL_WINDOW_NS              1000000000LL    /* 1 s */
+#define GYRO_CAL_MIN_SAMPLES            20
+#define GYRO_CAL_MAX_GAP_NS             200000000LL     /* longer gaps restart the window */
+#define GYRO_CAL_STILL_VARIANCE         (0.01f * 0.01f) /* (rad/s)^2 */
+/* Zero-rate offset of the part, boards can override it through the build */
+#ifndef GYRO_CAL_MAX_BIAS
+#define GYRO_CAL_MAX_BIAS               0.35f           /* rad/s, about 20 dps */
+#endif
+#define GYRO_CAL_STILL_WINDOWS          3
+#define GYRO_CAL_MAX_DRIFT              0.02f           /* rad/s, from the known bias */
+#define GYRO_CAL_NEW_BIAS_WINDOWS       10
+#define GYRO_CAL_AGREEMENT              0.003f          /* rad/s, between window means of a run */
+#define GYRO_CAL_BIAS_WEIGHT            0.25f           /* weight of a new run in the bias */
+
+struct gyro_cal_window_t {
+        int64_t start;
+        int64_t last;
+        int count;
+        float pivot[3];                 /* first sample, keeps the float sums small */
+        float sum[3];
+        float sum_sq[3];
+};
+
+/* Consecutive still windows so far */
+struct gyro_cal_run_t {
+        int count;
+        float sum[3];                   /* of the window means */
+};
+
+static struct gyro_cal_window_t window;
+static struct gyro_cal_run_t run;
+static float bias[3];
+static float stored_limit[3];           /* twice the stored bias, when above GYRO_CAL_MAX_BIAS */
+static int bias_valid;
+static int bias_dirty;
+
+static void window_reset()
+{
+        window.count = 0;
+}
+
+static void run_reset()
+{
+        run.count = 0;
+}
+
+void GyroCal_init(FILE *calDataFile)
+{
+        float stored[3];
+        int i;
+
+        window_reset();
+        run_reset();
+
+        /* The in-memory estimate is newer than anything stored */
+        if (bias_valid)
+                return;
+
+        if (!calDataFile)
+                return;
+
+        /* Any stored bias is applied, even one the part should not have */
+        if (fscanf(calDataFile, "%f %f %f", &stored[0], &stored[1], &stored[2]) != 3 ||
+            !isfinite(stored[0]) || !isfinite(stored[1]) || !isfinite(stored[2]))
+                return;
+
+        for (i = 0; i < 3; i++) {
+                bias[i] = stored[i];
+                /* Keep refining a bias beyond the part's offset instead of freezing it */
+                stored_limit[i] = 2 * fabsf(stored[i]);
+        }
+        bias_valid = 1;
+        LOGI("loaded bias %f %f %f", bias[0], bias[1], bias[2]);
+}
+
+int GyroCal_storeResult(FILE *calDataFile)
+{
+        if (!calDataFile || !bias_dirty)
+                return 0;
+
+        if (fprintf(calDataFile, "%f %f %f\n", bias[0], bias[1], bias[2]) < 0) {
+                LOGE("%s: store bias failed", __FUNCTION__);
+                return 0;
+        }
+
+        bias_dirty = 0;
+        return 1;
+}
+
+/* Return 1 if the window looked still, with its mean in mean */
+static int window_still(float *mean)
+{
+        int i;
+        float variance, limit;
+
+        for (i = 0; i < 3; i++) {
+                mean[i] = window.sum[i] / window.count;
+                variance = (window.sum_sq[i] - window.sum[i] * mean[i]) / (window.count - 1);
+                if (variance > GYRO_CAL_STILL_VARIANCE)
+                        return 0;
+                mean[i] += window.pivot[i];
+                limit = stored_limit[i] > GYRO_CAL_MAX_BIAS ? stored_limit[i] : GYRO_CAL_MAX_BIAS;
+                if (mean[i] < -limit || mean[i] > limit)
+                        return 0;
+        }
+
+        return 1;
+}
+
+static int window_close()
+{
+        int i, needed = GYRO_CAL_STILL_WINDOWS;
+        float mean[3], d;
+
+        if (!window_still(mean)) {
+                run_reset();
+                return 0;
+        }
+
+        /* A window off the run's mean starts a new run */
+        for (i = 0; i < 3 && run.count > 0; i++) {
+                d = mean[i] - run.sum[i] / run.count;
+                if (d < -GYRO_CAL_AGREEMENT || d > GYRO_CAL_AGREEMENT)
+                        run_reset();
+        }
+        if (run.count == 0)
+                run.sum[0] = run.sum[1] = run.sum[2] = 0;
+        for (i = 0; i < 3; i++)
+                run.sum[i] += mean[i];
+        run.count++;
+
+        for (i = 0; i < 3; i++) {
+                mean[i] = run.sum[i] / run.count;
+                d = mean[i] - bias[i];
+                if (!bias_valid || d < -GYRO_CAL_MAX_DRIFT || d > GYRO_CAL_MAX_DRIFT)
+                        needed = GYRO_CAL_NEW_BIAS_WINDOWS;
+        }
+        if (run.count < needed)
+                return 0;
+        run_reset();
+
+        for (i = 0; i < 3; i++) {
+                if (bias_valid)
+                        bias[i] += GYRO_CAL_BIAS_WEIGHT * (mean[i] - bias[i]);
+                else
+                        bias[i] = mean[i];
+        }
+        bias_valid = 1;
+        bias_dirty = 1;
+        LOGV("bias %f %f %f", bias[0], bias[1], bias[2]);
+
+        return 1;
+}
+
+int GyroCal_collectData(float rawX, float rawY, float rawZ, int64_t timestampNs)
+{
+        float raw[3] = { rawX, rawY, rawZ };
+        float d;
+        int i, updated = 0;
+
+        if (window.count > 0 && (timestampNs < window.last || timestampNs - window.last > GYRO_CAL_MAX_GAP_NS)) {
+                window_reset();
+                run_reset();
+        }
+
+        if (window.count == 0) {
+                window.start = timestampNs;
+                for (i = 0; i < 3; i++) {
+                        window.pivot[i] = raw[i];
+                        window.sum[i] = 0;
+                        window.sum_sq[i] = 0;
+                }
+        }
+
+        for (i = 0; i < 3; i++) {
+                d = raw[i] - window.pivot[i];
+                window.sum[i] += d;
+                window.sum_sq[i] += d * d;
+        }
+        window.count++;
+        window.last = timestampNs;
+
+        if (window.count >= GYRO_CAL_MIN_SAMPLES && timestampNs - window.start >= GYRO_CAL_WINDOW_NS) {
+                updated = window_close();
+                window_reset();
+        }
+
+        return updated;
+}
+
+int GyroCal_readyCheck()
+{
+        return bias_valid;
+}
+
+void GyroCal_removeBias(float rawX, float rawY, float rawZ, float *resultX,
+                        float *resultY, float *resultZ)
+{
+        float raw[3] = { rawX, rawY, rawZ };
+
+        GyroCal_removeBiasBatch(raw, raw, 1);
+        *resultX = raw[0];
+        *resultY = raw[1];
+        *resultZ = raw[2];
+}
+
+void GyroCal_removeBiasBatch(const float *raw, float *result, int count)
+{
+        /* Unknown bias is zero, so no branch on bias_valid */
+        const float bx = bias[0], by = bias[1], bz = bias[2];
+        int i;
+
+        for (i = 0; i < count; i++) {
+                result[3 * i] = raw[3 * i] - bx;
+                result[3 * i + 1] = raw[3 * i + 1] - by;
+                result[3 * i + 2] = raw[3 * i + 2] - bz;
+        }
+}
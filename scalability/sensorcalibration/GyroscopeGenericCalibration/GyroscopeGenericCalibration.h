@@ -0,0 +1,62 @@
+#ifndef __GYROSCOPE_GENERIC_CALIBRATION_H__
+#define __GYROSCOPE_GENERIC_CALIBRATION_H__
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* GyroCal_init
+ * Initialize the bias estimator. Must be called at first.
+ *
+ * If a bias has been stored before, it is loaded from
+ * calDataFile ("x y z" in rad/s) and used until the
+ * first stationary period refines it.
+ */
+void GyroCal_init(FILE *calDataFile);
+
+/* GyroCal_storeResult
+ * store the current bias into file
+ *
+ * Return 1 if the bias changed since init or the last
+ * store and was written, otherwise return 0.
+ */
+int GyroCal_storeResult(FILE *calDataFile);
+
+/* GyroCal_collectData
+ * feed one raw gyroscope sample, in rad/s, to the
+ * stationary detector. timestampNs is the sample time.
+ *
+ * Constant cost per sample: the detector only keeps the
+ * sum and the sum of squares of the current window.
+ *
+ * Return 1 if the sample closed the last of a run of
+ * agreeing stationary windows and the bias was updated,
+ * otherwise return 0.
+ */
+int GyroCal_collectData(float rawX, float rawY, float rawZ, int64_t timestampNs);
+
+/* GyroCal_readyCheck
+ * Return 1 if a bias is known, loaded or estimated,
+ * otherwise return 0.
+ */
+int GyroCal_readyCheck();
+
+/* GyroCal_removeBias
+ * Subtract the current bias from one sample.
+ */
+void GyroCal_removeBias(float rawX, float rawY, float rawZ, float *resultX,
+                        float *resultY, float *resultZ);
+
+/* GyroCal_removeBiasBatch
+ * Same as GyroCal_removeBias for count samples
+ * stored as consecutive x, y, z triplets.
+ *
+ * raw and result may point to the same buffer.
+ */
+void GyroCal_removeBiasBatch(const float *raw, float *result, int count);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__GYROSCOPE_GENERIC_CALIBRATION_H__*/
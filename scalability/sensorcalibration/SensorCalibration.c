@@ -8,6 +8,7 @@
 #include <errno.h>
 #include "SensorCalibration.h"
 #include "CompassGenericCalibration/CompassGenericCalibration.h"
+#include "GyroscopeGenericCalibration/GyroscopeGenericCalibration.h"
 
 void CompassGenericCalibration(struct sensors_event_t* event, calibration_flag_t flag, const char* configFile)
 {
@@ -71,33 +72,49 @@ void CompassGenericCalibration(struct sensors_event_t* event, calibration_flag_t
 
 void GyroscopeGenericCalibration(struct sensors_event_t* event, calibration_flag_t flag, const char* configFile)
 {
-        int ret, fd = -1;
-        char buf[50];
-        static float calX = 0.0, calY = 0.0, calZ = 0.0;
-
-        if (flag == STORE_DATA)
-                return;
+        int fd;
+        FILE *dataFile;
 
         if (flag == READ_DATA) {
                 fd = open(configFile, O_RDONLY);
-
+                if (fd < 0) {
+                        LOGW("%s line:%d no stored bias in %s", __FUNCTION__, __LINE__, configFile);
+                        GyroCal_init(NULL);
+                        return;
+                }
+                dataFile = fdopen(fd, "r");
+                if (dataFile == NULL) {
+                        close(fd);
+                        GyroCal_init(NULL);
+                        return;
+                }
+                GyroCal_init(dataFile);
+                fclose(dataFile);
+        }
+        else if (flag == STORE_DATA) {
+                fd = open(configFile, O_RDWR | O_CREAT, S_IRWXU);
                 if (fd < 0) {
                         LOGE("%s line:%d unable to open %s", __FUNCTION__, __LINE__, configFile);
                         return;
                 }
-
-                ret = pread(fd, buf, sizeof(buf), 0);
-                if (ret > 0) {
-                        ret = sscanf(buf, "%f %f %f\n", &calX, &calY, &calZ);
-                        if (ret != 3)
-                                calX = calY = calZ = 0.0;
+                dataFile = fdopen(fd, "w");
+                if (dataFile == NULL) {
+                        close(fd);
+                        return;
                 }
-                close(fd);
+                /* Only rewrite the file when a stationary period moved the bias */
+                if (GyroCal_storeResult(dataFile)) {
+                        fflush(dataFile);
+                        if (ftruncate(fd, ftell(dataFile)) < 0)
+                                LOGE("%s line:%d truncate %s error: %s", __FUNCTION__, __LINE__, configFile, strerror(errno));
+                }
+                fclose(dataFile);
         }
         else if (flag == CALIBRATION_DATA) {
-                event->gyro.x -= calX;
-                event->gyro.y -= calY;
-                event->gyro.z -= calZ;
+                GyroCal_collectData(event->gyro.x, event->gyro.y, event->gyro.z, event->timestamp);
+                GyroCal_removeBias(event->gyro.x, event->gyro.y, event->gyro.z,
+                                   &event->gyro.x, &event->gyro.y, &event->gyro.z);
+                event->gyro.status = GyroCal_readyCheck() ? SENSOR_STATUS_ACCURACY_HIGH : SENSOR_STATUS_ACCURACY_LOW;
         }
 }
 
@@ -114,28 +131,103 @@ typedef struct {
         int crosstalk[APDS9XXX_PROXIMITY_MAX_NUMBER];
 } apds9xxx_proximity_calibration_t;
 
-void APDS9XXXProximityDriverGenericCalibration(struct sensors_event_t* event, calibration_flag_t flag, const char* configFile, const char* configNode)
+/*
+ * Crosstalk history, loaded from configFile on the first calibration and kept
+ * for the life of the process. Enabling only arms the calibration, the first
+ * sample reads the crosstalk and pushes the threshold, and the history is
+ * written back when the sensor is disabled, if it changed.
+ */
+static apds9xxx_proximity_calibration_t apds9xxx_cal_data;
+static int apds9xxx_cal_loaded;
+static int apds9xxx_cal_dirty;
+
+static int apds9xxx_lock(int fd, short type)
 {
-        int config_fd, driver_fd, ret, threshold, raw_data = APDS9XXX_PROXIMITY_INIT_DATA;
-        char buf[16] = { 0 };
         struct flock lock;
-        apds9xxx_proximity_calibration_t cal_data = { 0, 0, 0, 0, { 0 } };
 
-        if (flag != CALIBRATION_DATA)
-                return;
+        lock.l_type = type;
+        lock.l_start = 0;
+        lock.l_whence = SEEK_SET;
+        lock.l_len = 0;
+        return fcntl(fd, F_SETLK, &lock);
+}
 
-        /* wait 50 milliseconds for hardware ready if needed */
-        usleep(50000);
-        driver_fd = open(configNode, O_RDWR);
-        if (driver_fd < 0) {
-                LOGE("%s line:%d cannot open file: %s", __FUNCTION__, __LINE__, configNode);
+static void apds9xxx_load(const char* configFile)
+{
+        int config_fd, ret;
+
+        apds9xxx_cal_loaded = 1;
+        memset(&apds9xxx_cal_data, 0, sizeof(apds9xxx_cal_data));
+
+        config_fd = open(configFile, O_RDONLY);
+        if (config_fd < 0) {
+                LOGW("%s line:%d No calibration data", __FUNCTION__, __LINE__);
                 return;
         }
 
+        if (apds9xxx_lock(config_fd, F_RDLCK) < 0)
+                LOGE("%s line:%d file lock error: %s %s", __FUNCTION__, __LINE__, configFile, strerror(errno));
+
+        ret = pread(config_fd, &apds9xxx_cal_data, sizeof(apds9xxx_cal_data), 0);
+        if (ret < 0) {
+                LOGE("%s line:%d file read error: %s %s", __FUNCTION__, __LINE__, configFile, strerror(errno));
+                memset(&apds9xxx_cal_data, 0, sizeof(apds9xxx_cal_data));
+        }
+        else if (ret == 0) {
+                LOGW("%s line:%d No calibration data", __FUNCTION__, __LINE__);
+        }
+
+        close(config_fd);
+}
+
+static void apds9xxx_store(const char* configFile)
+{
+        int config_fd, ret;
+
         config_fd = open(configFile, O_RDWR | O_CREAT, S_IRWXU);
         if (config_fd < 0) {
                 LOGE("%s line:%d cannot open file: %s", __FUNCTION__, __LINE__, configFile);
-                goto error_open;
+                return;
+        }
+
+        if (apds9xxx_lock(config_fd, F_WRLCK) < 0) {
+                LOGE("%s line:%d file lock error: %s %s", __FUNCTION__, __LINE__, configFile, strerror(errno));
+                close(config_fd);
+                return;
+        }
+
+        ret = pwrite(config_fd, &apds9xxx_cal_data, sizeof(apds9xxx_cal_data), 0);
+        if (ret < 0)
+                LOGE("%s line:%d: Write config file %s failed, error %s",
+                     __FUNCTION__, __LINE__, configFile, strerror(errno));
+        else
+                apds9xxx_cal_dirty = 0;
+
+        if (apds9xxx_lock(config_fd, F_UNLCK) < 0)
+                LOGE("%s line:%d file lock error: %s %s", __FUNCTION__, __LINE__, configFile, strerror(errno));
+        close(config_fd);
+}
+
+void APDS9XXXProximityDriverGenericCalibration(struct sensors_event_t* event, calibration_flag_t flag, const char* configFile, const char* configNode)
+{
+        int driver_fd, ret, threshold, raw_data = APDS9XXX_PROXIMITY_INIT_DATA;
+        char buf[16] = { 0 };
+        apds9xxx_proximity_calibration_t *cal_data = &apds9xxx_cal_data;
+
+        if (flag == READ_DATA)
+                return;
+
+        if (flag == STORE_DATA) {
+                if (apds9xxx_cal_dirty)
+                        apds9xxx_store(configFile);
+                return;
+        }
+
+        /* a sample was delivered, so the hardware is ready */
+        driver_fd = open(configNode, O_RDWR);
+        if (driver_fd < 0) {
+                LOGE("%s line:%d cannot open file: %s", __FUNCTION__, __LINE__, configNode);
+                return;
         }
 
         ret = read(driver_fd, buf, sizeof(buf) - 1);
@@ -150,68 +242,51 @@ void APDS9XXXProximityDriverGenericCalibration(struct sensors_event_t* event, ca
                 LOGW("%s line:%d raw data is invalid: 0x%x", __FUNCTION__, __LINE__, raw_data);
         }
 
-        lock.l_type = F_WRLCK;
-        lock.l_start = 0;
-        lock.l_whence = SEEK_SET;
-        lock.l_len = 0;
-        if (fcntl(config_fd, F_SETLK, &lock) < 0) {
-                LOGE("%s line:%d file lock error: %s %s", __FUNCTION__, __LINE__, configFile, strerror(errno));
-                goto error_lock;
-        }
-
-        ret = pread(config_fd, &cal_data, sizeof(cal_data), 0);
-        if (ret < 0) {
-                LOGE("%s line:%d file read error: %s %s", __FUNCTION__, __LINE__, configFile, strerror(errno));
-                goto error_read_config;
-        }
-        else if (ret == 0) {
-                LOGW("%s line:%d No calibration data", __FUNCTION__, __LINE__);
-        }
+        if (!apds9xxx_cal_loaded)
+                apds9xxx_load(configFile);
 
-        if (cal_data.number == 0 && raw_data == APDS9XXX_PROXIMITY_INIT_DATA)
+        if (cal_data->number == 0 && raw_data == APDS9XXX_PROXIMITY_INIT_DATA)
                 goto error_no_calibration;
 
         if (raw_data < APDS9XXX_PROXIMITY_MIN_CROSSTALK)
                 raw_data += APDS9XXX_PROXIMITY_MIN_CROSSTALK;
 
-        if (cal_data.number > APDS9XXX_PROXIMITY_MAX_NUMBER) {
+        if (cal_data->number > APDS9XXX_PROXIMITY_MAX_NUMBER) {
                 LOGE("%s line:%d number overflow", __FUNCTION__, __LINE__);
                 goto error_overflow;
         }
-        if (cal_data.number == 0) {
+        if (cal_data->number == 0) {
                 if (raw_data > APDS9XXX_PROXIMITY_MAX_CROSSTALK)
                 goto error_overflow;
-                cal_data.average = raw_data;
-                cal_data.sum = raw_data;
-                cal_data.crosstalk[0] = raw_data;
-                cal_data.number = 1;
-        }
-        else if (cal_data.number < APDS9XXX_PROXIMITY_MAX_NUMBER) {
-                if (raw_data <= cal_data.average * 2) {
-                        cal_data.crosstalk[cal_data.number++] = raw_data;
-                        cal_data.sum += raw_data;
-                        cal_data.average = cal_data.sum / cal_data.number;
+                cal_data->average = raw_data;
+                cal_data->sum = raw_data;
+                cal_data->crosstalk[0] = raw_data;
+                cal_data->number = 1;
+        }
+        else if (cal_data->number < APDS9XXX_PROXIMITY_MAX_NUMBER) {
+                if (raw_data <= cal_data->average * 2) {
+                        cal_data->crosstalk[cal_data->number++] = raw_data;
+                        cal_data->sum += raw_data;
+                        cal_data->average = cal_data->sum / cal_data->number;
                 }
         }
         else {
-                if (raw_data <= (cal_data.average * 15) / 10) {
-                        cal_data.sum -= cal_data.crosstalk[cal_data.head_offset];
-                        cal_data.sum += raw_data;
-                        cal_data.average = cal_data.sum / cal_data.number;
-                        cal_data.crosstalk[cal_data.head_offset] = raw_data;
-                        if (cal_data.head_offset < cal_data.number - 1)
-                                cal_data.head_offset++;
+                if (raw_data <= (cal_data->average * 15) / 10) {
+                        cal_data->sum -= cal_data->crosstalk[cal_data->head_offset];
+                        cal_data->sum += raw_data;
+                        cal_data->average = cal_data->sum / cal_data->number;
+                        cal_data->crosstalk[cal_data->head_offset] = raw_data;
+                        if (cal_data->head_offset < cal_data->number - 1)
+                                cal_data->head_offset++;
                         else
-                                cal_data.head_offset = 0;
+                                cal_data->head_offset = 0;
                 }
         }
 
-        ret = pwrite(config_fd, &cal_data, sizeof(cal_data), 0);
-        if (ret < 0)
-                LOGE("%s line:%d: Write config file %s failed, error %s",
-                     __FUNCTION__, __LINE__, configFile, strerror(errno));
+        /* persisted on STORE_DATA */
+        apds9xxx_cal_dirty = 1;
 
-        threshold = cal_data.average;
+        threshold = cal_data->average;
         if (threshold < APDS9XXX_PROXIMITY_MIN_CROSSTALK)
                 threshold = APDS9XXX_PROXIMITY_MIN_CROSSTALK;
 
@@ -229,13 +304,6 @@ void APDS9XXXProximityDriverGenericCalibration(struct sensors_event_t* event, ca
 
 error_overflow:
 error_no_calibration:
-error_read_config:
-        lock.l_type = F_UNLCK;
-        if (fcntl(config_fd, F_SETLK, &lock) < 0)
-                LOGE("%s line:%d file lock error: %s %s", __FUNCTION__, __LINE__, configFile, strerror(errno));
-error_lock:
 error_read_raw:
-        close(config_fd);
-error_open:
         close(driver_fd);
 }
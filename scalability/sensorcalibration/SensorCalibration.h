@@ -7,4 +7,12 @@ typedef enum {
         READ_DATA
 } calibration_flag_t;
 
+/*
+ * Driver calibrations (PlatformData::driverCalibrationFunc) are driven by the
+ * sensor instead of running inside activate():
+ *   READ_DATA         sensor enabled, arm the calibration; must not block
+ *   CALIBRATION_DATA  first sample after enabling, the hardware is up
+ *   STORE_DATA        sensor disabled, persist what changed
+ */
+
 #endif
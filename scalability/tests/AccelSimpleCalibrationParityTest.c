@@ -0,0 +1,157 @@
+/*
+ * Drives the accelerometer simple calibration and zcalibration and the
+ * rescanning implementations they replaced (kept verbatim under
+ * AccelSimpleCalibrationReference/) with the same event sequences, and
+ * checks that every return code, every calibrated output and the stored
+ * samples are bit-identical.
+ *
+ * Sequences hold the device still in one of the six axis orientations or in
+ * a random one for up to 200 samples, with a random noise level, so windows
+ * are accepted, rejected for noise and rejected for direction; resets of
+ * both calibrators are mixed in.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+/* The reference implementation is built into this file under other names */
+#define accel_simp_cal_calibration      ref_accel_simp_cal_calibration
+#define accel_simp_cal_reset            ref_accel_simp_cal_reset
+#define accel_simp_zcal_calibration     ref_accel_simp_zcal_calibration
+#define accel_simp_zcal_reset           ref_accel_simp_zcal_reset
+#include "AccelSimpleCalibrationReference/accelerometer_simple_calibration.c"
+#include "AccelSimpleCalibrationReference/accelerometer_simple_zcalibration.c"
+#undef accel_simp_cal_calibration
+#undef accel_simp_cal_reset
+#undef accel_simp_zcal_calibration
+#undef accel_simp_zcal_reset
+
+int accel_simp_cal_calibration(struct accelerometer_simple_calibration_event_t* event, const char* configFile);
+void accel_simp_cal_reset();
+int accel_simp_zcal_calibration(struct accelerometer_simple_calibration_event_t* event);
+void accel_simp_zcal_reset();
+
+#define SEEDS           8
+#define SEED_SAMPLES    60000
+#define HOLD_MAX        200
+#define RESET_PERIOD    5000
+#define ZRESET_PERIOD   3000
+#define CONFIG_MAX      4096
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+                printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+                printf(__VA_ARGS__); \
+                printf("\n"); \
+                failures++; \
+        } \
+} while (0)
+
+static uint32_t seed;
+
+static uint32_t uniform(uint32_t range)
+{
+        seed = seed * 1664525 + 1013904223;
+        return (seed >> 8) % range;
+}
+
+static float unit()
+{
+        return uniform(1 << 20) / (float)(1 << 20);
+}
+
+static size_t read_config(const char* path, char* buf)
+{
+        FILE* file = fopen(path, "rb");
+        size_t size;
+
+        if (file == NULL)
+                return 0;
+        size = fread(buf, 1, CONFIG_MAX, file);
+        fclose(file);
+        return size;
+}
+
+int main()
+{
+        char config[2][64], stored[2][CONFIG_MAX];
+        size_t storedSize[2];
+        float base[ACCEL_AXIS_MAX], noise = 0;
+        int hold = 0, s, n, i, mismatches = 0, calibrated = 0;
+
+        snprintf(config[0], sizeof(config[0]), "/tmp/accel_simple_cal_parity_ref.%d", (int)getpid());
+        snprintf(config[1], sizeof(config[1]), "/tmp/accel_simple_cal_parity_new.%d", (int)getpid());
+        unlink(config[0]);
+        unlink(config[1]);
+
+        /* Calibrator state lives in statics, so the seeds run back to back on one history */
+        for (s = 1; s <= SEEDS; s++) {
+                seed = s;
+                for (n = 0; n < SEED_SAMPLES; n++) {
+                        struct accelerometer_simple_calibration_event_t ref, ev, zref, zev;
+                        int orientation, ret[4];
+
+                        if (hold-- <= 0) {
+                                orientation = uniform(8);
+                                memset(base, 0, sizeof(base));
+                                if (orientation < 6) {
+                                        base[orientation / 2] = (orientation & 1 ? -1 : 1) * GRAVITY_EARTH * (0.95f + 0.1f * unit());
+                                } else {
+                                        for (i = 0; i < ACCEL_AXIS_MAX; i++)
+                                                base[i] = 6 * unit();
+                                }
+                                for (i = 0; i < ACCEL_AXIS_MAX; i++)
+                                        base[i] += 0.3f * (unit() - 0.5f);
+                                hold = uniform(HOLD_MAX);
+                                noise = uniform(3) * 0.15f + 0.05f;
+                        }
+                        for (i = 0; i < ACCEL_AXIS_MAX; i++)
+                                ref.data[i] = base[i] + noise * (unit() - 0.5f) * 2;
+                        ev = zref = zev = ref;
+
+                        if (uniform(RESET_PERIOD) == 0) {
+                                ref_accel_simp_cal_reset();
+                                accel_simp_cal_reset();
+                        }
+                        if (uniform(ZRESET_PERIOD) == 0) {
+                                ref_accel_simp_zcal_reset();
+                                accel_simp_zcal_reset();
+                        }
+
+                        ret[0] = ref_accel_simp_cal_calibration(&ref, config[0]);
+                        ret[1] = accel_simp_cal_calibration(&ev, config[1]);
+                        ret[2] = ref_accel_simp_zcal_calibration(&zref);
+                        ret[3] = accel_simp_zcal_calibration(&zev);
+
+                        if (ret[0] != ret[1] || ret[2] != ret[3] ||
+                            memcmp(ref.data, ev.data, sizeof(ref.data)) != 0 ||
+                            memcmp(zref.data, zev.data, sizeof(zref.data)) != 0)
+                                mismatches++;
+                        if (ret[1] == 0)
+                                calibrated++;
+                }
+        }
+
+        CHECK(mismatches == 0, "%d of %d samples differ from the reference", mismatches, SEEDS * SEED_SAMPLES);
+        /* Parity of two calibrators that never converge proves little */
+        CHECK(calibrated > 0, "the calibration never produced factors");
+
+        for (i = 0; i < 2; i++)
+                storedSize[i] = read_config(config[i], stored[i]);
+        CHECK(storedSize[0] > 0 && storedSize[0] == storedSize[1] &&
+              memcmp(stored[0], stored[1], storedSize[0]) == 0,
+              "stored samples differ from the reference");
+        unlink(config[0]);
+        unlink(config[1]);
+
+        if (failures) {
+                printf("%d check(s) failed\n", failures);
+                return 1;
+        }
+        printf("PASS\n");
+        return 0;
+}
@@ -0,0 +1,126 @@
+# Copyright (C) 2008 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Host side checks and benchmarks of the scalability HAL helpers, each one
+# is a standalone executable that exits non-zero when a check fails:
+#   $ out/host/<os>-x86/bin/sensorhal_timestamp_test
+#   $ out/host/<os>-x86/bin/sensorhal_decode_benchmark
+#   $ out/host/<os>-x86/bin/sensorhal_mat_benchmark
+#   $ out/host/<os>-x86/bin/sensorhal_accel_simple_cal_parity_test
+#   $ out/host/<os>-x86/bin/sensorhal_decimator_test
+#   $ out/host/<os>-x86/bin/sensorhal_psh_stub_test
+LOCAL_PATH := $(call my-dir)
+SENSORHAL_PATH := $(LOCAL_PATH)/..
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := sensorhal_timestamp_test
+LOCAL_MODULE_TAGS := tests
+
+LOCAL_SRC_FILES := TimestampEstimatorTest.cpp \
+                   ../TimestampEstimator.cpp
+
+LOCAL_C_INCLUDES := $(SENSORHAL_PATH)
+
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := sensorhal_decode_benchmark
+LOCAL_MODULE_TAGS := tests
+
+LOCAL_CFLAGS := -DLOG_TAG=\"SensorHubDecodeBenchmark\"
+LOCAL_SRC_FILES := SensorHubDecodeBenchmark.cpp \
+                   ../SensorHubHelper.cpp \
+                   ../SensorDevice.cpp \
+                   ../TimestampEstimator.cpp \
+                   ../utils.cpp
+
+LOCAL_C_INCLUDES := $(SENSORHAL_PATH) \
+                    $(COMMON_INCLUDES) \
+                    $(call include-path-for, libsensorhub)
+
+LOCAL_STATIC_LIBRARIES := libcutils liblog
+
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := sensorhal_mat_benchmark
+LOCAL_MODULE_TAGS := tests
+
+LOCAL_SRC_FILES := MatBenchmark.cpp
+
+# Same header as the legacy tree's mat.h
+LOCAL_C_INCLUDES := $(SENSORHAL_PATH)/sensorcalibration/CompassGenericCalibration
+
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := sensorhal_accel_simple_cal_parity_test
+LOCAL_MODULE_TAGS := tests
+
+ACCEL_SIMPLE_CAL_PATH := ../sensorcalibration/AccelerometerSimpleCalibration
+LOCAL_CFLAGS := -DLOG_TAG=\"AccelSimpleCalibrationParityTest\"
+# The reference implementation is #included by the test, not built on its own
+LOCAL_SRC_FILES := AccelSimpleCalibrationParityTest.c \
+                   $(ACCEL_SIMPLE_CAL_PATH)/accelerometer_simple_calibration.c \
+                   $(ACCEL_SIMPLE_CAL_PATH)/accelerometer_simple_zcalibration.c \
+                   $(ACCEL_SIMPLE_CAL_PATH)/accelerometer_simple_calibration_window.c
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH) \
+                    $(SENSORHAL_PATH)/sensorcalibration/AccelerometerSimpleCalibration
+
+LOCAL_STATIC_LIBRARIES := libcutils liblog
+
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := sensorhal_decimator_test
+LOCAL_MODULE_TAGS := tests
+
+LOCAL_SRC_FILES := SensorHubDecimatorTest.cpp \
+                   ../SensorHubDecimator.cpp
+
+LOCAL_C_INCLUDES := $(SENSORHAL_PATH)
+
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := sensorhal_psh_stub_test
+LOCAL_MODULE_TAGS := tests
+
+LOCAL_CFLAGS := -DLOG_TAG=\"PSHCommonSensorStubTest\"
+LOCAL_SRC_FILES := PSHCommonSensorStubTest.cpp \
+                   ../PSHCommonSensor.cpp \
+                   ../PSHSensor.cpp \
+                   ../Sensor.cpp \
+                   ../SensorDevice.cpp \
+                   ../SensorHubHelper.cpp \
+                   ../SensorHubStream.cpp \
+                   ../SensorHubDecimator.cpp \
+                   ../TimestampEstimator.cpp \
+                   ../utils.cpp
+
+LOCAL_C_INCLUDES := $(SENSORHAL_PATH) \
+                    $(COMMON_INCLUDES) \
+                    $(call include-path-for, libsensorhub)
+
+LOCAL_STATIC_LIBRARIES := libsensorhubstub libcutils liblog
+LOCAL_LDLIBS := -ldl -lpthread
+
+include $(BUILD_HOST_EXECUTABLE)
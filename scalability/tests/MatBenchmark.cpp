@@ -0,0 +1,247 @@
+/*
+ * Checks the fixed size mat.h kernels and cholesky_solve() against the
+ * generic loops they stand in for, then times both.
+ *
+ * The generic doMul() cannot be reached once a size is specialized, so
+ * referenceMul() repeats its loop here. The generic invert() is reached by
+ * naming its template arguments. Exits non-zero when results differ.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "mat.h"
+
+using namespace android;
+
+#define BENCH_INPUTS    64
+#define BENCH_LOOPS     2000000
+#define SOLVE_LOOPS     200000
+/* Rows of the 9 unknown ellipsoid design accumulated into the normal equations */
+#define SOLVE_ROWS      48
+
+static int failures;
+static volatile double sink;
+
+static int64_t elapsed(const struct timespec &start)
+{
+        struct timespec end;
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        return (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
+}
+
+static double uniform()
+{
+        return rand() / static_cast<double>(RAND_MAX) * 2 - 1;
+}
+
+/* The generic helpers::doMul() loop */
+template <typename T, size_t C, size_t R, size_t D>
+static mat<T, C, R> referenceMul(const mat<T, D, R> &lhs, const mat<T, C, D> &rhs)
+{
+        mat<T, C, R> res;
+
+        for (size_t c = 0; c < C; c++) {
+                for (size_t r = 0; r < R; r++) {
+                        T v(0);
+                        for (size_t k = 0; k < D; k++)
+                                v += lhs[k][r] * rhs[c][k];
+                        res[c][r] = v;
+                }
+        }
+        return res;
+}
+
+template <typename T, size_t C, size_t R>
+static void randomize(mat<T, C, R> &m)
+{
+        for (size_t c = 0; c < C; c++)
+                for (size_t r = 0; r < R; r++)
+                        m[c][r] = static_cast<T>(uniform());
+}
+
+template <typename T, size_t C, size_t R>
+static double maxError(const mat<T, C, R> &a, const mat<T, C, R> &b)
+{
+        double worst = 0;
+
+        for (size_t c = 0; c < C; c++) {
+                for (size_t r = 0; r < R; r++) {
+                        double scale = fabs(static_cast<double>(b[c][r])) > 1 ? fabs(static_cast<double>(b[c][r])) : 1;
+                        double error = fabs(static_cast<double>(a[c][r]) - static_cast<double>(b[c][r])) / scale;
+                        if (error > worst)
+                                worst = error;
+                }
+        }
+        return worst;
+}
+
+static void report(const char *name, double error, double tolerance, int64_t fast, int64_t generic, int loops)
+{
+        bool ok = error <= tolerance;
+
+        printf("%-28s %10.2f %10.2f %8.2fx   error %.1e %s\n", name,
+               static_cast<double>(fast) / loops, static_cast<double>(generic) / loops,
+               static_cast<double>(generic) / fast, error, ok ? "" : "FAIL");
+        if (!ok)
+                failures++;
+}
+
+template <typename T, size_t C, size_t D>
+static void benchMul(const char *name, double tolerance)
+{
+        mat<T, D, D> lhs[BENCH_INPUTS];
+        mat<T, C, D> rhs[BENCH_INPUTS];
+        mat<T, C, D> acc;
+        struct timespec start;
+        int64_t fast, generic;
+        double error = 0;
+
+        for (int i = 0; i < BENCH_INPUTS; i++) {
+                randomize(lhs[i]);
+                randomize(rhs[i]);
+                double e = maxError(mat<T, C, D>(lhs[i] * rhs[i]), referenceMul(lhs[i], rhs[i]));
+                if (e > error)
+                        error = e;
+        }
+
+        acc = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < BENCH_LOOPS; i++)
+                acc += lhs[i % BENCH_INPUTS] * rhs[(i + 1) % BENCH_INPUTS];
+        fast = elapsed(start);
+        sink = acc[0][0];
+
+        acc = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < BENCH_LOOPS; i++)
+                acc += referenceMul(lhs[i % BENCH_INPUTS], rhs[(i + 1) % BENCH_INPUTS]);
+        generic = elapsed(start);
+        sink = acc[0][0];
+
+        report(name, error, tolerance, fast, generic, BENCH_LOOPS);
+}
+
+template <typename T>
+static void benchInvert(const char *name, double tolerance)
+{
+        mat<T, 3, 3> src[BENCH_INPUTS];
+        mat<T, 3, 3> acc;
+        struct timespec start;
+        int64_t fast, generic;
+        double error = 0;
+
+        for (int i = 0; i < BENCH_INPUTS; i++) {
+                /* Keep it well conditioned, both paths divide by the pivots */
+                randomize(src[i]);
+                src[i] += mat<T, 3, 3>(3);
+                double e = maxError(invert(src[i]), invert<T, 3>(src[i]));
+                if (e > error)
+                        error = e;
+        }
+
+        acc = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < BENCH_LOOPS; i++)
+                acc += invert(src[i % BENCH_INPUTS]);
+        fast = elapsed(start);
+        sink = acc[0][0];
+
+        acc = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < BENCH_LOOPS; i++)
+                acc += invert<T, 3>(src[i % BENCH_INPUTS]);
+        generic = elapsed(start);
+        sink = acc[0][0];
+
+        report(name, error, tolerance, fast, generic, BENCH_LOOPS);
+}
+
+/* Normal equations of an ellipsoid fit, as CompassCalibration builds them */
+static void ellipsoidSystem(mat<double, 9, 9> &hh, mat<double, 1, 9> &hw)
+{
+        hh = 0;
+        hw = 0;
+        for (int n = 0; n < SOLVE_ROWS; n++) {
+                double u = uniform(), t = uniform() * M_PI, s = sqrt(1 - u * u);
+                double x = 40 * s * cos(t) + 20, y = 50 * s * sin(t) - 15, z = 45 * u + 35;
+                double h[9] = { x * x, y * y, z * z, 2 * x * y, 2 * x * z, 2 * y * z, 2 * x, 2 * y, 2 * z };
+                for (size_t c = 0; c < 9; c++) {
+                        for (size_t r = 0; r < 9; r++)
+                                hh[c][r] += h[c] * h[r];
+                        hw[0][c] += h[c];
+                }
+        }
+}
+
+static void benchSolve()
+{
+        mat<double, 9, 9> hh[BENCH_INPUTS];
+        mat<double, 1, 9> hw[BENCH_INPUTS];
+        mat<double, 1, 9> x, acc;
+        struct timespec start;
+        int64_t fast, generic;
+        double error = 0;
+
+        for (int i = 0; i < BENCH_INPUTS; i++) {
+                ellipsoidSystem(hh[i], hw[i]);
+                if (!cholesky_solve(hh[i], hw[i], x)) {
+                        printf("FAIL cholesky_solve rejected a positive definite system\n");
+                        failures++;
+                        continue;
+                }
+                double e = maxError(x, mat<double, 1, 9>(referenceMul(invert<double, 9>(hh[i]), hw[i])));
+                if (e > error)
+                        error = e;
+        }
+
+        acc = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < SOLVE_LOOPS; i++) {
+                cholesky_solve(hh[i % BENCH_INPUTS], hw[i % BENCH_INPUTS], x);
+                acc += x;
+        }
+        fast = elapsed(start);
+        sink = acc[0][0];
+
+        acc = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < SOLVE_LOOPS; i++)
+                acc += referenceMul(invert<double, 9>(hh[i % BENCH_INPUTS]), hw[i % BENCH_INPUTS]);
+        generic = elapsed(start);
+        sink = acc[0][0];
+
+        /* Relative to the solution scale, the ellipsoid system is badly conditioned */
+        report("9x9 solve vs invert", error, 1e-6, fast, generic, SOLVE_LOOPS);
+
+        /* A degenerate window has to be reported, not solved */
+        hh[0] = 0;
+        hh[0][0][0] = 1;
+        if (cholesky_solve(hh[0], hw[0], x)) {
+                printf("FAIL cholesky_solve accepted a singular system\n");
+                failures++;
+        }
+}
+
+int main()
+{
+        srand(1);
+        printf("%-28s %10s %10s %9s\n", "ns per operation", "fixed", "generic", "speedup");
+        benchMul<float, 3, 3>("3x3 * 3x3 float", 1e-6);
+        benchMul<double, 3, 3>("3x3 * 3x3 double", 1e-15);
+        benchMul<float, 1, 3>("3x3 * 3 float", 1e-6);
+        benchMul<double, 1, 3>("3x3 * 3 double", 1e-15);
+        benchMul<float, 4, 4>("4x4 * 4x4 float", 1e-6);
+        benchMul<double, 4, 4>("4x4 * 4x4 double", 1e-15);
+        benchInvert<float>("3x3 invert float", 1e-5);
+        benchInvert<double>("3x3 invert double", 1e-13);
+        benchSolve();
+
+        if (failures) {
+                printf("%d check(s) failed\n", failures);
+                return 1;
+        }
+        printf("PASS\n");
+        return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Runs a PSHCommonSensor on the host against SensorHubStub, the way the HAL
+ * drives it: the session is opened through the binding, started at the
+ * requested rate, fed records as the hub would and read back through
+ * getData(), then stopped and closed again.
+ *
+ * Once bound the binding keeps its table, a later install() of another one
+ * is refused.
+ */
+#include <stdio.h>
+#include "PSHCommonSensor.hpp"
+#include "SensorHubStub.hpp"
+
+#define HANDLE                  1
+#define MIN_DELAY_US            10000
+#define PERIOD_MS               20
+#define SCALE                   0.5f
+#define RECORDS                 10
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+                printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+                printf(__VA_ARGS__); \
+                printf("\n"); \
+                failures++; \
+        } \
+} while (0)
+
+/* Exposes the session for the stub's bookkeeping */
+class StubbedSensor : public PSHCommonSensor {
+public:
+        StubbedSensor(SensorDevice &device) :PSHCommonSensor(device) {}
+        handle_t getSession() { return sensorHandle; }
+};
+
+static void checkBinding()
+{
+        struct sensor_hub_methods other = SensorHubStub::getMethods();
+
+        other.psh_open_session = NULL;
+        CHECK(!SensorHubBinding::install(other), "binding replaced after first use");
+        CHECK(SensorHubBinding::getMethods().psh_open_session == SensorHubStub::getMethods().psh_open_session,
+              "binding lost the stub");
+}
+
+static void checkSensor(StubbedSensor &sensor)
+{
+        struct compass_raw_data records[RECORDS];
+        sensors_event_t events[RECORDS + 1];
+        int dataRate, bufferDelay, count;
+        int64_t before;
+
+        CHECK(sensor.getPollfd() >= 0, "no poll fd");
+        CHECK(SensorHubStub::getOpenSessions() == 1, "%d sessions open", SensorHubStub::getOpenSessions());
+        handle_t session = sensor.getSession();
+
+        CHECK(sensor.activate(HANDLE, 1) == 0, "activate failed");
+        CHECK(sensor.setDelay(HANDLE, PERIOD_MS * NS_TO_MS) == 0, "setDelay failed");
+        CHECK(SensorHubStub::getStreaming(session, dataRate, bufferDelay), "session not streaming");
+        CHECK(dataRate == 1000 / PERIOD_MS && bufferDelay == 0, "streaming at %d Hz, %d ms buffered", dataRate, bufferDelay);
+
+        for (int i = 0; i < RECORDS; i++) {
+                records[i].ts = 0;
+                records[i].x = 2 * i;
+                records[i].y = -i;
+                records[i].z = 100;
+                records[i].accuracy = 1;
+        }
+        CHECK(SensorHubStub::inject(session, records, sizeof(records)) == sizeof(records), "inject failed");
+
+        before = getTimestamp();
+        CHECK(sensor.getData() == 0, "getData failed");
+        count = sensor.getEventRing().drain(events, RECORDS + 1);
+        CHECK(count == RECORDS, "%d events read", count);
+        for (int i = 0; i < count; i++) {
+                CHECK(events[i].sensor == HANDLE && events[i].type == SENSOR_TYPE_MAGNETIC_FIELD,
+                      "event %d from sensor %d type %d", i, events[i].sensor, events[i].type);
+                CHECK(events[i].data[0] == 2 * i * SCALE && events[i].data[1] == -i * SCALE &&
+                      events[i].data[2] == 100 * SCALE, "event %d: %f %f %f",
+                      i, events[i].data[0], events[i].data[1], events[i].data[2]);
+                CHECK(events[i].magnetic.status == SENSOR_STATUS_ACCURACY_HIGH, "event %d: status %d",
+                      i, events[i].magnetic.status);
+                CHECK(i == 0 || events[i].timestamp > events[i - 1].timestamp, "event %d: timestamp out of order", i);
+        }
+        if (count > 0)
+                CHECK(events[count - 1].timestamp <= getTimestamp() && events[count - 1].timestamp >= before - PERIOD_MS * NS_TO_MS,
+                      "last event stamped %lld, read at %lld", (long long)events[count - 1].timestamp, (long long)before);
+
+        CHECK(sensor.activate(HANDLE, 0) == 0, "deactivate failed");
+        CHECK(!SensorHubStub::getStreaming(session, dataRate, bufferDelay), "session still streaming");
+        CHECK(SensorHubStub::inject(session, records, sizeof(records)) < 0, "stopped session accepted records");
+}
+
+int main()
+{
+        SensorDevice device;
+
+        CHECK(SensorHubBinding::install(SensorHubStub::getMethods()), "stub not installed");
+
+        device.setCategory(LIBSENSORHUB);
+        device.setType(SENSOR_TYPE_MAGNETIC_FIELD);
+        device.setHandle(HANDLE);
+        device.setName("Stub Compass");
+        device.setMinDelay(MIN_DELAY_US);
+        for (int i = AXIS_X; i <= AXIS_Z; i++)
+                device.setScale(i, SCALE);
+
+        {
+                StubbedSensor sensor(device);
+                checkBinding();
+                checkSensor(sensor);
+        }
+        CHECK(SensorHubStub::getOpenSessions() == 0, "%d sessions left open", SensorHubStub::getOpenSessions());
+
+        if (failures) {
+                printf("%d check(s) failed\n", failures);
+                return 1;
+        }
+        printf("PASS\n");
+        return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * Recovers the filter SensorHubDecimator applies for every supported ratio
+ * from its outputs, by pushing an impulse through it at each input phase,
+ * and checks the frequency response against the design: unity gain at DC,
+ * within 1 dB up to 0.4 times the output Nyquist frequency and at least
+ * 40 dB down from the output Nyquist frequency up to the input one.
+ *
+ * A ramp pushed through checks the delay: every output carries the record
+ * of the input its value stands for, getDelay() inputs before the newest
+ * one, which stays under LAG_MAX output periods, and the first output
+ * stands for the first input.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include "SensorHubDecimator.hpp"
+
+struct test_record {
+        int64_t ts;
+        short x, y, z;
+} __attribute__ ((packed));
+
+/* Impulse height that makes an output equal the Q14 tap it went through */
+#define IMPULSE                 16384
+#define PASSBAND_EDGE           0.4     /* relative to the output Nyquist frequency */
+#define PASSBAND_RIPPLE_DB      1.0
+#define STOPBAND_EDGE           1.0
+#define STOPBAND_MIN_DB         40.0
+#define RESPONSE_STEP           0.01
+#define LAG_MAX                 2       /* output periods */
+#define RAMP_SLOPE              8
+#define RAMP_OUTPUTS            16
+/* Outputs of one impulse run, each one ratio inputs apart */
+#define RECOVERED_MAX           (2 * (DECIMATOR_SPAN + 2) * DECIMATOR_MAX_RATIO)
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+                printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+                printf(__VA_ARGS__); \
+                printf("\n"); \
+                failures++; \
+        } \
+} while (0)
+
+/* Gain at f cycles per input sample */
+static double response(const int *h, int count, double f)
+{
+        double re = 0, im = 0;
+
+        for (int n = 0; n < count; n++) {
+                re += h[n] * cos(2 * M_PI * f * n);
+                im -= h[n] * sin(2 * M_PI * f * n);
+        }
+        return sqrt(re * re + im * im) / IMPULSE;
+}
+
+/* Impulse response seen through the outputs, the shift does not matter; returns its length */
+static int recover(unsigned int ratio, int *h, int *taps)
+{
+        /* The impulse comes once every branch it goes through has started */
+        const int impulse = DECIMATOR_SPAN * ratio, length = 2 * (DECIMATOR_SPAN + 1) * ratio;
+        int count = 0, first = RECOVERED_MAX;
+
+        for (int n = 0; n < RECOVERED_MAX; n++)
+                h[n] = 0;
+
+        for (unsigned int phase = 0; phase < ratio; phase++) {
+                SensorHubDecimator decimator;
+                struct test_record in, out;
+                int k = 0;
+
+                if (!decimator.setup(ratio, &DecimatorRecord<struct test_record>::ops, sizeof(in)))
+                        return -1;
+                in.ts = 0;
+                in.y = in.z = 0;
+                for (int i = 0; i < length; i++) {
+                        in.x = i == impulse + static_cast<int>(phase) ? IMPULSE : 0;
+                        if (!decimator.push(reinterpret_cast<const char *>(&in), reinterpret_cast<char *>(&out)))
+                                continue;
+                        int n = k++ * ratio + (ratio - 1 - phase);
+                        if (n < RECOVERED_MAX)
+                                h[n] = out.x;
+                        if (out.x != 0 && n + 1 > count)
+                                count = n + 1;
+                        if (out.x != 0 && n < first)
+                                first = n;
+                }
+        }
+
+        *taps = count - first;
+        return count;
+}
+
+/* Checks a ramp against the delay, returns the inputs an output lags the newest one */
+static int lag(unsigned int ratio)
+{
+        SensorHubDecimator decimator;
+        struct test_record in, out;
+        int length, outputs = 0;
+
+        if (!decimator.setup(ratio, &DecimatorRecord<struct test_record>::ops, sizeof(in)))
+                return -1;
+        length = DECIMATOR_MAX_TAPS + RAMP_OUTPUTS * ratio;
+        in.y = in.z = 0;
+        for (int i = 0; i < length; i++) {
+                in.ts = i;
+                in.x = RAMP_SLOPE * i;
+                if (!decimator.push(reinterpret_cast<const char *>(&in), reinterpret_cast<char *>(&out)))
+                        continue;
+                CHECK(outputs > 0 || out.ts == 0, "ratio %u: first output stands for input %lld", ratio, (long long)out.ts);
+                outputs++;
+                CHECK(i - out.ts == decimator.getDelay(), "ratio %u: output of input %d carries input %lld",
+                      ratio, i, (long long)out.ts);
+                /* The repeated first input bends the ramp until it has left the filter */
+                if (i < DECIMATOR_MAX_TAPS)
+                        continue;
+                CHECK(abs(out.x - RAMP_SLOPE * out.ts) <= RAMP_SLOPE / 2 + 1, "ratio %u: input %lld filtered to %d",
+                      ratio, (long long)out.ts, out.x);
+        }
+
+        return decimator.getDelay();
+}
+
+int main()
+{
+        int h[RECOVERED_MAX];
+        SensorHubDecimator decimator;
+
+        CHECK(!decimator.setup(DECIMATOR_MAX_RATIO + 1, &DecimatorRecord<struct test_record>::ops, sizeof(struct test_record)),
+              "ratio %d accepted", DECIMATOR_MAX_RATIO + 1);
+
+        for (unsigned int ratio = 2; ratio <= DECIMATOR_MAX_RATIO; ratio++) {
+                int taps, count = recover(ratio, h, &taps);
+                double nyquist = 0.5 / ratio, pass = 0, stop = 0, dc;
+
+                CHECK(count > 0, "ratio %u: no filter", ratio);
+                if (count <= 0)
+                        continue;
+
+                dc = response(h, count, 0);
+                for (double f = 0; f <= PASSBAND_EDGE + 1e-9; f += RESPONSE_STEP) {
+                        double db = fabs(20 * log10(response(h, count, f * nyquist)));
+                        if (db > pass)
+                                pass = db;
+                }
+                stop = 1e9;
+                for (double f = STOPBAND_EDGE; f <= ratio + 1e-9; f += RESPONSE_STEP) {
+                        double db = -20 * log10(response(h, count, f * nyquist) + 1e-12);
+                        if (db < stop)
+                                stop = db;
+                }
+                int delay = lag(ratio);
+                printf("ratio %2u: %3d taps, passband %.2f dB, stopband %.1f dB, delay %.2f outputs\n",
+                       ratio, taps, pass, stop, static_cast<double>(delay) / ratio);
+
+                CHECK(fabs(dc - 1) < 1e-9, "ratio %u: DC gain %f", ratio, dc);
+                CHECK(pass <= PASSBAND_RIPPLE_DB, "ratio %u: passband off by %.2f dB", ratio, pass);
+                CHECK(stop >= STOPBAND_MIN_DB, "ratio %u: stopband only %.1f dB down", ratio, stop);
+                CHECK(delay >= 0 && delay < LAG_MAX * static_cast<int>(ratio), "ratio %u: delay of %d inputs", ratio, delay);
+        }
+
+        if (failures) {
+                printf("%d check(s) failed\n", failures);
+                return 1;
+        }
+        printf("PASS\n");
+        return 0;
+}
@@ -0,0 +1,301 @@
+/*
+ * Compares the per session decoder table of SensorHubHelper with the
+ * per read allocation and sensor type switch it replaced.
+ *
+ * Each type is checked for identical events on random records first, then
+ * both paths are timed decoding in memory and reading from /dev/zero.
+ * Exits non-zero only when the decoded events differ.
+ */
+#include <stdio.h>
+#include <fcntl.h>
+#include "PSHCommonSensor.hpp"
+
+#define BENCH_BATCH     SENSORHUB_EVENT_BATCH
+#define BENCH_READS     200000
+
+static int64_t elapsed(const struct timespec &start)
+{
+        struct timespec end;
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        return (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
+}
+
+/* Record size lookup and decoding as done per read before the decoder table */
+static size_t legacyUnitSize(int sensorType)
+{
+        switch (sensorType) {
+        case SENSOR_TYPE_ACCELEROMETER:
+                return sizeof(struct accel_data);
+        case SENSOR_TYPE_MAGNETIC_FIELD:
+                return sizeof(struct compass_raw_data);
+        case SENSOR_TYPE_ORIENTATION:
+                return sizeof(struct orientation_data);
+        case SENSOR_TYPE_GYROSCOPE:
+                return sizeof(struct gyro_raw_data);
+        case SENSOR_TYPE_LIGHT:
+                return sizeof(struct als_raw_data);
+        case SENSOR_TYPE_PRESSURE:
+                return sizeof(struct baro_raw_data);
+        case SENSOR_TYPE_PROXIMITY:
+                return sizeof(struct ps_phy_data);
+        case SENSOR_TYPE_GRAVITY:
+                return sizeof(struct gravity_data);
+        case SENSOR_TYPE_LINEAR_ACCELERATION:
+                return sizeof(struct linear_accel_data);
+        case SENSOR_TYPE_ROTATION_VECTOR:
+                return sizeof(struct rotation_vector_data);
+        case SENSOR_TYPE_STEP_COUNTER:
+                return sizeof(struct stepcounter_data);
+        default:
+                return 0;
+        }
+}
+
+static void legacyDecode(struct SensorDevice &device, byte *stream, struct sensorhub_event_t *events, size_t count)
+{
+        switch (device.getType()) {
+        case SENSOR_TYPE_ACCELEROMETER:
+                for (unsigned int i = 0; i < count; i++) {
+                        events[i].data[0] = (reinterpret_cast<struct accel_data*>(stream))[i].x;
+                        events[i].data[1] = (reinterpret_cast<struct accel_data*>(stream))[i].y;
+                        events[i].data[2] = (reinterpret_cast<struct accel_data*>(stream))[i].z;
+                        events[i].accuracy = SENSOR_STATUS_ACCURACY_MEDIUM;
+                        SensorHubHelper::accelFilter(device, events[i]);
+                }
+                break;
+        case SENSOR_TYPE_MAGNETIC_FIELD:
+                for (unsigned int i = 0; i < count; i++) {
+                        events[i].data[0] = (reinterpret_cast<struct compass_raw_data *>(stream))[i].x;
+                        events[i].data[1] = (reinterpret_cast<struct compass_raw_data *>(stream))[i].y;
+                        events[i].data[2] = (reinterpret_cast<struct compass_raw_data *>(stream))[i].z;
+                        if((reinterpret_cast<struct compass_raw_data *>(stream))[i].accuracy)
+                                events[i].accuracy = SENSOR_STATUS_ACCURACY_HIGH;
+                        else
+                                events[i].accuracy = SENSOR_STATUS_ACCURACY_LOW;
+                }
+                break;
+        case SENSOR_TYPE_ORIENTATION:
+                for (unsigned int i = 0; i < count; i++) {
+                        events[i].data[0] = (reinterpret_cast<struct orientation_data*>(stream))[i].azimuth;
+                        events[i].data[1] = (reinterpret_cast<struct orientation_data*>(stream))[i].pitch;
+                        events[i].data[2] = (reinterpret_cast<struct orientation_data*>(stream))[i].roll;
+                        events[i].accuracy = SENSOR_STATUS_ACCURACY_MEDIUM;
+                }
+                break;
+        case SENSOR_TYPE_GYROSCOPE:
+                for (unsigned int i = 0; i < count; i++) {
+                        events[i].data[0] = (reinterpret_cast<struct gyro_raw_data*>(stream))[i].x;
+                        events[i].data[1] = (reinterpret_cast<struct gyro_raw_data*>(stream))[i].y;
+                        events[i].data[2] = (reinterpret_cast<struct gyro_raw_data*>(stream))[i].z;
+                        if ((reinterpret_cast<struct gyro_raw_data*>(stream))[i].accuracy)
+                                events[i].accuracy = SENSOR_STATUS_ACCURACY_HIGH;
+                        else
+                                events[i].accuracy = SENSOR_STATUS_ACCURACY_LOW;
+                }
+                break;
+        case SENSOR_TYPE_LIGHT:
+                for (unsigned int i = 0; i < count; i++) {
+                        events[i].data[0] = (reinterpret_cast<struct als_raw_data *>(stream))[i].lux;
+                }
+                break;
+        case SENSOR_TYPE_PRESSURE:
+                for (unsigned int i = 0; i < count; i++) {
+                        events[i].data[0] = (reinterpret_cast<struct baro_raw_data*>(stream))[i].p;
+                }
+                break;
+        case SENSOR_TYPE_PROXIMITY:
+                for (unsigned int i = 0; i < count; i++) {
+                        events[i].data[0] = (reinterpret_cast<struct ps_phy_data*>(stream))[i].near == 0 ? 1 : 0;
+                }
+                break;
+        case SENSOR_TYPE_GRAVITY:
+                for (unsigned int i = 0; i < count; i++) {
+                        events[i].data[0] = (reinterpret_cast<struct gravity_data*>(stream))[i].x;
+                        events[i].data[1] = (reinterpret_cast<struct gravity_data*>(stream))[i].y;
+                        events[i].data[2] = (reinterpret_cast<struct gravity_data*>(stream))[i].z;
+                        events[i].accuracy = SENSOR_STATUS_ACCURACY_MEDIUM;
+                }
+                break;
+        case SENSOR_TYPE_LINEAR_ACCELERATION:
+                for (unsigned int i = 0; i < count; i++) {
+                        events[i].data[0] = (reinterpret_cast<struct linear_accel_data*>(stream))[i].x;
+                        events[i].data[1] = (reinterpret_cast<struct linear_accel_data*>(stream))[i].y;
+                        events[i].data[2] = (reinterpret_cast<struct linear_accel_data*>(stream))[i].z;
+                        events[i].accuracy = SENSOR_STATUS_ACCURACY_MEDIUM;
+                }
+                break;
+        case SENSOR_TYPE_ROTATION_VECTOR:
+                for (unsigned int i = 0; i < count; i++) {
+                        events[i].data[0] = (reinterpret_cast<struct rotation_vector_data*>(stream))[i].x;
+                        events[i].data[1] = (reinterpret_cast<struct rotation_vector_data*>(stream))[i].y;
+                        events[i].data[2] = (reinterpret_cast<struct rotation_vector_data*>(stream))[i].z;
+                        events[i].data[3] = (reinterpret_cast<struct rotation_vector_data*>(stream))[i].w;
+                }
+                break;
+        case SENSOR_TYPE_STEP_COUNTER:
+                for (unsigned int i = 0; i < count; i++) {
+                        events[i].step_counter = ((reinterpret_cast<struct stepcounter_data*>(stream))[i]).num;
+                }
+                break;
+        default:
+                break;
+        }
+}
+
+/* The read path before the decoder table, without timestamping */
+static ssize_t legacyRead(struct SensorDevice &device, int fd, struct sensorhub_event_t *events, size_t count)
+{
+        size_t unitSize = legacyUnitSize(device.getType());
+        size_t streamSize = unitSize * count;
+        byte* stream = new byte[streamSize];
+
+        streamSize = read(fd, reinterpret_cast<void *>(stream), streamSize);
+        if (streamSize % unitSize != 0) {
+                delete[] stream;
+                return -1;
+        }
+
+        count = streamSize / unitSize;
+        legacyDecode(device, stream, events, count);
+        delete[] stream;
+
+        return count;
+}
+
+/* The read path with the decoder table, without timestamping */
+static ssize_t tableRead(struct SensorDevice &device, int fd, struct sensorhub_stream_t &stream,
+                         struct sensorhub_event_t *events, size_t count)
+{
+        ssize_t streamSize = read(fd, reinterpret_cast<void *>(stream.buffer), stream.unitSize * count);
+
+        if (streamSize < 0 || streamSize % stream.unitSize != 0)
+                return -1;
+
+        count = streamSize / stream.unitSize;
+        stream.decode(device, stream.buffer, events, count);
+
+        return count;
+}
+
+static const struct {
+        int type;
+        const char *name;
+} benchTypes[] = {
+        { SENSOR_TYPE_ACCELEROMETER, "accelerometer" },
+        { SENSOR_TYPE_MAGNETIC_FIELD, "magnetic field" },
+        { SENSOR_TYPE_ORIENTATION, "orientation" },
+        { SENSOR_TYPE_GYROSCOPE, "gyroscope" },
+        { SENSOR_TYPE_LIGHT, "light" },
+        { SENSOR_TYPE_PRESSURE, "pressure" },
+        { SENSOR_TYPE_PROXIMITY, "proximity" },
+        { SENSOR_TYPE_GRAVITY, "gravity" },
+        { SENSOR_TYPE_LINEAR_ACCELERATION, "linear acceleration" },
+        { SENSOR_TYPE_ROTATION_VECTOR, "rotation vector" },
+        { SENSOR_TYPE_STEP_COUNTER, "step counter" },
+};
+
+static bool checkType(struct SensorDevice &device, struct sensorhub_stream_t &stream)
+{
+        static byte records[BENCH_BATCH * 64];
+        struct sensorhub_event_t legacy[BENCH_BATCH], table[BENCH_BATCH];
+
+        for (size_t i = 0; i < stream.unitSize * BENCH_BATCH; i++)
+                records[i] = static_cast<byte>(rand());
+
+        memset(legacy, 0, sizeof(legacy));
+        memset(table, 0, sizeof(table));
+        /*
+         * accelFilter() keeps its state in statics. Decoding each record with
+         * both paths in turn leaves the second one the state it would have
+         * had on its own: a record the first one accepted is passed through
+         * again, a rejected one leaves the state unchanged.
+         */
+        for (size_t i = 0; i < BENCH_BATCH; i++) {
+                legacyDecode(device, records + i * stream.unitSize, legacy + i, 1);
+                stream.decode(device, records + i * stream.unitSize, table + i, 1);
+        }
+
+        return memcmp(legacy, table, sizeof(legacy)) == 0;
+}
+
+int main()
+{
+        struct sensorhub_event_t events[BENCH_BATCH];
+        byte records[BENCH_BATCH * 64];
+        int failures = 0;
+        int fd;
+
+        fd = open("/dev/zero", O_RDONLY);
+        if (fd < 0) {
+                perror("/dev/zero");
+                return 1;
+        }
+        memset(records, 0, sizeof(records));
+
+        printf("%-20s %14s %14s %14s %14s\n", "ns per record", "decode old", "decode table",
+               "read old", "read table");
+        for (size_t t = 0; t < sizeof(benchTypes) / sizeof(benchTypes[0]); t++) {
+                struct SensorDevice device;
+                struct sensorhub_stream_t stream;
+                struct timespec start;
+                int64_t decodeOld, decodeTable, readOld, readTable;
+
+                device.setType(benchTypes[t].type);
+                /* mg per LSB, accelFilter() derives its dead band from it */
+                device.setScale(AXIS_X, 0.001);
+                if (!SensorHubHelper::initStream(benchTypes[t].type, stream, BENCH_BATCH)) {
+                        printf("FAIL %s: no decoder\n", benchTypes[t].name);
+                        failures++;
+                        continue;
+                }
+                if (stream.unitSize != legacyUnitSize(benchTypes[t].type) || !checkType(device, stream)) {
+                        printf("FAIL %s: decoded events differ\n", benchTypes[t].name);
+                        failures++;
+                }
+
+                /* In memory: allocation and type switch per read against the table */
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                for (int i = 0; i < BENCH_READS; i++) {
+                        byte *buffer = new byte[legacyUnitSize(device.getType()) * BENCH_BATCH];
+                        memcpy(buffer, records, legacyUnitSize(device.getType()) * BENCH_BATCH);
+                        legacyDecode(device, buffer, events, BENCH_BATCH);
+                        delete[] buffer;
+                }
+                decodeOld = elapsed(start);
+
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                for (int i = 0; i < BENCH_READS; i++) {
+                        memcpy(stream.buffer, records, stream.unitSize * BENCH_BATCH);
+                        stream.decode(device, stream.buffer, events, BENCH_BATCH);
+                }
+                decodeTable = elapsed(start);
+
+                /* Through read(2), as the session fds are read */
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                for (int i = 0; i < BENCH_READS; i++)
+                        legacyRead(device, fd, events, BENCH_BATCH);
+                readOld = elapsed(start);
+
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                for (int i = 0; i < BENCH_READS; i++)
+                        tableRead(device, fd, stream, events, BENCH_BATCH);
+                readTable = elapsed(start);
+
+                printf("%-20s %14.2f %14.2f %14.2f %14.2f\n", benchTypes[t].name,
+                       static_cast<double>(decodeOld) / (BENCH_READS * BENCH_BATCH),
+                       static_cast<double>(decodeTable) / (BENCH_READS * BENCH_BATCH),
+                       static_cast<double>(readOld) / (BENCH_READS * BENCH_BATCH),
+                       static_cast<double>(readTable) / (BENCH_READS * BENCH_BATCH));
+
+                SensorHubHelper::releaseStream(stream);
+        }
+        close(fd);
+
+        if (failures) {
+                printf("%d type(s) failed\n", failures);
+                return 1;
+        }
+        printf("PASS\n");
+        return 0;
+}
@@ -0,0 +1,195 @@
+/*
+ * Replays synthetic sensor hub delivery traces through TimestampEstimator
+ * and checks the jitter of the reconstructed sample times against the
+ * even spread over the last read interval the HAL used before.
+ *
+ * Traces are 100 Hz streams with a 200 ppm clock drift, delivered in
+ * batches of 1 to 5 samples with 0 to 4 ms of random latency.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include "TimestampEstimator.hpp"
+
+#define PERIOD_NS       10000000LL
+#define DRIFT_PPM       200
+#define LATENCY_NS      4000000LL
+#define BATCH_MAX       5
+#define TRACE_SAMPLES   20000
+#define STALL_NS        500000000LL
+
+/* Estimated timestamps must jitter at least this much less than the even spread */
+#define JITTER_GAIN_MIN         3
+/* rms interval error bounds, ns */
+#define JITTER_MAX_NS           500000
+#define JITTER_HUB_MAX_NS       50000
+/* Distance from the true sample time once settled after a stall, ns */
+#define RESYNC_ERROR_MAX_NS     (PERIOD_NS + LATENCY_NS)
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+                printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+                printf(__VA_ARGS__); \
+                printf("\n"); \
+                failures++; \
+        } \
+} while (0)
+
+static uint32_t seed;
+
+static int64_t uniform(int64_t range)
+{
+        seed = seed * 1664525 + 1013904223;
+        return static_cast<int64_t>(seed >> 8) % range;
+}
+
+struct Trace {
+        int64_t sample[TRACE_SAMPLES];  /* true CLOCK_MONOTONIC time of each sample */
+        int64_t hub[TRACE_SAMPLES];     /* time stamped by the drifting hub clock */
+        int64_t arrival[TRACE_SAMPLES]; /* read time of the batch holding the sample */
+        int64_t start;
+};
+
+static void makeTrace(struct Trace &trace, int64_t stallAt)
+{
+        int64_t period = PERIOD_NS + PERIOD_NS * DRIFT_PPM / 1000000;
+        int64_t t = 1000000000LL;
+        int i = 0;
+
+        trace.start = t;
+        while (i < TRACE_SAMPLES) {
+                int batch = 1 + uniform(BATCH_MAX);
+                int64_t arrival;
+                int first = i;
+
+                for (; i < TRACE_SAMPLES && i - first < batch; i++) {
+                        if (i == stallAt)
+                                t += STALL_NS;
+                        t += period;
+                        trace.sample[i] = t;
+                        /* Hub clock runs at the nominal rate with an arbitrary epoch */
+                        trace.hub[i] = 5000000LL + (t - trace.start) * 1000000 / (1000000 + DRIFT_PPM);
+                }
+                arrival = t + uniform(LATENCY_NS);
+                for (int j = first; j < i; j++)
+                        trace.arrival[j] = arrival;
+        }
+}
+
+struct Result {
+        double jitter;          /* rms of interval error against the true interval, ns */
+        int64_t settledError;   /* worst distance from the true time after settling, ns */
+        bool monotonic;
+        bool causal;            /* never stamped after the sample was read */
+};
+
+/* mode 0: even spread over the read interval, 1: estimator, 2: estimator with hub stamps */
+static void replay(const struct Trace &trace, int mode, int settleFrom, struct Result &result)
+{
+        static int64_t ts[TRACE_SAMPLES];
+        TimestampEstimator estimator;
+        int64_t last = trace.start;
+        double sum = 0;
+        int i = 0;
+
+        estimator.reset(trace.start, PERIOD_NS);
+        while (i < TRACE_SAMPLES) {
+                int64_t now = trace.arrival[i];
+                int count = 0;
+
+                while (i + count < TRACE_SAMPLES && trace.arrival[i + count] == now)
+                        count++;
+
+                if (mode == 0) {
+                        int64_t step = (now - last) / count;
+                        for (int j = 0; j < count; j++)
+                                ts[i + j] = last + step * (j + 1);
+                        last = now;
+                } else {
+                        int64_t hub = mode == 2 ? trace.hub[i + count - 1] : 0;
+                        estimator.update(now, count, hub);
+                        for (int j = 0; j < count; j++)
+                                ts[i + j] = estimator.next(mode == 2 ? trace.hub[i + j] : 0);
+                }
+                i += count;
+        }
+
+        result.monotonic = true;
+        result.causal = true;
+        result.settledError = 0;
+        for (i = 0; i < TRACE_SAMPLES; i++) {
+                int64_t error = ts[i] - trace.sample[i];
+
+                if (ts[i] > trace.arrival[i])
+                        result.causal = false;
+                if (i > 0 && ts[i] <= ts[i - 1])
+                        result.monotonic = false;
+                if (i >= settleFrom) {
+                        if (error < 0)
+                                error = -error;
+                        if (error > result.settledError)
+                                result.settledError = error;
+                }
+                if (i > 0) {
+                        double d = static_cast<double>((ts[i] - ts[i - 1]) - (trace.sample[i] - trace.sample[i - 1]));
+                        sum += d * d;
+                }
+        }
+        result.jitter = sqrt(sum / (TRACE_SAMPLES - 1));
+}
+
+static struct Trace trace;
+
+static void testSteadyStream()
+{
+        struct Result spread, estimated, stamped;
+
+        seed = 1;
+        makeTrace(trace, -1);
+        replay(trace, 0, 0, spread);
+        replay(trace, 1, 0, estimated);
+        replay(trace, 2, 0, stamped);
+
+        printf("steady: jitter spread %.0f ns, estimated %.0f ns, hub stamped %.0f ns\n",
+               spread.jitter, estimated.jitter, stamped.jitter);
+
+        CHECK(estimated.monotonic && estimated.causal, "estimated timestamps out of order or ahead of arrival");
+        CHECK(stamped.monotonic && stamped.causal, "hub stamped timestamps out of order or ahead of arrival");
+        CHECK(estimated.jitter < JITTER_MAX_NS, "estimated jitter %.0f ns", estimated.jitter);
+        CHECK(estimated.jitter * JITTER_GAIN_MIN < spread.jitter,
+              "estimated jitter %.0f ns not below spread %.0f ns / %d", estimated.jitter, spread.jitter, JITTER_GAIN_MIN);
+        CHECK(stamped.jitter < JITTER_HUB_MAX_NS, "hub stamped jitter %.0f ns", stamped.jitter);
+}
+
+static void testStall()
+{
+        struct Result estimated;
+        int stallAt = TRACE_SAMPLES / 2;
+
+        seed = 2;
+        makeTrace(trace, stallAt);
+        /* Allow a second of samples to absorb the phase after the stall */
+        replay(trace, 1, stallAt + 100, estimated);
+
+        printf("stall: jitter %.0f ns, settled error %lld ns\n",
+               estimated.jitter, static_cast<long long>(estimated.settledError));
+
+        CHECK(estimated.monotonic && estimated.causal, "timestamps out of order or ahead of arrival");
+        CHECK(estimated.settledError < RESYNC_ERROR_MAX_NS,
+              "error %lld ns after resync", static_cast<long long>(estimated.settledError));
+}
+
+int main()
+{
+        testSteadyStream();
+        testStall();
+
+        if (failures) {
+                printf("%d check(s) failed\n", failures);
+                return 1;
+        }
+        printf("PASS\n");
+        return 0;
+}
@@ -0,0 +1,35 @@
+# Copyright (C) 2008 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+# Installs the precompiled sensor_hal_config_*.bin next to every XML listed
+# in SENSOR_HAL_CONFIG_XML, compiled by the sensor_hal_config_compiler host
+# module of the HAL being built. The HAL maps the .bin at open and only parses
+# the XML when no .bin is installed.
+
+ifneq ($(SENSOR_HAL_CONFIG_XML),)
+
+SENSOR_HAL_CONFIG_COMPILER := $(HOST_OUT_EXECUTABLES)/sensor_hal_config_compiler$(HOST_EXECUTABLE_SUFFIX)
+
+define sensor-hal-config-blob
+$(TARGET_OUT_ETC)/$(basename $(notdir $(1))).bin: $(1) $(SENSOR_HAL_CONFIG_COMPILER)
+	@echo "Sensor HAL config: $$@"
+	@mkdir -p $$(dir $$@)
+	$(hide) $(SENSOR_HAL_CONFIG_COMPILER) $(1) $$@
+ALL_DEFAULT_INSTALLED_MODULES += $(TARGET_OUT_ETC)/$(basename $(notdir $(1))).bin
+endef
+
+$(foreach xml,$(SENSOR_HAL_CONFIG_XML),$(eval $(call sensor-hal-config-blob,$(xml))))
+
+endif
@@ -14,16 +14,127 @@
  * limitations under the License.
  */
 
+#include <pthread.h>
 #include "sensors.h"
+#include "EventLoop.h"
+#include "FusionSensor.h"
 
 static int open_sensors(const struct hw_module_t* module, const char* id,
                         struct hw_device_t** device);
 
+/*
+ * Virtual sensors computed in the HAL from the raw accelerometer, gyroscope
+ * and compass, see SensorFusion.h. They are listed after the platform
+ * sensors when the platform has the raw sensors they need.
+ */
+static const struct fusion_sensor_desc {
+    int handle;
+    int type;
+    const char *name;
+    bool needsMag;
+} fusion_sensors[] = {
+    { SENSORS_HANDLE_ORIENTATION, SENSOR_TYPE_ORIENTATION, "Orientation Sensor", true },
+    { SENSORS_HANDLE_GRAVITY, SENSOR_TYPE_GRAVITY, "Gravity Sensor", false },
+    { SENSORS_HANDLE_LINEAR_ACCELERATION, SENSOR_TYPE_LINEAR_ACCELERATION, "Linear Acceleration Sensor", false },
+    { SENSORS_HANDLE_ROTATION_VECTOR, SENSOR_TYPE_ROTATION_VECTOR, "Rotation Vector Sensor", true },
+};
+
+#define FUSION_SENSOR_COUNT ARRAY_SIZE(fusion_sensors)
+
+static bool is_fusion_handle(int handle)
+{
+    for (size_t i = 0; i < FUSION_SENSOR_COUNT; i++) {
+        if (fusion_sensors[i].handle == handle)
+            return true;
+    }
+    return false;
+}
+
+static struct sensor_t *sensor_list_all;
+static int sensor_count_all;
+static sensor_platform_config_t fusion_configs[FUSION_SENSOR_COUNT];
+
+static const struct sensor_t* find_sensor(const struct sensor_t *list, int num, int handle)
+{
+    for (int i = 0; i < num; i++) {
+        if (list[i].handle == handle)
+            return &list[i];
+    }
+    return NULL;
+}
+
+/* Platform sensors followed by the virtual ones */
+static const struct sensor_t* get_sensor_list(int *num)
+{
+    const struct sensor_t *platform, *accel, *gyro, *mag;
+    int platform_num;
+
+    *num = 0;
+    if (sensor_list_all) {
+        *num = sensor_count_all;
+        return sensor_list_all;
+    }
+
+    platform = get_platform_sensor_list(&platform_num);
+    if (!platform)
+        return NULL;
+
+    sensor_list_all = (struct sensor_t *)calloc(platform_num + FUSION_SENSOR_COUNT, sizeof(struct sensor_t));
+    if (!sensor_list_all) {
+        E("malloc error!");
+        *num = platform_num;
+        return platform;
+    }
+    memcpy(sensor_list_all, platform, platform_num * sizeof(struct sensor_t));
+    sensor_count_all = platform_num;
+
+    accel = find_sensor(platform, platform_num, SENSORS_HANDLE_ACCELEROMETER);
+    gyro = find_sensor(platform, platform_num, SENSORS_HANDLE_GYROSCOPE);
+    mag = find_sensor(platform, platform_num, SENSORS_HANDLE_MAGNETIC_FIELD);
+
+    for (size_t i = 0; accel && gyro && i < FUSION_SENSOR_COUNT; i++) {
+        const struct fusion_sensor_desc &desc = fusion_sensors[i];
+
+        if (desc.needsMag && !mag)
+            continue;
+
+        struct sensor_t &item = sensor_list_all[sensor_count_all++];
+        item.name = desc.name;
+        item.vendor = accel->vendor;
+        item.version = 1;
+        item.handle = desc.handle;
+        item.type = desc.type;
+        item.minDelay = gyro->minDelay;
+        item.power = accel->power + gyro->power + (desc.needsMag ? mag->power : 0);
+        switch (desc.type) {
+        case SENSOR_TYPE_ORIENTATION:
+            item.maxRange = 360.0f;
+            item.resolution = 1.0f / 256.0f;
+            break;
+        case SENSOR_TYPE_ROTATION_VECTOR:
+            item.maxRange = 1.0f;
+            item.resolution = 1.0f / (1 << 24);
+            break;
+        default:
+            item.maxRange = accel->maxRange;
+            item.resolution = accel->resolution;
+            break;
+        }
+
+        fusion_configs[i].handle = desc.handle;
+        fusion_configs[i].name = desc.name;
+        fusion_configs[i].min_delay = gyro->minDelay * 1000;
+    }
+
+    *num = sensor_count_all;
+    return sensor_list_all;
+}
+
 static int sensors_get_sensors_list(struct sensors_module_t* module,
                                      struct sensor_t const** list)
 {
         int sensor_num;
-        *list = get_platform_sensor_list(&sensor_num);
+        *list = get_sensor_list(&sensor_num);
         return sensor_num;
 }
 
@@ -56,54 +167,86 @@ struct sensors_poll_context_t {
     int pollEvents(sensors_event_t* data, int count);
 
 private:
-    size_t wake;
-    static const char WAKE_MESSAGE = 'W';
-    struct pollfd mPollFds[SENSORS_HANDLE_MAX + 1]; // plus 1 for wakefd
-    int mWritePipeFd;
+    void markReady(SensorBase* sensor);
+    bool fusionUses(int handle) const;
+    int updateRaw(int handle);
+    int updateRawDelay(int handle);
+    void updateFusion();
+    int feedFusion(sensors_event_t* data, int count);
+    int readFusion(sensors_event_t* data, int count);
+
+    EventLoop mLoop;
+    /*
+     * Taken by activate()/setDelay() on the framework thread and by the poll
+     * thread around the fusion: protects mEnabled, mRunning, mDelay, the
+     * fusion state and the FusionSensor queues.
+     */
+    pthread_mutex_t mLock;
     int mNumSensors;
     SensorBase* mSensors[SENSORS_HANDLE_MAX + 1]; // reserved 0 for SENSORS_HANDLE_BASE
+    /* as requested by the framework, raw sensors also run for the fusion */
+    bool mEnabled[SENSORS_HANDLE_MAX + 1];
+    int64_t mDelay[SENSORS_HANDLE_MAX + 1];   /* -1 until set */
+    bool mRunning[SENSORS_HANDLE_MAX + 1];
+    SensorFusion mFusion;
+    FusionSensor* mFusionSensors[FUSION_SENSOR_COUNT];
+    int mNumFusion;
+    bool mFusionActive;
+    bool mFusionMag;
+    /* sensors that have data or pending events to be read, touched by the poll thread only */
+    SensorBase* mReady[SENSORS_HANDLE_MAX + 1];
+    int mNumReady;
     const struct sensor_t *sensor_list;
 };
 
 sensors_poll_context_t::sensors_poll_context_t()
+    : mNumFusion(0),
+      mFusionActive(false),
+      mFusionMag(false),
+      mNumReady(0)
 {
-    sensor_list = get_platform_sensor_list(&mNumSensors);
+    int platform_num;
+
+    pthread_mutex_init(&mLock, NULL);
+    memset(mSensors, 0, sizeof(mSensors));
+    memset(mEnabled, 0, sizeof(mEnabled));
+    memset(mRunning, 0, sizeof(mRunning));
+    for (int i = 0; i <= SENSORS_HANDLE_MAX; i++)
+        mDelay[i] = -1;
+
+    sensor_list = get_sensor_list(&mNumSensors);
+    get_platform_sensor_list(&platform_num);
 
     SensorBase **sensors = get_platform_sensors();
     if (!sensors) {
         LOGE("Get platform sensors error!");
+        mNumSensors = 0;
         return;
     }
 
-    for (int i = 0; i < mNumSensors; i++) {
+    for (int i = 0; i < platform_num; i++) {
         int handle = sensor_list[i].handle;
         mSensors[handle] = sensors[i];
-
-        mPollFds[i].fd = mSensors[handle]->getFd();
-        mPollFds[i].events = POLLIN;
-        mPollFds[i].revents = 0;
     }
 
-    wake = mNumSensors;
-    int wakeFds[2];
-    int result = pipe(wakeFds);
-    LOGE_IF(result<0, "error creating wake pipe (%s)", strerror(errno));
-    fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
-    fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
-    mWritePipeFd = wakeFds[1];
+    for (int i = platform_num; i < mNumSensors; i++) {
+        int handle = sensor_list[i].handle;
+        for (size_t j = 0; j < FUSION_SENSOR_COUNT; j++) {
+            if (fusion_sensors[j].handle != handle)
+                continue;
+            mFusionSensors[mNumFusion] = new FusionSensor(&fusion_configs[j], fusion_sensors[j].type, mFusion);
+            mSensors[handle] = mFusionSensors[mNumFusion++];
+        }
+    }
 
-    mPollFds[wake].fd = wakeFds[0];
-    mPollFds[wake].events = POLLIN;
-    mPollFds[wake].revents = 0;
+    LOGE_IF(!mLoop.isValid(), "error creating sensor event loop");
 }
 
 sensors_poll_context_t::~sensors_poll_context_t()
 {
     for (int i = 0 ; i < mNumSensors; i++)
         delete mSensors[sensor_list[i].handle];
-
-    close(mPollFds[wake].fd);
-    close(mWritePipeFd);
+    pthread_mutex_destroy(&mLock);
 }
 
 int sensors_poll_context_t::activate(int handle, int enabled)
@@ -114,12 +257,25 @@ int sensors_poll_context_t::activate(int handle, int enabled)
     if (handle <= SENSORS_HANDLE_BASE || handle > SENSORS_HANDLE_MAX)
         return (handle > 0 ? -handle : handle);
 
-    int err =  mSensors[handle]->enable(handle, enabled);
-    if (enabled && !err) {
-        const char wakeMessage(WAKE_MESSAGE);
-        int result = write(mWritePipeFd, &wakeMessage, 1);
-        LOGE_IF(result < 0, "error sending wake message (%s)", strerror(errno));
+    SensorBase* const sensor(mSensors[handle]);
+    if (!sensor)
+        return -EINVAL;
+
+    pthread_mutex_lock(&mLock);
+    int err;
+    if (is_fusion_handle(handle)) {
+        /* virtual sensor, runs the raw ones it is computed from */
+        err = sensor->enable(handle, enabled);
+        if (!err)
+            updateFusion();
+    } else {
+        bool was = mEnabled[handle];
+        mEnabled[handle] = enabled;
+        err = updateRaw(handle);
+        if (err)
+            mEnabled[handle] = was;
     }
+    pthread_mutex_unlock(&mLock);
     return err;
 }
 
@@ -128,47 +284,242 @@ int sensors_poll_context_t::setDelay(int handle, int64_t ns)
     if (handle <= SENSORS_HANDLE_BASE || handle > SENSORS_HANDLE_MAX)
         return (handle > 0 ? -handle : handle);
 
-    return mSensors[handle]->setDelay(handle, ns);
+    SensorBase* const sensor(mSensors[handle]);
+    if (!sensor)
+        return -EINVAL;
+
+    pthread_mutex_lock(&mLock);
+    int err = 0;
+    if (is_fusion_handle(handle)) {
+        sensor->setDelay(handle, ns);
+        updateRawDelay(SENSORS_HANDLE_ACCELEROMETER);
+        updateRawDelay(SENSORS_HANDLE_GYROSCOPE);
+        updateRawDelay(SENSORS_HANDLE_MAGNETIC_FIELD);
+    } else {
+        mDelay[handle] = ns;
+        err = updateRawDelay(handle);
+    }
+    pthread_mutex_unlock(&mLock);
+    return err;
+}
+
+bool sensors_poll_context_t::fusionUses(int handle) const
+{
+    if (!mFusionActive)
+        return false;
+    return handle == SENSORS_HANDLE_ACCELEROMETER || handle == SENSORS_HANDLE_GYROSCOPE ||
+           (handle == SENSORS_HANDLE_MAGNETIC_FIELD && mFusionMag);
+}
+
+/* Run a raw sensor while the framework or the fusion needs it */
+int sensors_poll_context_t::updateRaw(int handle)
+{
+    SensorBase* const sensor(mSensors[handle]);
+    bool run = mEnabled[handle] || fusionUses(handle);
+
+    if (!sensor)
+        return -EINVAL;
+
+    if (run != mRunning[handle]) {
+        int err = sensor->enable(handle, run);
+        if (err)
+            return err;
+        mRunning[handle] = run;
+
+        /* only running sensors are watched by the event loop */
+        if (run) {
+            mLoop.add(sensor->getFd(), sensor);
+            /* let pollEvents() pick up events queued by enable() */
+            mLoop.wake();
+        } else {
+            mLoop.remove(sensor->getFd());
+        }
+    }
+
+    updateRawDelay(handle);
+    return 0;
+}
+
+/* The fastest of the framework and the fusion rates */
+int sensors_poll_context_t::updateRawDelay(int handle)
+{
+    SensorBase* const sensor(mSensors[handle]);
+    int64_t delay = mEnabled[handle] ? mDelay[handle] : -1;
+
+    if (!sensor)
+        return 0;
+
+    if (fusionUses(handle)) {
+        for (int i = 0; i < mNumFusion; i++) {
+            int64_t ns = mFusionSensors[i]->getDelay();
+            if (mFusionSensors[i]->isEnabled() && (delay < 0 || ns < delay))
+                delay = ns;
+        }
+    }
+
+    /* not running yet: the rate the framework set up front, if any */
+    if (delay < 0)
+        delay = mDelay[handle];
+    if (delay < 0)
+        return 0;
+
+    return sensor->setDelay(handle, delay);
+}
+
+void sensors_poll_context_t::updateFusion()
+{
+    bool active = false, mag = false;
+
+    for (int i = 0; i < mNumFusion; i++) {
+        if (!mFusionSensors[i]->isEnabled())
+            continue;
+        active = true;
+        if (mFusionSensors[i]->getType() == SENSOR_TYPE_ORIENTATION ||
+            mFusionSensors[i]->getType() == SENSOR_TYPE_ROTATION_VECTOR)
+            mag = true;
+    }
+
+    if (active != mFusionActive || mag != mFusionMag)
+        mFusion.reset(mag);
+    mFusionActive = active;
+    mFusionMag = mag;
+
+    updateRaw(SENSORS_HANDLE_ACCELEROMETER);
+    updateRaw(SENSORS_HANDLE_GYROSCOPE);
+    if (mSensors[SENSORS_HANDLE_MAGNETIC_FIELD])
+        updateRaw(SENSORS_HANDLE_MAGNETIC_FIELD);
+}
+
+/*
+ * Hand raw events to the fusion and drop those of sensors that only run for
+ * it. Returns the number of events left for the framework. Called with
+ * mLock held, like readFusion().
+ */
+int sensors_poll_context_t::feedFusion(sensors_event_t* data, int count)
+{
+    int kept = 0;
+
+    for (int i = 0; i < count; i++) {
+        const sensors_event_t &event = data[i];
+
+        switch (event.type) {
+        case SENSOR_TYPE_ACCELEROMETER:
+            mFusion.handleAccel(event.data);
+            break;
+        case SENSOR_TYPE_MAGNETIC_FIELD:
+            mFusion.handleMag(event.data);
+            break;
+        case SENSOR_TYPE_GYROSCOPE:
+            if (mFusion.handleGyro(event.data, event.timestamp)) {
+                for (int j = 0; j < mNumFusion; j++)
+                    mFusionSensors[j]->publish(event.timestamp);
+            }
+            break;
+        }
+
+        if (event.sensor > SENSORS_HANDLE_BASE && event.sensor <= SENSORS_HANDLE_MAX &&
+            !mEnabled[event.sensor])
+            continue;
+        if (kept != i)
+            data[kept] = event;
+        kept++;
+    }
+
+    return kept;
+}
+
+int sensors_poll_context_t::readFusion(sensors_event_t* data, int count)
+{
+    int total = 0;
+
+    for (int i = 0; count && i < mNumFusion; i++) {
+        if (!mFusionSensors[i]->hasPendingEvents())
+            continue;
+        int nb = mFusionSensors[i]->readEvents(data, count);
+        if (nb > 0) {
+            count -= nb;
+            total += nb;
+            data += nb;
+        }
+    }
+
+    return total;
+}
+
+void sensors_poll_context_t::markReady(SensorBase* sensor)
+{
+    for (int i = 0; i < mNumReady; i++) {
+        if (mReady[i] == sensor)
+            return;
+    }
+    mReady[mNumReady++] = sensor;
 }
 
 int sensors_poll_context_t::pollEvents(sensors_event_t* data, int count)
 {
+    void* owners[SENSORS_HANDLE_MAX + 1];
     int nbEvents = 0;
     int n = 0;
 
     do {
-        /* see if we have some leftover from the last poll() */
-        for (int i = 0; count && i < mNumSensors; i++) {
-            SensorBase* const sensor(mSensors[sensor_list[i].handle]);
-            if ((mPollFds[i].revents & POLLIN) || sensor->hasPendingEvents()) {
+        /* see if we have some leftover from the last wait() */
+        int kept = 0;
+        for (int i = 0; i < mNumReady; i++) {
+            SensorBase* const sensor(mReady[i]);
+            if (count) {
                 int nb = sensor->readEvents(data, count);
-                if (nb < count) {
-                    /* no more data or error for this sensor */
-                    mPollFds[i].revents = 0;
-                    if (nb < 0)
-                        continue;
+                /* no more data or error for this sensor */
+                bool drained = nb < count && !sensor->hasPendingEvents();
+                if (nb > 0) {
+                    pthread_mutex_lock(&mLock);
+                    if (mFusionActive)
+                        nb = feedFusion(data, nb);
+                    pthread_mutex_unlock(&mLock);
+                }
+                if (nb > 0) {
+                    count -= nb;
+                    nbEvents += nb;
+                    data += nb;
                 }
-                count -= nb;
-                nbEvents += nb;
-                data += nb;
+                if (drained)
+                    continue;
             }
+            mReady[kept++] = sensor;
         }
+        mNumReady = kept;
+
+        /* virtual sensors updated by the raw events above */
+        if (count) {
+            pthread_mutex_lock(&mLock);
+            int nb = mFusionActive ? readFusion(data, count) : 0;
+            pthread_mutex_unlock(&mLock);
+            count -= nb;
+            nbEvents += nb;
+            data += nb;
+        }
+
         if (count) {
             /* we still have some room, so try to see if we can get some events
              * immediately or just wait if we don't have anything to return */
-            n = poll(mPollFds, mNumSensors + 1, nbEvents ? 0 : -1);
+            bool woken;
+            n = mLoop.wait(owners, SENSORS_HANDLE_MAX + 1, nbEvents ? 0 : -1, &woken);
             if (n < 0) {
-                E("poll() failed (%s)", strerror(errno));
-                return -errno;
+                E("epoll_wait() failed (%s)", strerror(-n));
+                return n;
             }
-            if (mPollFds[wake].revents & POLLIN) {
-                char msg;
-                int result = read(mPollFds[wake].fd, &msg, 1);
-                LOGE_IF(result < 0, "error reading from wake pipe (%s)",
-                        strerror(errno));
-                LOGE_IF(msg != WAKE_MESSAGE,
-                        "unknown message on wake queue (0x%02x)", int(msg));
-                mPollFds[wake].revents = 0;
+            for (int i = 0; i < n; i++)
+                markReady(static_cast<SensorBase*>(owners[i]));
+            if (woken) {
+                /* a sensor was enabled, it may have queued an initial event */
+                for (int i = 0; i < mNumSensors; i++) {
+                    /* virtual sensors are only read by readFusion(), under mLock */
+                    if (is_fusion_handle(sensor_list[i].handle))
+                        continue;
+                    SensorBase* const sensor(mSensors[sensor_list[i].handle]);
+                    if (sensor->hasPendingEvents())
+                        markReady(sensor);
+                }
+                n++;
             }
         }
     } while (n && count);
@@ -59,7 +59,12 @@ __BEGIN_DECLS
 #define SENSORS_HANDLE_GYROSCOPE        5
 #define SENSORS_HANDLE_PRESSURE         6
 #define SENSORS_HANDLE_AMBIENT_TEMPERATURE      7
-#define SENSORS_HANDLE_MAX              7
+/* virtual sensors, see SensorFusion.h */
+#define SENSORS_HANDLE_ORIENTATION      8
+#define SENSORS_HANDLE_GRAVITY          9
+#define SENSORS_HANDLE_LINEAR_ACCELERATION      10
+#define SENSORS_HANDLE_ROTATION_VECTOR  11
+#define SENSORS_HANDLE_MAX              11
 
 #define GRAVITY 9.80665f
 
@@ -29,8 +29,13 @@ LOCAL_MODULE_TAGS := optional
 LOCAL_CFLAGS := -DLOG_TAG=\"Sensors\"
 LOCAL_SRC_FILES := config.cpp                      \
                     ../InputEventReader.cpp	       \
+                    ../EventLoop.cpp                 \
+                    ../InputDeviceIndex.cpp          \
+                    ../SysfsControl.cpp              \
                     ../sensors.cpp                 \
-                    ../SensorBase.cpp
+                    ../SensorBase.cpp              \
+                    ../SensorFusion.cpp            \
+                    ../FusionSensor.cpp
 
 LOCAL_SRC_FILES += ../AccelSensor.cpp              \
                  ../LightSensor_apds9300.cpp		\